@@ -20,6 +20,7 @@
 #include <memory.h>
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include "base/raw_buffer.h"
@@ -143,7 +144,11 @@ class RefCountedSlice : public Slice {
         return RefCountedSlice(buf, size, false);
     }
 
-    RefCountedSlice() : Slice(nullptr, 0), ref_cnt_(nullptr) {}
+    // Create slice of [offset, offset + size) of this slice, sharing the ownership of
+    // the buffer, e.g. a row of a buffer holding many rows
+    RefCountedSlice SubSlice(size_t offset, size_t size) const;
+
+    RefCountedSlice() : Slice(nullptr, 0), ref_(nullptr) {}
 
     RefCountedSlice(const RefCountedSlice &slice);
     RefCountedSlice(RefCountedSlice &&);
@@ -151,18 +156,28 @@ class RefCountedSlice : public Slice {
     RefCountedSlice &operator=(RefCountedSlice &&);
 
  private:
+    // the reference count and the buffer to free, shared by the slices of the buffer
+    struct Ref {
+        Ref(int8_t *b, size_t s) : cnt(1), buf(b), size(s) {}
+        // atomic, the rows of a request may be shared by the producers running concurrently
+        std::atomic<int32_t> cnt;
+        int8_t *buf;
+        size_t size;
+    };
+
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
-          ref_cnt_(managed ? new int(1) : nullptr) {}
+          ref_(managed ? new Ref(data, size) : nullptr) {}
 
     RefCountedSlice(const char *data, size_t size, bool managed)
-        : Slice(data, size), ref_cnt_(managed ? new int(1) : nullptr) {}
+        : Slice(data, size),
+          ref_(managed ? new Ref(reinterpret_cast<int8_t *>(const_cast<char *>(data)), size) : nullptr) {}
 
     void Release();
 
     void Update(const RefCountedSlice &slice);
 
-    int32_t *ref_cnt_;
+    Ref *ref_;
 };
 
 }  // namespace base
@@ -113,6 +113,24 @@ class EngineOptions {
         return enable_window_column_pruning_;
     }
 
+    /// Set `true` to run batch mode window aggregations on columnar kernels if the window
+    /// only uses sum/avg/count/min/max and their `*_where` forms, default `true`.
+    inline EngineOptions* SetEnableColumnarWindowAgg(bool flag) {
+        enable_columnar_window_agg_ = flag;
+        return this;
+    }
+    /// Return if the engine runs window aggregations on columnar kernels.
+    inline bool IsEnableColumnarWindowAgg() const { return enable_columnar_window_agg_; }
+
+    /// Set the executor that runs the independent input subtrees of a request-mode query
+    /// concurrently, default `nullptr`, which runs them one by one on the calling thread.
+    inline EngineOptions* SetParallelExecutor(const std::shared_ptr<ParallelExecutor>& executor) {
+        parallel_executor_ = executor;
+        return this;
+    }
+    /// Return the executor of the independent input subtrees, `nullptr` if not set.
+    inline const std::shared_ptr<ParallelExecutor>& GetParallelExecutor() const { return parallel_executor_; }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void SetMaxSqlCacheSize(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -132,8 +150,10 @@ class EngineOptions {
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
     bool enable_window_column_pruning_;
+    bool enable_columnar_window_agg_;
     uint32_t max_sql_cache_size_;
     JitOptions jit_options_;
+    std::shared_ptr<ParallelExecutor> parallel_executor_;
 };
 
 /// \brief A RunSession maintain SQL running context, including compile information, procedure name.
@@ -183,11 +203,15 @@ class RunSession {
         options_ = options;
     }
 
+    /// Return the bytes allocated by the jit run steps of the last run.
+    uint64_t GetArenaBytes() const { return arena_bytes_; }
+
  protected:
     std::shared_ptr<hybridse::vm::CompileInfo> compile_info_;
     hybridse::vm::EngineMode engine_mode_;
     bool is_debug_;
     std::string sp_name_;
+    uint64_t arena_bytes_ = 0;
     std::shared_ptr<const std::unordered_map<std::string, std::string>> options_ = nullptr;
     friend Engine;
 };
@@ -15,10 +15,12 @@
  */
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_CONTEXT_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_CONTEXT_H_
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 #include "boost/compute/detail/lru_cache.hpp"
 #include "vm/physical_op.h"
 namespace hybridse {
@@ -101,11 +103,36 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    // the memory in bytes of the object code cache shared by the jits of the process, 0 means disable
+    uint64_t GetObjCacheCapacity() const { return obj_cache_capacity_; }
+    void SetObjCacheCapacity(uint64_t capacity) { obj_cache_capacity_ = capacity; }
+
+    // the dir the cached objects persist in, so they survive the restart. empty means memory only
+    const std::string& GetObjCacheDir() const { return obj_cache_dir_; }
+    void SetObjCacheDir(const std::string& dir) { obj_cache_dir_ = dir; }
+
+    // the disk space in bytes of the objects in the dir, the least recently used files are removed beyond it
+    uint64_t GetObjCacheDirCapacity() const { return obj_cache_dir_capacity_; }
+    void SetObjCacheDirCapacity(uint64_t capacity) { obj_cache_dir_capacity_ = capacity; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    uint64_t obj_cache_capacity_ = 0;
+    std::string obj_cache_dir_;
+    uint64_t obj_cache_dir_capacity_ = 1024 << 20;
+};
+
+// Runs the independent input subtrees of a request concurrently, e.g. the windows over
+// different tables and the remote subqueries. Implemented by the host, e.g. on bthreads
+class ParallelExecutor {
+ public:
+    virtual ~ParallelExecutor() {}
+
+    // run all the tasks and return after all of them finish, a task may run on the calling thread
+    virtual void RunAll(const std::vector<std::function<void()>>& tasks) = 0;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -1488,14 +1488,19 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
 
 class PhysicalRequestAggUnionNode : public PhysicalOpNode {
  public:
-    PhysicalRequestAggUnionNode(PhysicalOpNode *request, PhysicalOpNode *raw, PhysicalOpNode *aggr,
-                                const RequestWindowOp &window, const RequestWindowOp &aggr_window,
+    // producers are the request, the raw table and the distinct pre-aggr tables.
+    // `projects[i]` is merged from the pre-aggr table `aggrs[aggr_idx[i]]`
+    PhysicalRequestAggUnionNode(PhysicalOpNode *request, PhysicalOpNode *raw,
+                                const std::vector<PhysicalOpNode *> &aggrs, const RequestWindowOp &window,
+                                const std::vector<RequestWindowOp> &aggr_windows,
                                 bool instance_not_in_window, bool exclude_current_time, bool output_request_row,
-                                const node::CallExprNode *project)
+                                const std::vector<const node::CallExprNode *> &projects,
+                                const std::vector<size_t> &aggr_idx)
         : PhysicalOpNode(kPhysicalOpRequestAggUnion, true),
           window_(window),
-          agg_window_(aggr_window),
-          project_(project),
+          agg_windows_(aggr_windows),
+          projects_(projects),
+          aggr_idx_(aggr_idx),
           instance_not_in_window_(instance_not_in_window),
           exclude_current_time_(exclude_current_time),
           output_request_row_(output_request_row) {
@@ -1506,12 +1511,18 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
         AddFnInfo(&window_.range_.fn_info());
         AddFnInfo(&window_.index_key_.fn_info());
 
-        AddFnInfo(&agg_window_.partition_.fn_info());
-        AddFnInfo(&agg_window_.sort_.fn_info());
-        AddFnInfo(&agg_window_.range_.fn_info());
-        AddFnInfo(&agg_window_.index_key_.fn_info());
+        for (auto &agg_window : agg_windows_) {
+            AddFnInfo(&agg_window.partition_.fn_info());
+            AddFnInfo(&agg_window.sort_.fn_info());
+            AddFnInfo(&agg_window.range_.fn_info());
+            AddFnInfo(&agg_window.index_key_.fn_info());
+        }
 
-        AddProducers(request, raw, aggr);
+        AddProducer(request);
+        AddProducer(raw);
+        for (auto aggr : aggrs) {
+            AddProducer(aggr);
+        }
     }
     virtual ~PhysicalRequestAggUnionNode() {}
     base::Status InitSchema(PhysicalPlanContext *) override;
@@ -1523,11 +1534,36 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
     const bool Valid() { return true; }
     static PhysicalRequestAggUnionNode *CastFrom(PhysicalOpNode *node);
 
+    // union a table without pre-aggregation, it is merged as the raw table
+    bool AddWindowUnion(PhysicalOpNode *node, const RequestWindowOp &window) {
+        if (nullptr == node) {
+            LOG(WARNING) << "Fail to add window union : table is null";
+            return false;
+        }
+        if (producers_.size() < 2 || nullptr == producers_[1]) {
+            LOG(WARNING) << "Fail to add window union : raw table is empty or null";
+            return false;
+        }
+        if (!IsSameSchema(*node->GetOutputSchema(), *producers_[1]->GetOutputSchema())) {
+            LOG(WARNING) << "Union Table and raw table schema aren't consistent";
+            return false;
+        }
+        window_unions_.AddWindowUnion(node, window);
+        RequestWindowOp &window_union = window_unions_.window_unions_.back().second;
+        fn_infos_.push_back(&window_union.partition_.fn_info());
+        fn_infos_.push_back(&window_union.sort_.fn_info());
+        fn_infos_.push_back(&window_union.range_.fn_info());
+        fn_infos_.push_back(&window_union.index_key_.fn_info());
+        return true;
+    }
+
     const bool instance_not_in_window() const { return instance_not_in_window_; }
     const bool exclude_current_time() const { return exclude_current_time_; }
     const bool output_request_row() const { return output_request_row_; }
     void set_out_request_row(bool flag) { output_request_row_ = flag; }
     const RequestWindowOp &window() const { return window_; }
+    const RequestWindowUnionList &window_unions() const { return window_unions_; }
+    size_t GetAggrTableCnt() const { return agg_windows_.size(); }
 
     base::Status WithNewChildren(node::NodeManager *nm,
                                  const std::vector<PhysicalOpNode *> &children,
@@ -1536,19 +1572,16 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
     }
 
     RequestWindowOp window_;
-    RequestWindowOp agg_window_;
+    // one window for each pre-aggr table, never resized since fn infos point into it
+    std::vector<RequestWindowOp> agg_windows_;
+    RequestWindowUnionList window_unions_;
 
-    // for long window, each node has only one projection node
-    const node::CallExprNode* project_;
+    // the long window aggregations, each one is a column of the output
+    const std::vector<const node::CallExprNode*> projects_;
+    const std::vector<size_t> aggr_idx_;
     const SchemasContext* parent_schema_context_ = nullptr;
 
  private:
-    void AddProducers(PhysicalOpNode *request, PhysicalOpNode *raw, PhysicalOpNode *aggr) {
-        AddProducer(request);
-        AddProducer(raw);
-        AddProducer(aggr);
-    }
-
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
 
@@ -22,26 +22,31 @@ namespace base {
 RefCountedSlice::~RefCountedSlice() { Release(); }
 
 void RefCountedSlice::Release() {
-    if (this->ref_cnt_ != nullptr) {
-        auto& cnt = *this->ref_cnt_;
-        cnt -= 1;
-        if (cnt == 0) {
+    if (this->ref_ != nullptr) {
+        if (this->ref_->cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
             // memset in case the buf is still used after free
-            memset(buf(), 0, size());
-            free(buf());
-            delete this->ref_cnt_;
+            memset(ref_->buf, 0, ref_->size);
+            free(ref_->buf);
+            delete this->ref_;
         }
     }
 }
 
 void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
-    this->ref_cnt_ = slice.ref_cnt_;
-    if (this->ref_cnt_ != nullptr) {
-        (*this->ref_cnt_) += 1;
+    this->ref_ = slice.ref_;
+    if (this->ref_ != nullptr) {
+        this->ref_->cnt.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
+RefCountedSlice RefCountedSlice::SubSlice(size_t offset, size_t size) const {
+    assert(offset + size <= this->size());
+    RefCountedSlice slice(*this);
+    slice.reset(data() + offset, size);
+    return slice;
+}
+
 RefCountedSlice::RefCountedSlice(const RefCountedSlice& slice) {
     this->Update(slice);
 }
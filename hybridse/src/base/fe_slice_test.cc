@@ -46,6 +46,23 @@ TEST_F(SliceTest, ref_cnt_slice) {
     ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
 }
 
+TEST_F(SliceTest, sub_slice) {
+    auto buf = reinterpret_cast<int8_t*>(malloc(1024));
+    strcpy(reinterpret_cast<char*>(buf), "hello world");  // NOLINT
+
+    RefCountedSlice sub;
+    {
+        auto slice = RefCountedSlice::CreateManaged(buf, 1024);
+        sub = slice.SubSlice(6, 5);
+    }
+    // the buffer is freed with the last slice
+    ASSERT_EQ(5u, sub.size());
+    ASSERT_EQ(0, memcmp(sub.data(), "world", 5));
+    RefCountedSlice copy = sub;
+    sub = RefCountedSlice();
+    ASSERT_EQ(0, memcmp(copy.data(), "world", 5));
+}
+
 }  // namespace base
 }  // namespace hybridse
 
@@ -53,6 +53,32 @@ TEST_F(MemPoolTest, ByteMemoryPoolTest) {
         ASSERT_EQ("helloworldhybri", std::string(s3, 15));
     }
 }
+
+TEST_F(MemPoolTest, RecycleTest) {
+    ::openmldb::base::ByteMemoryPool mem_pool;
+    for (int i = 0; i < 3; i++) {
+        mem_pool.Alloc(3000);
+    }
+    ASSERT_EQ(9000u, mem_pool.allocated_size());
+
+    // the allocations of the next round fit in one chuck
+    mem_pool.Recycle(mem_pool.allocated_size());
+    ASSERT_EQ(0u, mem_pool.allocated_size());
+    char* s1 = mem_pool.Alloc(3000);
+    char* s2 = mem_pool.Alloc(3000);
+    char* s3 = mem_pool.Alloc(3000);
+    ASSERT_EQ(s1 + 3000, s2);
+    ASSERT_EQ(s2 + 3000, s3);
+
+    // the chuck is reused
+    mem_pool.Recycle(9000);
+    ASSERT_EQ(s1, mem_pool.Alloc(9000));
+
+    // a chuck much larger than needed is freed
+    mem_pool.Recycle(0);
+    mem_pool.Alloc(4000);
+    ASSERT_EQ(4000u, mem_pool.allocated_size());
+}
 }  // namespace base
 }  // namespace hybridse
 
@@ -18,6 +18,9 @@
 // batch config
 DEFINE_string(default_db_name, "_hybridse",
               "config the default batch catalog db name");
+DEFINE_uint64(last_join_hash_max_bytes, 512 << 20,
+              "config the max memory of the hash table of a batch last join whose right table is not "
+              "indexed on the join key, a larger right table is grouped and sorted instead. 0 disables it");
 
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
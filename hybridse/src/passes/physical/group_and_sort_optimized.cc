@@ -172,16 +172,28 @@ bool GroupAndSortOptimized::Transform(PhysicalOpNode* in,
                     }
                 }
 
-                if (KeysAndOrderFilterOptimized(
-                        union_op->GetProducer(2)->schemas_ctx(), union_op->GetProducer(2),
-                        &union_op->agg_window_.partition_,
-                        &union_op->agg_window_.index_key_, &union_op->agg_window_.sort_,
-                        &new_producer)) {
-                    if (!ResetProducer(plan_ctx_, union_op, 2, new_producer)) {
-                        return false;
+                for (size_t i = 0; i < union_op->agg_windows_.size(); i++) {
+                    auto& agg_window = union_op->agg_windows_[i];
+                    if (KeysAndOrderFilterOptimized(
+                            union_op->GetProducer(2 + i)->schemas_ctx(), union_op->GetProducer(2 + i),
+                            &agg_window.partition_, &agg_window.index_key_, &agg_window.sort_,
+                            &new_producer)) {
+                        if (!ResetProducer(plan_ctx_, union_op, 2 + i, new_producer)) {
+                            return false;
+                        }
                     }
                 }
             }
+
+            for (auto& window_union : union_op->window_unions_.window_unions_) {
+                auto& window = window_union.second;
+                if (KeysAndOrderFilterOptimized(
+                        window_union.first->schemas_ctx(),
+                        window_union.first, &window.partition_,
+                        &window.index_key_, &window.sort_, &new_producer)) {
+                    window_union.first = new_producer;
+                }
+            }
             return true;
         }
         case PhysicalOpType::kPhysicalOpRequestJoin: {
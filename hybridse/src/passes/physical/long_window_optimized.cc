@@ -15,6 +15,7 @@
  */
 #include "passes/physical/long_window_optimized.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -61,12 +62,6 @@ bool LongWindowOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output)
     }
 
     auto project_aggr_op = dynamic_cast<vm::PhysicalAggregationNode*>(project_op);
-    // TODO(zhanghao): we only support transform PhysicalAggregationNode with one and only one window aggregation op
-    // we may remove this constraint in a later optimization
-    if (!VerifySingleAggregation(project_op)) {
-        LOG(WARNING) << "we only support transform PhysicalAggregationNode with one and only one window aggregation op";
-        return false;
-    }
 
     // this case shouldn't happen as we add the LongWindowOptimized pass only when `long_windows` option exists
     if (long_windows_.empty()) {
@@ -85,7 +80,9 @@ bool LongWindowOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output)
             // skip ANONYMOUS_WINDOW
             if (!window->GetName().empty()) {
                 if (long_windows_.count(window->GetName())) {
-                    return OptimizeWithPreAggr(project_aggr_op, i, output);
+                    // all projects of an aggregation node are over the same window, projects out of
+                    // pre-aggregation were split out by SplitAggregationOptimized
+                    return OptimizeWithPreAggr(project_aggr_op, output);
                 }
             }
         }
@@ -94,100 +91,11 @@ bool LongWindowOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output)
     return true;
 }
 
-bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, PhysicalOpNode** output) {
-    *output = in;
-
-    if (in->producers()[0]->GetOpType() != vm::kPhysicalOpRequestUnion) {
-        return false;
-    }
-    auto req_union_op = dynamic_cast<vm::PhysicalRequestUnionNode*>(in->producers()[0]);
-    if (!req_union_op->window_unions_.Empty()) {
-        LOG(WARNING) << "Not support optimization of RequestUnionOp with window unions";
-        return false;
-    }
-    const auto& projects = in->project();
-    auto orig_data_provider = dynamic_cast<vm::PhysicalDataProviderNode*>(req_union_op->GetProducer(1));
-    auto aggr_op = dynamic_cast<const node::CallExprNode*>(projects.GetExpr(idx));
-    auto window = aggr_op->GetOver();
-
-    auto s = CheckCallExpr(aggr_op);
-    if (!s.ok()) {
-        LOG(ERROR) << s.status();
-        return false;
-    }
-
-    const std::string& db_name = orig_data_provider->GetDb();
-    const std::string& table_name = orig_data_provider->GetName();
-    std::string func_name = aggr_op->GetFnDef()->GetName();
-    std::string aggr_col = ConcatExprList({aggr_op->children_.front()});
-    std::string filter_col = std::string(s->filter_col_name);
-    std::string partition_col;
-    if (window->GetPartitions()) {
-        partition_col = ConcatExprList(window->GetPartitions()->children_);
-    } else {
-        partition_col = ConcatExprList(req_union_op->window().partition().keys()->children_);
-    }
-
-    std::string order_col;
-    if (window->GetOrders()) {
-        order_col = ConcatExprList(window->GetOrders()->children_);
-    } else {
-        auto orders = req_union_op->window().sort().orders()->order_expressions();
-        for (size_t i = 0; i < orders->GetChildNum(); i++) {
-            auto order = dynamic_cast<node::OrderExpression*>(orders->GetChild(i));
-            if (order == nullptr || order->expr() == nullptr) {
-                LOG(ERROR) << "OrderBy col is empty";
-                return false;
-            }
-            auto col_ref = dynamic_cast<const node::ColumnRefNode*>(order->expr());
-            if (!col_ref) {
-                LOG(ERROR) << "OrderBy Col is not ColumnRefNode";
-                return false;
-            }
-            if (order_col.empty()) {
-                order_col = col_ref->GetColumnName();
-            } else {
-                order_col = absl::StrCat(order_col, ",", col_ref->GetColumnName());
-            }
-        }
-    }
-
-    auto table_infos =
-        catalog_->GetAggrTables(db_name, table_name, func_name, aggr_col, partition_col, order_col, filter_col);
-    if (table_infos.empty()) {
-        LOG(WARNING) << absl::StrCat("No Pre-aggregation tables exists for ", db_name, ".", table_name, ": ", func_name,
-                                     "(", aggr_col, ")", " partition by ", partition_col, " order by ", order_col);
-        return false;
-    }
-
-    // TODO(zhanghao): optimize the selection of the best pre-aggregation tables
-    auto table = catalog_->GetTable(table_infos[0].aggr_db, table_infos[0].aggr_table);
-    if (!table) {
-        LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << table_infos[0].aggr_db << "."
-                   << table_infos[0].aggr_table;
-        return false;
-    }
-
-    vm::PhysicalTableProviderNode* aggr = nullptr;
-    auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(&aggr, table);
-    if (!status.isOK()) {
-        LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << table_infos[0].aggr_db
-                   << "." << table_infos[0].aggr_table << ": " << status;
-        return false;
-    }
-
-    if (table->GetIndex().size() != 1) {
-        LOG(ERROR) << "PreAggregation table index size != 1";
-        return false;
-    }
+// the window over the pre-aggr table: partition by the key of its only index, order by ts_start,
+// with the frame of the original window
+static vm::RequestWindowOp BuildAggrWindow(node::NodeManager* nm, const std::shared_ptr<vm::TableHandler>& table,
+                                           const vm::RequestWindowOp& req_window) {
     auto index = table->GetIndex().cbegin()->second;
-    auto nm = plan_ctx_->node_manager();
-
-    auto request = req_union_op->GetProducer(0);
-    auto raw = req_union_op->GetProducer(1);
-
-    // generate an aggregation window for the aggr table
-    auto req_window = req_union_op->window();
     auto partitions = nm->MakeExprList();
     for (size_t i = 0; i < index.keys.size(); i++) {
         auto col_ref = nm->MakeColumnRefNode(index.keys[i].name, table->GetName(), table->GetDatabase());
@@ -213,19 +121,96 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
     aggr_window.range_ = req_window.range_;
     aggr_window.range_.range_key_ = order_col_ref;
     aggr_window.partition_.keys_ = partition_by;
+    return aggr_window;
+}
+
+bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, PhysicalOpNode** output) {
+    *output = in;
+
+    if (in->producers()[0]->GetOpType() != vm::kPhysicalOpRequestUnion) {
+        return false;
+    }
+    auto req_union_op = dynamic_cast<vm::PhysicalRequestUnionNode*>(in->producers()[0]);
+    if (!SupportWindowUnions(req_union_op)) {
+        LOG(WARNING) << "Not support optimization of RequestUnionOp with window unions on "
+                     << req_union_op->window().range_.ToString();
+        return false;
+    }
+
+    // aggregations with the same pre-aggr table share one producer, so the table is scanned once
+    const auto& projects = in->project();
+    std::vector<const node::CallExprNode*> aggr_ops;
+    std::vector<size_t> aggr_idx;
+    std::vector<vm::AggrTableInfo> aggr_tables;
+    for (size_t i = 0; i < projects.size(); i++) {
+        if (projects.GetExpr(i)->GetExprType() != node::kExprCall) {
+            LOG(WARNING) << "Long window project is not a call expr: " << projects.GetExpr(i)->GetExprString();
+            return false;
+        }
+        auto aggr_op = dynamic_cast<const node::CallExprNode*>(projects.GetExpr(i));
+        auto table_info = GetAggrTableInfo(catalog_, req_union_op, aggr_op);
+        if (!table_info.ok()) {
+            LOG(WARNING) << table_info.status();
+            return false;
+        }
+        auto it = absl::c_find_if(aggr_tables, [&table_info](const vm::AggrTableInfo& info) {
+            return info.aggr_db == table_info->aggr_db && info.aggr_table == table_info->aggr_table;
+        });
+        aggr_idx.push_back(it - aggr_tables.begin());
+        if (it == aggr_tables.end()) {
+            aggr_tables.push_back(table_info.value());
+        }
+        aggr_ops.push_back(aggr_op);
+    }
+
+    auto nm = plan_ctx_->node_manager();
+    std::vector<PhysicalOpNode*> aggrs;
+    std::vector<vm::RequestWindowOp> aggr_windows;
+    for (const auto& table_info : aggr_tables) {
+        auto table = catalog_->GetTable(table_info.aggr_db, table_info.aggr_table);
+        if (!table) {
+            LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << table_info.aggr_db << "."
+                       << table_info.aggr_table;
+            return false;
+        }
+
+        vm::PhysicalTableProviderNode* aggr = nullptr;
+        auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(&aggr, table);
+        if (!status.isOK()) {
+            LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << table_info.aggr_db
+                       << "." << table_info.aggr_table << ": " << status;
+            return false;
+        }
+
+        if (table->GetIndex().size() != 1) {
+            LOG(ERROR) << "PreAggregation table index size != 1";
+            return false;
+        }
+        aggrs.push_back(aggr);
+        // generate an aggregation window for the aggr table
+        aggr_windows.push_back(BuildAggrWindow(nm, table, req_union_op->window()));
+    }
+
+    auto request = req_union_op->GetProducer(0);
+    auto raw = req_union_op->GetProducer(1);
 
     vm::PhysicalRequestAggUnionNode* request_aggr_union = nullptr;
-    status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
-        &request_aggr_union, request, raw, aggr, req_union_op->window(), aggr_window,
+    auto status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
+        &request_aggr_union, request, raw, aggrs, req_union_op->window(), aggr_windows,
         req_union_op->instance_not_in_window(), req_union_op->exclude_current_time(),
-        req_union_op->output_request_row(), aggr_op);
-    if (req_union_op->exclude_current_row_) {
-        request_aggr_union->set_out_request_row(false);
-    }
+        req_union_op->output_request_row(), aggr_ops, aggr_idx);
     if (!status.isOK()) {
         LOG(ERROR) << "Fail to create PhysicalRequestAggUnionNode: " << status;
         return false;
     }
+    if (req_union_op->exclude_current_row_) {
+        request_aggr_union->set_out_request_row(false);
+    }
+    for (auto& window_union : req_union_op->window_unions_.window_unions_) {
+        if (!request_aggr_union->AddWindowUnion(window_union.first, window_union.second)) {
+            return false;
+        }
+    }
 
     vm::PhysicalReduceAggregationNode* reduce_aggr = nullptr;
     auto condition = in->having_condition_.condition();
@@ -235,25 +220,89 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
 
     status = plan_ctx_->CreateOp<vm::PhysicalReduceAggregationNode>(&reduce_aggr, request_aggr_union, in->project(),
                                                                     condition, in);
+    if (!status.isOK()) {
+        LOG(ERROR) << "Fail to create PhysicalReduceAggregationNode: " << status;
+        return false;
+    }
 
     auto ctx = reduce_aggr->schemas_ctx();
-    if (ctx->GetSchemaSourceSize() != 1 || ctx->GetSchema(0)->size() != 1) {
+    if (ctx->GetSchemaSourceSize() != 1 || static_cast<size_t>(ctx->GetSchema(0)->size()) != projects.size()) {
         LOG(ERROR) << "PhysicalReduceAggregationNode schema is unexpected";
         return false;
     }
     request_aggr_union->UpdateParentSchema(ctx);
 
-    if (!status.isOK()) {
-        LOG(ERROR) << "Fail to create PhysicalReduceAggregationNode: " << status;
-        return false;
-    }
     DLOG(INFO) << "[LongWindowOptimized] Before transform sql:\n" << (*output)->GetTreeString();
     *output = reduce_aggr;
     DLOG(INFO) << "[LongWindowOptimized] After transform sql:\n" << (*output)->GetTreeString();
     return true;
 }
 
-bool LongWindowOptimized::VerifySingleAggregation(vm::PhysicalProjectNode* op) { return op->project().size() == 1; }
+absl::StatusOr<vm::AggrTableInfo> LongWindowOptimized::GetAggrTableInfo(
+    const std::shared_ptr<vm::Catalog>& catalog, const vm::PhysicalRequestUnionNode* req_union_op,
+    const node::CallExprNode* aggr_op) {
+    auto s = CheckCallExpr(aggr_op);
+    if (!s.ok()) {
+        return s.status();
+    }
+
+    auto orig_data_provider = dynamic_cast<vm::PhysicalDataProviderNode*>(req_union_op->GetProducer(1));
+    if (orig_data_provider == nullptr) {
+        return absl::UnimplementedError("window over non-table input");
+    }
+    auto window = aggr_op->GetOver();
+    const std::string& db_name = orig_data_provider->GetDb();
+    const std::string& table_name = orig_data_provider->GetName();
+    std::string func_name = aggr_op->GetFnDef()->GetName();
+    std::string aggr_col = ConcatExprList({aggr_op->children_.front()});
+    std::string filter_col = std::string(s->filter_col_name);
+    std::string partition_col;
+    if (window->GetPartitions()) {
+        partition_col = ConcatExprList(window->GetPartitions()->children_);
+    } else {
+        partition_col = ConcatExprList(req_union_op->window().partition().keys()->children_);
+    }
+
+    std::string order_col;
+    if (window->GetOrders()) {
+        order_col = ConcatExprList(window->GetOrders()->children_);
+    } else {
+        auto orders = req_union_op->window().sort().orders()->order_expressions();
+        for (size_t i = 0; i < orders->GetChildNum(); i++) {
+            auto order = dynamic_cast<node::OrderExpression*>(orders->GetChild(i));
+            if (order == nullptr || order->expr() == nullptr) {
+                return absl::InvalidArgumentError("OrderBy col is empty");
+            }
+            auto col_ref = dynamic_cast<const node::ColumnRefNode*>(order->expr());
+            if (!col_ref) {
+                return absl::UnimplementedError("OrderBy Col is not ColumnRefNode");
+            }
+            if (order_col.empty()) {
+                order_col = col_ref->GetColumnName();
+            } else {
+                order_col = absl::StrCat(order_col, ",", col_ref->GetColumnName());
+            }
+        }
+    }
+
+    auto table_infos =
+        catalog->GetAggrTables(db_name, table_name, func_name, aggr_col, partition_col, order_col, filter_col);
+    if (table_infos.empty()) {
+        return absl::NotFoundError(absl::StrCat("No Pre-aggregation tables exists for ", db_name, ".", table_name,
+                                                ": ", func_name, "(", aggr_col, ")", " partition by ", partition_col,
+                                                " order by ", order_col));
+    }
+    // TODO(zhanghao): optimize the selection of the best pre-aggregation tables
+    return table_infos[0];
+}
+
+bool LongWindowOptimized::SupportWindowUnions(const vm::PhysicalRequestUnionNode* req_union_op) {
+    if (req_union_op->window_unions_.Empty()) {
+        return true;
+    }
+    auto frame = req_union_op->window().range_.frame();
+    return frame != nullptr && frame->frame_type() == node::kFrameRowsRange && frame->frame_maxsize() == 0;
+}
 
 std::string LongWindowOptimized::ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter) {
     std::string str = "";
@@ -16,6 +16,7 @@
 #ifndef HYBRIDSE_SRC_PASSES_PHYSICAL_LONG_WINDOW_OPTIMIZED_H_
 #define HYBRIDSE_SRC_PASSES_PHYSICAL_LONG_WINDOW_OPTIMIZED_H_
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -39,10 +40,19 @@ class LongWindowOptimized : public TransformUpPysicalPass {
         absl::string_view filter_col_name;
     };
 
+    // the pre-aggregation table for `call` over the window of `req_union_op`,
+    // error if the call can not be computed from pre-aggregation
+    static absl::StatusOr<vm::AggrTableInfo> GetAggrTableInfo(const std::shared_ptr<vm::Catalog>& catalog,
+                                                              const vm::PhysicalRequestUnionNode* req_union_op,
+                                                              const node::CallExprNode* call);
+
+    // window unions are merged as raw tables, which is only correct when the frame is decided
+    // by timestamp alone, i.e ROWS_RANGE without MAXSIZE
+    static bool SupportWindowUnions(const vm::PhysicalRequestUnionNode* req_union_op);
+
  private:
     bool Transform(PhysicalOpNode* in, PhysicalOpNode** output) override;
-    bool VerifySingleAggregation(vm::PhysicalProjectNode* op);
-    bool OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, PhysicalOpNode** output);
+    bool OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, PhysicalOpNode** output);
 
     static std::string ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter = ",");
 
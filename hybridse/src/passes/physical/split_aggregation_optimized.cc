@@ -17,6 +17,7 @@
 
 #include <vector>
 
+#include "passes/physical/long_window_optimized.h"
 #include "vm/engine.h"
 #include "vm/physical_op.h"
 
@@ -87,9 +88,14 @@ bool SplitAggregationOptimized::SplitProjects(vm::PhysicalAggregationNode* in, P
 
     DLOG(INFO) << "Split expr: " << in->GetTreeString();
 
+    // the aggregations computed from pre-aggregation are kept in one node, so they share one scan.
+    // Other window aggregations are split into one node each
+    auto req_union_op = dynamic_cast<vm::PhysicalRequestUnionNode*>(in->GetProducer(0));
     std::vector<vm::PhysicalProjectNode*> split_nodes;
     vm::ColumnProjects final_column_projects;
+    vm::ColumnProjects long_window_projects;
     vm::ColumnProjects simple_column_projects;
+    std::vector<vm::ColumnProjects> window_projects;
     for (size_t i = 0; i < projects.size(); i++) {
         const auto* expr = projects.GetExpr(i);
         auto name = projects.GetName(i);
@@ -100,23 +106,14 @@ bool SplitAggregationOptimized::SplitProjects(vm::PhysicalAggregationNode* in, P
             const auto* window = call_expr->GetOver();
 
             if (window) {
-                // create PhysicalAggregationNode of the window project
+                if (long_windows_.count(window->GetName()) &&
+                    LongWindowOptimized::GetAggrTableInfo(catalog_, req_union_op, call_expr).ok()) {
+                    long_window_projects.Add(name, expr, projects.GetFrame(i));
+                    continue;
+                }
                 vm::ColumnProjects column_projects;
                 column_projects.Add(name, expr, projects.GetFrame(i));
-                column_projects.SetPrimaryFrame(projects.GetPrimaryFrame());
-                vm::PhysicalAggregationNode* node = nullptr;
-                DLOG(INFO) << "Create Single Aggregation: size = " << column_projects.size()
-                           << ", expr = " << column_projects.GetExpr(column_projects.size() - 1)->GetExprString();
-
-                auto status = plan_ctx_->CreateOp<vm::PhysicalAggregationNode>(
-                    &node, in->GetProducer(0), column_projects, in->having_condition_.condition());
-                if (!status.isOK()) {
-                    LOG(ERROR) << "Fail to create PhysicalAggregationNode: " << status;
-                    return false;
-                }
-
-                split_nodes.emplace_back(node);
-                column_projects.Clear();
+                window_projects.push_back(column_projects);
             } else {
                 simple_column_projects.Add(projects.GetName(i), expr, projects.GetFrame(i));
             }
@@ -125,6 +122,30 @@ bool SplitAggregationOptimized::SplitProjects(vm::PhysicalAggregationNode* in, P
         }
     }
 
+    if (long_window_projects.size() == projects.size()) {
+        // nothing to split, LongWindowOptimized takes the whole node
+        return false;
+    }
+    if (long_window_projects.size() > 0) {
+        window_projects.insert(window_projects.begin(), long_window_projects);
+    }
+
+    for (auto& column_projects : window_projects) {
+        // create PhysicalAggregationNode of the window projects
+        column_projects.SetPrimaryFrame(projects.GetPrimaryFrame());
+        vm::PhysicalAggregationNode* node = nullptr;
+        DLOG(INFO) << "Create Aggregation: size = " << column_projects.size()
+                   << ", expr = " << column_projects.GetExpr(column_projects.size() - 1)->GetExprString();
+
+        auto status = plan_ctx_->CreateOp<vm::PhysicalAggregationNode>(&node, in->GetProducer(0), column_projects,
+                                                                       in->having_condition_.condition());
+        if (!status.isOK()) {
+            LOG(ERROR) << "Fail to create PhysicalAggregationNode: " << status;
+            return false;
+        }
+        split_nodes.emplace_back(node);
+    }
+
     if (simple_column_projects.size() > 0) {
         vm::PhysicalRowProjectNode* row_prj = nullptr;
         auto status =
@@ -177,7 +198,7 @@ bool SplitAggregationOptimized::IsSplitable(vm::PhysicalAggregationNode* op) {
     }
 
     auto req_union_op = dynamic_cast<vm::PhysicalRequestUnionNode*>(op->producers()[0]);
-    return req_union_op->window_unions_.Empty();
+    return LongWindowOptimized::SupportWindowUnions(req_union_op);
 }
 
 }  // namespace passes
@@ -165,9 +165,7 @@ class StringSplitState : public base::FeBaseObject {
 
 struct FZStringOpsDef {
     static StringSplitState* InitList() {
-        auto list = new StringSplitState();
-        vm::JitRuntime::get()->AddManagedObject(list);
-        return list;
+        return vm::JitRuntime::get()->NewManagedObject<StringSplitState>();
     }
 
     static void OutputList(StringSplitState* state,
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <tuple>
+#include <utility>
 
 #include "base/string_ref.h"
 #include "base/type.h"
@@ -29,6 +30,7 @@
 #include "proto/fe_type.pb.h"
 #include "udf/literal_traits.h"
 #include "udf/openmldb_udf.h"
+#include "vm/jit_runtime.h"
 
 namespace hybridse {
 namespace udf {
@@ -51,7 +53,7 @@ namespace v1 {
 //
 // The two arrays' lifetime will managed by JitRuntime:
 // - Allocate outside with new/malloc operation
-// - Register with `RegisterManagedObj`
+// - Construct the meta with `NewManagedObj`
 // - Free in `JitRuntime::ReleaseRunStep`
 template <typename T, typename CType = typename DataTypeTrait<T>::CCallArgType>
 struct ArrayMeta : public base::FeBaseObject {
@@ -86,6 +88,12 @@ struct OpaqueMeta : public base::FeBaseObject {
 // register the obj to jit runtime
 void RegisterManagedObj(base::FeBaseObject* obj);
 
+// construct the obj in the memory of jit runtime, it is destructed when the run step is released
+template <typename T, typename... Args>
+T* NewManagedObj(Args&&... args) {
+    return vm::JitRuntime::get()->NewManagedObject<T>(std::forward<Args>(args)...);
+}
+
 /**
  * Allocate string buffer from jit runtime.
  */
@@ -111,7 +119,7 @@ void AllocManagedArray(ArrayRef<T>* arr, uint64_t sz) {
         for (size_t i = 0; i < sz; ++i) {
             CType inst = CCallDataTypeTrait<CType>::alloc_instance();
 
-            RegisterManagedObj(new OpaqueMeta<CType>(inst));
+            NewManagedObj<OpaqueMeta<CType>>(inst);
 
             raw[i] = inst;
         }
@@ -119,7 +127,7 @@ void AllocManagedArray(ArrayRef<T>* arr, uint64_t sz) {
 
     auto nulls = new bool[sz];
 
-    RegisterManagedObj(new ArrayMeta<T>(raw, nulls));
+    NewManagedObj<ArrayMeta<T>>(raw, nulls);
 
     arr->raw = raw;
     arr->nullables = nulls;
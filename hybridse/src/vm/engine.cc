@@ -48,6 +48,7 @@ EngineOptions::EngineOptions()
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
       enable_window_column_pruning_(false),
+      enable_columnar_window_agg_(true),
       max_sql_cache_size_(50) {
 }
 
@@ -223,6 +224,8 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.is_batch_request_optimized = options_.IsBatchRequestOptimized();
     sql_context.enable_batch_window_parallelization = options_.IsEnableBatchWindowParallelization();
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
+    sql_context.enable_columnar_window_agg = options_.IsEnableColumnarWindowAgg();
+    sql_context.parallel_executor = options_.GetParallelExecutor();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
     sql_context.options = session.GetOptions();
@@ -452,9 +455,11 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row, Row* o
         return -2;
     }
     DLOG(INFO) << "Request Row Run with task_id " << task_id;
-    RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job, in_row,
-                      sp_name_, is_debug_);
+    auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
+    RunnerContext ctx(&sql_ctx.cluster_job, in_row, sp_name_, is_debug_);
+    ctx.SetParallelExecutor(sql_ctx.parallel_executor.get());
     auto output = task->RunWithCache(ctx);
+    arena_bytes_ = ctx.GetArenaBytes();
     if (!output) {
         LOG(WARNING) << "Run request plan output is null";
         return -1;
@@ -481,6 +486,7 @@ int32_t BatchRequestRunSession::Run(const uint32_t id, const std::vector<Row>& r
         return -2;
     }
     auto handler = task->BatchRequestRun(ctx);
+    arena_bytes_ = ctx.GetArenaBytes();
     if (!handler) {
         LOG(WARNING) << "Run request plan output is null";
         return -1;
@@ -0,0 +1,355 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vm/internal/agg_union_kernel.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "codec/fe_row_codec.h"
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+absl::StatusOr<ResolvedColumn> ResolvedColumn::Resolve(const SchemasContext* schemas_ctx,
+                                                       const node::ColumnRefNode* column) {
+    size_t schema_idx = 0;
+    size_t col_idx = 0;
+    auto status = schemas_ctx->ResolveColumnRefIndex(column, &schema_idx, &col_idx);
+    if (!status.isOK()) {
+        return absl::NotFoundError(status.GetMsg());
+    }
+    return Resolve(schemas_ctx, schema_idx, col_idx);
+}
+
+absl::StatusOr<ResolvedColumn> ResolvedColumn::Resolve(const SchemasContext* schemas_ctx,
+                                                       const std::string& column_name) {
+    size_t schema_idx = 0;
+    size_t col_idx = 0;
+    auto status = schemas_ctx->ResolveColumnIndexByName("", "", column_name, &schema_idx, &col_idx);
+    if (!status.isOK()) {
+        return absl::NotFoundError(status.GetMsg());
+    }
+    return Resolve(schemas_ctx, schema_idx, col_idx);
+}
+
+absl::StatusOr<ResolvedColumn> ResolvedColumn::Resolve(const SchemasContext* schemas_ctx, size_t schema_idx,
+                                                       size_t col_idx) {
+    // the same slice layout as RowParser, the schema_idx-th slice of a row is the schema_idx-th schema source
+    codec::SliceFormat format(schemas_ctx->GetSchema(schema_idx));
+    ResolvedColumn column;
+    column.slice_ = static_cast<int32_t>(schema_idx);
+    column.type_ = schemas_ctx->GetSchema(schema_idx)->Get(col_idx).type();
+    if (column.type_ == type::kVarchar) {
+        codec::StringColInfo info;
+        if (!format.GetStringColumnInfo(col_idx, &info)) {
+            return absl::InternalError(absl::StrCat("fail to resolve string column ", col_idx));
+        }
+        column.idx_ = info.idx;
+        column.offset_ = info.offset;
+        column.next_str_offset_ = info.str_next_offset;
+        column.str_start_offset_ = info.str_start_offset;
+    } else {
+        const codec::ColInfo* info = format.GetColumnInfo(col_idx);
+        if (info == nullptr) {
+            return absl::InternalError(absl::StrCat("fail to resolve column ", col_idx));
+        }
+        column.idx_ = info->idx;
+        column.offset_ = info->offset;
+    }
+    return column;
+}
+
+template <typename L, typename R>
+static std::optional<bool> Compare(node::FnOperator op, const L& lhs, const R& rhs) {
+    switch (op) {
+        case node::FnOperator::kFnOpLt:
+            return lhs < rhs;
+        case node::FnOperator::kFnOpLe:
+            return lhs <= rhs;
+        case node::FnOperator::kFnOpGt:
+            return lhs > rhs;
+        case node::FnOperator::kFnOpGe:
+            return lhs >= rhs;
+        case node::FnOperator::kFnOpEq:
+            return lhs == rhs;
+        case node::FnOperator::kFnOpNeq:
+            return lhs != rhs;
+        default:
+            break;
+    }
+    return std::nullopt;
+}
+
+// the value type a constant is kept as, strings are read from rows as absl::string_view
+template <typename T>
+using ConstType = std::conditional_t<std::is_same_v<T, absl::string_view>, std::string, T>;
+
+// 'col op const' or 'const op col' on a base table row
+template <typename T>
+class ColumnCond : public CompiledCond {
+ public:
+    ColumnCond(const ResolvedColumn& column, node::FnOperator op, std::optional<ConstType<T>> constant,
+               bool column_on_left)
+        : column_(column), op_(op), constant_(std::move(constant)), column_on_left_(column_on_left) {}
+
+    absl::StatusOr<std::optional<bool>> Eval(const codec::Row& row) const override {
+        if (!constant_.has_value() || column_.IsNull(row)) {
+            return std::nullopt;
+        }
+        T val = column_.GetValueUnsafe<T>(row);
+        if constexpr (std::is_same_v<T, absl::string_view>) {
+            absl::string_view constant = constant_.value();
+            return column_on_left_ ? Compare(op_, val, constant) : Compare(op_, constant, val);
+        } else {
+            return column_on_left_ ? Compare(op_, val, constant_.value()) : Compare(op_, constant_.value(), val);
+        }
+    }
+
+ private:
+    ResolvedColumn column_;
+    node::FnOperator op_;
+    std::optional<ConstType<T>> constant_;
+    bool column_on_left_;
+};
+
+// the filter key of a pre-aggr row is a string, it is parsed by the type of the constant
+template <typename T>
+static bool ParseFilterKey(absl::string_view filter_val, T* val) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return absl::SimpleAtob(filter_val, val);
+    } else if constexpr (std::is_same_v<T, int16_t>) {
+        int32_t v = 0;
+        if (!absl::SimpleAtoi<int32_t>(filter_val, &v)) {
+            return false;
+        }
+        *val = static_cast<int16_t>(v);
+        return true;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return absl::SimpleAtof(filter_val, val);
+    } else if constexpr (std::is_same_v<T, double>) {
+        return absl::SimpleAtod(filter_val, val);
+    } else {
+        return absl::SimpleAtoi<T>(filter_val, val);
+    }
+}
+
+template <typename T>
+class AggRowCond : public CompiledCond {
+ public:
+    AggRowCond(const ResolvedColumn& filter_key, node::FnOperator op, std::optional<ConstType<T>> constant,
+               bool column_on_left)
+        : filter_key_(filter_key), op_(op), constant_(std::move(constant)), column_on_left_(column_on_left) {}
+
+    absl::StatusOr<std::optional<bool>> Eval(const codec::Row& row) const override {
+        if (filter_key_.IsNull(row) || !constant_.has_value()) {
+            return std::nullopt;
+        }
+        auto filter_val = filter_key_.GetValueUnsafe<absl::string_view>(row);
+        if constexpr (std::is_same_v<T, absl::string_view>) {
+            absl::string_view constant = constant_.value();
+            return column_on_left_ ? Compare(op_, filter_val, constant) : Compare(op_, constant, filter_val);
+        } else {
+            T val;
+            if (!ParseFilterKey(filter_val, &val)) {
+                return absl::InvalidArgumentError(absl::StrCat("can't cast ", filter_val, " to filter type"));
+            }
+            return column_on_left_ ? Compare(op_, val, constant_.value()) : Compare(op_, constant_.value(), val);
+        }
+    }
+
+ private:
+    ResolvedColumn filter_key_;
+    node::FnOperator op_;
+    std::optional<ConstType<T>> constant_;
+    bool column_on_left_;
+};
+
+template <template <typename> class CondClass, typename T>
+static absl::StatusOr<std::unique_ptr<CompiledCond>> MakeCond(const ResolvedColumn& column, node::FnOperator op,
+                                                              const node::ConstNode* const_node,
+                                                              bool column_on_left) {
+    auto constant = const_node->GetAs<ConstType<T>>();
+    if (!constant.ok()) {
+        return constant.status();
+    }
+    return std::unique_ptr<CompiledCond>(new CondClass<T>(column, op, constant.value(), column_on_left));
+}
+
+// split 'col op const' or 'const op col' into the column and the constant
+static absl::Status SplitBinaryExpr(const node::ExprNode* cond, const node::BinaryExpr** bin_expr,
+                                    const node::ColumnRefNode** column, const node::ConstNode** const_node,
+                                    bool* column_on_left) {
+    *bin_expr = dynamic_cast<const node::BinaryExpr*>(cond);
+    if (*bin_expr == nullptr) {
+        return absl::InvalidArgumentError("can't compile expr other than binary expr");
+    }
+    const auto* left = (*bin_expr)->GetChild(0);
+    const auto* right = (*bin_expr)->GetChild(1);
+    if (left->GetExprType() == node::kExprColumnRef && right->GetExprType() == node::kExprPrimary) {
+        *column = dynamic_cast<const node::ColumnRefNode*>(left);
+        *const_node = dynamic_cast<const node::ConstNode*>(right);
+        *column_on_left = true;
+    } else if (right->GetExprType() == node::kExprColumnRef && left->GetExprType() == node::kExprPrimary) {
+        *column = dynamic_cast<const node::ColumnRefNode*>(right);
+        *const_node = dynamic_cast<const node::ConstNode*>(left);
+        *column_on_left = false;
+    } else {
+        return absl::UnimplementedError(absl::StrCat("can't compile ", cond->GetExprString()));
+    }
+    if (*column == nullptr || *const_node == nullptr) {
+        return absl::InvalidArgumentError(absl::StrCat("can't compile ", cond->GetExprString()));
+    }
+    return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<CompiledCond>> CompileCond(const SchemasContext* schemas_ctx,
+                                                          const node::ExprNode* cond) {
+    const node::BinaryExpr* bin_expr = nullptr;
+    const node::ColumnRefNode* column_ref = nullptr;
+    const node::ConstNode* const_node = nullptr;
+    bool column_on_left = true;
+    auto status = SplitBinaryExpr(cond, &bin_expr, &column_ref, &const_node, &column_on_left);
+    if (!status.ok()) {
+        return status;
+    }
+    auto column = ResolvedColumn::Resolve(schemas_ctx, column_ref);
+    if (!column.ok()) {
+        return column.status();
+    }
+    auto op = bin_expr->GetOp();
+    // the column type is the compare type, same as EvalCond
+    switch (column->type()) {
+        case type::kBool:
+            return MakeCond<ColumnCond, bool>(column.value(), op, const_node, column_on_left);
+        case type::kInt16:
+            return MakeCond<ColumnCond, int16_t>(column.value(), op, const_node, column_on_left);
+        case type::kInt32:
+            return MakeCond<ColumnCond, int32_t>(column.value(), op, const_node, column_on_left);
+        case type::kInt64:
+            return MakeCond<ColumnCond, int64_t>(column.value(), op, const_node, column_on_left);
+        case type::kFloat:
+            return MakeCond<ColumnCond, float>(column.value(), op, const_node, column_on_left);
+        case type::kDouble:
+            return MakeCond<ColumnCond, double>(column.value(), op, const_node, column_on_left);
+        case type::kVarchar:
+            return MakeCond<ColumnCond, absl::string_view>(column.value(), op, const_node, column_on_left);
+        default:
+            break;
+    }
+    return absl::UnimplementedError(absl::StrCat("can't compile ", cond->GetExprString(), " on type ",
+                                                 type::Type_Name(column->type())));
+}
+
+absl::StatusOr<std::unique_ptr<CompiledCond>> CompileCondWithAggRow(const SchemasContext* schemas_ctx,
+                                                                    const node::ExprNode* cond,
+                                                                    const std::string& filter_col_name) {
+    const node::BinaryExpr* bin_expr = nullptr;
+    const node::ColumnRefNode* column_ref = nullptr;
+    const node::ConstNode* const_node = nullptr;
+    bool column_on_left = true;
+    auto status = SplitBinaryExpr(cond, &bin_expr, &column_ref, &const_node, &column_on_left);
+    if (!status.ok()) {
+        return status;
+    }
+    auto filter_key = ResolvedColumn::Resolve(schemas_ctx, filter_col_name);
+    if (!filter_key.ok()) {
+        return filter_key.status();
+    }
+    if (filter_key->type() != type::kVarchar) {
+        return absl::InvalidArgumentError(absl::StrCat(filter_col_name, " is not a string column"));
+    }
+    auto op = bin_expr->GetOp();
+    // the constant type is the compare type, same as EvalCondWithAggRow
+    switch (const_node->GetDataType()) {
+        case node::DataType::kBool:
+            return MakeCond<AggRowCond, bool>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kInt16:
+            return MakeCond<AggRowCond, int16_t>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kInt32:
+        case node::DataType::kDate:
+            return MakeCond<AggRowCond, int32_t>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kInt64:
+        case node::DataType::kTimestamp:
+            return MakeCond<AggRowCond, int64_t>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kFloat:
+            return MakeCond<AggRowCond, float>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kDouble:
+            return MakeCond<AggRowCond, double>(filter_key.value(), op, const_node, column_on_left);
+        case node::DataType::kVarchar:
+            return MakeCond<AggRowCond, absl::string_view>(filter_key.value(), op, const_node, column_on_left);
+        default:
+            break;
+    }
+    return absl::UnimplementedError(absl::StrCat("can't compile ", cond->GetExprString()));
+}
+
+// V is the column type and R is the value type of the aggregator
+template <typename V, typename R>
+static void UpdateBase(BaseAggregator* aggregator, const ResolvedColumn& column, const codec::Row& row) {
+    if constexpr (std::is_same_v<V, absl::string_view>) {
+        static_cast<Aggregator<R>*>(aggregator)->UpdateValue(std::string(column.GetValueUnsafe<V>(row)));
+    } else {
+        static_cast<Aggregator<R>*>(aggregator)->UpdateValue(static_cast<R>(column.GetValueUnsafe<V>(row)));
+    }
+}
+
+// the same mapping from representative type to Aggregator<R> as AggregatorUpdate
+template <typename V>
+static BaseUpdateFn GetNumericUpdateFn(type::Type rep_type) {
+    switch (rep_type) {
+        case type::kInt16:
+            return &UpdateBase<V, int16_t>;
+        case type::kDate:
+        case type::kInt32:
+            return &UpdateBase<V, int32_t>;
+        case type::kTimestamp:
+        case type::kInt64:
+            return &UpdateBase<V, int64_t>;
+        case type::kFloat:
+            return &UpdateBase<V, float>;
+        case type::kDouble:
+            return &UpdateBase<V, double>;
+        default:
+            return nullptr;
+    }
+}
+
+BaseUpdateFn GetBaseUpdateFn(type::Type col_type, type::Type rep_type) {
+    switch (col_type) {
+        case type::kInt16:
+            return GetNumericUpdateFn<int16_t>(rep_type);
+        case type::kDate:
+        case type::kInt32:
+            return GetNumericUpdateFn<int32_t>(rep_type);
+        case type::kTimestamp:
+        case type::kInt64:
+            return GetNumericUpdateFn<int64_t>(rep_type);
+        case type::kFloat:
+            return GetNumericUpdateFn<float>(rep_type);
+        case type::kDouble:
+            return GetNumericUpdateFn<double>(rep_type);
+        case type::kVarchar:
+            return rep_type == type::kVarchar ? &UpdateBase<absl::string_view, std::string> : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,138 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: agg_union_kernel.h
+// -----------------------------------------------------------------------------
+//
+// Kernels of the merge in 'RequestAggUnionRunner'. Columns, filter conditions
+// and the aggregator update are resolved once when the runner is built, the
+// merge of each window then runs on field offsets and typed functions instead
+// of looking columns up by name and interpreting the condition per row.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef HYBRIDSE_SRC_VM_INTERNAL_AGG_UNION_KERNEL_H_
+#define HYBRIDSE_SRC_VM_INTERNAL_AGG_UNION_KERNEL_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "codec/row.h"
+#include "codec/type_codec.h"
+#include "node/expr_node.h"
+#include "vm/aggregator.h"
+#include "vm/schemas_context.h"
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+// a column resolved to its slice and field offset
+class ResolvedColumn {
+ public:
+    ResolvedColumn() = default;
+
+    static absl::StatusOr<ResolvedColumn> Resolve(const SchemasContext* schemas_ctx,
+                                                  const node::ColumnRefNode* column);
+    static absl::StatusOr<ResolvedColumn> Resolve(const SchemasContext* schemas_ctx, const std::string& column_name);
+
+    type::Type type() const { return type_; }
+
+    bool IsNull(const codec::Row& row) const { return codec::v1::IsNullAt(row.buf(slice_), idx_); }
+
+    // the column is assumed not null, T is absl::string_view for kVarchar
+    template <typename T>
+    T GetValueUnsafe(const codec::Row& row) const {
+        const int8_t* buf = row.buf(slice_);
+        if constexpr (std::is_same_v<T, bool>) {
+            return codec::v1::GetBoolFieldUnsafe(buf, offset_) == 1;
+        } else if constexpr (std::is_same_v<T, int16_t>) {
+            return codec::v1::GetInt16FieldUnsafe(buf, offset_);
+        } else if constexpr (std::is_same_v<T, int32_t>) {
+            return codec::v1::GetInt32FieldUnsafe(buf, offset_);
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            return codec::v1::GetInt64FieldUnsafe(buf, offset_);
+        } else if constexpr (std::is_same_v<T, float>) {
+            return codec::v1::GetFloatFieldUnsafe(buf, offset_);
+        } else if constexpr (std::is_same_v<T, double>) {
+            return codec::v1::GetDoubleFieldUnsafe(buf, offset_);
+        } else {
+            static_assert(std::is_same_v<T, absl::string_view>, "unsupported field type");
+            const char* data = nullptr;
+            uint32_t size = 0;
+            codec::v1::GetStrFieldUnsafe(buf, idx_, offset_, next_str_offset_, str_start_offset_,
+                                         codec::v1::GetAddrSpace(row.size(slice_)), &data, &size);
+            return absl::string_view(data, size);
+        }
+    }
+
+    // same as RowParser::GetValue, `val` is untouched if the column is null
+    template <typename T>
+    bool GetValue(const codec::Row& row, T* val) const {
+        if (IsNull(row)) {
+            return false;
+        }
+        *val = GetValueUnsafe<T>(row);
+        return true;
+    }
+
+ private:
+    static absl::StatusOr<ResolvedColumn> Resolve(const SchemasContext* schemas_ctx, size_t schema_idx,
+                                                  size_t col_idx);
+
+    int32_t slice_ = 0;
+    uint32_t idx_ = 0;
+    // field offset, or the offset of the string address for kVarchar
+    uint32_t offset_ = 0;
+    uint32_t next_str_offset_ = 0;
+    uint32_t str_start_offset_ = 0;
+    type::Type type_ = type::kNull;
+};
+
+// a filter condition of `*_where` with the column and the constant resolved
+class CompiledCond {
+ public:
+    virtual ~CompiledCond() {}
+
+    // the same result as `EvalCond` or `EvalCondWithAggRow` on the row
+    virtual absl::StatusOr<std::optional<bool>> Eval(const codec::Row& row) const = 0;
+};
+
+// compile the condition evaluated by `EvalCond`. Only 'col op const' and 'const op col'
+// are compiled, the caller should fall back to `EvalCond` on error
+absl::StatusOr<std::unique_ptr<CompiledCond>> CompileCond(const SchemasContext* schemas_ctx,
+                                                          const node::ExprNode* cond);
+
+// compile the condition evaluated by `EvalCondWithAggRow`
+absl::StatusOr<std::unique_ptr<CompiledCond>> CompileCondWithAggRow(const SchemasContext* schemas_ctx,
+                                                                    const node::ExprNode* cond,
+                                                                    const std::string& filter_col_name);
+
+// update the aggregator by the value of a base table row, the column is not null
+using BaseUpdateFn = void (*)(BaseAggregator* aggregator, const ResolvedColumn& column, const codec::Row& row);
+
+// pick the update kernel by the column type and the representative type of the aggregator,
+// nullptr if the aggregator can not take the column
+BaseUpdateFn GetBaseUpdateFn(type::Type col_type, type::Type rep_type);
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_SRC_VM_INTERNAL_AGG_UNION_KERNEL_H_
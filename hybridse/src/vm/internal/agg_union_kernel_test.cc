@@ -0,0 +1,339 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vm/internal/agg_union_kernel.h"
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "gtest/gtest.h"
+#include "node/node_manager.h"
+#include "vm/internal/eval.h"
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+static const node::FnOperator kOps[] = {node::FnOperator::kFnOpLt, node::FnOperator::kFnOpLe,
+                                        node::FnOperator::kFnOpGt, node::FnOperator::kFnOpGe,
+                                        node::FnOperator::kFnOpEq, node::FnOperator::kFnOpNeq};
+
+class AggUnionKernelTest : public ::testing::Test {
+ public:
+    AggUnionKernelTest() {
+        for (auto& [name, type] : std::vector<std::pair<std::string, type::Type>>{
+                 {"c_bool", type::kBool},
+                 {"c_i16", type::kInt16},
+                 {"c_i32", type::kInt32},
+                 {"c_i64", type::kInt64},
+                 {"c_float", type::kFloat},
+                 {"c_double", type::kDouble},
+                 {"c_str", type::kVarchar},
+                 {"c_date", type::kDate},
+                 {"c_ts", type::kTimestamp},
+             }) {
+            auto col = base_schema_.Add();
+            col->set_name(name);
+            col->set_type(type);
+        }
+        base_ctx_.BuildTrivial({&base_schema_});
+
+        for (auto& name : {"filter_key", "agg_val"}) {
+            auto col = agg_schema_.Add();
+            col->set_name(name);
+            col->set_type(type::kVarchar);
+        }
+        agg_ctx_.BuildTrivial({&agg_schema_});
+    }
+
+    // small domains so that the equal cases are hit, every tenth value is null
+    codec::Row MakeBaseRow(std::mt19937* rng) {
+        std::uniform_int_distribution<int> dist(-3, 3);
+        std::vector<int> vals;
+        for (int i = 0; i < base_schema_.size(); i++) {
+            vals.push_back(dist(*rng));
+        }
+        std::string str = std::string(1, static_cast<char>('b' + vals[6]));
+        codec::RowBuilder builder(base_schema_);
+        uint32_t size = builder.CalTotalLength(str.size());
+        int8_t* buf = static_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        std::uniform_int_distribution<int> null_dist(0, 9);
+        for (int i = 0; i < base_schema_.size(); i++) {
+            if (null_dist(*rng) == 0) {
+                builder.AppendNULL();
+                continue;
+            }
+            switch (base_schema_.Get(i).type()) {
+                case type::kBool:
+                    builder.AppendBool(vals[i] > 0);
+                    break;
+                case type::kInt16:
+                    builder.AppendInt16(static_cast<int16_t>(vals[i]));
+                    break;
+                case type::kInt32:
+                    builder.AppendInt32(vals[i]);
+                    break;
+                case type::kInt64:
+                    builder.AppendInt64(vals[i]);
+                    break;
+                case type::kFloat:
+                    builder.AppendFloat(vals[i] / 2.0f);
+                    break;
+                case type::kDouble:
+                    builder.AppendDouble(vals[i] / 2.0);
+                    break;
+                case type::kVarchar:
+                    builder.AppendString(str.c_str(), str.size());
+                    break;
+                case type::kDate:
+                    builder.AppendDate(vals[i] + 10);
+                    break;
+                case type::kTimestamp:
+                    builder.AppendTimestamp(vals[i] + 10);
+                    break;
+                default:
+                    break;
+            }
+        }
+        return codec::Row(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+
+    // filter_key is nullptr for a null key
+    codec::Row MakeAggRow(const char* filter_key) {
+        std::string key = filter_key == nullptr ? "" : filter_key;
+        std::string agg_val = "v";
+        codec::RowBuilder builder(agg_schema_);
+        uint32_t size = builder.CalTotalLength(key.size() + agg_val.size());
+        int8_t* buf = static_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        if (filter_key == nullptr) {
+            builder.AppendNULL();
+        } else {
+            builder.AppendString(key.c_str(), key.size());
+        }
+        builder.AppendString(agg_val.c_str(), agg_val.size());
+        return codec::Row(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+
+    std::vector<node::ConstNode*> MakeConstants() {
+        return {nm_.MakeConstNode(true),
+                nm_.MakeConstNode(false),
+                nm_.MakeConstNode(static_cast<int16_t>(1)),
+                nm_.MakeConstNode(0),
+                nm_.MakeConstNode(-2),
+                nm_.MakeConstNode(static_cast<int64_t>(2)),
+                nm_.MakeConstNode(12, node::kDate),
+                nm_.MakeConstNode(static_cast<int64_t>(11), node::kTimestamp),
+                nm_.MakeConstNode(0.5f),
+                nm_.MakeConstNode(-1.0),
+                nm_.MakeConstNode(std::string("b")),
+                nm_.MakeConstNode(std::string("1")),
+                nm_.MakeConstNode()};
+    }
+
+    static void ExpectSameResult(const absl::StatusOr<std::optional<bool>>& expect,
+                                 const absl::StatusOr<std::optional<bool>>& actual, const std::string& msg) {
+        ASSERT_EQ(expect.ok(), actual.ok()) << msg << ": " << expect.status() << " vs " << actual.status();
+        if (expect.ok()) {
+            ASSERT_EQ(expect.value(), actual.value()) << msg;
+        }
+    }
+
+ protected:
+    node::NodeManager nm_;
+    codec::Schema base_schema_;
+    codec::Schema agg_schema_;
+    SchemasContext base_ctx_;
+    SchemasContext agg_ctx_;
+};
+
+TEST_F(AggUnionKernelTest, CompileCondTest) {
+    RowParser parser(&base_ctx_);
+    std::mt19937 rng(42);
+    std::vector<codec::Row> rows;
+    for (int i = 0; i < 64; i++) {
+        rows.push_back(MakeBaseRow(&rng));
+    }
+    size_t compiled = 0;
+    for (const auto& col_def : base_schema_) {
+        for (auto* constant : MakeConstants()) {
+            for (auto op : kOps) {
+                for (bool column_on_left : {true, false}) {
+                    auto* column = nm_.MakeColumnRefNode(col_def.name(), "");
+                    auto* cond = column_on_left ? nm_.MakeBinaryExprNode(column, constant, op)
+                                                : nm_.MakeBinaryExprNode(constant, column, op);
+                    auto kernel = CompileCond(&base_ctx_, cond);
+                    if (!kernel.ok()) {
+                        // the runner evaluates it by EvalCond
+                        continue;
+                    }
+                    compiled++;
+                    for (const auto& row : rows) {
+                        ExpectSameResult(EvalCond(&parser, row, cond), kernel.value()->Eval(row),
+                                         cond->GetExprString());
+                    }
+                }
+            }
+        }
+    }
+    // every column type but date and timestamp takes every constant of the same type
+    ASSERT_GE(compiled, 7u * 12u);
+}
+
+TEST_F(AggUnionKernelTest, CompileCondWithAggRowTest) {
+    RowParser parser(&agg_ctx_);
+    std::vector<codec::Row> rows;
+    std::vector<const char*> keys = {"1", "0", "-2", "2", "12", "0.5", "-1", "true", "false", "b", "a", "", "abc",
+                                     nullptr};
+    for (const char* key : keys) {
+        rows.push_back(MakeAggRow(key));
+    }
+    size_t compiled = 0;
+    for (auto* constant : MakeConstants()) {
+        for (auto op : kOps) {
+            for (bool column_on_left : {true, false}) {
+                // the column name is ignored, the filter key of the pre-aggr table is compared
+                auto* column = nm_.MakeColumnRefNode("c_i32", "");
+                auto* cond = column_on_left ? nm_.MakeBinaryExprNode(column, constant, op)
+                                            : nm_.MakeBinaryExprNode(constant, column, op);
+                auto kernel = CompileCondWithAggRow(&agg_ctx_, cond, "filter_key");
+                if (!kernel.ok()) {
+                    continue;
+                }
+                compiled++;
+                for (const auto& row : rows) {
+                    ExpectSameResult(EvalCondWithAggRow(&parser, row, cond, "filter_key"),
+                                     kernel.value()->Eval(row), cond->GetExprString());
+                }
+            }
+        }
+    }
+    // all the constants but null
+    ASSERT_EQ(12u * 6u * 2u, compiled);
+}
+
+// the update before the kernels: read the value by the column type and dispatch on the aggregator
+static void UpdateByParser(const RowParser& parser, BaseAggregator* aggregator, const std::string& col,
+                           const codec::Row& row) {
+    auto type = aggregator->type();
+    switch (type) {
+        case type::kInt16: {
+            int16_t val = 0;
+            parser.GetValue(row, col, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::kDate:
+        case type::kInt32: {
+            int32_t val = 0;
+            parser.GetValue(row, col, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::kTimestamp:
+        case type::kInt64: {
+            int64_t val = 0;
+            parser.GetValue(row, col, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::kFloat: {
+            float val = 0;
+            parser.GetValue(row, col, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::kDouble: {
+            double val = 0;
+            parser.GetValue(row, col, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::kVarchar: {
+            std::string val;
+            parser.GetString(row, col, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        default:
+            FAIL() << "unexpected type " << Type_Name(type);
+    }
+}
+
+TEST_F(AggUnionKernelTest, BaseUpdateFnTest) {
+    RowParser parser(&base_ctx_);
+    std::mt19937 rng(7);
+    std::vector<codec::Row> rows;
+    for (int i = 0; i < 64; i++) {
+        rows.push_back(MakeBaseRow(&rng));
+    }
+    // a string output keeps the raw bytes of the aggregated value
+    codec::Schema output_schema;
+    output_schema.Add()->set_type(type::kVarchar);
+    using Factory = std::function<std::unique_ptr<BaseAggregator>(type::Type)>;
+    std::vector<std::pair<std::string, Factory>> factories = {
+        {"sum", [&](type::Type t) { return MakeOverflowAggregator<SumAggregator>(t, output_schema); }},
+        {"avg", [&](type::Type t) { return std::make_unique<AvgAggregator>(t, output_schema); }},
+        {"min", [&](type::Type t) { return MakeSameTypeAggregator<MinAggregator>(t, output_schema); }},
+        {"max", [&](type::Type t) { return MakeSameTypeAggregator<MaxAggregator>(t, output_schema); }},
+    };
+    size_t checked = 0;
+    for (const auto& col_def : base_schema_) {
+        auto column = ResolvedColumn::Resolve(&base_ctx_, col_def.name());
+        ASSERT_TRUE(column.ok()) << column.status();
+        for (const auto& [name, factory] : factories) {
+            // the runner rejects the aggregations without an aggregator or an update kernel
+            if (col_def.type() == type::kBool || (name == "avg" && col_def.type() == type::kVarchar)) {
+                continue;
+            }
+            auto expect = factory(col_def.type());
+            auto actual = factory(col_def.type());
+            if (!expect) {
+                continue;
+            }
+            auto fn = GetBaseUpdateFn(column->type(), actual->GetRepType());
+            ASSERT_TRUE(fn != nullptr) << name << " on " << col_def.name();
+            for (const auto& row : rows) {
+                if (parser.IsNull(row, col_def.name())) {
+                    ASSERT_TRUE(column->IsNull(row));
+                    continue;
+                }
+                UpdateByParser(parser, expect.get(), col_def.name(), row);
+                fn(actual.get(), column.value(), row);
+            }
+            auto expect_row = expect->Output();
+            auto actual_row = actual->Output();
+            ASSERT_EQ(expect_row.ToString(), actual_row.ToString()) << name << " on " << col_def.name();
+            checked++;
+        }
+    }
+    // sum on the numeric columns, avg on them and date, min and max on all but bool
+    ASSERT_EQ(6u + 7u + 8u + 8u, checked);
+}
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::GTEST_FLAG(color) = "yes";
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,978 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vm/internal/window_agg_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "codec/fe_row_codec.h"
+#include "gflags/gflags.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HYBRIDSE_WINDOW_AGG_AVX2
+#include <immintrin.h>
+#endif
+
+DECLARE_bool(enable_spark_unsaferow_format);
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+enum class ReduceOp { kSum, kMin, kMax };
+
+template <typename T, ReduceOp OP>
+static T ReduceIdentity() {
+    if constexpr (OP == ReduceOp::kSum) {
+        return T(0);
+    } else if constexpr (OP == ReduceOp::kMin) {
+        return std::numeric_limits<T>::max();
+    } else {
+        return std::numeric_limits<T>::lowest();
+    }
+}
+
+template <typename T, ReduceOp OP>
+static T Combine(T lhs, T rhs) {
+    if constexpr (OP == ReduceOp::kSum) {
+        // add as unsigned, so the overflow wraps around as the integer add of the jit function
+        using U = std::make_unsigned_t<T>;
+        return static_cast<T>(static_cast<U>(static_cast<U>(lhs) + static_cast<U>(rhs)));
+    } else if constexpr (OP == ReduceOp::kMin) {
+        return std::min(lhs, rhs);
+    } else {
+        return std::max(lhs, rhs);
+    }
+}
+
+template <typename T, ReduceOp OP>
+static T ReduceScalar(const T* vals, size_t n) {
+    T acc = ReduceIdentity<T, OP>();
+    for (size_t i = 0; i < n; i++) {
+        acc = Combine<T, OP>(acc, vals[i]);
+    }
+    return acc;
+}
+
+#ifdef HYBRIDSE_WINDOW_AGG_AVX2
+template <typename T>
+__attribute__((target("avx2"))) static inline __m256i Avx2Set1(T val) {
+    if constexpr (sizeof(T) == 2) {
+        return _mm256_set1_epi16(val);
+    } else if constexpr (sizeof(T) == 4) {
+        return _mm256_set1_epi32(val);
+    } else {
+        return _mm256_set1_epi64x(val);
+    }
+}
+
+template <typename T, ReduceOp OP>
+__attribute__((target("avx2"))) static inline __m256i Avx2Combine(__m256i acc, __m256i v) {
+    if constexpr (OP == ReduceOp::kSum) {
+        if constexpr (sizeof(T) == 2) {
+            return _mm256_add_epi16(acc, v);
+        } else if constexpr (sizeof(T) == 4) {
+            return _mm256_add_epi32(acc, v);
+        } else {
+            return _mm256_add_epi64(acc, v);
+        }
+    } else if constexpr (OP == ReduceOp::kMin) {
+        if constexpr (sizeof(T) == 2) {
+            return _mm256_min_epi16(acc, v);
+        } else if constexpr (sizeof(T) == 4) {
+            return _mm256_min_epi32(acc, v);
+        } else {
+            // no min_epi64 before AVX-512
+            return _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(acc, v));
+        }
+    } else {
+        if constexpr (sizeof(T) == 2) {
+            return _mm256_max_epi16(acc, v);
+        } else if constexpr (sizeof(T) == 4) {
+            return _mm256_max_epi32(acc, v);
+        } else {
+            return _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(v, acc));
+        }
+    }
+}
+
+template <typename T, ReduceOp OP>
+__attribute__((target("avx2"))) static T ReduceAvx2(const T* vals, size_t n) {
+    constexpr size_t LANES = sizeof(__m256i) / sizeof(T);
+    // two accumulators to hide the latency of the dependent adds
+    __m256i acc0 = Avx2Set1<T>(ReduceIdentity<T, OP>());
+    __m256i acc1 = acc0;
+    size_t i = 0;
+    for (; i + 2 * LANES <= n; i += 2 * LANES) {
+        acc0 = Avx2Combine<T, OP>(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vals + i)));
+        acc1 = Avx2Combine<T, OP>(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vals + i + LANES)));
+    }
+    acc0 = Avx2Combine<T, OP>(acc0, acc1);
+    T lanes[LANES];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc0);
+    return Combine<T, OP>(ReduceScalar<T, OP>(lanes, LANES), ReduceScalar<T, OP>(vals + i, n - i));
+}
+
+__attribute__((target("avx2"))) static int64_t CountAvx2(const uint8_t* mask, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        // sum of the absolute differences to zero, the 32 bytes are summed into 4 int64 lanes
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, zero));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    int64_t cnt = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) {
+        cnt += mask[i];
+    }
+    return cnt;
+}
+#endif
+
+bool UseAvx2Kernels() {
+#ifdef HYBRIDSE_WINDOW_AGG_AVX2
+    static const bool use_avx2 = __builtin_cpu_supports("avx2");
+    return use_avx2;
+#else
+    return false;
+#endif
+}
+
+template <typename T, ReduceOp OP>
+static T Reduce(const T* vals, size_t n) {
+    static_assert(std::is_integral_v<T>, "only integers are reduced out of order");
+#ifdef HYBRIDSE_WINDOW_AGG_AVX2
+    if (UseAvx2Kernels()) {
+        return ReduceAvx2<T, OP>(vals, n);
+    }
+#endif
+    return ReduceScalar<T, OP>(vals, n);
+}
+
+template <typename T>
+T SumRange(const T* vals, size_t n) {
+    return Reduce<T, ReduceOp::kSum>(vals, n);
+}
+
+template <typename T>
+T MinRange(const T* vals, size_t n) {
+    return Reduce<T, ReduceOp::kMin>(vals, n);
+}
+
+template <typename T>
+T MaxRange(const T* vals, size_t n) {
+    return Reduce<T, ReduceOp::kMax>(vals, n);
+}
+
+template int16_t SumRange<int16_t>(const int16_t*, size_t);
+template int32_t SumRange<int32_t>(const int32_t*, size_t);
+template int64_t SumRange<int64_t>(const int64_t*, size_t);
+template int16_t MinRange<int16_t>(const int16_t*, size_t);
+template int32_t MinRange<int32_t>(const int32_t*, size_t);
+template int64_t MinRange<int64_t>(const int64_t*, size_t);
+template int16_t MaxRange<int16_t>(const int16_t*, size_t);
+template int32_t MaxRange<int32_t>(const int32_t*, size_t);
+template int64_t MaxRange<int64_t>(const int64_t*, size_t);
+
+int64_t CountRange(const uint8_t* mask, size_t n) {
+#ifdef HYBRIDSE_WINDOW_AGG_AVX2
+    if (UseAvx2Kernels()) {
+        return CountAvx2(mask, n);
+    }
+#endif
+    int64_t cnt = 0;
+    for (size_t i = 0; i < n; i++) {
+        cnt += mask[i];
+    }
+    return cnt;
+}
+
+using Project = ColumnarWindowAgg::Project;
+
+// the outputs of an aggregation project for the rows of a partition
+struct AggOutput {
+    std::vector<uint8_t> is_null;
+    // values of the int16, int32 and int64 outputs
+    std::vector<int64_t> ints;
+    // values of the float and double outputs
+    std::vector<double> reals;
+};
+
+static bool IsNumeric(type::Type type) {
+    switch (type) {
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kFloat:
+        case type::kDouble:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static std::string GetFnName(const node::CallExprNode* call) {
+    const auto* fn_def = call->GetFnDef();
+    if (fn_def == nullptr) {
+        return "";
+    }
+    // the same as AggregateIRBuilder::CollectAggColumn
+    switch (fn_def->GetType()) {
+        case node::kExternalFnDef:
+            return absl::AsciiStrToLower(dynamic_cast<const node::ExternalFnDefNode*>(fn_def)->function_name());
+        case node::kUdafDef:
+            return absl::AsciiStrToLower(dynamic_cast<const node::UdafDefNode*>(fn_def)->GetName());
+        default:
+            return "";
+    }
+}
+
+// CompileCond casts the constant to the column type, while the jit function compares on the
+// wider type of the two. They are the same only if the constant casts to the column type
+// without loss
+static absl::Status CheckCond(const SchemasContext* schemas_ctx, const node::ExprNode* cond) {
+    const auto* bin_expr = dynamic_cast<const node::BinaryExpr*>(cond);
+    if (bin_expr == nullptr) {
+        return absl::UnimplementedError(absl::StrCat("condition ", cond->GetExprString()));
+    }
+    switch (bin_expr->GetOp()) {
+        case node::FnOperator::kFnOpLt:
+        case node::FnOperator::kFnOpLe:
+        case node::FnOperator::kFnOpGt:
+        case node::FnOperator::kFnOpGe:
+        case node::FnOperator::kFnOpEq:
+        case node::FnOperator::kFnOpNeq:
+            break;
+        default:
+            return absl::UnimplementedError(absl::StrCat("condition ", cond->GetExprString()));
+    }
+    const node::ColumnRefNode* column_ref = nullptr;
+    const node::ConstNode* const_node = nullptr;
+    for (size_t i = 0; i < 2; i++) {
+        const auto* child = bin_expr->GetChild(i);
+        if (child->GetExprType() == node::kExprColumnRef) {
+            column_ref = dynamic_cast<const node::ColumnRefNode*>(child);
+        } else if (child->GetExprType() == node::kExprPrimary) {
+            const_node = dynamic_cast<const node::ConstNode*>(child);
+        }
+    }
+    if (column_ref == nullptr || const_node == nullptr) {
+        return absl::UnimplementedError(absl::StrCat("condition ", cond->GetExprString()));
+    }
+    auto column = ResolvedColumn::Resolve(schemas_ctx, column_ref);
+    if (!column.ok()) {
+        return column.status();
+    }
+    auto const_type = const_node->GetDataType();
+    bool lossless = false;
+    switch (column->type()) {
+        case type::kBool:
+            lossless = const_type == node::kBool;
+            break;
+        case type::kInt16:
+            lossless = const_type == node::kInt16;
+            break;
+        case type::kInt32:
+            lossless = const_type == node::kInt16 || const_type == node::kInt32;
+            break;
+        case type::kInt64:
+            lossless = const_type == node::kInt16 || const_type == node::kInt32 || const_type == node::kInt64;
+            break;
+        case type::kFloat:
+            lossless = const_type == node::kFloat;
+            break;
+        case type::kDouble:
+            lossless = const_type == node::kFloat || const_type == node::kDouble;
+            break;
+        case type::kVarchar:
+            lossless = const_type == node::kVarchar;
+            break;
+        default:
+            break;
+    }
+    if (!lossless) {
+        return absl::UnimplementedError(absl::StrCat("condition ", cond->GetExprString(), " on type ",
+                                                     type::Type_Name(column->type())));
+    }
+    return absl::OkStatus();
+}
+
+static absl::StatusOr<Project> BuildProject(const SchemasContext* schemas_ctx, const node::ExprNode* expr) {
+    Project project;
+    if (expr->GetExprType() == node::kExprColumnRef) {
+        auto column = ResolvedColumn::Resolve(schemas_ctx, dynamic_cast<const node::ColumnRefNode*>(expr));
+        if (!column.ok()) {
+            return column.status();
+        }
+        switch (column->type()) {
+            case type::kBool:
+            case type::kInt16:
+            case type::kInt32:
+            case type::kInt64:
+            case type::kFloat:
+            case type::kDouble:
+            case type::kDate:
+            case type::kTimestamp:
+            case type::kVarchar:
+                break;
+            default:
+                return absl::UnimplementedError(absl::StrCat("column ", expr->GetExprString()));
+        }
+        project.kind = ColumnarWindowAgg::kColumn;
+        project.column = column.value();
+        project.output_type = column->type();
+        return project;
+    }
+    if (expr->GetExprType() != node::kExprCall) {
+        return absl::UnimplementedError(absl::StrCat("project ", expr->GetExprString()));
+    }
+    const auto* call = dynamic_cast<const node::CallExprNode*>(expr);
+    std::string fn_name = GetFnName(call);
+    absl::string_view name = fn_name;
+    project.where = absl::ConsumeSuffix(&name, "_where");
+    if (name == "sum") {
+        project.kind = ColumnarWindowAgg::kSum;
+    } else if (name == "avg") {
+        project.kind = ColumnarWindowAgg::kAvg;
+    } else if (name == "count") {
+        project.kind = ColumnarWindowAgg::kCount;
+    } else if (name == "min") {
+        project.kind = ColumnarWindowAgg::kMin;
+    } else if (name == "max") {
+        project.kind = ColumnarWindowAgg::kMax;
+    } else {
+        return absl::UnimplementedError(absl::StrCat("function ", fn_name));
+    }
+
+    size_t arg_cnt = project.where ? 2 : 1;
+    if (call->GetChildNum() != arg_cnt || call->GetChild(0)->GetExprType() != node::kExprColumnRef) {
+        return absl::UnimplementedError(absl::StrCat("project ", expr->GetExprString()));
+    }
+    auto column = ResolvedColumn::Resolve(schemas_ctx, dynamic_cast<const node::ColumnRefNode*>(call->GetChild(0)));
+    if (!column.ok()) {
+        return column.status();
+    }
+    // count only checks the column is null
+    bool any_type = project.kind == ColumnarWindowAgg::kCount && !project.where;
+    if (!any_type && !IsNumeric(column->type())) {
+        return absl::UnimplementedError(
+            absl::StrCat("project ", expr->GetExprString(), " on type ", type::Type_Name(column->type())));
+    }
+    project.column = column.value();
+    if (project.where) {
+        auto status = CheckCond(schemas_ctx, call->GetChild(1));
+        if (!status.ok()) {
+            return status;
+        }
+        auto cond = CompileCond(schemas_ctx, call->GetChild(1));
+        if (!cond.ok()) {
+            return cond.status();
+        }
+        project.cond = std::move(cond).value();
+    }
+    switch (project.kind) {
+        case ColumnarWindowAgg::kCount:
+            project.output_type = type::kInt64;
+            break;
+        case ColumnarWindowAgg::kAvg:
+            project.output_type = type::kDouble;
+            break;
+        default:
+            project.output_type = column->type();
+            break;
+    }
+    return project;
+}
+
+absl::StatusOr<std::unique_ptr<ColumnarWindowAgg>> ColumnarWindowAgg::Build(const ColumnProjects& projects,
+                                                                             const WindowRange& window_range) {
+    if (FLAGS_enable_spark_unsaferow_format) {
+        return absl::UnimplementedError("spark unsafe row format");
+    }
+    // `rows` and `rows_range` windows end at the current row
+    if (window_range.frame_type_ != Window::kFrameRows && window_range.frame_type_ != Window::kFrameRowsRange) {
+        return absl::UnimplementedError("frame type");
+    }
+    if (window_range.end_offset_ != 0 || window_range.end_row_ != 0) {
+        return absl::UnimplementedError("frame not end at current row");
+    }
+    const auto& fn_info = projects.fn_info();
+    const auto* schemas_ctx = fn_info.schemas_ctx();
+    const auto* fn_schema = fn_info.fn_schema();
+    const auto* primary_frame = fn_info.GetPrimaryFrame();
+    if (schemas_ctx == nullptr || primary_frame == nullptr || primary_frame->IsPureHistoryFrame()) {
+        return absl::UnimplementedError("window without primary frame");
+    }
+    if (static_cast<size_t>(fn_schema->size()) != projects.size() || fn_info.GetFrames().size() != projects.size()) {
+        return absl::InternalError("projects mismatch the function");
+    }
+    // a project over other frame runs on a sub window of the primary window
+    const std::string primary_frame_str = primary_frame->GetExprString();
+    for (auto* frame : fn_info.GetFrames()) {
+        if (frame != nullptr && frame->GetExprString() != primary_frame_str) {
+            return absl::UnimplementedError(absl::StrCat("frame ", frame->GetExprString()));
+        }
+    }
+
+    std::vector<Project> kernels;
+    for (size_t i = 0; i < projects.size(); i++) {
+        auto project = BuildProject(schemas_ctx, projects.GetExpr(i));
+        if (!project.ok()) {
+            return project.status();
+        }
+        if (project->output_type != fn_schema->Get(i).type()) {
+            return absl::UnimplementedError(absl::StrCat("output type of ", projects.GetExpr(i)->GetExprString()));
+        }
+        kernels.push_back(std::move(project).value());
+    }
+    return std::unique_ptr<ColumnarWindowAgg>(new ColumnarWindowAgg(*fn_schema, window_range, std::move(kernels)));
+}
+
+// the same window as HistoryWindow::BufferData on the keys when the frame ends at the
+// current row: [starts[i], i] for the i-th row, empty if starts[i] is i + 1
+bool ColumnarWindowAgg::ComputeWindowStarts(const std::vector<uint64_t>& keys, std::vector<size_t>* starts) const {
+    size_t n = keys.size();
+    starts->resize(n);
+    size_t range_start = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0 && keys[i] < keys[i - 1]) {
+            // HistoryWindow refuses to buffer the row
+            return false;
+        }
+        size_t start = 0;
+        if (window_range_.frame_type_ == Window::kFrameRows) {
+            start = window_range_.start_row_ >= i ? 0 : i - window_range_.start_row_;
+        } else {
+            int64_t sub = static_cast<int64_t>(keys[i]) + window_range_.start_offset_;
+            uint64_t start_ts = sub < 0 ? 0u : static_cast<uint64_t>(sub);
+            while (range_start <= i && keys[range_start] < start_ts) {
+                range_start++;
+            }
+            start = range_start;
+        }
+        if (window_range_.max_size_ > 0 && i + 1 > window_range_.max_size_) {
+            start = std::max(start, static_cast<size_t>(i + 1 - window_range_.max_size_));
+        }
+        (*starts)[i] = start;
+    }
+    return true;
+}
+
+// decode the value column of the rows, mask[j] is 1 if the j-th value is aggregated
+template <typename T>
+static bool DecodeColumn(const Project& project, const std::vector<codec::Row>& rows, std::vector<T>* vals,
+                         std::vector<uint8_t>* mask) {
+    size_t n = rows.size();
+    vals->assign(n, T(0));
+    mask->assign(n, 0);
+    for (size_t j = 0; j < n; j++) {
+        T val = T(0);
+        bool valid = project.column.GetValue(rows[j], &val);
+        if (valid && project.where) {
+            auto cond = project.cond->Eval(rows[j]);
+            if (!cond.ok()) {
+                return false;
+            }
+            valid = cond->value_or(false);
+        }
+        if (valid && project.where &&
+            (project.kind == ColumnarWindowAgg::kSum || project.kind == ColumnarWindowAgg::kAvg)) {
+            // sum_where and avg_where update on `value and cond`, where a zero value is false
+            valid = val != T(0);
+        }
+        (*vals)[j] = val;
+        (*mask)[j] = valid ? 1 : 0;
+    }
+    return true;
+}
+
+// the longest window of the rows. Windows up to `kMaxRangeWindow` rows are reduced with the
+// range kernels, longer ones slide over the partition
+static constexpr size_t kMaxRangeWindow = 32;
+
+static size_t MaxWindowSize(const std::vector<size_t>& starts) {
+    size_t max_size = 0;
+    for (size_t i = 0; i < starts.size(); i++) {
+        max_size = std::max(max_size, i + 1 - starts[i]);
+    }
+    return max_size;
+}
+
+// sliding windows: the starts never decrease, so a row enters the window of its own and leaves
+// the window once, the state is updated on the rows entering and leaving instead of reducing
+// the whole window of each row
+
+static void SlideCount(const std::vector<uint8_t>& mask, const std::vector<size_t>& starts,
+                       std::vector<int64_t>* cnts) {
+    size_t n = mask.size();
+    cnts->resize(n);
+    int64_t cnt = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        cnt += mask[i];
+        for (; start < starts[i]; start++) {
+            cnt -= mask[start];
+        }
+        (*cnts)[i] = cnt;
+    }
+}
+
+// the sum is computed as unsigned, add and subtract wrap around, so the sum truncated to T is
+// the same as the jit function
+template <typename T>
+static void SlideSum(const std::vector<T>& vals, const std::vector<uint8_t>& mask, const std::vector<size_t>& starts,
+                     std::vector<int64_t>* sums) {
+    size_t n = vals.size();
+    sums->resize(n);
+    uint64_t sum = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (mask[i]) {
+            sum += static_cast<uint64_t>(static_cast<int64_t>(vals[i]));
+        }
+        for (; start < starts[i]; start++) {
+            if (mask[start]) {
+                sum -= static_cast<uint64_t>(static_cast<int64_t>(vals[start]));
+            }
+        }
+        (*sums)[i] = static_cast<int64_t>(sum);
+    }
+}
+
+// min and max with a monotonic queue of the row indexes, the value of the front is the result.
+// The jit function is order sensitive on equal values, e.g. 0.0 and -0.0 of floating point: min
+// keeps the oldest one, while max, min_where and max_where keep the newest one
+template <typename T>
+static void SlideMinMax(const Project& project, const std::vector<T>& vals, const std::vector<uint8_t>& mask,
+                        const std::vector<size_t>& starts, std::vector<T>* results, std::vector<uint8_t>* is_null) {
+    size_t n = vals.size();
+    bool is_min = project.kind == ColumnarWindowAgg::kMin;
+    bool keep_older = is_min && !project.where;
+    results->resize(n);
+    is_null->assign(n, 1);
+    std::vector<size_t> queue(n);
+    size_t head = 0;
+    size_t tail = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (mask[i]) {
+            T val = vals[i];
+            while (tail > head) {
+                T back = vals[queue[tail - 1]];
+                bool drop = is_min ? (keep_older ? back > val : back >= val) : back <= val;
+                if (!drop) {
+                    break;
+                }
+                tail--;
+            }
+            queue[tail++] = i;
+        }
+        while (head < tail && queue[head] < starts[i]) {
+            head++;
+        }
+        if (head == tail) {
+            continue;
+        }
+        T result = vals[queue[head]];
+        if (!project.where) {
+            // min/max start from the max/lowest value, e.g. min of float inf is the float max
+            T identity = is_min ? std::numeric_limits<T>::max() : std::numeric_limits<T>::lowest();
+            result = is_min ? (identity < result ? identity : result) : (identity < result ? result : identity);
+        }
+        (*results)[i] = result;
+        (*is_null)[i] = 0;
+    }
+}
+
+// integers: sum, min and max are reduced out of order, on values where the masked out ones are
+// replaced by the identity
+template <typename T>
+static void ReduceInts(const Project& project, const std::vector<T>& vals, const std::vector<uint8_t>& mask,
+                       const std::vector<size_t>& starts, bool slide, AggOutput* out) {
+    size_t n = vals.size();
+    out->ints.resize(n);
+    if (slide) {
+        if (project.kind == ColumnarWindowAgg::kSum) {
+            std::vector<int64_t> cnts;
+            SlideCount(mask, starts, &cnts);
+            SlideSum(vals, mask, starts, &out->ints);
+            for (size_t i = 0; i < n; i++) {
+                out->is_null[i] = cnts[i] == 0;
+                out->ints[i] = static_cast<T>(out->ints[i]);
+            }
+        } else {
+            std::vector<T> results;
+            SlideMinMax(project, vals, mask, starts, &results, &out->is_null);
+            std::copy(results.begin(), results.end(), out->ints.begin());
+        }
+        return;
+    }
+    std::vector<T> masked(n);
+    T identity = project.kind == ColumnarWindowAgg::kMin   ? std::numeric_limits<T>::max()
+                 : project.kind == ColumnarWindowAgg::kMax ? std::numeric_limits<T>::lowest()
+                                                           : T(0);
+    for (size_t j = 0; j < n; j++) {
+        masked[j] = mask[j] ? vals[j] : identity;
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t start = starts[i];
+        size_t len = i + 1 - start;
+        out->is_null[i] = CountRange(mask.data() + start, len) == 0;
+        switch (project.kind) {
+            case ColumnarWindowAgg::kSum:
+                out->ints[i] = SumRange(masked.data() + start, len);
+                break;
+            case ColumnarWindowAgg::kMin:
+                out->ints[i] = MinRange(masked.data() + start, len);
+                break;
+            case ColumnarWindowAgg::kMax:
+                out->ints[i] = MaxRange(masked.data() + start, len);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// whether any sum of the aggregated values is exact in double, i.e. the sum of the absolute
+// values is within 2^53, then the jit function that adds them as double in its order gets
+// the same as the integer sum
+template <typename T>
+static bool IsSumExactInDouble(const std::vector<T>& vals, const std::vector<uint8_t>& mask) {
+    constexpr uint64_t kMaxExact = uint64_t(1) << 53;
+    uint64_t abs_sum = 0;
+    for (size_t j = 0; j < vals.size(); j++) {
+        if (!mask[j]) {
+            continue;
+        }
+        int64_t val = static_cast<int64_t>(vals[j]);
+        uint64_t abs_val = val < 0 ? uint64_t(0) - static_cast<uint64_t>(val) : static_cast<uint64_t>(val);
+        if (abs_val > kMaxExact - abs_sum) {
+            return false;
+        }
+        abs_sum += abs_val;
+    }
+    return true;
+}
+
+// avg of integers whose sums are exact in double, see IsSumExactInDouble
+template <typename T>
+static void AvgInts(const std::vector<T>& vals, const std::vector<uint8_t>& mask, const std::vector<size_t>& starts,
+                    bool slide, AggOutput* out) {
+    size_t n = vals.size();
+    std::vector<int64_t> sums;
+    std::vector<int64_t> cnts;
+    if (slide) {
+        SlideSum(vals, mask, starts, &sums);
+        SlideCount(mask, starts, &cnts);
+    } else {
+        std::vector<int64_t> masked(n);
+        for (size_t j = 0; j < n; j++) {
+            masked[j] = mask[j] ? static_cast<int64_t>(vals[j]) : 0;
+        }
+        sums.resize(n);
+        cnts.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            size_t start = starts[i];
+            size_t len = i + 1 - start;
+            sums[i] = SumRange(masked.data() + start, len);
+            cnts[i] = CountRange(mask.data() + start, len);
+        }
+    }
+    out->reals.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        out->is_null[i] = cnts[i] == 0;
+        if (cnts[i] > 0) {
+            out->reals[i] = static_cast<double>(sums[i]) / static_cast<double>(cnts[i]);
+        }
+    }
+}
+
+// floating point values, and the avg of integers whose sums may be inexact in double, are
+// accumulated one by one, newest row first, the same order as the jit function iterates the
+// window. Floating point add and subtract don't cancel, so the sums don't slide
+template <typename T>
+static void ReduceInOrder(const Project& project, const std::vector<T>& vals, const std::vector<uint8_t>& mask,
+                          const std::vector<size_t>& starts, AggOutput* out) {
+    size_t n = vals.size();
+    out->reals.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        size_t start = starts[i];
+        int64_t cnt = 0;
+        double result = 0;
+        switch (project.kind) {
+            case ColumnarWindowAgg::kSum: {
+                T sum = T(0);
+                for (size_t j = i + 1; j-- > start;) {
+                    if (mask[j]) {
+                        sum += vals[j];
+                        cnt++;
+                    }
+                }
+                result = sum;
+                break;
+            }
+            case ColumnarWindowAgg::kAvg: {
+                double sum = 0;
+                for (size_t j = i + 1; j-- > start;) {
+                    if (mask[j]) {
+                        sum += static_cast<double>(vals[j]);
+                        cnt++;
+                    }
+                }
+                result = cnt > 0 ? sum / static_cast<double>(cnt) : 0;
+                break;
+            }
+            case ColumnarWindowAgg::kMin:
+            case ColumnarWindowAgg::kMax: {
+                bool is_min = project.kind == ColumnarWindowAgg::kMin;
+                // min/max start from the max/lowest value, while min_where/max_where start from the first value
+                T acc = is_min ? std::numeric_limits<T>::max() : std::numeric_limits<T>::lowest();
+                for (size_t j = i + 1; j-- > start;) {
+                    if (!mask[j]) {
+                        continue;
+                    }
+                    T val = vals[j];
+                    if (project.where) {
+                        if (cnt == 0 || (is_min ? val < acc : val > acc)) {
+                            acc = val;
+                        }
+                    } else {
+                        acc = is_min ? (acc < val ? acc : val) : (acc < val ? val : acc);
+                    }
+                    cnt++;
+                }
+                result = acc;
+                break;
+            }
+            default:
+                break;
+        }
+        out->is_null[i] = cnt == 0;
+        out->reals[i] = result;
+    }
+}
+
+template <typename T>
+static bool HasNaN(const std::vector<T>& vals, const std::vector<uint8_t>& mask) {
+    for (size_t j = 0; j < vals.size(); j++) {
+        if (mask[j] && std::isnan(vals[j])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+static bool ComputeAgg(const Project& project, const std::vector<codec::Row>& rows, const std::vector<size_t>& starts,
+                       bool slide, AggOutput* out) {
+    std::vector<T> vals;
+    std::vector<uint8_t> mask;
+    if (!DecodeColumn(project, rows, &vals, &mask)) {
+        return false;
+    }
+    out->is_null.assign(rows.size(), 1);
+    if constexpr (std::is_integral_v<T>) {
+        if (project.kind != ColumnarWindowAgg::kAvg) {
+            ReduceInts(project, vals, mask, starts, slide, out);
+            return true;
+        }
+        if (IsSumExactInDouble(vals, mask)) {
+            AvgInts(vals, mask, starts, slide, out);
+            return true;
+        }
+    } else {
+        // NaN is not ordered, the result of the jit function depends on where it is
+        bool is_min_max = project.kind == ColumnarWindowAgg::kMin || project.kind == ColumnarWindowAgg::kMax;
+        if (slide && is_min_max && !HasNaN(vals, mask)) {
+            std::vector<T> results;
+            SlideMinMax(project, vals, mask, starts, &results, &out->is_null);
+            out->reals.assign(results.begin(), results.end());
+            return true;
+        }
+    }
+    ReduceInOrder(project, vals, mask, starts, out);
+    return true;
+}
+
+static bool ComputeCount(const Project& project, const std::vector<codec::Row>& rows,
+                         const std::vector<size_t>& starts, bool slide, AggOutput* out) {
+    size_t n = rows.size();
+    std::vector<uint8_t> mask(n, 0);
+    for (size_t j = 0; j < n; j++) {
+        bool valid = !project.column.IsNull(rows[j]);
+        if (valid && project.where) {
+            auto cond = project.cond->Eval(rows[j]);
+            if (!cond.ok()) {
+                return false;
+            }
+            valid = cond->value_or(false);
+        }
+        mask[j] = valid ? 1 : 0;
+    }
+    out->is_null.assign(n, 0);
+    if (slide) {
+        SlideCount(mask, starts, &out->ints);
+        return true;
+    }
+    out->ints.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        out->ints[i] = CountRange(mask.data() + starts[i], i + 1 - starts[i]);
+    }
+    return true;
+}
+
+static bool AppendColumn(const Project& project, const codec::Row& row, codec::RowBuilder* builder) {
+    const auto& column = project.column;
+    if (column.IsNull(row)) {
+        return builder->AppendNULL();
+    }
+    switch (column.type()) {
+        case type::kBool:
+            return builder->AppendBool(column.GetValueUnsafe<bool>(row));
+        case type::kInt16:
+            return builder->AppendInt16(column.GetValueUnsafe<int16_t>(row));
+        case type::kInt32:
+            return builder->AppendInt32(column.GetValueUnsafe<int32_t>(row));
+        case type::kDate:
+            return builder->AppendDate(column.GetValueUnsafe<int32_t>(row));
+        case type::kInt64:
+            return builder->AppendInt64(column.GetValueUnsafe<int64_t>(row));
+        case type::kTimestamp:
+            return builder->AppendTimestamp(column.GetValueUnsafe<int64_t>(row));
+        case type::kFloat:
+            return builder->AppendFloat(column.GetValueUnsafe<float>(row));
+        case type::kDouble:
+            return builder->AppendDouble(column.GetValueUnsafe<double>(row));
+        case type::kVarchar: {
+            auto str = column.GetValueUnsafe<absl::string_view>(row);
+            return builder->AppendString(str.data(), str.size());
+        }
+        default:
+            return false;
+    }
+}
+
+static bool AppendAgg(const Project& project, const AggOutput& out, size_t i, codec::RowBuilder* builder) {
+    if (out.is_null[i]) {
+        return builder->AppendNULL();
+    }
+    switch (project.output_type) {
+        case type::kInt16:
+            return builder->AppendInt16(static_cast<int16_t>(out.ints[i]));
+        case type::kInt32:
+            return builder->AppendInt32(static_cast<int32_t>(out.ints[i]));
+        case type::kInt64:
+            return builder->AppendInt64(out.ints[i]);
+        case type::kFloat:
+            return builder->AppendFloat(static_cast<float>(out.reals[i]));
+        case type::kDouble:
+            return builder->AppendDouble(out.reals[i]);
+        default:
+            return false;
+    }
+}
+
+bool ColumnarWindowAgg::Run(const std::vector<uint64_t>& keys, const std::vector<codec::Row>& rows,
+                            size_t append_slices, std::vector<codec::Row>* output) const {
+    std::vector<size_t> starts;
+    if (keys.size() != rows.size() || !ComputeWindowStarts(keys, &starts)) {
+        return false;
+    }
+    bool slide = MaxWindowSize(starts) > kMaxRangeWindow;
+    std::vector<AggOutput> outputs(projects_.size());
+    for (size_t p = 0; p < projects_.size(); p++) {
+        const auto& project = projects_[p];
+        bool ok = true;
+        if (project.kind == kColumn) {
+            continue;
+        } else if (project.kind == kCount) {
+            ok = ComputeCount(project, rows, starts, slide, &outputs[p]);
+        } else {
+            switch (project.column.type()) {
+                case type::kInt16:
+                    ok = ComputeAgg<int16_t>(project, rows, starts, slide, &outputs[p]);
+                    break;
+                case type::kInt32:
+                    ok = ComputeAgg<int32_t>(project, rows, starts, slide, &outputs[p]);
+                    break;
+                case type::kInt64:
+                    ok = ComputeAgg<int64_t>(project, rows, starts, slide, &outputs[p]);
+                    break;
+                case type::kFloat:
+                    ok = ComputeAgg<float>(project, rows, starts, slide, &outputs[p]);
+                    break;
+                case type::kDouble:
+                    ok = ComputeAgg<double>(project, rows, starts, slide, &outputs[p]);
+                    break;
+                default:
+                    ok = false;
+                    break;
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    codec::RowBuilder builder(output_schema_);
+    std::vector<codec::Row> results;
+    results.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        uint32_t str_len = 0;
+        for (const auto& project : projects_) {
+            if (project.kind == kColumn && project.column.type() == type::kVarchar && !project.column.IsNull(rows[i])) {
+                str_len += project.column.GetValueUnsafe<absl::string_view>(rows[i]).size();
+            }
+        }
+        uint32_t total_len = builder.CalTotalLength(str_len);
+        int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+        codec::Row out(base::RefCountedSlice::CreateManaged(buf, total_len));
+        if (!builder.SetBuffer(buf, total_len)) {
+            return false;
+        }
+        for (size_t p = 0; p < projects_.size(); p++) {
+            const auto& project = projects_[p];
+            bool ok = project.kind == kColumn ? AppendColumn(project, rows[i], &builder)
+                                              : AppendAgg(project, outputs[p], i, &builder);
+            if (!ok) {
+                return false;
+            }
+        }
+        if (append_slices > 0) {
+            results.emplace_back(append_slices, rows[i], 1, out);
+        } else {
+            results.push_back(out);
+        }
+    }
+    for (auto& row : results) {
+        output->push_back(std::move(row));
+    }
+    return true;
+}
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,109 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: window_agg_kernel.h
+// -----------------------------------------------------------------------------
+//
+// Columnar execution of the batch mode window aggregation in 'WindowAggRunner'.
+// When every project of the window is a column of the current row or one of
+// sum/avg/count/min/max and their `*_where` forms over a column, the rows of a
+// partition are decoded once into typed arrays, and each output row reduces a
+// contiguous range of the arrays instead of running the jit function over the
+// window list row by row.
+//
+// Long windows slide: the frame ends at the current row and its start never goes
+// back, so sum, count and avg keep a running state, adding the row entering the
+// window and subtracting the rows leaving it, while min and max keep a monotonic
+// queue. A partition is then O(n) regardless of the window size.
+//
+// The results are the same as the jit function, including the null results and
+// the order floating point values are accumulated in: newest row first.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef HYBRIDSE_SRC_VM_INTERNAL_WINDOW_AGG_KERNEL_H_
+#define HYBRIDSE_SRC_VM_INTERNAL_WINDOW_AGG_KERNEL_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "codec/row.h"
+#include "vm/internal/agg_union_kernel.h"
+#include "vm/mem_catalog.h"
+#include "vm/physical_op.h"
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+// reduce vals[0, n), T is int16_t, int32_t or int64_t. The sum wraps around as the jit
+// function does. They run with AVX2 if the cpu supports it
+template <typename T>
+T SumRange(const T* vals, size_t n);
+template <typename T>
+T MinRange(const T* vals, size_t n);
+template <typename T>
+T MaxRange(const T* vals, size_t n);
+
+// the sum of mask[0, n), each byte is 0 or 1
+int64_t CountRange(const uint8_t* mask, size_t n);
+
+// whether the kernels above run with AVX2
+bool UseAvx2Kernels();
+
+class ColumnarWindowAgg {
+ public:
+    enum AggKind { kColumn, kSum, kAvg, kCount, kMin, kMax };
+
+    struct Project {
+        AggKind kind = kColumn;
+        // the `*_where` form, `cond` is the compiled condition
+        bool where = false;
+        ResolvedColumn column;
+        std::unique_ptr<CompiledCond> cond;
+        type::Type output_type = type::kNull;
+    };
+
+    // build from the projects of a window aggregation, error if any project, the frame or
+    // the output can't be computed by the columnar kernels, then the jit function is used
+    static absl::StatusOr<std::unique_ptr<ColumnarWindowAgg>> Build(const ColumnProjects& projects,
+                                                                    const WindowRange& window_range);
+
+    // compute the output rows of a partition, `keys` and `rows` are in the order of the
+    // window. Return false if the partition can't run on the columnar kernels, e.g. keys
+    // out of order, the caller should run the jit function on the partition instead
+    bool Run(const std::vector<uint64_t>& keys, const std::vector<codec::Row>& rows, size_t append_slices,
+             std::vector<codec::Row>* output) const;
+
+ private:
+    ColumnarWindowAgg(const codec::Schema& output_schema, const WindowRange& window_range,
+                      std::vector<Project>&& projects)
+        : output_schema_(output_schema), window_range_(window_range), projects_(std::move(projects)) {}
+
+    // the first row in the window of each row
+    bool ComputeWindowStarts(const std::vector<uint64_t>& keys, std::vector<size_t>* starts) const;
+
+    const codec::Schema output_schema_;
+    const WindowRange window_range_;
+    std::vector<Project> projects_;
+};
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_SRC_VM_INTERNAL_WINDOW_AGG_KERNEL_H_
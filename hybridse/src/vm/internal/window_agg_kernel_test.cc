@@ -0,0 +1,443 @@
+// Copyright 2022 4Paradigm Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vm/internal/window_agg_kernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "codec/fe_row_codec.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "vm/engine.h"
+#include "vm/runner.h"
+#include "vm/simple_catalog.h"
+#include "vm/sql_compiler.h"
+
+namespace hybridse {
+namespace vm {
+namespace internal {
+
+class WindowAggKernelTest : public ::testing::Test {};
+
+template <typename T>
+void CheckRanges() {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> dist(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max());
+    // the lengths cover the vector body and the scalar tail
+    for (size_t n : {0, 1, 3, 15, 16, 17, 33, 64, 100, 1027}) {
+        std::vector<T> vals(n);
+        for (auto& v : vals) {
+            v = static_cast<T>(dist(rng));
+        }
+        T sum = 0;
+        T min = std::numeric_limits<T>::max();
+        T max = std::numeric_limits<T>::lowest();
+        for (auto v : vals) {
+            sum = static_cast<T>(static_cast<uint64_t>(sum) + static_cast<uint64_t>(v));
+            min = v < min ? v : min;
+            max = max < v ? v : max;
+        }
+        EXPECT_EQ(sum, SumRange<T>(vals.data(), n)) << "n=" << n;
+        EXPECT_EQ(min, MinRange<T>(vals.data(), n)) << "n=" << n;
+        EXPECT_EQ(max, MaxRange<T>(vals.data(), n)) << "n=" << n;
+    }
+}
+
+TEST_F(WindowAggKernelTest, RangeTest) {
+    LOG(INFO) << "avx2 kernels: " << UseAvx2Kernels();
+    CheckRanges<int16_t>();
+    CheckRanges<int32_t>();
+    CheckRanges<int64_t>();
+}
+
+TEST_F(WindowAggKernelTest, CountRangeTest) {
+    std::mt19937 rng(7);
+    for (size_t n : {0, 1, 31, 32, 33, 255, 4099}) {
+        std::vector<uint8_t> mask(n);
+        int64_t cnt = 0;
+        for (auto& m : mask) {
+            m = rng() & 1;
+            cnt += m;
+        }
+        EXPECT_EQ(cnt, CountRange(mask.data(), n)) << "n=" << n;
+    }
+}
+
+// the numeric columns the kernels aggregate, and the conditions of the `*_where` forms. The
+// constants cast to the column type without loss, or the jit function is used
+static const char* kNumericColumns[] = {"c2", "c3", "c4", "c5", "c6"};
+static const char* kConds[] = {"c3 > 0", "c4 <= 0", "c6 < 0.5", "c8 = 'a'", "c3 != 7"};
+
+class ColumnarWindowAggTest : public ::testing::Test {
+ public:
+    // t(c1 string, c2 int16, c3 int32, c4 int64, c5 float, c6 double, c7 timestamp, c8 string)
+    // without index, so the windows are grouped and sorted by the runners as in offline jobs. The
+    // values are nullable except c1 and c7, and the timestamps of a key are unique, so the rows
+    // of a window are the same however the partition is sorted. Random values, or `monotonic`
+    // runs without NaN for the sliding min/max
+    void BuildTable(size_t key_cnt, size_t rows_per_key, uint32_t seed, bool monotonic = false) {
+        type::Database db;
+        db.set_name("db");
+        auto* table = db.add_tables();
+        table->set_name("t");
+        table->set_catalog("db");
+        const std::vector<type::Type> types = {type::kVarchar, type::kInt16,  type::kInt32,     type::kInt64,
+                                               type::kFloat,   type::kDouble, type::kTimestamp, type::kVarchar};
+        for (size_t i = 0; i < types.size(); i++) {
+            auto* column = table->add_columns();
+            column->set_name(absl::StrCat("c", i + 1));
+            column->set_type(types[i]);
+        }
+        catalog_ = std::make_shared<SimpleCatalog>(true);
+        catalog_->AddDatabase(db);
+
+        std::mt19937_64 rng(seed);
+        auto one_in = [&rng](int n) { return rng() % n == 0; };
+        auto int_val = [&rng, &one_in](int64_t lowest, int64_t max) -> int64_t {
+            // mostly small values, the extremes overflow the sums
+            if (one_in(10)) {
+                return one_in(2) ? lowest : max;
+            }
+            return static_cast<int64_t>(rng() % 201) - 100;
+        };
+        auto real_val = [&rng, &one_in]() -> double {
+            switch (rng() % 16) {
+                case 0:
+                    return 0.0;
+                case 1:
+                    return -0.0;
+                case 2:
+                    // large values make the sums depend on the order they are added in
+                    return one_in(2) ? 1e30 : -1e30;
+                case 3:
+                    if (one_in(8)) {
+                        return std::numeric_limits<double>::quiet_NaN();
+                    }
+                    return 1.0;
+                default:
+                    return std::uniform_real_distribution<double>(-1, 1)(rng);
+            }
+        };
+        const char* strs[] = {"a", "b", ""};
+
+        std::vector<codec::Row> rows;
+        codec::RowBuilder builder(table->columns());
+        for (size_t k = 0; k < key_cnt; k++) {
+            std::string key = absl::StrCat("key", k);
+            int64_t ts = 1000;
+            for (size_t i = 0; i < rows_per_key; i++) {
+                ts += 1 + rng() % 3000;
+                // c2, c3, c4 and c5, c6, nullopt for null
+                std::optional<int64_t> ints[3];
+                std::optional<double> reals[2];
+                const char* c8 = nullptr;
+                if (monotonic) {
+                    // runs of 50 rising and falling values with repeats, so the min or the max
+                    // leaves the window at each row, and every 4th run is null
+                    if (i / 50 % 4 != 3) {
+                        int64_t val = i / 50 % 2 == 0 ? static_cast<int64_t>(i / 3) : -static_cast<int64_t>(i / 3);
+                        ints[0] = ints[1] = ints[2] = val;
+                        reals[0] = reals[1] = i % 7 == 0 ? (i % 14 == 0 ? 0.0 : -0.0) : val * 0.5;
+                    }
+                    c8 = strs[i % 2];
+                } else {
+                    if (!one_in(5)) {
+                        ints[0] = int_val(std::numeric_limits<int16_t>::lowest(), std::numeric_limits<int16_t>::max());
+                    }
+                    if (!one_in(5)) {
+                        ints[1] = int_val(std::numeric_limits<int32_t>::lowest(), std::numeric_limits<int32_t>::max());
+                    }
+                    if (!one_in(5)) {
+                        ints[2] = int_val(std::numeric_limits<int64_t>::lowest(), std::numeric_limits<int64_t>::max());
+                    }
+                    for (auto& real : reals) {
+                        if (!one_in(5)) {
+                            real = real_val();
+                        }
+                    }
+                    if (!one_in(5)) {
+                        c8 = strs[rng() % 3];
+                    }
+                }
+                uint32_t size = builder.CalTotalLength(key.size() + (c8 == nullptr ? 0 : strlen(c8)));
+                int8_t* buf = static_cast<int8_t*>(malloc(size));
+                builder.SetBuffer(buf, size);
+                builder.AppendString(key.data(), key.size());
+                ints[0] ? builder.AppendInt16(static_cast<int16_t>(*ints[0])) : builder.AppendNULL();
+                ints[1] ? builder.AppendInt32(static_cast<int32_t>(*ints[1])) : builder.AppendNULL();
+                ints[2] ? builder.AppendInt64(*ints[2]) : builder.AppendNULL();
+                reals[0] ? builder.AppendFloat(static_cast<float>(*reals[0])) : builder.AppendNULL();
+                reals[1] ? builder.AppendDouble(*reals[1]) : builder.AppendNULL();
+                builder.AppendTimestamp(ts);
+                c8 == nullptr ? builder.AppendNULL() : builder.AppendString(c8, strlen(c8));
+                rows.emplace_back(base::RefCountedSlice::CreateManaged(buf, size));
+            }
+        }
+        // insert the rows of the keys interleaved and out of time order
+        std::shuffle(rows.begin(), rows.end(), rng);
+        ASSERT_TRUE(catalog_->InsertRows("db", "t", rows));
+    }
+
+    static bool HasColumnarAgg(Runner* root) {
+        if (nullptr == root) {
+            return false;
+        }
+        if (root->type_ == kRunnerWindowAgg && dynamic_cast<WindowAggRunner*>(root)->columnar_agg_ != nullptr) {
+            return true;
+        }
+        for (auto runner : root->GetProducers()) {
+            if (HasColumnarAgg(runner)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RunBatch(const std::string& sql, bool columnar, std::vector<codec::Row>* output, codec::Schema* schema) {
+        EngineOptions options;
+        options.SetEnableColumnarWindowAgg(columnar);
+        Engine engine(catalog_, options);
+        BatchRunSession session;
+        base::Status status;
+        ASSERT_TRUE(engine.Get(sql, "db", session, status)) << status.msg;
+        auto compile_info = std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo());
+        ASSERT_TRUE(compile_info != nullptr);
+        ASSERT_EQ(columnar, HasColumnarAgg(compile_info->get_sql_context().cluster_job.GetMainTask().GetRoot()))
+            << sql;
+        ASSERT_EQ(0, session.Run(*output));
+        *schema = session.GetSchema();
+    }
+
+    // the outputs of the columnar kernels are identical to the jit function, down to the bits of
+    // the floating point values
+    void CheckSameAsJit(const std::string& sql) {
+        std::vector<codec::Row> exp_rows;
+        std::vector<codec::Row> rows;
+        codec::Schema schema;
+        ASSERT_NO_FATAL_FAILURE(RunBatch(sql, false, &exp_rows, &schema));
+        ASSERT_NO_FATAL_FAILURE(RunBatch(sql, true, &rows, &schema));
+        ASSERT_EQ(exp_rows.size(), rows.size()) << sql;
+        ASSERT_FALSE(rows.empty());
+        codec::RowView exp_view(schema);
+        codec::RowView view(schema);
+        for (size_t i = 0; i < rows.size(); i++) {
+            exp_view.Reset(exp_rows[i].buf(), exp_rows[i].size());
+            view.Reset(rows[i].buf(), rows[i].size());
+            for (int j = 0; j < schema.size(); j++) {
+                ASSERT_EQ(exp_view.IsNULL(j), view.IsNULL(j))
+                    << sql << "\nrow " << i << " column " << schema.Get(j).name();
+                if (view.IsNULL(j)) {
+                    continue;
+                }
+                if (schema.Get(j).type() == type::kFloat) {
+                    float exp = 0, val = 0;
+                    exp_view.GetFloat(j, &exp);
+                    view.GetFloat(j, &val);
+                    ASSERT_EQ(0, memcmp(&exp, &val, sizeof(float)))
+                        << sql << "\nrow " << i << " column " << schema.Get(j).name() << ": " << exp << " vs " << val;
+                } else if (schema.Get(j).type() == type::kDouble) {
+                    double exp = 0, val = 0;
+                    exp_view.GetDouble(j, &exp);
+                    view.GetDouble(j, &val);
+                    ASSERT_EQ(0, memcmp(&exp, &val, sizeof(double)))
+                        << sql << "\nrow " << i << " column " << schema.Get(j).name() << ": " << exp << " vs " << val;
+                } else {
+                    ASSERT_EQ(exp_view.GetAsString(j), view.GetAsString(j))
+                        << sql << "\nrow " << i << " column " << schema.Get(j).name();
+                }
+            }
+        }
+    }
+
+    // recomputes the window of each output row from the rows of its partition, the frame is the
+    // `rows_preceding` rows before the current one, or the rows in `range_preceding` ms
+    void CheckSameAsRecompute(const std::string& frame, size_t rows_preceding, int64_t range_preceding) {
+        std::string sql = absl::StrCat(
+            "SELECT c1, c7, c4, sum(c4) OVER w AS s, count(c4) OVER w AS cnt, min(c4) OVER w AS mi, "
+            "max(c4) OVER w AS ma, avg(c4) OVER w AS a FROM t WINDOW w AS (PARTITION BY c1 ORDER BY c7 ",
+            frame, ");");
+        std::vector<codec::Row> rows;
+        codec::Schema schema;
+        ASSERT_NO_FATAL_FAILURE(RunBatch(sql, true, &rows, &schema));
+        ASSERT_FALSE(rows.empty());
+        codec::RowView view(schema);
+        // key -> ts -> the output row
+        std::map<std::string, std::map<int64_t, codec::Row>> partitions;
+        for (auto& row : rows) {
+            view.Reset(row.buf(), row.size());
+            int64_t ts = 0;
+            view.GetTimestamp(1, &ts);
+            partitions[view.GetAsString(0)][ts] = row;
+        }
+        size_t slid = 0;
+        for (auto& kv : partitions) {
+            std::vector<std::pair<int64_t, std::optional<int64_t>>> vals;
+            for (auto& ts_row : kv.second) {
+                view.Reset(ts_row.second.buf(), ts_row.second.size());
+                std::optional<int64_t> val;
+                if (!view.IsNULL(2)) {
+                    int64_t v = 0;
+                    view.GetInt64(2, &v);
+                    val = v;
+                }
+                vals.emplace_back(ts_row.first, val);
+            }
+            size_t start = 0;
+            size_t i = 0;
+            for (auto& ts_row : kv.second) {
+                size_t prev_start = start;
+                if (range_preceding > 0) {
+                    while (vals[start].first < ts_row.first - range_preceding) {
+                        start++;
+                    }
+                } else {
+                    start = i > rows_preceding ? i - rows_preceding : 0;
+                }
+                if (i > 0 && start > prev_start) {
+                    // a row entered and at least one left
+                    slid++;
+                }
+                int64_t sum = 0;
+                int64_t cnt = 0;
+                int64_t min = std::numeric_limits<int64_t>::max();
+                int64_t max = std::numeric_limits<int64_t>::lowest();
+                for (size_t j = start; j <= i; j++) {
+                    if (vals[j].second) {
+                        sum += *vals[j].second;
+                        cnt++;
+                        min = std::min(min, *vals[j].second);
+                        max = std::max(max, *vals[j].second);
+                    }
+                }
+                view.Reset(ts_row.second.buf(), ts_row.second.size());
+                std::string msg = absl::StrCat(sql, "\nkey ", kv.first, " row ", i);
+                int64_t val = 0;
+                ASSERT_EQ(0, view.GetInt64(4, &val)) << msg;
+                ASSERT_EQ(cnt, val) << msg;
+                ASSERT_EQ(cnt == 0, view.IsNULL(3)) << msg;
+                ASSERT_EQ(cnt == 0, view.IsNULL(5)) << msg;
+                ASSERT_EQ(cnt == 0, view.IsNULL(6)) << msg;
+                ASSERT_EQ(cnt == 0, view.IsNULL(7)) << msg;
+                if (cnt > 0) {
+                    view.GetInt64(3, &val);
+                    ASSERT_EQ(sum, val) << msg;
+                    view.GetInt64(5, &val);
+                    ASSERT_EQ(min, val) << msg;
+                    view.GetInt64(6, &val);
+                    ASSERT_EQ(max, val) << msg;
+                    double avg = 0;
+                    view.GetDouble(7, &avg);
+                    ASSERT_DOUBLE_EQ(static_cast<double>(sum) / cnt, avg) << msg;
+                }
+                i++;
+            }
+        }
+        ASSERT_GT(slid, 0u);
+    }
+
+    // every aggregate the kernels claim, over every numeric column, on the frame
+    void CheckAllAggs(const std::string& frame) {
+        for (const char* fn : {"sum", "avg", "count", "min", "max"}) {
+            std::vector<std::string> projects = {"c1", "c7"};
+            std::vector<std::string> where_projects = {"c1", "c7"};
+            for (size_t i = 0; i < std::size(kNumericColumns); i++) {
+                projects.push_back(absl::StrCat(fn, "(", kNumericColumns[i], ") OVER w AS r", i));
+                where_projects.push_back(
+                    absl::StrCat(fn, "_where(", kNumericColumns[i], ", ", kConds[i], ") OVER w AS r", i));
+            }
+            if (std::string(fn) == "count") {
+                // count on any type
+                for (const char* col : {"c1", "c7", "c8"}) {
+                    projects.push_back(absl::StrCat("count(", col, ") OVER w AS count_", col));
+                }
+            }
+            for (auto* selects : {&projects, &where_projects}) {
+                std::string sql = absl::StrCat("SELECT ", absl::StrJoin(*selects, ", "),
+                                               " FROM t WINDOW w AS (PARTITION BY c1 ORDER BY c7 ", frame, ");");
+                ASSERT_NO_FATAL_FAILURE(CheckSameAsJit(sql));
+            }
+        }
+    }
+
+ protected:
+    std::shared_ptr<SimpleCatalog> catalog_;
+};
+
+TEST_F(ColumnarWindowAggTest, RowsFrameTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(8, 40, 1));
+    CheckAllAggs("ROWS BETWEEN 3 PRECEDING AND CURRENT ROW");
+}
+
+TEST_F(ColumnarWindowAggTest, RowsRangeFrameTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(8, 40, 2));
+    CheckAllAggs("ROWS_RANGE BETWEEN 5s PRECEDING AND CURRENT ROW");
+}
+
+// windows longer than 32 rows slide the state instead of reducing the ranges
+TEST_F(ColumnarWindowAggTest, SlidingRowsFrameTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(4, 400, 4));
+    CheckAllAggs("ROWS BETWEEN 40 PRECEDING AND CURRENT ROW");
+    CheckAllAggs("ROWS BETWEEN 100 PRECEDING AND CURRENT ROW");
+}
+
+TEST_F(ColumnarWindowAggTest, SlidingRowsRangeFrameTest) {
+    // about 60 rows in a window
+    ASSERT_NO_FATAL_FAILURE(BuildTable(4, 400, 5));
+    CheckAllAggs("ROWS_RANGE BETWEEN 90s PRECEDING AND CURRENT ROW");
+}
+
+TEST_F(ColumnarWindowAggTest, SlidingMinMaxTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(3, 600, 6, true));
+    // shorter and longer than the null runs
+    CheckAllAggs("ROWS BETWEEN 40 PRECEDING AND CURRENT ROW");
+    CheckAllAggs("ROWS BETWEEN 70 PRECEDING AND CURRENT ROW");
+    CheckAllAggs("ROWS_RANGE BETWEEN 90s PRECEDING AND CURRENT ROW");
+}
+
+// the rows enter and leave the frame at each step, and the min or the max leaves with them
+TEST_F(ColumnarWindowAggTest, SlidingRecomputeTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(3, 400, 7, true));
+    CheckSameAsRecompute("ROWS BETWEEN 40 PRECEDING AND CURRENT ROW", 40, 0);
+    CheckSameAsRecompute("ROWS_RANGE BETWEEN 90s PRECEDING AND CURRENT ROW", 0, 90000);
+}
+
+TEST_F(ColumnarWindowAggTest, MixedAggsTest) {
+    ASSERT_NO_FATAL_FAILURE(BuildTable(4, 40, 3));
+    CheckSameAsJit(
+        "SELECT c1, c2, c5, c7, c8, sum(c4) OVER w AS s, avg_where(c3, c6 < 0.5) OVER w AS a, "
+        "count(c8) OVER w AS cnt, min_where(c5, c8 = 'a') OVER w AS mi, max(c6) OVER w AS ma FROM t "
+        "WINDOW w AS (PARTITION BY c1 ORDER BY c7 ROWS BETWEEN 7 PRECEDING AND CURRENT ROW);");
+}
+
+}  // namespace internal
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::GTEST_FLAG(color) = "yes";
+    ::testing::InitGoogleTest(&argc, argv);
+    hybridse::vm::Engine::InitializeGlobalLLVM();
+    return RUN_ALL_TESTS();
+}
@@ -150,8 +150,24 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
 
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (obj_cache_) {
+        // same as the default compile function of LLJIT, with the object cache
+        auto obj_cache = obj_cache_.get();
+        builder.setCompileFunctionCreator(
+            [obj_cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                std::shared_ptr<::llvm::TargetMachine> target_machine = std::move(*tm);
+                ::llvm::orc::SimpleCompiler compiler(*target_machine, obj_cache);
+                return ::llvm::orc::IRCompileLayer::CompileFunction(
+                    [target_machine, compiler](::llvm::Module& m) mutable { return compiler(m); });
+            });
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -251,6 +267,9 @@ bool HybridSeMcJitWrapper::AddModule(
         for (auto& pair : extern_functions_) {
             resolver->addSymbol(pair.first, pair.second);
         }
+        if (obj_cache_) {
+            execution_engine_->setObjectCache(obj_cache_.get());
+        }
     } else {
         execution_engine_->addModule(std::move(module));
     }
@@ -22,6 +22,7 @@
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -88,6 +89,7 @@ std::string LlvmToString(const T& value) {
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(std::shared_ptr<JitObjectCache> obj_cache) : obj_cache_(obj_cache) {}
     ~HybridSeLlvmJitWrapper() {}
 
     bool Init() override;
@@ -105,13 +107,14 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  private:
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
+    std::shared_ptr<JitObjectCache> obj_cache_;
 };
 
 #ifdef LLVM_EXT_ENABLE
 class HybridSeMcJitWrapper : public HybridSeJitWrapper {
  public:
     explicit HybridSeMcJitWrapper(const JitOptions& jit_options)
-        : jit_options_(jit_options) {}
+        : jit_options_(jit_options), obj_cache_(JitObjectCache::Get(jit_options)) {}
     ~HybridSeMcJitWrapper() {}
 
     bool Init() override;
@@ -133,6 +136,7 @@ class HybridSeMcJitWrapper : public HybridSeJitWrapper {
     const JitOptions jit_options_;
     std::string err_str_ = "";
     std::map<std::string, void*> extern_functions_;
+    std::shared_ptr<JitObjectCache> obj_cache_;
     llvm::ExecutionEngine* execution_engine_ = nullptr;
 };
 #endif
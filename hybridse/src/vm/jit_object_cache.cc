@@ -0,0 +1,347 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "boost/filesystem.hpp"
+#include "glog/logging.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+static const char OBJECT_KEY_PREFIX[] = "hybridse_obj_";
+static const char OBJECT_FILE_SUFFIX[] = ".o";
+// a tmp file older than this is left by a crashed writer
+static const std::time_t STALE_TMP_FILE_SECONDS = 3600;
+// the expired entries of pinned_ are swept when it grows to this size
+static const size_t PINNED_SWEEP_SIZE = 64;
+
+JitObjectCache::JitObjectCache(const std::string& dir, uint64_t capacity, uint64_t dir_capacity)
+    : dir_(dir), capacity_(capacity), dir_capacity_(dir_capacity) {
+    if (!dir_.empty()) {
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(dir_, ec);
+        if (ec) {
+            LOG(WARNING) << "fail to create jit object cache dir " << dir_ << ": " << ec.message();
+        }
+        std::lock_guard<std::mutex> lock(dir_mu_);
+        GcDir();
+    }
+}
+
+std::shared_ptr<JitObjectCache> JitObjectCache::Get(const JitOptions& options) {
+    if (options.GetObjCacheCapacity() == 0) {
+        return nullptr;
+    }
+    // one cache for each dir, so the engines of the process share the objects
+    static std::mutex mu;
+    static std::map<std::string, std::shared_ptr<JitObjectCache>> caches;
+    std::lock_guard<std::mutex> lock(mu);
+    auto& cache = caches[options.GetObjCacheDir()];
+    if (!cache) {
+        cache = std::make_shared<JitObjectCache>(options.GetObjCacheDir(), options.GetObjCacheCapacity(),
+                                                 options.GetObjCacheDirCapacity());
+    }
+    return cache;
+}
+
+// the enabled features of the host cpu, e.g. a host without avx512 can't run the code generated on one with it
+static const std::string& GetHostCPUFeatures() {
+    static const std::string features = []() {
+        ::llvm::StringMap<bool> feature_map;
+        std::vector<std::string> enabled;
+        if (::llvm::sys::getHostCPUFeatures(feature_map)) {
+            for (const auto& feature : feature_map) {
+                if (feature.getValue()) {
+                    enabled.push_back(feature.getKey().str());
+                }
+            }
+        }
+        std::sort(enabled.begin(), enabled.end());
+        return absl::StrJoin(enabled, ",");
+    }();
+    return features;
+}
+
+std::string JitObjectCache::GetModuleKey(const ::llvm::Module& m) {
+    std::string ir;
+    ::llvm::raw_string_ostream ss(ir);
+    ss << m;
+    ss.flush();
+
+    ::llvm::SHA1 hasher;
+    hasher.update(ir);
+    // the object is only valid for the same code generator and target
+    hasher.update(LLVM_VERSION_STRING);
+    hasher.update(::llvm::sys::getProcessTriple());
+    hasher.update(::llvm::sys::getHostCPUName());
+    hasher.update(GetHostCPUFeatures());
+    return OBJECT_KEY_PREFIX + ::llvm::toHex(hasher.final(), true);
+}
+
+bool JitObjectCache::IsModuleKey(const std::string& id) {
+    return id.compare(0, sizeof(OBJECT_KEY_PREFIX) - 1, OBJECT_KEY_PREFIX) == 0;
+}
+
+JitObjectCache::PinnedObject JitObjectCache::Pin(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto obj = FindInMemory(key);
+        if (obj) {
+            pinned_[key] = obj;
+            return obj;
+        }
+    }
+    auto obj = LoadFromDisk(key);
+    if (!obj) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    // the object may be loaded by another compile meanwhile
+    auto cur = FindInMemory(key);
+    if (cur) {
+        obj = cur;
+    } else {
+        Insert(key, obj);
+    }
+    if (pinned_.size() >= PINNED_SWEEP_SIZE) {
+        for (auto it = pinned_.begin(); it != pinned_.end();) {
+            it = it->second.expired() ? pinned_.erase(it) : std::next(it);
+        }
+    }
+    pinned_[key] = obj;
+    return obj;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m, ::llvm::MemoryBufferRef obj) {
+    const std::string& key = m->getModuleIdentifier();
+    if (!IsModuleKey(key)) {
+        return;
+    }
+    auto buf = std::make_shared<const std::string>(obj.getBufferStart(), obj.getBufferSize());
+    WriteToDisk(key, *buf);
+    std::lock_guard<std::mutex> lock(mu_);
+    Insert(key, buf);
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(const ::llvm::Module* m) {
+    const std::string& key = m->getModuleIdentifier();
+    if (!IsModuleKey(key)) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto obj = FindInMemory(key);
+        if (obj) {
+            hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+            return ::llvm::MemoryBuffer::getMemBufferCopy(*obj, key);
+        }
+    }
+    auto obj = LoadFromDisk(key);
+    if (!obj) {
+        miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mu_);
+    Insert(key, obj);
+    return ::llvm::MemoryBuffer::getMemBufferCopy(*obj, key);
+}
+
+uint64_t JitObjectCache::GetMemSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return mem_size_;
+}
+
+uint64_t JitObjectCache::GetDirSize() {
+    std::lock_guard<std::mutex> lock(dir_mu_);
+    return dir_size_;
+}
+
+JitObjectCache::PinnedObject JitObjectCache::FindInMemory(const std::string& key) {
+    auto pin_it = pinned_.find(key);
+    if (pin_it != pinned_.end()) {
+        auto obj = pin_it->second.lock();
+        if (obj) {
+            return obj;
+        }
+        pinned_.erase(pin_it);
+    }
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    objects_.splice(objects_.begin(), objects_, it->second);
+    return it->second->second;
+}
+
+void JitObjectCache::Insert(const std::string& key, const PinnedObject& obj) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        objects_.splice(objects_.begin(), objects_, it->second);
+        return;
+    }
+    if (obj->size() > capacity_) {
+        return;
+    }
+    mem_size_ += obj->size();
+    objects_.emplace_front(key, obj);
+    index_.emplace(key, objects_.begin());
+    while (mem_size_ > capacity_) {
+        auto& last = objects_.back();
+        mem_size_ -= last.second->size();
+        index_.erase(last.first);
+        objects_.pop_back();
+    }
+}
+
+std::string JitObjectCache::GetObjectPath(const std::string& key) const {
+    return dir_ + "/" + key + OBJECT_FILE_SUFFIX;
+}
+
+JitObjectCache::PinnedObject JitObjectCache::LoadFromDisk(const std::string& key) {
+    if (dir_.empty()) {
+        return nullptr;
+    }
+    std::string path = GetObjectPath(key);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    if (file.bad()) {
+        LOG(WARNING) << "fail to read jit object " << path;
+        return nullptr;
+    }
+    if (ss.str().empty()) {
+        return nullptr;
+    }
+    // the modification time orders the files for GcDir
+    boost::system::error_code ec;
+    boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+    return std::make_shared<const std::string>(ss.str());
+}
+
+void JitObjectCache::WriteToDisk(const std::string& key, const std::string& obj) {
+    if (dir_.empty() || obj.size() > dir_capacity_) {
+        return;
+    }
+    // write to a tmp file then rename, a reader never sees a partial object
+    std::string path = GetObjectPath(key);
+    std::string tmp_path = absl::StrCat(path, ".tmp.", ::getpid(), ".",
+                                        std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG(WARNING) << "fail to open " << tmp_path;
+            return;
+        }
+        file.write(obj.data(), obj.size());
+        if (!file.good()) {
+            LOG(WARNING) << "fail to write jit object " << tmp_path;
+            file.close();
+            std::remove(tmp_path.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG(WARNING) << "fail to rename " << tmp_path << " to " << path;
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    std::lock_guard<std::mutex> lock(dir_mu_);
+    dir_size_ += obj.size();
+    if (dir_size_ > dir_capacity_) {
+        GcDir();
+    }
+}
+
+void JitObjectCache::GcDir() {
+    struct ObjectFile {
+        std::time_t mtime;
+        uint64_t size;
+        boost::filesystem::path path;
+    };
+    std::vector<ObjectFile> files;
+    uint64_t total = 0;
+    std::time_t now = std::time(nullptr);
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const auto& path = it->path();
+        boost::system::error_code file_ec;
+        std::time_t mtime = boost::filesystem::last_write_time(path, file_ec);
+        if (file_ec || !boost::filesystem::is_regular_file(path, file_ec)) {
+            continue;
+        }
+        std::string name = path.filename().string();
+        if (name.find(".tmp.") != std::string::npos) {
+            if (now - mtime > STALE_TMP_FILE_SECONDS) {
+                boost::filesystem::remove(path, file_ec);
+            }
+            continue;
+        }
+        if (!IsModuleKey(name) || path.extension().string() != OBJECT_FILE_SUFFIX) {
+            continue;
+        }
+        uint64_t size = boost::filesystem::file_size(path, file_ec);
+        if (file_ec) {
+            continue;
+        }
+        files.push_back({mtime, size, path});
+        total += size;
+    }
+    if (ec) {
+        LOG(WARNING) << "fail to list jit object cache dir " << dir_ << ": " << ec.message();
+    }
+    if (total > dir_capacity_) {
+        std::sort(files.begin(), files.end(),
+                  [](const ObjectFile& l, const ObjectFile& r) { return l.mtime < r.mtime; });
+        for (const auto& file : files) {
+            if (total <= dir_capacity_) {
+                break;
+            }
+            boost::system::error_code file_ec;
+            if (boost::filesystem::remove(file.path, file_ec)) {
+                total -= file.size;
+            }
+        }
+    }
+    dir_size_ = total;
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "vm/engine_context.h"
+
+namespace hybridse {
+namespace vm {
+
+// The object code of the compiled modules, shared by all the jits of the process.
+//
+// A module is keyed by the sha1 of its ir before optimization, together with the llvm
+// version and the host cpu, see `GetModuleKey`. The same sql compiles to the same ir,
+// so a deployment created again, or created in another db with the same plan, links the
+// cached object instead of running the optimization and the code generation. Modules
+// whose identifier is not a key are never cached.
+//
+// Objects are kept in memory under an LRU of `capacity` bytes. If `dir` is not empty,
+// they are also written to `dir`, so a restarted process loads them from disk. The files
+// in `dir` are bounded by `dir_capacity` bytes, the least recently used are removed first.
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    // an object held by the compile that skips the optimization for it
+    using PinnedObject = std::shared_ptr<const std::string>;
+
+    JitObjectCache(const std::string& dir, uint64_t capacity, uint64_t dir_capacity = 1024 << 20);
+    ~JitObjectCache() override {}
+
+    // the cache of the process for the jit options, nullptr if the cache is disabled
+    static std::shared_ptr<JitObjectCache> Get(const JitOptions& options);
+
+    static std::string GetModuleKey(const ::llvm::Module& m);
+
+    // the object of the key in memory or on disk, nullptr if it's not cached. While the
+    // returned object is held, `getObject` of the key returns it even if it's evicted
+    PinnedObject Pin(const std::string& key);
+
+    void notifyObjectCompiled(const ::llvm::Module* m, ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(const ::llvm::Module* m) override;
+
+    uint64_t GetHitCount() const { return hit_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetMissCount() const { return miss_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetMemSize();
+    uint64_t GetDirSize();
+
+ private:
+    using ObjectList = std::list<std::pair<std::string, PinnedObject>>;
+
+    static bool IsModuleKey(const std::string& id);
+
+    // the caller should hold mu_
+    PinnedObject FindInMemory(const std::string& key);
+    // the caller should hold mu_
+    void Insert(const std::string& key, const PinnedObject& obj);
+
+    std::string GetObjectPath(const std::string& key) const;
+    PinnedObject LoadFromDisk(const std::string& key);
+    void WriteToDisk(const std::string& key, const std::string& obj);
+    // remove the least recently used files until the dir is within dir_capacity_
+    void GcDir();
+
+    const std::string dir_;
+    const uint64_t capacity_;
+    const uint64_t dir_capacity_;
+
+    std::mutex mu_;
+    // the most recently used object is at the front
+    ObjectList objects_;
+    std::unordered_map<std::string, ObjectList::iterator> index_;
+    // the objects held by the compiles, they stay valid after evicted from objects_
+    std::unordered_map<std::string, std::weak_ptr<const std::string>> pinned_;
+    uint64_t mem_size_ = 0;
+
+    std::mutex dir_mu_;
+    uint64_t dir_size_ = 0;
+
+    std::atomic<uint64_t> hit_cnt_{0};
+    std::atomic<uint64_t> miss_cnt_{0};
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
@@ -26,6 +26,11 @@ int8_t* JitRuntime::AllocManaged(size_t bytes) {
     return reinterpret_cast<int8_t*>(mem_pool_.Alloc(bytes));
 }
 
+void* JitRuntime::AllocAligned(size_t bytes, size_t align) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(mem_pool_.Alloc(bytes + align - 1));
+    return reinterpret_cast<void*>((addr + align - 1) & ~(align - 1));
+}
+
 void JitRuntime::AddManagedObject(base::FeBaseObject* obj) {
     if (obj != nullptr) {
         allocated_obj_pool_.push_back(obj);
@@ -35,13 +40,42 @@ void JitRuntime::AddManagedObject(base::FeBaseObject* obj) {
 void JitRuntime::InitRunStep() {}
 
 void JitRuntime::ReleaseRunStep() {
-    mem_pool_.Reset();
+    // objects in place may refer to the others, destruct in the reverse order of construction
+    for (auto it = in_place_obj_pool_.rbegin(); it != in_place_obj_pool_.rend(); ++it) {
+        (*it)->~FeBaseObject();
+    }
+    in_place_obj_pool_.clear();
     for (base::FeBaseObject* obj : allocated_obj_pool_) {
         if (obj != nullptr) {
             delete obj;
         }
     }
     allocated_obj_pool_.clear();
+
+    size_t used = mem_pool_.allocated_size();
+    auto* counter = GetArenaCounter();
+    if (counter != nullptr) {
+        counter->fetch_add(used, std::memory_order_relaxed);
+    }
+    // follow the high-water mark of recent run steps. It decays slowly, so a run step
+    // smaller than the previous ones reuses the memory instead of reallocating it
+    arena_hint_ = used >= arena_hint_ ? used : arena_hint_ - (arena_hint_ - used) / 16;
+    mem_pool_.Recycle(arena_hint_ < kMaxRetainedArenaSize ? arena_hint_ : kMaxRetainedArenaSize);
+}
+
+ScopedArenaCounter::ScopedArenaCounter(std::atomic<uint64_t>* counter)
+    : runtime_(JitRuntime::get()), counter_(nullptr) {
+    if (counter != nullptr && runtime_->GetArenaCounter() != counter) {
+        runtime_->arena_counter_.store(counter, std::memory_order_relaxed);
+        counter_ = counter;
+    }
+}
+
+ScopedArenaCounter::~ScopedArenaCounter() {
+    if (counter_ != nullptr) {
+        auto* expected = counter_;
+        runtime_->arena_counter_.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+    }
 }
 
 }  // namespace vm
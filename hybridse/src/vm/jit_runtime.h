@@ -16,7 +16,11 @@
 #ifndef HYBRIDSE_SRC_VM_JIT_RUNTIME_H_
 #define HYBRIDSE_SRC_VM_JIT_RUNTIME_H_
 
-#include <list>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "base/fe_object.h"
 #include "base/mem_pool.h"
@@ -48,6 +52,19 @@ class JitRuntime {
      */
     void AddManagedObject(base::FeBaseObject* obj);
 
+    /**
+     * Construct a managed object in place in the run step memory.
+     * The object is destructed by `ReleaseRunStep()`, and its memory
+     * is reused by the next run step.
+     */
+    template <typename T, typename... Args>
+    T* NewManagedObject(Args&&... args) {
+        static_assert(std::is_base_of_v<base::FeBaseObject, T>, "managed object should be a FeBaseObject");
+        T* obj = new (AllocAligned(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        in_place_obj_pool_.push_back(obj);
+        return obj;
+    }
+
     /**
      * Initialize before each single run step
      */
@@ -58,13 +75,52 @@ class JitRuntime {
      */
     void ReleaseRunStep();
 
+    /**
+     * Bytes allocated by the run steps of this thread are added to
+     * the counter set, see `ScopedArenaCounter`.
+     */
+    std::atomic<uint64_t>* GetArenaCounter() const { return arena_counter_.load(std::memory_order_relaxed); }
+
+    // the memory of run steps kept for reuse is sized from the recent high-water mark, up to this size
+    static constexpr size_t kMaxRetainedArenaSize = 1 << 20;
+
  private:
+    friend class ScopedArenaCounter;
+
+    void* AllocAligned(size_t bytes, size_t align);
+
     openmldb::base::ByteMemoryPool mem_pool_;
-    std::list<base::FeBaseObject*> allocated_obj_pool_;
+    // the bytes retained by mem_pool_ after a run step
+    size_t arena_hint_ = 0;
+    std::vector<base::FeBaseObject*> allocated_obj_pool_;
+    std::vector<base::FeBaseObject*> in_place_obj_pool_;
+    // set and reset by ScopedArenaCounter, maybe from another thread
+    std::atomic<std::atomic<uint64_t>*> arena_counter_{nullptr};
 
     static thread_local JitRuntime tls_runtime_inst_;
 };
 
+/**
+ * Count the bytes allocated by the run steps of the current thread into
+ * `counter` within the scope. The scope may end on another thread if the
+ * bthread running it has been blocked, so the counter is reset in the runtime
+ * where it was set, and only if no other scope replaced it. The counter
+ * should outlive the scope.
+ */
+class ScopedArenaCounter {
+ public:
+    explicit ScopedArenaCounter(std::atomic<uint64_t>* counter);
+    ~ScopedArenaCounter();
+
+    ScopedArenaCounter(const ScopedArenaCounter&) = delete;
+    ScopedArenaCounter& operator=(const ScopedArenaCounter&) = delete;
+
+ private:
+    JitRuntime* runtime_;
+    // nullptr if the counter was already set by an outer scope
+    std::atomic<uint64_t>* counter_;
+};
+
 }  // namespace vm
 }  // namespace hybridse
 #endif  // HYBRIDSE_SRC_VM_JIT_RUNTIME_H_
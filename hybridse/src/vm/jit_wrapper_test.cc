@@ -15,10 +15,19 @@
  */
 
 #include "vm/jit_wrapper.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit_object_cache.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
@@ -130,6 +139,93 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_obj_cache) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    EngineOptions options;
+    options.jit_options().SetObjCacheCapacity(64 << 20);
+    options.jit_options().SetObjCacheDir(dir.string());
+    auto obj_cache = JitObjectCache::Get(options.jit_options());
+    ASSERT_TRUE(obj_cache != nullptr);
+
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1, col_2 + 1 as col_3 from t1;";
+    auto compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    ASSERT_EQ(0u, obj_cache->GetHitCount());
+    ASSERT_GT(obj_cache->GetMemSize(), 0u);
+
+    // the same sql compiled by another engine links the cached object
+    auto cached_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(cached_info != nullptr);
+    ASSERT_EQ(1u, obj_cache->GetHitCount());
+
+    auto &sql_context = cached_info->get_sql_context();
+    auto fn = sql_context.physical_plan->GetFnInfos()[0]->fn_ptr();
+    ASSERT_TRUE(fn != nullptr);
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(sql_context.schema, output.buf(), output.size());
+    double c1;
+    int64_t c3;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c3), 0);
+    ASSERT_EQ(c1, 3.14);
+    ASSERT_EQ(c3, 43);
+
+    // a cache of a restarted process loads the object from disk
+    JitObjectCache restarted_cache(dir.string(), 64 << 20);
+    std::string key;
+    for (auto &entry : boost::filesystem::directory_iterator(dir)) {
+        key = entry.path().stem().string();
+    }
+    ASSERT_FALSE(key.empty());
+    ASSERT_TRUE(restarted_cache.Pin(key) != nullptr);
+    ASSERT_TRUE(restarted_cache.Pin(key + "0") == nullptr);
+    boost::filesystem::remove_all(dir);
+}
+
+TEST_F(JitWrapperTest, test_obj_cache_pin_and_gc) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    // room for two objects in memory and three on disk
+    JitObjectCache cache(dir.string(), 200, 300);
+    auto llvm_ctx = std::make_unique<::llvm::LLVMContext>();
+    std::vector<std::unique_ptr<::llvm::Module>> modules;
+    for (int i = 0; i < 5; i++) {
+        auto m = std::make_unique<::llvm::Module>("m" + std::to_string(i), *llvm_ctx);
+        m->setModuleIdentifier(JitObjectCache::GetModuleKey(*m) + std::to_string(i));
+        modules.push_back(std::move(m));
+    }
+    std::string obj(100, 'x');
+    cache.notifyObjectCompiled(modules[0].get(), ::llvm::MemoryBufferRef(obj, "obj"));
+    auto pinned = cache.Pin(modules[0]->getModuleIdentifier());
+    ASSERT_TRUE(pinned != nullptr);
+    for (int i = 1; i < 5; i++) {
+        cache.notifyObjectCompiled(modules[i].get(), ::llvm::MemoryBufferRef(obj, "obj"));
+    }
+    ASSERT_EQ(200u, cache.GetMemSize());
+    ASSERT_EQ(300u, cache.GetDirSize());
+    size_t file_cnt =
+        std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator());
+    ASSERT_EQ(3u, file_cnt);
+    // evicted from memory, but the pinned object is still linked
+    ASSERT_TRUE(cache.getObject(modules[0].get()) != nullptr);
+    pinned.reset();
+    // the files are removed in the order of the modification time in seconds, so any three of them are left.
+    // modules 3 and 4 are in memory, the others are loaded only if their files are left
+    for (int i = 0; i < 3; i++) {
+        bool on_disk = boost::filesystem::exists(dir / (modules[i]->getModuleIdentifier() + ".o"));
+        ASSERT_EQ(on_disk, cache.getObject(modules[i].get()) != nullptr) << i;
+    }
+    boost::filesystem::remove_all(dir);
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.SetKeepIr(true);
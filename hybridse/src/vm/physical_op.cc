@@ -18,7 +18,9 @@
 
 #include <set>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "passes/physical/physical_pass.h"
 
@@ -1327,7 +1329,8 @@ void PhysicalRequestAggUnionNode::Print(std::ostream& output, const std::string&
 }
 
 void PhysicalRequestAggUnionNode::PrintChildren(std::ostream& output, const std::string& tab) const {
-    if (3 != producers_.size() || nullptr == producers_[0] || nullptr == producers_[1] || nullptr == producers_[2]) {
+    if (producers_.size() < 3 ||
+        absl::c_any_of(producers_, [](const PhysicalOpNode* producer) { return producer == nullptr; })) {
         LOG(WARNING) << "fail to print PhysicalRequestAggUnionNode children";
         return;
     }
@@ -1336,6 +1339,10 @@ void PhysicalRequestAggUnionNode::PrintChildren(std::ostream& output, const std:
         output << "\n";
         producers_[i]->Print(output, tab + INDENT);
     }
+    for (auto& window_union : window_unions_.window_unions_) {
+        output << "\n";
+        window_union.first->Print(output, tab + INDENT);
+    }
 }
 
 base::Status PhysicalRequestAggUnionNode::InitSchema(PhysicalPlanContext* ctx) {
@@ -1348,14 +1355,18 @@ base::Status PhysicalRequestAggUnionNode::InitSchema(PhysicalPlanContext* ctx) {
     if (parent_schema_context_) {
         source->SetSchema(parent_schema_context_->GetOutputSchema());
     } else {
-        auto column = agg_schema_.Add();
-        column->set_type(::hybridse::type::kVarchar);
-        column->set_name("agg_val");
+        for (size_t i = 0; i < projects_.size(); i++) {
+            auto column = agg_schema_.Add();
+            column->set_type(::hybridse::type::kVarchar);
+            column->set_name(projects_.size() == 1 ? "agg_val" : absl::StrCat("agg_val_", i));
+        }
         source->SetSchema(&agg_schema_);
     }
 
-    source->SetColumnID(0, ctx->GetNewColumnID());
-    source->SetNonSource(0);
+    for (size_t i = 0; i < projects_.size(); i++) {
+        source->SetColumnID(i, ctx->GetNewColumnID());
+        source->SetNonSource(i);
+    }
     return Status::OK();
 }
 
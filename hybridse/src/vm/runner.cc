@@ -16,7 +16,9 @@
 
 #include "vm/runner.h"
 
+#include <functional>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -33,6 +35,7 @@
 #include "vm/mem_catalog.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_uint64(last_join_hash_max_bytes);
 
 namespace hybridse {
 namespace vm {
@@ -273,6 +276,17 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                                                   join_right_runner);
                         }
                     }
+                    if (enable_columnar_window_agg_ && op->window_unions_.Empty() && op->window_joins_.Empty() &&
+                        !op->instance_not_in_window() && !op->exclude_current_time() &&
+                        !op->exclude_current_row()) {
+                        auto columnar_agg = internal::ColumnarWindowAgg::Build(
+                            op->project(), runner->instance_window_gen_.range_gen_.window_range_);
+                        if (columnar_agg.ok()) {
+                            runner->SetColumnarAgg(std::move(columnar_agg).value());
+                        } else {
+                            DLOG(INFO) << "window aggregation runs on the jit function: " << columnar_agg.status();
+                        }
+                    }
                     return RegisterTask(node,
                                         UnaryInheritTask(cluster_task, runner));
                 }
@@ -562,26 +576,43 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
         LOG(WARNING) << status;
         return fail;
     }
-    auto agg_table_task = Build(node->producers().at(2), status);
-    auto agg_table = agg_table_task.GetRoot();
-    if (!agg_table_task.IsValid()) {
-        status.msg = "fail to build agg_table input runner";
-        status.code = common::kExecutionPlanError;
-        LOG(WARNING) << status;
-        return fail;
-    }
     auto op = dynamic_cast<const PhysicalRequestAggUnionNode*>(node);
+    std::vector<ClusterTask> agg_table_tasks;
+    for (size_t i = 0; i < op->GetAggrTableCnt(); i++) {
+        auto agg_table_task = Build(node->producers().at(2 + i), status);
+        if (!agg_table_task.IsValid()) {
+            status.msg = "fail to build agg_table input runner";
+            status.code = common::kExecutionPlanError;
+            LOG(WARNING) << status;
+            return fail;
+        }
+        agg_table_tasks.push_back(agg_table_task);
+    }
     RequestAggUnionRunner* runner = nullptr;
     CreateRunner<RequestAggUnionRunner>(&runner, id_++, node->schemas_ctx(), op->GetLimitCnt(), op->window().range_,
-                                        op->exclude_current_time(), op->output_request_row(), op->project_);
+                                        op->exclude_current_time(), op->output_request_row(), op->projects_,
+                                        op->aggr_idx_);
     Key index_key;
     if (!op->instance_not_in_window()) {
         index_key = op->window_.index_key();
         runner->AddWindowUnion(op->window_, base_table);
-        runner->AddWindowUnion(op->agg_window_, agg_table);
+        for (size_t i = 0; i < agg_table_tasks.size(); i++) {
+            runner->AddWindowUnion(op->agg_windows_[i], agg_table_tasks[i].GetRoot());
+        }
+        for (auto window_union : op->window_unions_.window_unions_) {
+            auto union_task = Build(window_union.first, status);
+            auto union_table = union_task.GetRoot();
+            if (nullptr == union_table) {
+                return fail;
+            }
+            runner->AddWindowUnion(window_union.second, union_table);
+        }
+    }
+    std::vector<const ClusterTask*> tasks = {&request_task, &base_table_task};
+    for (auto& agg_table_task : agg_table_tasks) {
+        tasks.push_back(&agg_table_task);
     }
-    auto task = RegisterTask(node, MultipleInherit({&request_task, &base_table_task, &agg_table_task}, runner,
-                                                   index_key, kRightBias));
+    auto task = RegisterTask(node, MultipleInherit(tasks, runner, index_key, kRightBias));
     if (!runner->InitAggregator()) {
         return fail;
     } else {
@@ -589,6 +620,57 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
     }
 }
 
+// the runners that scan windows, join tables or query remote tablets under the runner
+static void CollectHeavyRunners(Runner* runner, std::set<Runner*>* heavy_runners) {
+    if (runner == nullptr || heavy_runners->find(runner) != heavy_runners->end()) {
+        return;
+    }
+    switch (runner->type_) {
+        case kRunnerRequestUnion:
+        case kRunnerRequestAggUnion:
+        case kRunnerRequestLastJoin:
+        case kRunnerRequestRunProxy:
+            heavy_runners->insert(runner);
+            break;
+        default:
+            break;
+    }
+    for (auto* producer : runner->GetProducers()) {
+        CollectHeavyRunners(producer, heavy_runners);
+    }
+}
+
+void RunnerBuilder::MarkParallelProducers(Runner* runner, std::set<Runner*>* visited) {
+    if (runner == nullptr || !visited->insert(runner).second) {
+        return;
+    }
+    const auto& producers = runner->GetProducers();
+    if (producers.size() > 1) {
+        // a heavy runner shared by the producers would run twice, it is cached but the
+        // producers race on the cache
+        std::set<Runner*> all_heavy;
+        size_t heavy_producers = 0;
+        bool disjoint = true;
+        for (auto* producer : producers) {
+            std::set<Runner*> heavy;
+            CollectHeavyRunners(producer, &heavy);
+            if (heavy.empty()) {
+                continue;
+            }
+            heavy_producers++;
+            for (auto* heavy_runner : heavy) {
+                disjoint &= all_heavy.insert(heavy_runner).second;
+            }
+        }
+        if (heavy_producers > 1 && disjoint) {
+            runner->EnableParallelProducers();
+        }
+    }
+    for (auto* producer : producers) {
+        MarkParallelProducers(producer, visited);
+    }
+}
+
 ClusterTask RunnerBuilder::BinaryInherit(const ClusterTask& left,
                                          const ClusterTask& right,
                                          Runner* runner, const Key& index_key,
@@ -1113,7 +1195,11 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
             }
             inputs.push_back(batch_inputs[producer_idx]->Get(idx));
         }
-        auto res = Run(ctx, inputs);
+        std::shared_ptr<DataHandler> res;
+        {
+            ScopedArenaCounter arena_counter(ctx.arena_counter());
+            res = Run(ctx, inputs);
+        }
         if (need_batch_cache_) {
             if (ctx.is_debug()) {
                 std::ostringstream oss;
@@ -1159,11 +1245,25 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
         }
     }
     std::vector<std::shared_ptr<DataHandler>> inputs(producers_.size());
-    for (size_t idx = producers_.size(); idx > 0; idx--) {
-        inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
+    auto* executor = ctx.parallel_executor();
+    if (parallel_producers_ && executor != nullptr) {
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(producers_.size());
+        for (size_t idx = 0; idx < producers_.size(); idx++) {
+            tasks.emplace_back([this, idx, &inputs, &ctx]() { inputs[idx] = producers_[idx]->RunWithCache(ctx); });
+        }
+        executor->RunAll(tasks);
+    } else {
+        for (size_t idx = producers_.size(); idx > 0; idx--) {
+            inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
+        }
     }
 
-    auto res = Run(ctx, inputs);
+    std::shared_ptr<DataHandler> res;
+    {
+        ScopedArenaCounter arena_counter(ctx.arena_counter());
+        res = Run(ctx, inputs);
+    }
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << "\n";
@@ -1472,6 +1572,10 @@ void WindowAggRunner::RunWindowAggOnKey(
         return;
     }
 
+    if (columnar_agg_ && RunColumnarAggOnSegment(instance_segment, output_table)) {
+        return;
+    }
+
     auto instance_segment_iter = instance_segment->GetIterator();
     if (!instance_segment_iter) {
         LOG(WARNING) << "Instance Segment is Empty";
@@ -1561,6 +1665,37 @@ void WindowAggRunner::RunWindowAggOnKey(
     }
 }
 
+// Run the window of the segment on the columnar kernels, the window has no union or join.
+// Nothing is outputed if it returns false, and the segment runs on the jit function then
+bool WindowAggRunner::RunColumnarAggOnSegment(std::shared_ptr<TableHandler> instance_segment,
+                                              std::shared_ptr<MemTableHandler> output_table) {
+    auto iter = instance_segment->GetIterator();
+    if (!iter) {
+        return false;
+    }
+    int32_t cnt = output_table->GetCount();
+    std::vector<uint64_t> keys;
+    std::vector<Row> rows;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        if (limit_cnt_.has_value() && cnt + static_cast<int32_t>(rows.size()) >= limit_cnt_.value()) {
+            break;
+        }
+        if (iter->GetValue().empty()) {
+            return false;
+        }
+        keys.push_back(iter->GetKey());
+        rows.push_back(iter->GetValue());
+    }
+    std::vector<Row> outputs;
+    if (!columnar_agg_->Run(keys, rows, append_slices_, &outputs)) {
+        return false;
+    }
+    for (auto& row : outputs) {
+        output_table->AddRow(row);
+    }
+    return true;
+}
+
 std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {  // NOLINT
@@ -1609,6 +1744,15 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
 
     switch (left->GetHandlerType()) {
         case kTableHandler: {
+            auto left_table = std::dynamic_pointer_cast<TableHandler>(left);
+            if (join_gen_.right_group_gen_.Valid() && kTableHandler == right->GetHandlerType()) {
+                auto output_table = std::make_shared<MemTimeTableHandler>();
+                output_table->SetOrderType(left_table->GetOrderType());
+                if (join_gen_.TableHashJoin(left_table, std::dynamic_pointer_cast<TableHandler>(right), parameter,
+                                            output_table)) {
+                    return output_table;
+                }
+            }
             if (join_gen_.right_group_gen_.Valid()) {
                 right = join_gen_.right_group_gen_.Partition(right, parameter);
             }
@@ -1616,7 +1760,6 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
                 LOG(WARNING) << "fail to run last join: right partition is empty";
                 return fail_ptr;
             }
-            auto left_table = std::dynamic_pointer_cast<TableHandler>(left);
 
             auto output_table =
                 std::shared_ptr<MemTimeTableHandler>(new MemTimeTableHandler());
@@ -1641,6 +1784,16 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
             return output_table;
         }
         case kPartitionHandler: {
+            auto left_partition =
+                std::dynamic_pointer_cast<PartitionHandler>(left);
+            if (join_gen_.right_group_gen_.Valid() && kTableHandler == right->GetHandlerType()) {
+                auto output_partition = std::make_shared<MemPartitionHandler>();
+                output_partition->SetOrderType(left_partition->GetOrderType());
+                if (join_gen_.PartitionHashJoin(left_partition, std::dynamic_pointer_cast<TableHandler>(right),
+                                                parameter, output_partition)) {
+                    return output_partition;
+                }
+            }
             if (join_gen_.right_group_gen_.Valid()) {
                 right = join_gen_.right_group_gen_.Partition(right, parameter);
             }
@@ -1650,8 +1803,6 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
             }
             auto output_partition =
                 std::shared_ptr<MemPartitionHandler>(new MemPartitionHandler());
-            auto left_partition =
-                std::dynamic_pointer_cast<PartitionHandler>(left);
             output_partition->SetOrderType(left_partition->GetOrderType());
             if (kPartitionHandler == right->GetHandlerType()) {
                 if (!join_gen_.PartitionJoin(
@@ -2022,13 +2173,7 @@ bool JoinGenerator::TableJoin(std::shared_ptr<TableHandler> left,
     left_iter->SeekToFirst();
     while (left_iter->Valid()) {
         const Row& left_row = left_iter->GetValue();
-        std::string key_str =
-            index_key_gen_.Valid() ? index_key_gen_.Gen(left_row, parameter) : "";
-        if (left_key_gen_.Valid()) {
-            key_str = key_str.empty()
-                          ? left_key_gen_.Gen(left_row, parameter)
-                          : key_str + "|" + left_key_gen_.Gen(left_row, parameter);
-        }
+        std::string key_str = LeftJoinKey(left_row, parameter);
         DLOG(INFO) << "key_str " << key_str;
         auto right_table = right->GetSegment(key_str);
         output->AddRow(left_iter->GetKey(), Runner::RowLastJoinTable(left_slices_, left_row, right_slices_, right_table,
@@ -2101,16 +2246,7 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
         left_iter->SeekToFirst();
         while (left_iter->Valid()) {
             const Row& left_row = left_iter->GetValue();
-
-            std::string key_str = "";
-            if (index_key_gen_.Valid()) {
-                key_str = index_key_gen_.Gen(left_row, parameter);
-            }
-            if (left_key_gen_.Valid()) {
-                key_str = key_str.empty() ? left_key_gen_.Gen(left_row, parameter) :
-                                          key_str.append("|").append(left_key_gen_.Gen(left_row, parameter));
-            }
-            auto right_table = right->GetSegment(key_str);
+            auto right_table = right->GetSegment(LeftJoinKey(left_row, parameter));
             auto left_key_str = std::string(
                 reinterpret_cast<const char*>(left_key.buf()), left_key.size());
             output->AddRow(left_key_str, left_iter->GetKey(),
@@ -2123,6 +2259,130 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
     }
     return true;
 }
+std::string JoinGenerator::LeftJoinKey(const Row& left_row, const Row& parameter) {
+    std::string key_str = index_key_gen_.Valid() ? index_key_gen_.Gen(left_row, parameter) : "";
+    if (left_key_gen_.Valid()) {
+        key_str = key_str.empty() ? left_key_gen_.Gen(left_row, parameter)
+                                  : key_str + "|" + left_key_gen_.Gen(left_row, parameter);
+    }
+    return key_str;
+}
+
+bool JoinGenerator::BuildLastJoinHashTable(std::shared_ptr<TableHandler> right, const Row& parameter,
+                                           LastJoinHashTable* hash_table) {
+    if (!right || !right_group_gen_.Valid() || FLAGS_last_join_hash_max_bytes == 0) {
+        return false;
+    }
+    bool sorted = right_sort_gen_.Valid();
+    // without an order key, the sort follows the order type of the right table, leave it to the partition join
+    if (sorted && !right_sort_gen_.order_gen().Valid()) {
+        return false;
+    }
+    // the last join picks the first row of the segment sorted in the reverse order. The order keys
+    // compare as uint64 as SortGenerator does, so the two joins agree on negative keys
+    bool desc = sorted && right_sort_gen_.is_asc();
+    auto before = [desc](uint64_t lhs, uint64_t rhs) { return desc ? lhs > rhs : lhs < rhs; };
+    auto iter = right->GetIterator();
+    if (!iter) {
+        return false;
+    }
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        const Row& row = iter->GetValue();
+        uint64_t order = sorted ? static_cast<uint64_t>(right_sort_gen_.GenOrderKey(row)) : 0;
+        auto res = hash_table->buckets.try_emplace(right_group_gen_.GetKey(row, parameter));
+        auto& bucket = res.first->second;
+        if (res.second) {
+            hash_table->memory_bytes += sizeof(std::string) + res.first->first.size() + sizeof(bucket);
+        }
+        if (!condition_gen_.Valid() && !bucket.empty()) {
+            // only the first row in order can be picked without a condition
+            if (sorted && before(order, bucket[0].first)) {
+                bucket[0] = std::make_pair(order, row);
+            }
+            continue;
+        }
+        bucket.emplace_back(order, row);
+        hash_table->memory_bytes += sizeof(std::pair<uint64_t, Row>);
+        if (hash_table->memory_bytes > FLAGS_last_join_hash_max_bytes) {
+            LOG(WARNING) << "last join hash table exceeds " << FLAGS_last_join_hash_max_bytes
+                         << " bytes, fall back to partition join";
+            return false;
+        }
+    }
+    if (sorted && condition_gen_.Valid()) {
+        for (auto& kv : hash_table->buckets) {
+            std::stable_sort(kv.second.begin(), kv.second.end(),
+                             [&before](const std::pair<uint64_t, Row>& lhs, const std::pair<uint64_t, Row>& rhs) {
+                                 return before(lhs.first, rhs.first);
+                             });
+        }
+    }
+    DLOG(INFO) << "last join hash table of " << hash_table->buckets.size() << " keys, "
+               << hash_table->memory_bytes << " bytes";
+    return true;
+}
+
+Row JoinGenerator::RowLastJoinHash(const Row& left_row, const LastJoinHashTable& hash_table,
+                                   const Row& parameter) {
+    auto it = hash_table.buckets.find(LeftJoinKey(left_row, parameter));
+    if (it != hash_table.buckets.end()) {
+        for (auto& kv : it->second) {
+            Row joined_row(left_slices_, left_row, right_slices_, kv.second);
+            if (!condition_gen_.Valid() || condition_gen_.Gen(joined_row, parameter)) {
+                return joined_row;
+            }
+        }
+    }
+    return Row(left_slices_, left_row, right_slices_, Row());
+}
+
+bool JoinGenerator::TableHashJoin(std::shared_ptr<TableHandler> left, std::shared_ptr<TableHandler> right,
+                                  const Row& parameter, std::shared_ptr<MemTimeTableHandler> output) {
+    LastJoinHashTable hash_table;
+    if (!BuildLastJoinHashTable(right, parameter, &hash_table)) {
+        return false;
+    }
+    auto left_iter = left->GetIterator();
+    if (!left_iter) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+    for (left_iter->SeekToFirst(); left_iter->Valid(); left_iter->Next()) {
+        output->AddRow(left_iter->GetKey(), RowLastJoinHash(left_iter->GetValue(), hash_table, parameter));
+    }
+    return true;
+}
+
+bool JoinGenerator::PartitionHashJoin(std::shared_ptr<PartitionHandler> left, std::shared_ptr<TableHandler> right,
+                                      const Row& parameter, std::shared_ptr<MemPartitionHandler> output) {
+    if (!left) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+    auto left_partition_iter = left->GetWindowIterator();
+    if (!left_partition_iter) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+    LastJoinHashTable hash_table;
+    if (!BuildLastJoinHashTable(right, parameter, &hash_table)) {
+        return false;
+    }
+    for (left_partition_iter->SeekToFirst(); left_partition_iter->Valid(); left_partition_iter->Next()) {
+        auto left_iter = left_partition_iter->GetValue();
+        if (!left_iter) {
+            continue;
+        }
+        auto left_key = left_partition_iter->GetKey();
+        auto left_key_str = std::string(reinterpret_cast<const char*>(left_key.buf()), left_key.size());
+        for (left_iter->SeekToFirst(); left_iter->Valid(); left_iter->Next()) {
+            output->AddRow(left_key_str, left_iter->GetKey(),
+                           RowLastJoinHash(left_iter->GetValue(), hash_table, parameter));
+        }
+    }
+    return true;
+}
+
 const Row Runner::RowLastJoinTable(size_t left_slices, const Row& left_row,
                                    size_t right_slices,
                                    std::shared_ptr<TableHandler> right_table,
@@ -2666,48 +2926,124 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
 }
 
 bool RequestAggUnionRunner::InitAggregator() {
-    auto func_name = func_->GetName();
-    auto type_it = agg_type_map_.find(func_name);
-    if (type_it == agg_type_map_.end()) {
-        LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_name;
-        return false;
+    for (auto& agg_project : agg_projects_) {
+        auto func_name = agg_project.func->GetName();
+        auto type_it = agg_type_map_.find(func_name);
+        if (type_it == agg_type_map_.end()) {
+            LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_name;
+            return false;
+        }
+
+        agg_project.agg_type = type_it->second;
+        if (agg_project.agg_col->GetExprType() == node::kExprColumnRef) {
+            agg_project.agg_col_type = producers_[1]->row_parser()->GetType(agg_project.agg_col_name);
+        } else if (agg_project.agg_col->GetExprType() == node::kExprAll) {
+            if (agg_project.agg_type != kCount && agg_project.agg_type != kCountWhere) {
+                LOG(ERROR) << "only support " << ExprTypeName(agg_project.agg_col->GetExprType()) << "on count op";
+                return false;
+            }
+            agg_project.agg_col_type = type::Type::kInt64;
+        } else {
+            LOG(ERROR) << "non-support aggr expr type " << ExprTypeName(agg_project.agg_col->GetExprType());
+            return false;
+        }
+
+        size_t idx = &agg_project - agg_projects_.data();
+        if (static_cast<int>(idx) >= output_schemas_->GetOutputSchema()->size()) {
+            LOG(ERROR) << "RequestAggUnionRunner output schema size mismatch";
+            return false;
+        }
+        agg_project.output_schema.Add()->CopyFrom(output_schemas_->GetOutputSchema()->Get(idx));
+        if (!InitMergeKernel(&agg_project)) {
+            return false;
+        }
     }
+    return true;
+}
 
-    agg_type_ = type_it->second;
-    if (agg_col_->GetExprType() == node::kExprColumnRef) {
-        agg_col_type_ = producers_[1]->row_parser()->GetType(agg_col_name_);
-    } else if (agg_col_->GetExprType() == node::kExprAll) {
-        if (agg_type_ != kCount && agg_type_ != kCountWhere) {
-            LOG(ERROR) << "only support " << ExprTypeName(agg_col_->GetExprType()) << "on count op";
+bool RequestAggUnionRunner::InitMergeKernel(AggProject* agg_project) {
+    const auto base_schemas_ctx = producers_[1]->output_schemas();
+    const auto agg_schemas_ctx = producers_[2 + agg_project->aggr_idx]->output_schemas();
+    if (!agg_project->agg_col_name.empty()) {
+        auto col = internal::ResolvedColumn::Resolve(base_schemas_ctx, agg_project->agg_col_name);
+        if (!col.ok()) {
+            LOG(ERROR) << "fail to resolve aggr column " << agg_project->agg_col_name << ": " << col.status();
             return false;
         }
-        agg_col_type_ = type::Type::kInt64;
-    } else {
-        LOG(ERROR) << "non-support aggr expr type " << ExprTypeName(agg_col_->GetExprType());
-        return false;
+        agg_project->base_agg_col = col.value();
+    }
+    // count(col) only skips the null values of col
+    if (agg_project->agg_type != kCount && agg_project->agg_type != kCountWhere) {
+        auto aggregator = CreateAggregator(*agg_project);
+        if (!aggregator) {
+            return false;
+        }
+        agg_project->base_update_fn =
+            internal::GetBaseUpdateFn(agg_project->base_agg_col.type(), aggregator->GetRepType());
+        if (agg_project->base_update_fn == nullptr) {
+            LOG(ERROR) << "RequestAggUnionRunner does not support " << agg_project->func->GetName() << " on "
+                       << Type_Name(agg_project->base_agg_col.type());
+            return false;
+        }
+    }
+
+    for (auto& [name, col] : {std::make_pair("agg_val", &agg_project->agg_val_col),
+                              std::make_pair("ts_end", &agg_project->ts_end_col),
+                              std::make_pair("num_rows", &agg_project->num_rows_col)}) {
+        auto resolved = internal::ResolvedColumn::Resolve(agg_schemas_ctx, name);
+        if (!resolved.ok()) {
+            LOG(ERROR) << "fail to resolve column " << name << " of pre-aggr table: " << resolved.status();
+            return false;
+        }
+        *col = resolved.value();
+    }
+
+    auto cond = agg_project->cond;
+    if (cond != nullptr) {
+        auto filter_key = internal::ResolvedColumn::Resolve(agg_schemas_ctx, "filter_key");
+        if (!filter_key.ok()) {
+            LOG(ERROR) << "fail to resolve column filter_key of pre-aggr table: " << filter_key.status();
+            return false;
+        }
+        agg_project->filter_key_col = filter_key.value();
+
+        // the interpreter is kept for the conditions out of the kernels
+        auto base_cond = internal::CompileCond(base_schemas_ctx, cond);
+        if (base_cond.ok()) {
+            agg_project->base_cond = std::move(base_cond).value();
+        } else {
+            DLOG(INFO) << "evaluate " << cond->GetExprString() << " by interpreter: " << base_cond.status();
+        }
+        auto agg_cond = internal::CompileCondWithAggRow(agg_schemas_ctx, cond, "filter_key");
+        if (agg_cond.ok()) {
+            agg_project->agg_cond = std::move(agg_cond).value();
+        } else {
+            DLOG(INFO) << "evaluate " << cond->GetExprString() << " by interpreter: " << agg_cond.status();
+        }
     }
     return true;
 }
 
-std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const {
-    switch (agg_type_) {
+std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator(const AggProject& agg_project) const {
+    const auto& output_schema = agg_project.output_schema;
+    switch (agg_project.agg_type) {
         case kSum:
         case kSumWhere:
-            return MakeOverflowAggregator<SumAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+            return MakeOverflowAggregator<SumAggregator>(agg_project.agg_col_type, output_schema);
         case kAvg:
         case kAvgWhere:
-            return std::make_unique<AvgAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+            return std::make_unique<AvgAggregator>(agg_project.agg_col_type, output_schema);
         case kCount:
         case kCountWhere:
-            return std::make_unique<CountAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+            return std::make_unique<CountAggregator>(agg_project.agg_col_type, output_schema);
         case kMin:
         case kMinWhere:
-            return MakeSameTypeAggregator<MinAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+            return MakeSameTypeAggregator<MinAggregator>(agg_project.agg_col_type, output_schema);
         case kMax:
         case kMaxWhere:
-            return MakeSameTypeAggregator<MaxAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+            return MakeSameTypeAggregator<MaxAggregator>(agg_project.agg_col_type, output_schema);
         default:
-            LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_->GetName();
+            LOG(ERROR) << "RequestAggUnionRunner does not support for op " << agg_project.func->GetName();
             return nullptr;
     }
 }
@@ -2738,22 +3074,25 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
     if (ctx.is_debug()) {
         for (size_t i = 0; i < union_inputs.size(); i++) {
             std::ostringstream sss;
-            PrintData(sss, producers_[i + 1]->output_schemas(), union_inputs[i]);
+            PrintData(sss, windows_union_gen_.input_runners_[i]->output_schemas(), union_inputs[i]);
             LOG(INFO) << "union input " << i << ":\n" << sss.str();
         }
     }
 
     auto& key_gen = windows_union_gen_.windows_gen_[0].index_seek_gen_.index_key_gen_;
     std::string key = key_gen.Gen(request, ctx.GetParameterRow());
-    // do not use codegen to gen the union outputs for aggr segment
-    union_inputs.pop_back();
 
-    auto union_segments =
-        windows_union_gen_.GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
-    // code_gen result of agg_segment is not correct. we correct the result here
-    auto agg_segment = std::dynamic_pointer_cast<PartitionHandler>(union_inputs[1])->GetSegment(key);
-    if (agg_segment) {
-        union_segments.emplace_back(agg_segment);
+    // do not use codegen to gen the union outputs for aggr segments, the code_gen result of
+    // agg_segment is not correct. we get the segments of the aggr tables by the key of the raw table
+    std::vector<std::shared_ptr<TableHandler>> union_segments(union_inputs.size());
+    auto& windows_gen = windows_union_gen_.windows_gen_;
+    for (size_t i = 0; i < union_inputs.size(); i++) {
+        if (i >= 1 && i <= aggr_table_cnt_) {
+            auto partition = std::dynamic_pointer_cast<PartitionHandler>(union_inputs[i]);
+            union_segments[i] = partition ? partition->GetSegment(key) : nullptr;
+        } else {
+            union_segments[i] = windows_gen[i].GetRequestWindow(request, ctx.GetParameterRow(), union_inputs[i]);
+        }
     }
 
     if (ctx.is_debug()) {
@@ -2761,170 +3100,161 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
             if (!union_segments[i]) continue;
 
             std::ostringstream sss;
-            PrintData(sss, producers_[i + 1]->output_schemas(), union_segments[i]);
+            PrintData(sss, windows_union_gen_.input_runners_[i]->output_schemas(), union_segments[i]);
             LOG(INFO) << "union output " << i << ":\n" << sss.str();
         }
     }
 
-    std::shared_ptr<TableHandler> window;
-    if (agg_segment) {
-        window = RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, output_request_row_,
-                                    exclude_current_time_);
-    } else {
-        LOG(WARNING) << "Aggr segment is empty. Fall back to normal RequestUnionRunner";
-        // NOTE: normal request union should always `output_request_row`, while the `output_request_row_`
-        // here indicate whether `EXCLUDE CURRENT_ROW`
-        window = RequestUnionRunner::RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, true,
-                                                        exclude_current_time_, !output_request_row_);
-    }
-
-    return window;
+    return RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, output_request_row_,
+                              exclude_current_time_);
 }
 
 std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
     const WindowRange& window_range, const bool output_request_row, const bool exclude_current_time) const {
-    // TOOD(zhanghao): for now, we only support AggUnion with 1 base table and 1 agg table
-    size_t unions_cnt = union_segments.size();
-    if (unions_cnt != 2) {
-        LOG(ERROR) << "Not support of RequestAggUnion with more than 2 unions";
+    if (union_segments.size() < 1 + aggr_table_cnt_) {
+        LOG(ERROR) << "RequestAggUnion expect " << 1 + aggr_table_cnt_ << " unions at least, but got "
+                   << union_segments.size();
         return nullptr;
     }
-
     if (!union_segments[0]) {
         LOG(ERROR) << "base table is empty";
         return nullptr;
     }
-    if (!union_segments[1]) {
-        LOG(ERROR) << "agg table is empty";
-        return nullptr;
-    }
-
-    const auto base_row_parser = producers_[1]->row_parser();
-    const auto agg_row_parser = producers_[2]->row_parser();
 
-    int64_t start = 0;
-    int64_t end = INT64_MAX;
-    int64_t rows_start_preceding = 0;
-    int64_t max_size = 0;
+    WindowBound bound;
     if (ts_gen >= 0) {
         if (window_range.frame_type_ != Window::kFrameRows) {
-            start = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
+            bound.start = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
         }
         if (exclude_current_time && 0 == window_range.end_offset_) {
-            end = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
+            bound.end = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
         } else {
-            end = (ts_gen + window_range.end_offset_) < 0 ? 0 : (ts_gen + window_range.end_offset_);
+            bound.end = (ts_gen + window_range.end_offset_) < 0 ? 0 : (ts_gen + window_range.end_offset_);
         }
-        rows_start_preceding = window_range.start_row_;
-        max_size = window_range.max_size_;
+        bound.rows_start_preceding = window_range.start_row_;
+        bound.max_size = window_range.max_size_;
     }
-    int64_t request_key = ts_gen > 0 ? ts_gen : 0;
+    bound.request_key = ts_gen > 0 ? ts_gen : 0;
 
-    auto aggregator = CreateAggregator();
-    auto update_base_aggregator = [aggregator = aggregator.get(), row_parser = base_row_parser, this](const Row& row) {
-        DLOG(INFO) << "[Update Base]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
-        if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
-            return;
-        }
+    Aggregators aggregators;
+    for (const auto& agg_project : agg_projects_) {
+        aggregators.push_back(CreateAggregator(agg_project));
+    }
 
-        if (cond_ != nullptr) {
-            // for those condition exists and evaluated to NULL/false
-            // will apply to functions `*_where`
-            // include `count_where` has supported, or `{min/max/avg/sum}_where` support later
-            auto matches = internal::EvalCond(row_parser, row, cond_);
-            DLOG(INFO) << "[Update Base Filter] Evaluate result of " << cond_->GetExprString() << ": "
-                       << PrintEvalValue(matches);
-            if (!matches.ok()) {
-                LOG(ERROR) << matches.status();
-                return;
-            }
-            if (false == matches->value_or(false)) {
-                return;
-            }
+    // the aggregations of one pre-aggr table share the scan of the table
+    for (size_t i = 0; i < aggr_table_cnt_; i++) {
+        if (!union_segments[1 + i]) {
+            LOG(WARNING) << "Aggr segment " << i << " is empty. Use base window only";
         }
+        MergeAggrTable(request, union_segments[0], union_segments[1 + i], i, window_range, bound, output_request_row,
+                       &aggregators);
+    }
 
-        auto type = aggregator->type();
-        if (agg_type_ == kCount || agg_type_ == kCountWhere) {
-            dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
-            return;
-        }
+    for (size_t i = 1 + aggr_table_cnt_; i < union_segments.size(); i++) {
+        MergeUnionTable(union_segments[i], bound, &aggregators);
+    }
 
-        if (agg_col_name_.empty()) {
+    auto window_table = std::make_shared<MemTimeTableHandler>();
+    window_table->AddRow(bound.start, Output(&aggregators));
+    DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
+    return window_table;
+}
+
+void RequestAggUnionRunner::UpdateBase(const AggProject& agg_project, BaseAggregator* aggregator,
+                                       const Row& row) const {
+    const auto row_parser = producers_[1]->row_parser();
+    DLOG(INFO) << "[Update Base]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
+    if (!agg_project.agg_col_name.empty() && agg_project.base_agg_col.IsNull(row)) {
+        return;
+    }
+
+    if (agg_project.cond != nullptr) {
+        // for those condition exists and evaluated to NULL/false
+        // will apply to functions `*_where`
+        // include `count_where` has supported, or `{min/max/avg/sum}_where` support later
+        auto matches = agg_project.base_cond ? agg_project.base_cond->Eval(row)
+                                             : internal::EvalCond(row_parser, row, agg_project.cond);
+        DLOG(INFO) << "[Update Base Filter] Evaluate result of " << agg_project.cond->GetExprString() << ": "
+                   << PrintEvalValue(matches);
+        if (!matches.ok()) {
+            LOG(ERROR) << matches.status();
             return;
         }
-        switch (type) {
-            case type::Type::kInt16: {
-                int16_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kDate:
-            case type::Type::kInt32: {
-                int32_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kTimestamp:
-            case type::Type::kInt64: {
-                int64_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kFloat: {
-                float val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kDouble: {
-                double val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kVarchar: {
-                std::string val;
-                row_parser->GetString(row, agg_col_name_, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            default:
-                LOG(ERROR) << "Not support type: " << Type_Name(type);
-                break;
+        if (false == matches->value_or(false)) {
+            return;
         }
-    };
+    }
 
-    auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser, this](const Row& row) {
-        DLOG(INFO) << "[Update Agg]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
-        if (row_parser->IsNull(row, "agg_val")) {
+    if (agg_project.agg_type == kCount || agg_project.agg_type == kCountWhere) {
+        static_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
+        return;
+    }
+    agg_project.base_update_fn(aggregator, agg_project.base_agg_col, row);
+}
+
+void RequestAggUnionRunner::UpdateAgg(const AggProject& agg_project, BaseAggregator* aggregator,
+                                      const Row& row) const {
+    const auto row_parser = producers_[2 + agg_project.aggr_idx]->row_parser();
+    DLOG(INFO) << "[Update Agg]\n" << GetPrettyRow(row_parser->schema_ctx(), row);
+    absl::string_view agg_val;
+    if (!agg_project.agg_val_col.GetValue(row, &agg_val)) {
+        return;
+    }
+
+    if (agg_project.cond != nullptr) {
+        auto matches = agg_project.agg_cond
+                           ? agg_project.agg_cond->Eval(row)
+                           : internal::EvalCondWithAggRow(row_parser, row, agg_project.cond, "filter_key");
+        DLOG(INFO) << "[Update Agg Filter] Evaluate result of " << agg_project.cond->GetExprString() << ": "
+                   << PrintEvalValue(matches);
+        if (!matches.ok()) {
+            LOG(ERROR) << matches.status();
+            return;
+        }
+        if (false == matches->value_or(false)) {
             return;
         }
+    }
 
-        if (cond_ != nullptr) {
-            auto matches = internal::EvalCondWithAggRow(row_parser, row, cond_, "filter_key");
-            DLOG(INFO) << "[Update Agg Filter] Evaluate result of " << cond_->GetExprString() << ": "
-                       << PrintEvalValue(matches);
-            if (!matches.ok()) {
-                LOG(ERROR) << matches.status();
-                return;
-            }
-            if (false == matches->value_or(false)) {
-                return;
-            }
+    aggregator->Update(std::string(agg_val));
+}
+
+void RequestAggUnionRunner::MergeAggrTable(const Row& request, const std::shared_ptr<TableHandler>& base_segment,
+                                           const std::shared_ptr<TableHandler>& aggr_segment, size_t aggr_idx,
+                                           const WindowRange& window_range, const WindowBound& bound,
+                                           const bool output_request_row, Aggregators* aggregators) const {
+    std::vector<size_t> project_ids;
+    for (size_t i = 0; i < agg_projects_.size(); i++) {
+        if (agg_projects_[i].aggr_idx == aggr_idx) {
+            project_ids.push_back(i);
         }
+    }
+    if (project_ids.empty()) {
+        return;
+    }
+    // the aggregations sharing a pre-aggr table have the same filter column and layout
+    const auto& leader = agg_projects_[project_ids[0]];
+    const bool with_filter = leader.cond != nullptr;
+    const int64_t start = bound.start;
+    const int64_t end = bound.end;
+    const int64_t rows_start_preceding = bound.rows_start_preceding;
+    const int64_t max_size = bound.max_size;
 
-        std::string agg_val;
-        row_parser->GetString(row, "agg_val", &agg_val);
-        aggregator->Update(agg_val);
+    auto update_base_aggregator = [&](const Row& row) {
+        for (auto id : project_ids) {
+            UpdateBase(agg_projects_[id], aggregators->at(id).get(), row);
+        }
+    };
+    auto update_agg_aggregator = [&](const Row& row) {
+        for (auto id : project_ids) {
+            UpdateAgg(agg_projects_[id], aggregators->at(id).get(), row);
+        }
     };
 
     int64_t cnt = 0;
     auto range_status = window_range.GetWindowPositionStatus(cnt > rows_start_preceding, window_range.end_offset_ < 0,
-                                                             request_key < start);
+                                                             bound.request_key < start);
     if (output_request_row) {
         update_base_aggregator(request);
     }
@@ -2932,17 +3262,14 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         cnt++;
     }
 
-    auto window_table = std::make_shared<MemTimeTableHandler>();
-    auto base_it = union_segments[0]->GetIterator();
+    auto base_it = base_segment->GetIterator();
     if (!base_it) {
         LOG(WARNING) << "Base window is empty.";
-        window_table->AddRow(start, aggregator->Output());
-        DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
-        return window_table;
+        return;
     }
     base_it->Seek(end);
 
-    auto agg_it = union_segments[1]->GetIterator();
+    auto agg_it = aggr_segment ? aggr_segment->GetIterator() : nullptr;
     if (agg_it) {
         agg_it->Seek(end);
     } else {
@@ -2972,7 +3299,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         //   - ts_end <= end
         while (agg_it->Valid()) {
             ts_start = agg_it->GetKey();
-            agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
+            leader.ts_end_col.GetValue(agg_it->GetValue(), &ts_end);
             if (ts_end <= end) {
                 break;
             }
@@ -2992,7 +3319,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     DLOG(INFO) << absl::Substitute(
         "[RequestUnion]($6) {start=$0, start_base=$1, end_base=$2, end=$3, base_key=$4, agg_key=$5}", start,
         start_base.value_or(-1), end_base.value_or(-1), end, base_it->GetKey(), (agg_it ? agg_it->GetKey() : -1),
-        (cond_ ? cond_->GetExprString() : ""));
+        (with_filter ? leader.cond->GetExprString() : ""));
 
     // 1. iterate over base table from [end, end_base) end (inclusive) to end_base (exclusive)
     if (end_base < end) {
@@ -3024,7 +3351,7 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
             break;
         }
 
-        if (cond_ == nullptr) {
+        if (!with_filter) {
             const uint64_t ts_start = agg_it->GetKey();
             const Row& row = agg_it->GetValue();
             if (prev_ts_start == ts_start) {
@@ -3035,9 +3362,9 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
             prev_ts_start = ts_start;
 
             int64_t ts_end = -1;
-            agg_row_parser->GetValue(row, "ts_end", type::Type::kTimestamp, &ts_end);
-            int num_rows = 0;
-            agg_row_parser->GetValue(row, "num_rows", type::Type::kInt32, &num_rows);
+            leader.ts_end_col.GetValue(row, &ts_end);
+            int32_t num_rows = 0;
+            leader.num_rows_col.GetValue(row, &num_rows);
 
             // FIXME(zhanghao): check cnt and rows_start_preceding meanings
             int next_incr = num_rows > 0 ? num_rows - 1 : 0;
@@ -3064,21 +3391,17 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
 
             int total_rows = 0;
             int64_t ts_end_range = -1;
-            agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end_range);
+            leader.ts_end_col.GetValue(agg_it->GetValue(), &ts_end_range);
             while (agg_it->Valid() && ts_start == agg_it->GetKey()) {
                 const Row& drow = agg_it->GetValue();
 
-                std::string filter_val;
-                if (agg_row_parser->IsNull(drow, "filter_key")) {
+                absl::string_view filter_key;
+                if (!leader.filter_key_col.GetValue(drow, &filter_key)) {
                     LOG(ERROR) << "filter_key is null for *_where op";
                     agg_it->Next();
                     continue;
                 }
-                if (0 != agg_row_parser->GetString(drow, "filter_key", &filter_val)) {
-                    LOG(ERROR) << "failed to get value of filter_key";
-                    agg_it->Next();
-                    continue;
-                }
+                std::string filter_val(filter_key);
 
                 if (prev_ts_start == ts_start && filter_val_set.count(filter_val) != 0) {
                     DLOG(INFO) << "Found duplicate entries in agg table for ts_start = " << ts_start
@@ -3090,8 +3413,8 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
                 prev_ts_start = ts_start;
                 filter_val_set.insert(filter_val);
 
-                int num_rows = 0;
-                agg_row_parser->GetValue(drow, "num_rows", type::Type::kInt32, &num_rows);
+                int32_t num_rows = 0;
+                leader.num_rows_col.GetValue(drow, &num_rows);
 
                 if (num_rows > 0) {
                     total_rows += num_rows;
@@ -3144,10 +3467,99 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
             base_it->Next();
         }
     }
+}
 
-    window_table->AddRow(start, aggregator->Output());
-    DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
-    return window_table;
+void RequestAggUnionRunner::MergeUnionTable(const std::shared_ptr<TableHandler>& union_segment,
+                                            const WindowBound& bound, Aggregators* aggregators) const {
+    if (!union_segment) {
+        return;
+    }
+    auto it = union_segment->GetIterator();
+    if (!it) {
+        return;
+    }
+    // window unions only come with ROWS_RANGE frame without MAXSIZE, the frame is decided by timestamp alone
+    it->Seek(bound.end);
+    while (it->Valid()) {
+        int64_t ts = it->GetKey();
+        if (ts < bound.start) {
+            break;
+        }
+        if (ts <= bound.end) {
+            for (size_t i = 0; i < agg_projects_.size(); i++) {
+                UpdateBase(agg_projects_[i], aggregators->at(i).get(), it->GetValue());
+            }
+        }
+        it->Next();
+    }
+}
+
+Row RequestAggUnionRunner::Output(Aggregators* aggregators) const {
+    if (aggregators->size() == 1) {
+        return aggregators->front()->Output();
+    }
+
+    // concat the single column outputs into one row
+    std::vector<Row> outputs;
+    std::vector<codec::RowView> views;
+    uint32_t str_len = 0;
+    for (size_t i = 0; i < aggregators->size(); i++) {
+        outputs.push_back(aggregators->at(i)->Output());
+        auto& view = views.emplace_back(agg_projects_[i].output_schema);
+        view.Reset(outputs.back().buf(), outputs.back().size());
+        if (agg_projects_[i].output_schema.Get(0).type() == type::kVarchar && !view.IsNULL(0)) {
+            str_len += view.GetStringUnsafe(0).size();
+        }
+    }
+
+    const auto& schema = *output_schemas_->GetOutputSchema();
+    codec::RowBuilder row_builder(schema);
+    uint32_t total_len = row_builder.CalTotalLength(str_len);
+    int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+    row_builder.SetBuffer(buf, total_len);
+    for (size_t i = 0; i < views.size(); i++) {
+        auto& view = views[i];
+        if (view.IsNULL(0)) {
+            row_builder.AppendNULL();
+            continue;
+        }
+        switch (schema.Get(i).type()) {
+            case type::kBool:
+                row_builder.AppendBool(view.GetBoolUnsafe(0));
+                break;
+            case type::kInt16:
+                row_builder.AppendInt16(view.GetInt16Unsafe(0));
+                break;
+            case type::kInt32:
+                row_builder.AppendInt32(view.GetInt32Unsafe(0));
+                break;
+            case type::kDate:
+                row_builder.AppendDate(view.GetDateUnsafe(0));
+                break;
+            case type::kInt64:
+                row_builder.AppendInt64(view.GetInt64Unsafe(0));
+                break;
+            case type::kTimestamp:
+                row_builder.AppendTimestamp(view.GetTimestampUnsafe(0));
+                break;
+            case type::kFloat:
+                row_builder.AppendFloat(view.GetFloatUnsafe(0));
+                break;
+            case type::kDouble:
+                row_builder.AppendDouble(view.GetDoubleUnsafe(0));
+                break;
+            case type::kVarchar: {
+                auto str = view.GetStringUnsafe(0);
+                row_builder.AppendString(str.data(), str.size());
+                break;
+            }
+            default:
+                LOG(ERROR) << "Aggregator not support type: " << Type_Name(schema.Get(i).type());
+                row_builder.AppendNULL();
+                break;
+        }
+    }
+    return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
 }
 
 std::string RequestAggUnionRunner::PrintEvalValue(const absl::StatusOr<std::optional<bool>>& val) {
@@ -3224,48 +3636,88 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
                               range_gen_.window_range_, output_request_row_,
                               exclude_current_time_, exclude_current_row_);
 }
-std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
-    const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
-    const WindowRange& window_range, bool output_request_row, bool exclude_current_time, bool exclude_current_row) {
-    uint64_t start = 0;
-    // end is empty means end value < 0, that there is no effective window range
-    // this happend when `ts_gen` is 0 and exclude current_time needed
-    std::optional<uint64_t> end = UINT64_MAX;
-    uint64_t rows_start_preceding = 0;
-    uint64_t max_size = 0;
-    if (ts_gen >= 0) {
-        start = (ts_gen + window_range.start_offset_) < 0
-                    ? 0
-                    : (ts_gen + window_range.start_offset_);
-        if (exclude_current_time && 0 == window_range.end_offset_) {
-            if (ts_gen == 0) {
-                end = {};
+namespace {
+// builds the window of a request from the rows of the union segments, which are added in desc order of key
+class RequestUnionWindowBuilder {
+ public:
+    RequestUnionWindowBuilder(const Row& request, int64_t ts_gen, const WindowRange& window_range,
+                              bool output_request_row, bool exclude_current_time, bool exclude_current_row)
+        : window_range_(window_range), window_table_(std::make_shared<MemTimeTableHandler>()) {
+        if (ts_gen >= 0) {
+            start_ = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
+            if (exclude_current_time && 0 == window_range.end_offset_) {
+                if (ts_gen == 0) {
+                    end_ = {};
+                } else {
+                    end_ = ts_gen - 1;
+                }
             } else {
-                end = ts_gen - 1;
+                end_ = (ts_gen + window_range.end_offset_) < 0 ? 0 : (ts_gen + window_range.end_offset_);
+            }
+            rows_start_preceding_ = window_range.start_row_;
+            max_size_ = window_range.max_size_;
+
+            // HACK: window ... maxsize sz exclude current_row
+            // due to the implementation, current row should always present in the returned table
+            // because `AggRunner` requires that current row to be the first two parameters to udf call
+            // so we make the return one size more if original maxsize is set.
+            // the proper window list will generated for exclude current_row in codegen
+            //
+            // see `Runner::GroupbyProject` when `exclude_current_row` is true
+            if (exclude_current_row && max_size_ > 0) {
+                max_size_++;
             }
-        } else {
-            end = (ts_gen + window_range.end_offset_) < 0
-                      ? 0
-                      : (ts_gen + window_range.end_offset_);
         }
-        rows_start_preceding = window_range.start_row_;
-        max_size = window_range.max_size_;
+        uint64_t request_key = ts_gen > 0 ? static_cast<uint64_t>(ts_gen) : 0;
+        auto range_status = window_range.GetWindowPositionStatus(cnt_ > rows_start_preceding_,
+                                                                 window_range.end_offset_ < 0, request_key < start_);
+        if (output_request_row) {
+            window_table_->AddRow(request_key, request);
+        }
+        if (WindowRange::kInWindow == range_status) {
+            cnt_++;
+        }
+    }
+
+    // the max key of the rows in the window, empty if there is no effective window range
+    const std::optional<uint64_t>& end() const { return end_; }
 
-        // HACK: window ... maxsize sz exclude current_row
-        // due to the implementation, current row should always present in the returned table
-        // because `AggRunner` requires that current row to be the first two parameters to udf call
-        // so we make the return one size more if original maxsize is set.
-        // the proper window list will generated for exclude current_row in codegen
-        //
-        // see `Runner::GroupbyProject` when `exclude_current_row` is true
-        if (exclude_current_row && max_size > 0) {
-            max_size++;
+    // return false if the window is complete and the rest rows are not needed
+    bool Add(uint64_t key, const Row& row) {
+        if (max_size_ > 0 && cnt_ >= max_size_) {
+            return false;
         }
+        auto range_status = window_range_.GetWindowPositionStatus(cnt_ > rows_start_preceding_, key > end_,
+                                                                  key < start_);
+        if (WindowRange::kExceedWindow == range_status) {
+            return false;
+        }
+        if (WindowRange::kInWindow == range_status) {
+            window_table_->AddRow(key, row);
+            cnt_++;
+        }
+        return true;
     }
-    uint64_t request_key = ts_gen > 0 ? static_cast<uint64_t>(ts_gen) : 0;
 
-    auto window_table = std::make_shared<MemTimeTableHandler>();
+    std::shared_ptr<MemTimeTableHandler> window() const { return window_table_; }
 
+ private:
+    const WindowRange& window_range_;
+    uint64_t start_ = 0;
+    // end is empty means end value < 0, that there is no effective window range
+    // this happend when `ts_gen` is 0 and exclude current_time needed
+    std::optional<uint64_t> end_ = UINT64_MAX;
+    uint64_t rows_start_preceding_ = 0;
+    uint64_t max_size_ = 0;
+    uint64_t cnt_ = 0;
+    std::shared_ptr<MemTimeTableHandler> window_table_;
+};
+
+// visit the rows of the union segments not greater than `seek_key` in desc order of key,
+// until `visit` returns false
+template <typename F>
+void ScanUnionSegments(const std::vector<std::shared_ptr<TableHandler>>& union_segments, uint64_t seek_key,
+                       F&& visit) {
     size_t unions_cnt = union_segments.size();
     // Prepare Union Segment Iterators
     std::vector<std::unique_ptr<RowIterator>> union_segment_iters(unions_cnt);
@@ -3281,7 +3733,7 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
             union_segment_status[i] = IteratorStatus();
             continue;
         }
-        union_segment_iters[i]->Seek(end.value_or(0));
+        union_segment_iters[i]->Seek(seek_key);
         if (!union_segment_iters[i]->Valid()) {
             union_segment_status[i] = IteratorStatus();
             continue;
@@ -3291,47 +3743,172 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     }
     int32_t max_union_pos = IteratorStatus::FindFirstIteratorWithMaximizeKey(union_segment_status);
 
-    uint64_t cnt = 0;
-    auto range_status = window_range.GetWindowPositionStatus(
-        cnt > rows_start_preceding, window_range.end_offset_ < 0,
-        request_key < start);
-    if (output_request_row) {
-        window_table->AddRow(request_key, request);
-    }
-    if (WindowRange::kInWindow == range_status) {
-        cnt++;
-    }
-
     while (-1 != max_union_pos) {
-        if (max_size > 0 && cnt >= max_size) {
-            break;
-        }
-        auto range_status = window_range.GetWindowPositionStatus(
-            cnt > rows_start_preceding,
-            union_segment_status[max_union_pos].key_ > end,
-            union_segment_status[max_union_pos].key_ < start);
-        if (WindowRange::kExceedWindow == range_status) {
+        if (!visit(union_segment_status[max_union_pos].key_, union_segment_iters[max_union_pos]->GetValue())) {
             break;
         }
-        if (WindowRange::kInWindow == range_status) {
-            window_table->AddRow(
-                union_segment_status[max_union_pos].key_,
-                union_segment_iters[max_union_pos]->GetValue());
-            cnt++;
-        }
         // Update Iterator Status
         union_segment_iters[max_union_pos]->Next();
         if (!union_segment_iters[max_union_pos]->Valid()) {
             union_segment_status[max_union_pos].MarkInValid();
         } else {
-            union_segment_status[max_union_pos].set_key(
-                union_segment_iters[max_union_pos]->GetKey());
+            union_segment_status[max_union_pos].set_key(union_segment_iters[max_union_pos]->GetKey());
         }
         // Pick new mininum union pos
         max_union_pos = IteratorStatus::FindFirstIteratorWithMaximizeKey(union_segment_status);
     }
-    DLOG(INFO) << "REQUEST UNION cnt = " << window_table->GetCount();
-    return window_table;
+}
+}  // namespace
+
+std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
+    const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
+    const WindowRange& window_range, bool output_request_row, bool exclude_current_time, bool exclude_current_row) {
+    RequestUnionWindowBuilder builder(request, ts_gen, window_range, output_request_row, exclude_current_time,
+                                      exclude_current_row);
+    ScanUnionSegments(union_segments, builder.end().value_or(0),
+                      [&builder](uint64_t key, const Row& row) { return builder.Add(key, row); });
+    DLOG(INFO) << "REQUEST UNION cnt = " << builder.window()->GetCount();
+    return builder.window();
+}
+
+std::vector<std::shared_ptr<TableHandler>> RequestUnionRunner::RequestUnionWindows(
+    const std::vector<Row>& requests, const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+    const std::vector<int64_t>& request_ts, const WindowRange& window_range, bool output_request_row,
+    bool exclude_current_time, bool exclude_current_row) {
+    std::vector<RequestUnionWindowBuilder> builders;
+    builders.reserve(requests.size());
+    // the windows not complete yet
+    std::vector<size_t> active;
+    std::optional<uint64_t> seek_key;
+    for (size_t i = 0; i < requests.size(); i++) {
+        builders.emplace_back(requests[i], request_ts[i], window_range, output_request_row, exclude_current_time,
+                              exclude_current_row);
+        // a window without effective range contains no row of the segments
+        auto& end = builders.back().end();
+        if (end) {
+            active.push_back(i);
+            seek_key = seek_key ? std::max(*seek_key, *end) : *end;
+        }
+    }
+    if (seek_key) {
+        // the rows greater than the end of a window are skipped by it, so the windows ending
+        // earlier see the same rows as a scan seeking to their own end
+        ScanUnionSegments(union_segments, *seek_key, [&builders, &active](uint64_t key, const Row& row) {
+            size_t remain = 0;
+            for (size_t idx : active) {
+                if (builders[idx].Add(key, row)) {
+                    active[remain++] = idx;
+                }
+            }
+            active.resize(remain);
+            return !active.empty();
+        });
+    }
+    std::vector<std::shared_ptr<TableHandler>> windows;
+    windows.reserve(builders.size());
+    for (auto& builder : builders) {
+        windows.push_back(builder.window());
+    }
+    return windows;
+}
+
+std::shared_ptr<DataHandlerList> RequestUnionRunner::BatchRequestRun(RunnerContext& ctx) {
+    if (need_batch_cache_ || producers_.size() < 2u || ctx.GetRequestSize() <= 1) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    std::vector<std::shared_ptr<DataHandlerList>> batch_inputs(producers_.size());
+    for (size_t idx = producers_.size(); idx > 0; idx--) {
+        batch_inputs[idx - 1] = producers_[idx - 1]->BatchRequestRun(ctx);
+        if (batch_inputs[idx - 1] == nullptr) {
+            LOG(WARNING) << "the result of producer " << idx - 1 << " is null";
+            return nullptr;
+        }
+    }
+    size_t request_cnt = ctx.GetRequestSize();
+    std::vector<Row> requests(request_cnt);
+    std::vector<int64_t> request_ts(request_cnt);
+    // the window of an invalid request is null, as Run returns for it
+    std::vector<bool> valid(request_cnt, false);
+    for (size_t idx = 0; idx < request_cnt; idx++) {
+        auto left = batch_inputs[0]->Get(idx);
+        if (!left || kRowHandler != left->GetHandlerType() || !batch_inputs[1]->Get(idx)) {
+            continue;
+        }
+        valid[idx] = true;
+        requests[idx] = std::dynamic_pointer_cast<RowHandler>(left)->GetValue();
+        request_ts[idx] = range_gen_.Valid() ? range_gen_.ts_gen_.Gen(requests[idx]) : -1;
+    }
+
+    // group the requests by the keys of their window segments, in the order of first appearance
+    std::vector<std::vector<size_t>> groups;
+    {
+        absl::flat_hash_map<std::string, size_t> group_idx;
+        for (size_t idx = 0; idx < request_cnt; idx++) {
+            if (!valid[idx]) {
+                continue;
+            }
+            auto res = group_idx.try_emplace(windows_union_gen_.GetRequestWindowsKey(requests[idx],
+                                                                                     ctx.GetParameterRow()),
+                                             groups.size());
+            if (res.second) {
+                groups.emplace_back();
+            }
+            groups[res.first->second].push_back(idx);
+        }
+    }
+
+    std::vector<std::shared_ptr<DataHandler>> windows(request_cnt);
+    {
+        ScopedArenaCounter arena_counter(ctx.arena_counter());
+        auto union_inputs = windows_union_gen_.RunInputs(ctx);
+        std::vector<Row> group_requests;
+        std::vector<int64_t> group_ts;
+        for (auto& group : groups) {
+            group_requests.clear();
+            group_ts.clear();
+            for (size_t idx : group) {
+                group_requests.push_back(requests[idx]);
+                group_ts.push_back(request_ts[idx]);
+            }
+            auto union_segments =
+                windows_union_gen_.GetRequestWindows(requests[group[0]], ctx.GetParameterRow(), union_inputs);
+            auto group_windows =
+                RequestUnionWindows(group_requests, union_segments, group_ts, range_gen_.window_range_,
+                                    output_request_row_, exclude_current_time_, exclude_current_row_);
+            for (size_t i = 0; i < group.size(); i++) {
+                windows[group[i]] = group_windows[i];
+            }
+        }
+    }
+    DLOG(INFO) << "REQUEST UNION " << request_cnt << " requests in " << groups.size() << " groups";
+
+    auto outputs = std::make_shared<DataHandlerVector>();
+    for (auto& window : windows) {
+        outputs->Add(window);
+    }
+    if (ctx.is_debug()) {
+        std::ostringstream oss;
+        oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << "\n";
+        for (size_t idx = 0; idx < outputs->GetSize(); idx++) {
+            if (idx >= MAX_DEBUG_BATCH_SiZE) {
+                oss << ">= MAX_DEBUG_BATCH_SiZE...\n";
+                break;
+            }
+            Runner::PrintData(oss, output_schemas_, outputs->Get(idx));
+        }
+        LOG(INFO) << oss.str();
+    }
+    if (need_cache_) {
+        ctx.SetBatchCache(id_, outputs);
+    }
+    return outputs;
 }
 
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
@@ -3958,6 +4535,19 @@ std::vector<std::shared_ptr<DataHandler>> InputsGenerator::RunInputs(
     }
     return union_inputs;
 }
+std::string RequestWindowGenertor::GetRequestWindowKey(const Row& row, const Row& parameter) {
+    std::string index_key = index_seek_gen_.Valid() ? index_seek_gen_.index_key_gen_.Gen(row, parameter) : "";
+    // the size prefix keeps the keys of different segments from colliding
+    return absl::StrCat(index_key.size(), ":", index_key, filter_gen_.GetKey(row, parameter));
+}
+std::string RequestWindowUnionGenerator::GetRequestWindowsKey(const Row& row, const Row& parameter) {
+    std::string key;
+    for (auto& window_gen : windows_gen_) {
+        std::string window_key = window_gen.GetRequestWindowKey(row, parameter);
+        absl::StrAppend(&key, window_key.size(), ":", window_key);
+    }
+    return key;
+}
 std::vector<std::shared_ptr<PartitionHandler>>
 WindowUnionGenerator::PartitionEach(
     std::vector<std::shared_ptr<DataHandler>> union_inputs,
@@ -4157,6 +4747,7 @@ void RunnerContext::SetBatchCache(int64_t id,
 }
 
 std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
+    std::lock_guard<std::mutex> lock(cache_mu_);
     auto iter = cache_.find(id);
     if (iter == cache_.end()) {
         return std::shared_ptr<DataHandler>();
@@ -4167,6 +4758,7 @@ std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
 
 void RunnerContext::SetCache(int64_t id,
                              const std::shared_ptr<DataHandler> data) {
+    std::lock_guard<std::mutex> lock(cache_mu_);
     cache_[id] = data;
 }
 
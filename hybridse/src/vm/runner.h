@@ -17,8 +17,11 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -34,6 +37,9 @@
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/engine_context.h"
+#include "vm/internal/agg_union_kernel.h"
+#include "vm/internal/window_agg_kernel.h"
 #include "vm/mem_catalog.h"
 #include "vm/physical_op.h"
 namespace hybridse {
@@ -232,6 +238,8 @@ class SortGenerator {
     std::shared_ptr<TableHandler> Sort(std::shared_ptr<TableHandler> table,
                                        const bool reverse = false);
     const OrderGenerator& order_gen() const { return order_gen_; }
+    const bool is_asc() const { return is_asc_; }
+    const int64_t GenOrderKey(const Row& row) { return order_gen_.Gen(row); }
 
  private:
     bool is_valid_;
@@ -320,6 +328,8 @@ class RequestWindowGenertor {
         }
         return segment;
     }
+    // the requests with the same key have the same window segment
+    std::string GetRequestWindowKey(const Row& row, const Row& parameter);
     RequestWindowOp window_op_;
     FilterKeyGenerator filter_gen_;
     SortGenerator sort_gen_;
@@ -459,6 +469,9 @@ class Runner : public node::NodeBase<Runner> {
         if (is_lazy_) {
             output << " lazy";
         }
+        if (parallel_producers_) {
+            output << " parallel";
+        }
     }
     virtual void Print(std::ostream& output, const std::string& tab,
                        std::set<int32_t>* visited_ids) const {  // NOLINT
@@ -486,6 +499,9 @@ class Runner : public node::NodeBase<Runner> {
     void DisableCache() { need_cache_ = false; }
     void EnableBatchCache() { need_batch_cache_ = true; }
     void DisableBatchCache() { need_batch_cache_ = false; }
+    // run the producers concurrently on the parallel executor of the context, if any
+    void EnableParallelProducers() { parallel_producers_ = true; }
+    const bool parallel_producers() const { return parallel_producers_; }
 
     const int32_t id_;
     const RunnerType type_;
@@ -567,6 +583,7 @@ class Runner : public node::NodeBase<Runner> {
 
     bool need_cache_;
     bool need_batch_cache_;
+    bool parallel_producers_ = false;
     std::vector<Runner*> producers_;
     const vm::SchemasContext* output_schemas_;
     std::unique_ptr<RowParser> row_parser_ = nullptr;
@@ -651,8 +668,16 @@ class RequestWindowUnionGenerator : public InputsGenerator {
         }
         return union_segments;
     }
+    std::string GetRequestWindowsKey(const Row& row, const Row& parameter);
     std::vector<RequestWindowGenertor> windows_gen_;
 };
+// the right rows of a last join grouped by the join key, in the order the last join picks them
+struct LastJoinHashTable {
+    absl::flat_hash_map<std::string, std::vector<std::pair<uint64_t, Row>>> buckets;
+    // the memory of the buckets, the rows are shared with the right table
+    size_t memory_bytes = 0;
+};
+
 class JoinGenerator {
  public:
     explicit JoinGenerator(const Join& join, size_t left_slices,
@@ -680,8 +705,24 @@ class JoinGenerator {
                        const Row& parameter,
                        std::shared_ptr<MemPartitionHandler>);  // NOLINT
 
+
+    // hash join with a right table not indexed on the join key. The hash table is built once, instead
+    // of grouping the right table into a partition and sorting the segment of every left row.
+    // Return false and leave the output empty if the join doesn't fit, see BuildLastJoinHashTable
+    bool TableHashJoin(std::shared_ptr<TableHandler> left, std::shared_ptr<TableHandler> right,
+                       const Row& parameter,
+                       std::shared_ptr<MemTimeTableHandler> output);  // NOLINT
+    bool PartitionHashJoin(std::shared_ptr<PartitionHandler> left, std::shared_ptr<TableHandler> right,
+                           const Row& parameter,
+                           std::shared_ptr<MemPartitionHandler> output);  // NOLINT
+    // false if the join keys or the order of the right rows can't be hashed, or the memory of
+    // the hash table exceeds --last_join_hash_max_bytes
+    bool BuildLastJoinHashTable(std::shared_ptr<TableHandler> right, const Row& parameter,
+                                LastJoinHashTable* hash_table);
+
     Row RowLastJoin(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
     Row RowLastJoinDropLeftSlices(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
+
     ConditionGenerator condition_gen_;
     KeyGenerator left_key_gen_;
     PartitionGenerator right_group_gen_;
@@ -696,6 +737,9 @@ class JoinGenerator {
     Row RowLastJoinTable(const Row& left_row,
                          std::shared_ptr<TableHandler> table,
                          const Row& parameter);
+    // the key of the right segment to join with, as TableJoin and PartitionJoin look it up
+    std::string LeftJoinKey(const Row& left_row, const Row& parameter);
+    Row RowLastJoinHash(const Row& left_row, const LastJoinHashTable& hash_table, const Row& parameter);
 
     size_t left_slices_;
     size_t right_slices_;
@@ -941,6 +985,10 @@ class WindowAggRunner : public Runner {
     void AddWindowUnion(const WindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    // run the window on the columnar kernels, the window has no union or join
+    void SetColumnarAgg(std::unique_ptr<internal::ColumnarWindowAgg> columnar_agg) {
+        columnar_agg_ = std::move(columnar_agg);
+    }
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
@@ -951,6 +999,9 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    // false if the segment can't run on the columnar kernels
+    bool RunColumnarAggOnSegment(std::shared_ptr<TableHandler> instance_segment,
+                                 std::shared_ptr<MemTableHandler> output_table);
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -962,6 +1013,7 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    std::unique_ptr<internal::ColumnarWindowAgg> columnar_agg_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -978,11 +1030,21 @@ class RequestUnionRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // the requests of a batch sharing the same window segments are grouped, and the windows of
+    // a group are built in one scan of the segments
+    std::shared_ptr<DataHandlerList> BatchRequestRun(
+        RunnerContext& ctx) override;  // NOLINT
     static std::shared_ptr<TableHandler> RequestUnionWindow(const Row& request,
                                                             std::vector<std::shared_ptr<TableHandler>> union_segments,
                                                             int64_t request_ts, const WindowRange& window_range,
                                                             bool output_request_row, bool exclude_current_time,
                                                             bool exclude_current_row);
+    // the windows of the requests over the same union segments, the same as calling
+    // RequestUnionWindow for each request, but the segments are scanned once
+    static std::vector<std::shared_ptr<TableHandler>> RequestUnionWindows(
+        const std::vector<Row>& requests, const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+        const std::vector<int64_t>& request_ts, const WindowRange& window_range, bool output_request_row,
+        bool exclude_current_time, bool exclude_current_row);
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
@@ -995,29 +1057,38 @@ class RequestUnionRunner : public Runner {
 
 class RequestAggUnionRunner : public Runner {
  public:
+    // `projects[i]` merges the pre-aggr table of producer `2 + aggr_idx[i]`. A pre-aggr table is maintained by one
+    // storage::Aggregator of a single aggregation, so projects only share a table when they are the same aggregation
     RequestAggUnionRunner(const int32_t id, const SchemasContext* schema, const std::optional<int32_t> limit_cnt,
                           const Range& range, bool exclude_current_time, bool output_request_row,
-                          const node::CallExprNode* project)
+                          const std::vector<const node::CallExprNode*>& projects, const std::vector<size_t>& aggr_idx)
         : Runner(id, kRunnerRequestAggUnion, schema, limit_cnt),
           range_gen_(range),
           exclude_current_time_(exclude_current_time),
-          output_request_row_(output_request_row),
-          func_(project->GetFnDef()),
-          agg_col_(project->GetChild(0)) {
-        if (agg_col_->GetExprType() == node::kExprColumnRef) {
-            agg_col_name_ = dynamic_cast<const node::ColumnRefNode*>(agg_col_)->GetColumnName();
-        } /* for kAllExpr like count(*), agg_col_name_ is empty */
-
-        if (project->GetChildNum() >= 2) {
-            // assume second kid of project as filter condition
-            // function support check happens in compile
-            cond_ = project->GetChild(1);
+          output_request_row_(output_request_row) {
+        for (size_t i = 0; i < projects.size(); i++) {
+            auto& agg_project = agg_projects_.emplace_back();
+            agg_project.func = projects[i]->GetFnDef();
+            agg_project.agg_col = projects[i]->GetChild(0);
+            if (agg_project.agg_col->GetExprType() == node::kExprColumnRef) {
+                agg_project.agg_col_name =
+                    dynamic_cast<const node::ColumnRefNode*>(agg_project.agg_col)->GetColumnName();
+            } /* for kAllExpr like count(*), agg_col_name is empty */
+
+            if (projects[i]->GetChildNum() >= 2) {
+                // assume second kid of project as filter condition
+                // function support check happens in compile
+                agg_project.cond = projects[i]->GetChild(1);
+            }
+            agg_project.aggr_idx = aggr_idx[i];
+            aggr_table_cnt_ = std::max(aggr_table_cnt_, aggr_idx[i] + 1);
         }
     }
 
     bool InitAggregator();
     std::shared_ptr<DataHandler> Run(RunnerContext& ctx,
                                      const std::vector<std::shared_ptr<DataHandler>>& inputs) override;
+    // `union_segments` are the segments of the raw table, the pre-aggr tables, then the window unions
     std::shared_ptr<TableHandler> RequestUnionWindow(const Row& request,
                                                      std::vector<std::shared_ptr<TableHandler>> union_segments,
                                                      int64_t request_ts, const WindowRange& window_range,
@@ -1043,6 +1114,64 @@ class RequestAggUnionRunner : public Runner {
         kMaxWhere,
     };
 
+    // one long window aggregation, an output column of the runner
+    struct AggProject {
+        const node::FnDefNode* func = nullptr;
+        AggType agg_type;
+        const node::ExprNode* agg_col = nullptr;
+        std::string agg_col_name;
+        type::Type agg_col_type;
+
+        // the filter condition for count_where
+        // simple compassion binary expr like col < 0 is supported
+        node::ExprNode* cond = nullptr;
+
+        // index of the pre-aggr table merged
+        size_t aggr_idx = 0;
+        // the single column the aggregator outputs
+        codec::Schema output_schema;
+
+        // resolved by InitAggregator, so the merge runs on field offsets and typed kernels.
+        // a condition that can not be compiled is left null and evaluated by the interpreter
+        internal::ResolvedColumn base_agg_col;
+        internal::BaseUpdateFn base_update_fn = nullptr;
+        std::unique_ptr<internal::CompiledCond> base_cond;
+        internal::ResolvedColumn agg_val_col;
+        internal::ResolvedColumn ts_end_col;
+        internal::ResolvedColumn num_rows_col;
+        internal::ResolvedColumn filter_key_col;
+        std::unique_ptr<internal::CompiledCond> agg_cond;
+    };
+
+    // the frame of the window of a request
+    struct WindowBound {
+        int64_t start = 0;
+        int64_t end = INT64_MAX;
+        int64_t rows_start_preceding = 0;
+        int64_t max_size = 0;
+        int64_t request_key = 0;
+    };
+
+    using Aggregators = std::vector<std::unique_ptr<BaseAggregator>>;
+
+    std::unique_ptr<BaseAggregator> CreateAggregator(const AggProject& agg_project) const;
+    bool InitMergeKernel(AggProject* agg_project);
+
+    void UpdateBase(const AggProject& agg_project, BaseAggregator* aggregator, const Row& row) const;
+    void UpdateAgg(const AggProject& agg_project, BaseAggregator* aggregator, const Row& row) const;
+
+    // merge the raw table and the pre-aggr table `aggr_idx` into the aggregators of the table
+    void MergeAggrTable(const Row& request, const std::shared_ptr<TableHandler>& base_segment,
+                        const std::shared_ptr<TableHandler>& aggr_segment, size_t aggr_idx,
+                        const WindowRange& window_range, const WindowBound& bound, const bool output_request_row,
+                        Aggregators* aggregators) const;
+
+    // update all the aggregators by the rows of a union table inside [start, end]
+    void MergeUnionTable(const std::shared_ptr<TableHandler>& union_segment, const WindowBound& bound,
+                         Aggregators* aggregators) const;
+
+    Row Output(Aggregators* aggregators) const;
+
     RequestWindowUnionGenerator windows_union_gen_;
     RangeGenerator range_gen_;
     bool exclude_current_time_;
@@ -1051,17 +1180,8 @@ class RequestAggUnionRunner : public Runner {
     // turn to false if `EXCLUDE CURRENT_ROW` from window definition
     bool output_request_row_;
 
-    const node::FnDefNode* func_ = nullptr;
-    AggType agg_type_;
-    const node::ExprNode* agg_col_ = nullptr;
-    std::string agg_col_name_;
-    type::Type agg_col_type_;
-
-    // the filter condition for count_where
-    // simple compassion binary expr like col < 0 is supported
-    node::ExprNode* cond_ = nullptr;
-
-    std::unique_ptr<BaseAggregator> CreateAggregator() const;
+    std::vector<AggProject> agg_projects_;
+    size_t aggr_table_cnt_ = 0;
 
     static inline const absl::flat_hash_map<absl::string_view, AggType> agg_type_map_ = {
         {"sum", kSum},
@@ -1478,9 +1598,13 @@ class RunnerBuilder {
                            const std::string& db,
                            bool support_cluster_optimized,
                            const std::set<size_t>& common_column_indices,
-                           const std::set<size_t>& batch_common_node_set)
+                           const std::set<size_t>& batch_common_node_set,
+                           bool enable_columnar_window_agg = false,
+                           bool enable_parallel_producers = false)
         : nm_(nm),
           support_cluster_optimized_(support_cluster_optimized),
+          enable_columnar_window_agg_(enable_columnar_window_agg),
+          enable_parallel_producers_(enable_parallel_producers),
           id_(0),
           cluster_job_(sql, db, common_column_indices),
           task_map_(),
@@ -1526,6 +1650,12 @@ class RunnerBuilder {
         } else {
             cluster_job_.AddMainTask(task);
         }
+        if (enable_parallel_producers_) {
+            std::set<Runner*> visited;
+            for (size_t i = 0; i < cluster_job_.GetTaskSize(); i++) {
+                MarkParallelProducers(cluster_job_.GetTask(i).GetRoot(), &visited);
+            }
+        }
         return cluster_job_;
     }
 
@@ -1538,6 +1668,8 @@ class RunnerBuilder {
  private:
     node::NodeManager* nm_;
     bool support_cluster_optimized_;
+    bool enable_columnar_window_agg_;
+    bool enable_parallel_producers_;
     int32_t id_;
     ClusterJob cluster_job_;
 
@@ -1570,6 +1702,9 @@ class RunnerBuilder {
     ClusterTask BuildRequestTask(RequestRunner* runner);
     ClusterTask UnaryInheritTask(const ClusterTask& input, Runner* runner);
     ClusterTask BuildRequestAggUnionTask(PhysicalOpNode* node, Status& status);  // NOLINT
+    // mark the runners with at least two producers that scan windows, join tables or query
+    // remote tablets independently, so they run the producers concurrently
+    void MarkParallelProducers(Runner* runner, std::set<Runner*>* visited);
 };
 
 class RunnerContext {
@@ -1617,11 +1752,19 @@ class RunnerContext {
     void SetRequest(const hybridse::codec::Row& request);
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
+    ParallelExecutor* parallel_executor() const { return parallel_executor_; }
+    void SetParallelExecutor(ParallelExecutor* executor) { parallel_executor_ = executor; }
+    // bytes allocated by the jit run steps of the runners
+    uint64_t GetArenaBytes() const { return arena_bytes_.load(std::memory_order_relaxed); }
+    std::atomic<uint64_t>* arena_counter() { return &arena_bytes_; }
 
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
     void SetCache(int64_t id, std::shared_ptr<DataHandler> data);
-    void ClearCache() { cache_.clear(); }
+    void ClearCache() {
+        std::lock_guard<std::mutex> lock(cache_mu_);
+        cache_.clear();
+    }
     std::shared_ptr<DataHandlerList> GetBatchCache(int64_t id) const;
     void SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data);
 
@@ -1633,6 +1776,10 @@ class RunnerContext {
     hybridse::codec::Row parameter_;
     size_t idx_;
     const bool is_debug_;
+    ParallelExecutor* parallel_executor_ = nullptr;
+    std::atomic<uint64_t> arena_bytes_{0};
+    // guards cache_, the producers of a runner may run concurrently
+    mutable std::mutex cache_mu_;
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
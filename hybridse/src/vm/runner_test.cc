@@ -14,8 +14,13 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <random>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "boost/algorithm/string.hpp"
@@ -41,6 +46,8 @@
 using namespace llvm;       // NOLINT
 using namespace llvm::orc;  // NOLINT
 
+DECLARE_uint64(last_join_hash_max_bytes);
+
 ExitOnError ExitOnErr;
 
 namespace hybridse {
@@ -524,6 +531,219 @@ TEST_F(RunnerTest, RunnerPrintDataMemTimeTableTest) {
         LOG(INFO) << oss.str();
     }
 }
+
+class SequentialExecutor : public ParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override {
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+};
+
+static bool HasParallelProducers(Runner* root) {
+    if (nullptr == root) {
+        return false;
+    }
+    if (root->parallel_producers()) {
+        return true;
+    }
+    for (auto runner : root->GetProducers()) {
+        if (HasParallelProducers(runner)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_F(RunnerTest, ParallelProducersTest) {
+    std::string sqlstr =
+        "select sum(col2) over w1 as s1, sum(col2) over w2 as s2 from t1 window "
+        "w1 as (partition by col1 order by col5 rows between 3 preceding and current row), "
+        "w2 as (union t2 partition by col1 order by col5 rows between 3 preceding and current row);";
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index1");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::TableDef table_def2;
+    BuildTableDef(table_def2);
+    table_def2.set_name("t2");
+    index = table_def2.add_indexes();
+    index->set_name("index1_t2");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    AddTable(db, table_def2);
+    auto catalog = BuildSimpleCatalog(db);
+
+    for (bool parallel : {false, true}) {
+        SqlCompiler sql_compiler(catalog);
+        SqlContext sql_context;
+        sql_context.sql = sqlstr;
+        sql_context.db = "db";
+        sql_context.engine_mode = kRequestMode;
+        if (parallel) {
+            sql_context.parallel_executor = std::make_shared<SequentialExecutor>();
+        }
+        base::Status compile_status;
+        ASSERT_TRUE(sql_compiler.Compile(sql_context, compile_status)) << compile_status;
+        ASSERT_TRUE(sql_compiler.BuildClusterJob(sql_context, compile_status)) << compile_status;
+        std::ostringstream oss;
+        sql_context.cluster_job.Print(oss, "");
+        LOG(INFO) << "runner:\n" << oss.str();
+        // the two windows scan t1 and t1 union t2 independently
+        ASSERT_EQ(parallel, HasParallelProducers(sql_context.cluster_job.GetMainTask().GetRoot()));
+    }
+}
+
+// run a batch query and return its rows as strings in sorted order
+static std::vector<std::string> RunBatchRows(std::shared_ptr<SimpleCatalog> catalog, const std::string& sql) {
+    Engine engine(catalog);
+    BatchRunSession session;
+    base::Status status;
+    EXPECT_TRUE(engine.Get(sql, "db", session, status)) << status;
+    std::vector<Row> output;
+    EXPECT_EQ(0, session.Run(output));
+    codec::RowView view(session.GetSchema());
+    std::vector<std::string> rows;
+    for (auto& row : output) {
+        view.Reset(row.buf(), row.size());
+        std::string str;
+        for (int i = 0; i < session.GetSchema().size(); i++) {
+            str.append(view.IsNULL(i) ? "NULL" : view.GetAsString(i)).append(",");
+        }
+        rows.push_back(str);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+TEST_F(RunnerTest, LastJoinHashTest) {
+    // t1 and t2(c1 string, c2 int32, c3 int64, c4 timestamp) without index, so the right table
+    // of the last join is a table scan and joins through the hash table
+    hybridse::type::Database db;
+    db.set_name("db");
+    for (auto name : {"t1", "t2"}) {
+        auto* table = db.add_tables();
+        table->set_name(name);
+        table->set_catalog("db");
+        const std::vector<type::Type> types = {type::kVarchar, type::kInt32, type::kInt64, type::kTimestamp};
+        for (size_t i = 0; i < types.size(); i++) {
+            auto* column = table->add_columns();
+            column->set_name("c" + std::to_string(i + 1));
+            column->set_type(types[i]);
+        }
+    }
+    auto catalog = BuildSimpleCatalog(db);
+
+    struct TestRow {
+        std::string c1;
+        int32_t c2;
+        int64_t c3;
+        int64_t c4;
+    };
+    std::mt19937 rng(17);
+    // unique order keys in a key, negative ones included
+    std::vector<int64_t> c3_vals;
+    std::vector<int64_t> c4_vals;
+    for (int64_t i = 0; i < 600; i++) {
+        c3_vals.push_back(i - 300);
+        c4_vals.push_back(1000 + i * 7);
+    }
+    std::shuffle(c3_vals.begin(), c3_vals.end(), rng);
+    std::shuffle(c4_vals.begin(), c4_vals.end(), rng);
+    std::vector<TestRow> left;
+    std::vector<TestRow> right;
+    for (int32_t i = 0; i < 300; i++) {
+        // keys k30 to k34 have no right rows
+        left.push_back({"k" + std::to_string(rng() % 35), i, 0, 0});
+    }
+    for (size_t i = 0; i < c3_vals.size(); i++) {
+        right.push_back({"k" + std::to_string(rng() % 30), static_cast<int32_t>(rng() % 300), c3_vals[i], c4_vals[i]});
+    }
+    auto build_rows = [&db](const std::vector<TestRow>& test_rows) {
+        codec::RowBuilder builder(db.tables(0).columns());
+        std::vector<Row> rows;
+        for (auto& r : test_rows) {
+            uint32_t size = builder.CalTotalLength(r.c1.size());
+            int8_t* buf = static_cast<int8_t*>(malloc(size));
+            builder.SetBuffer(buf, size);
+            builder.AppendString(r.c1.data(), r.c1.size());
+            builder.AppendInt32(r.c2);
+            builder.AppendInt64(r.c3);
+            builder.AppendTimestamp(r.c4);
+            rows.emplace_back(base::RefCountedSlice::CreateManaged(buf, size));
+        }
+        return rows;
+    };
+    ASSERT_TRUE(catalog->InsertRows("db", "t1", build_rows(left)));
+    ASSERT_TRUE(catalog->InsertRows("db", "t2", build_rows(right)));
+
+    // the expected rows: the last join picks the last right row ordered by the order key, which
+    // compares as uint64 in SortGenerator, so the negative keys order after the positive ones
+    auto expect_rows = [&](bool by_ts, bool desc, bool with_cond) {
+        std::vector<std::string> rows;
+        for (auto& l : left) {
+            const TestRow* picked = nullptr;
+            for (auto& r : right) {
+                if (r.c1 != l.c1 || (with_cond && !(r.c2 > l.c2))) {
+                    continue;
+                }
+                uint64_t order = static_cast<uint64_t>(by_ts ? r.c4 : r.c3);
+                uint64_t picked_order = picked == nullptr ? 0 : static_cast<uint64_t>(by_ts ? picked->c4 : picked->c3);
+                if (picked == nullptr || (desc ? order < picked_order : order > picked_order)) {
+                    picked = &r;
+                }
+            }
+            rows.push_back(l.c1 + "," + std::to_string(l.c2) + "," +
+                           (picked == nullptr ? "NULL,NULL," : std::to_string(picked->c2) + "," +
+                                                                   std::to_string(picked->c3) + ","));
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    };
+
+    const std::string select = "SELECT t1.c1, t1.c2, t2.c2 AS r2, t2.c3 AS r3 FROM t1 LAST JOIN t2 ";
+    const std::string cond = " AND t2.c2 > t1.c2;";
+    struct Case {
+        std::string sql;
+        bool by_ts;
+        bool desc;
+        bool with_cond;
+    };
+    std::vector<Case> cases = {
+        {select + "ORDER BY t2.c3 ON t1.c1 = t2.c1" + cond, false, false, true},
+        {select + "ORDER BY t2.c3 DESC ON t1.c1 = t2.c1" + cond, false, true, true},
+        {select + "ORDER BY t2.c4 ON t1.c1 = t2.c1" + cond, true, false, true},
+        // only the winning row of a key is kept in the hash table
+        {select + "ORDER BY t2.c3 ON t1.c1 = t2.c1;", false, false, false},
+        {select + "ORDER BY t2.c3 DESC ON t1.c1 = t2.c1;", false, true, false},
+        {select + "ORDER BY t2.c4 DESC ON t1.c1 = t2.c1;", true, true, false},
+    };
+    auto max_bytes = FLAGS_last_join_hash_max_bytes;
+    // the hash join, the partition join, and the hash join falling back to the partition join
+    // once the hash table exceeds the memory limit
+    for (uint64_t limit : {max_bytes, static_cast<uint64_t>(0), static_cast<uint64_t>(1024)}) {
+        FLAGS_last_join_hash_max_bytes = limit;
+        for (auto& c : cases) {
+            ASSERT_EQ(expect_rows(c.by_ts, c.desc, c.with_cond), RunBatchRows(catalog, c.sql))
+                << c.sql << " with limit " << limit;
+        }
+    }
+
+    // without order, the right rows are picked in the order of the table by both joins
+    for (auto& sql : {select + "ON t1.c1 = t2.c1" + cond, select + "ON t1.c1 = t2.c1;"}) {
+        FLAGS_last_join_hash_max_bytes = 0;
+        auto exp = RunBatchRows(catalog, sql);
+        FLAGS_last_join_hash_max_bytes = max_bytes;
+        ASSERT_EQ(exp, RunBatchRows(catalog, sql)) << sql;
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
 
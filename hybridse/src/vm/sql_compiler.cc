@@ -33,6 +33,7 @@
 #include "vm/runner.h"
 #include "vm/transform.h"
 #include "vm/engine.h"
+#include "vm/jit_object_cache.h"
 
 using ::hybridse::base::Status;
 using hybridse::common::kPlanError;
@@ -125,7 +126,18 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
     }
     InitBuiltinJitSymbols(jit.get());
     ctx.udf_library->InitJITSymbols(jit.get());
-    if (!jit->OptModule(m.get())) {
+    // the module is keyed before optimization, so a cached object skips the opt passes as well. The object is
+    // pinned until the jit links it below, an eviction in between would leave the module unoptimized
+    JitObjectCache::PinnedObject cached_obj;
+    auto obj_cache = JitObjectCache::Get(ctx.jit_options);
+    if (obj_cache) {
+        auto key = JitObjectCache::GetModuleKey(*m);
+        m->setModuleIdentifier(key);
+        if (!keep_ir_) {
+            cached_obj = obj_cache->Pin(key);
+        }
+    }
+    if (!cached_obj && !jit->OptModule(m.get())) {
         LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
         return false;
     }
@@ -307,7 +319,9 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
     RunnerBuilder runner_builder(&ctx.nm, ctx.sql, ctx.db,
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
-                                 ctx.batch_request_info.common_node_set);
+                                 ctx.batch_request_info.common_node_set,
+                                 ctx.enable_columnar_window_agg,
+                                 ctx.parallel_executor != nullptr && vm::kRequestMode == ctx.engine_mode);
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
@@ -368,6 +382,17 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
             }
             break;
         }
+        case kPhysicalOpRequestAggUnion: {
+            auto request_union_op =
+                dynamic_cast<PhysicalRequestAggUnionNode*>(node);
+            for (auto window_union :
+                 request_union_op->window_unions_.window_unions_) {
+                if (!ResolvePlanFnAddress(window_union.first, jit, status)) {
+                    return false;
+                }
+            }
+            break;
+        }
         case kPhysicalOpProject: {
             auto project_op = dynamic_cast<PhysicalProjectNode*>(node);
             if (kWindowAggregation == project_op->project_type_) {
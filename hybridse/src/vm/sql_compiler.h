@@ -45,6 +45,7 @@ struct SqlContext {
     bool enable_expr_optimize = false;
     bool enable_batch_window_parallelization = true;
     bool enable_window_column_pruning = false;
+    bool enable_columnar_window_agg = false;
 
     // the sql content
     std::string sql;
@@ -58,6 +59,8 @@ struct SqlContext {
     // eg using bthead to compile ir
     hybridse::vm::JitOptions jit_options;
     std::shared_ptr<hybridse::vm::HybridSeJitWrapper> jit = nullptr;
+    // runs the independent input subtrees of a request concurrently if not null
+    std::shared_ptr<ParallelExecutor> parallel_executor = nullptr;
     Schema schema;
     Schema request_schema;
     std::string request_db_name;
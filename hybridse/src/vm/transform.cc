@@ -290,8 +290,18 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                 dynamic_cast<PhysicalRequestAggUnionNode*>(node);
             CHECK_STATUS(GenRequestWindow(&request_union_op->window_,
                                           node->producers()[0]));
-            CHECK_STATUS(GenRequestWindow(&request_union_op->agg_window_,
-                                          node->producers()[2]));
+            for (size_t i = 0; i < request_union_op->agg_windows_.size(); i++) {
+                CHECK_STATUS(GenRequestWindow(&request_union_op->agg_windows_[i],
+                                              node->producers()[2 + i]));
+            }
+            for (auto& window_union :
+                 request_union_op->window_unions_.window_unions_) {
+                CHECK_STATUS(InitFnInfo(window_union.first, visited),
+                             "Fail Gen Request Window Union Sub Query Plan");
+            }
+            CHECK_STATUS(
+                GenRequestWindowUnionList(&request_union_op->window_unions_,
+                                          request_union_op->producers()[0]));
             break;
         }
         case kPhysicalOpPostRequestUnion: {
@@ -1774,6 +1784,16 @@ Status BatchModeTransformer::ValidateIndexOptimization(PhysicalOpNode* in) {
             }
             break;
         }
+        case kPhysicalOpRequestAggUnion: {
+            PhysicalRequestAggUnionNode* union_op =
+                dynamic_cast<PhysicalRequestAggUnionNode*>(in);
+            for (auto& window_union :
+                 union_op->window_unions().window_unions_) {
+                CHECK_STATUS(ValidateWindowIndexOptimization(
+                    window_union.second, window_union.first));
+            }
+            break;
+        }
         case kPhysicalOpRequestJoin: {
             PhysicalRequestJoinNode* join_op =
                 dynamic_cast<PhysicalRequestJoinNode*>(in);
@@ -498,18 +498,11 @@ TEST_F(TransformRequestModePassOptimizedTest, SplitAggregationOptimizedTest) {
         "      REQUEST_JOIN(type=kJoinTypeConcat)\n"
         "        PROJECT(type=RowProject)\n"
         "          DATA_PROVIDER(request=t1)\n"
-        "        SIMPLE_PROJECT(sources=(sum(col2)over w1, count(col2)over w1))\n"
-        "          REQUEST_JOIN(type=kJoinTypeConcat)\n"
-        "            PROJECT(type=Aggregation)\n"
-        "              REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
+        "        PROJECT(type=Aggregation)\n"
+        "          REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
         "index_keys=(col1))\n"
-        "                DATA_PROVIDER(request=t1)\n"
-        "                DATA_PROVIDER(type=Partition, table=t1, index=index1)\n"
-        "            PROJECT(type=Aggregation)\n"
-        "              REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
-        "index_keys=(col1))\n"
-        "                DATA_PROVIDER(request=t1)\n"
-        "                DATA_PROVIDER(type=Partition, table=t1, index=index1)\n"
+        "            DATA_PROVIDER(request=t1)\n"
+        "            DATA_PROVIDER(type=Partition, table=t1, index=index1)\n"
         "      PROJECT(type=Aggregation)\n"
         "        REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 3 PRECEDING, 0 CURRENT), "
         "index_keys=(col1,col2))\n"
@@ -563,7 +556,7 @@ TEST_F(TransformRequestModePassOptimizedTest, SplitAggregationOptimizedTest) {
 }
 
 TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedTest) {
-    // five long window agg applied
+    // five long window agg applied, the four over w1 share one pre-aggr scan
     const std::string sql =
         R"(SELECT
             col1,
@@ -587,30 +580,11 @@ TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedTest) {
       REQUEST_JOIN(type=kJoinTypeConcat)
         PROJECT(type=RowProject)
           DATA_PROVIDER(request=t1)
-        SIMPLE_PROJECT(sources=(sum(col2)over w1, count(col2)over w1, cw1, cw2))
-          REQUEST_JOIN(type=kJoinTypeConcat)
-            REQUEST_JOIN(type=kJoinTypeConcat)
-              REQUEST_JOIN(type=kJoinTypeConcat)
-                PROJECT(type=ReduceAggregation: sum(col2)over w1 (range[180000 PRECEDING,0 CURRENT]))
-                  REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), index_keys=(col1))
-                    DATA_PROVIDER(request=t1)
-                    DATA_PROVIDER(type=Partition, table=t1, index=index1)
-                    DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
-                PROJECT(type=ReduceAggregation: count(col2)over w1 (range[180000 PRECEDING,0 CURRENT]))
-                  REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), index_keys=(col1))
-                    DATA_PROVIDER(request=t1)
-                    DATA_PROVIDER(type=Partition, table=t1, index=index1)
-                    DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
-              PROJECT(type=ReduceAggregation: count_where(col0, col1 > 1)over w1 (range[180000 PRECEDING,0 CURRENT]))
-                REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), index_keys=(col1))
-                  DATA_PROVIDER(request=t1)
-                  DATA_PROVIDER(type=Partition, table=t1, index=index1)
-                  DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
-            PROJECT(type=ReduceAggregation: count_where(*, col5 = 0)over w1 (range[180000 PRECEDING,0 CURRENT]))
-              REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), index_keys=(col1))
-                DATA_PROVIDER(request=t1)
-                DATA_PROVIDER(type=Partition, table=t1, index=index1)
-                DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
+        PROJECT(type=ReduceAggregation: sum(col2)over w1 (range[180000 PRECEDING,0 CURRENT]), count(col2)over w1 (range[180000 PRECEDING,0 CURRENT]), count_where(col0, col1 > 1)over w1 (range[180000 PRECEDING,0 CURRENT]), count_where(*, col5 = 0)over w1 (range[180000 PRECEDING,0 CURRENT]))
+          REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), index_keys=(col1))
+            DATA_PROVIDER(request=t1)
+            DATA_PROVIDER(type=Partition, table=t1, index=index1)
+            DATA_PROVIDER(type=Partition, table=aggr_t1, index=index1_t2)
       PROJECT(type=ReduceAggregation: sum(col2)over w2 (range[3 PRECEDING,0 CURRENT]))
         REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 3 PRECEDING, 0 CURRENT), index_keys=(col1,col2))
           DATA_PROVIDER(request=t1)
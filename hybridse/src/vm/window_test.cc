@@ -1546,6 +1546,73 @@ TEST_F(RequestUnionWindowTest, RequestRowsMergeRowsRangeWindowTest) {
             window_range, keys, current_key, exp_keys, exclude_current_time));
     }
 }
+
+TEST_F(RequestUnionWindowTest, RequestUnionWindowsTest) {
+    Row row;
+    auto table1 = std::make_shared<MemTimeTableHandler>();
+    for (uint64_t key : {12L, 10L, 9L, 7L, 7L, 4L, 2L, 0L}) {
+        table1->AddRow(key, row);
+    }
+    auto table2 = std::make_shared<MemTimeTableHandler>();
+    for (uint64_t key : {11L, 9L, 8L, 7L, 3L, 1L}) {
+        table2->AddRow(key, row);
+    }
+    std::vector<std::shared_ptr<TableHandler>> union_segments({table1, table2});
+    std::vector<int64_t> request_ts({10L, 0L, 7L, 20L, 3L, 9L, 7L});
+    std::vector<Row> requests(request_ts.size(), row);
+
+    struct Case {
+        WindowRange window_range;
+        bool exclude_current_time;
+        bool exclude_current_row;
+        // the keys of the window of each request row, the request row first
+        std::vector<std::vector<uint64_t>> exp_keys;
+    };
+    // exclude current row only changes the windows with a max size
+    std::vector<Case> cases({
+        {WindowRange::CreateRowsWindow(3), false, false,
+         {{10, 10, 9, 9}, {0, 0}, {7, 7, 7, 7}, {20, 12, 11, 10}, {3, 3, 2, 1}, {9, 9, 9, 8}, {7, 7, 7, 7}}},
+        {WindowRange::CreateRowsWindow(3), true, false,
+         {{10, 9, 9, 8}, {0}, {7, 4, 3, 2}, {20, 12, 11, 10}, {3, 2, 1, 0}, {9, 8, 7, 7}, {7, 4, 3, 2}}},
+        {WindowRange::CreateRowsRangeWindow(-4, 0), false, false,
+         {{10, 10, 9, 9, 8, 7, 7, 7}, {0, 0}, {7, 7, 7, 7, 4, 3}, {20}, {3, 3, 2, 1, 0}, {9, 9, 9, 8, 7, 7, 7},
+          {7, 7, 7, 7, 4, 3}}},
+        {WindowRange::CreateRowsRangeWindow(-4, 0), true, false,
+         {{10, 9, 9, 8, 7, 7, 7}, {0}, {7, 4, 3}, {20}, {3, 2, 1, 0}, {9, 8, 7, 7, 7}, {7, 4, 3}}},
+        {WindowRange::CreateRowsRangeWindow(-6, -2, 3), false, false,
+         {{10, 8, 7, 7}, {0, 0}, {7, 4, 3, 2}, {20}, {3, 1, 0}, {9, 7, 7, 7}, {7, 4, 3, 2}}},
+        {WindowRange::CreateRowsRangeWindow(-6, -2, 3), false, true,
+         {{10, 8, 7, 7, 7}, {0, 0}, {7, 4, 3, 2, 1}, {20}, {3, 1, 0}, {9, 7, 7, 7, 4}, {7, 4, 3, 2, 1}}},
+        {WindowRange::CreateRowsRangeWindow(-6, -2, 3), true, false,
+         {{10, 8, 7, 7}, {0, 0}, {7, 4, 3, 2}, {20}, {3, 1, 0}, {9, 7, 7, 7}, {7, 4, 3, 2}}},
+        {WindowRange::CreateRowsRangeWindow(-6, -2, 3), true, true,
+         {{10, 8, 7, 7, 7}, {0, 0}, {7, 4, 3, 2, 1}, {20}, {3, 1, 0}, {9, 7, 7, 7, 4}, {7, 4, 3, 2, 1}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-3, 2), false, false,
+         {{10, 10, 9, 9, 8, 7, 7, 7}, {0, 0}, {7, 7, 7, 7, 4}, {20, 12, 11}, {3, 3, 2, 1, 0}, {9, 9, 9, 8, 7, 7, 7},
+          {7, 7, 7, 7, 4}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-3, 2), true, false,
+         {{10, 9, 9, 8, 7, 7, 7}, {0}, {7, 4, 3}, {20, 12, 11}, {3, 2, 1, 0}, {9, 8, 7, 7, 7}, {7, 4, 3}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-5, 2, 4), false, false,
+         {{10, 10, 9, 9}, {0, 0}, {7, 7, 7, 7}, {20, 12, 11}, {3, 3, 2, 1}, {9, 9, 9, 8}, {7, 7, 7, 7}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-5, 2, 4), false, true,
+         {{10, 10, 9, 9, 8}, {0, 0}, {7, 7, 7, 7, 4}, {20, 12, 11}, {3, 3, 2, 1, 0}, {9, 9, 9, 8, 7},
+          {7, 7, 7, 7, 4}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-5, 2, 4), true, false,
+         {{10, 9, 9, 8}, {0}, {7, 4, 3, 2}, {20, 12, 11}, {3, 2, 1, 0}, {9, 8, 7, 7}, {7, 4, 3, 2}}},
+        {WindowRange::CreateRowsMergeRowsRangeWindow(-5, 2, 4), true, true,
+         {{10, 9, 9, 8, 7}, {0}, {7, 4, 3, 2}, {20, 12, 11}, {3, 2, 1, 0}, {9, 8, 7, 7, 7}, {7, 4, 3, 2}}},
+    });
+    for (size_t k = 0; k < cases.size(); k++) {
+        auto& c = cases[k];
+        auto windows = RequestUnionRunner::RequestUnionWindows(requests, union_segments, request_ts, c.window_range,
+                                                               true, c.exclude_current_time, c.exclude_current_row);
+        ASSERT_EQ(requests.size(), windows.size());
+        for (size_t i = 0; i < requests.size(); i++) {
+            SCOPED_TRACE("case " + std::to_string(k) + " request " + std::to_string(i));
+            ASSERT_NO_FATAL_FAILURE(CHECK_TABLE_KEY(windows[i], c.exp_keys[i]));
+        }
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
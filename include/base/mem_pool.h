@@ -35,6 +35,9 @@ class MemoryChunk {
         delete[] mem_;
     }
     inline size_t available_size() const { return chuck_size_ - allocated_size_; }
+    inline size_t capacity() const { return chuck_size_; }
+    // make the whole chuck available again
+    inline void Clear() { allocated_size_ = 0; }
     char* Alloc(size_t request_size) {
         if (request_size > available_size()) {
             return nullptr;
@@ -55,7 +58,7 @@ class MemoryChunk {
 class ByteMemoryPool {
  public:
     explicit ByteMemoryPool(size_t init_size = MemoryChunk::DEFAULT_CHUCK_SIZE)
-        : chucks_(nullptr) {
+        : chucks_(nullptr), allocated_size_(0) {
         ExpandStorage(init_size);
     }
     ~ByteMemoryPool() {
@@ -65,9 +68,13 @@ class ByteMemoryPool {
         if (nullptr == chucks_ || chucks_->available_size() < request_size) {
             ExpandStorage(request_size);
         }
+        allocated_size_ += request_size;
         return chucks_->Alloc(request_size);
     }
 
+    // bytes allocated since the last reset
+    inline size_t allocated_size() const { return allocated_size_; }
+
     // clear last chuck
     // and delete other chucks
     void Reset() {
@@ -77,6 +84,24 @@ class ByteMemoryPool {
             delete chuck;
             chuck = chucks_;
         }
+        allocated_size_ = 0;
+    }
+
+    // reset the pool for reuse. A single chuck of at least retain_size is kept, so the next round
+    // of allocations not larger than retain_size needs no malloc. A chuck much larger than
+    // retain_size is freed to give the memory of a rare large round back
+    void Recycle(size_t retain_size) {
+        if (retain_size < MemoryChunk::DEFAULT_CHUCK_SIZE) {
+            retain_size = MemoryChunk::DEFAULT_CHUCK_SIZE;
+        }
+        if (chucks_ != nullptr && chucks_->next() == nullptr && chucks_->capacity() >= retain_size &&
+            chucks_->capacity() / 2 <= retain_size) {
+            chucks_->Clear();
+            allocated_size_ = 0;
+            return;
+        }
+        Reset();
+        ExpandStorage(retain_size);
     }
     void ExpandStorage(size_t request_size) {
         chucks_ = new MemoryChunk(chucks_, request_size);
@@ -84,6 +109,7 @@ class ByteMemoryPool {
 
  private:
     MemoryChunk* chucks_;
+    size_t allocated_size_;
 };
 }  // namespace base
 }  // namespace openmldb
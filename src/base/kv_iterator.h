@@ -105,6 +105,9 @@ class TraverseKvIterator : public KvIterator {
 
     uint32_t GetTSPos() const { return ts_pos_; }
 
+    // the pairs up to the current one take at least half of the page
+    bool IsPastHalfPage() const { return offset_ * 2 >= tsize_; }
+
  private:
     void Reset();
 
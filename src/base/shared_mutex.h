@@ -0,0 +1,58 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_SHARED_MUTEX_H_
+#define SRC_BASE_SHARED_MUTEX_H_
+
+#include <pthread.h>
+
+namespace openmldb {
+namespace base {
+
+// a shared mutex which prefers the writer. Once a writer waits, the new readers wait behind it, so a writer
+// waits for the readers already holding the lock only. The readers of std::shared_mutex can keep a writer
+// waiting forever on glibc. Method names are chosen so std::lock_guard and std::shared_lock work with it
+class WriterPreferredSharedMutex {
+ public:
+    WriterPreferredSharedMutex() {
+        pthread_rwlockattr_t attr;
+        pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+        pthread_rwlock_init(&rwlock_, &attr);
+        pthread_rwlockattr_destroy(&attr);
+    }
+    ~WriterPreferredSharedMutex() { pthread_rwlock_destroy(&rwlock_); }
+    WriterPreferredSharedMutex(const WriterPreferredSharedMutex&) = delete;
+    WriterPreferredSharedMutex& operator=(const WriterPreferredSharedMutex&) = delete;
+
+    void lock() { pthread_rwlock_wrlock(&rwlock_); }
+    bool try_lock() { return pthread_rwlock_trywrlock(&rwlock_) == 0; }
+    void unlock() { pthread_rwlock_unlock(&rwlock_); }
+
+    void lock_shared() { pthread_rwlock_rdlock(&rwlock_); }
+    bool try_lock_shared() { return pthread_rwlock_tryrdlock(&rwlock_) == 0; }
+    void unlock_shared() { pthread_rwlock_unlock(&rwlock_); }
+
+ private:
+    pthread_rwlock_t rwlock_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_SHARED_MUTEX_H_
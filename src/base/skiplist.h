@@ -21,7 +21,9 @@
 #include <stdint.h>
 
 #include <atomic>
+#include <functional>
 #include <iostream>
+#include <thread>
 
 #include "base/random.h"
 
@@ -77,6 +79,12 @@ class Node {
         return nexts_[level].load(std::memory_order_relaxed);
     }
 
+    // Set the next node only if it is still expected
+    bool CasNext(uint8_t level, Node<K, V>* expected, Node<K, V>* node) {
+        assert(level < height_ && level >= 0);
+        return nexts_[level].compare_exchange_strong(expected, node, std::memory_order_acq_rel);
+    }
+
     V& GetValue() { return value_; }
 
     const K& GetKey() const { return key_; }
@@ -131,6 +139,28 @@ class Skiplist {
         return height;
     }
 
+    // Insert can run with other InsertConcurrently and GetOrInsertConcurrently at the same time,
+    // but Remove, Split, Replace and Clear still need external synchronized with it.
+    // The nodes with the same key may be linked in different orders on the upper levels,
+    // so Remove is only safe on a list without duplicated keys
+    uint8_t InsertConcurrently(const K& key, V& value) {  // NOLINT
+        Node<K, V>* node = NewNode(key, value, RandomHeightConcurrently());
+        LinkConcurrently(node, false);
+        return node->Height();
+    }
+
+    // Return the node of key if it exists, otherwise insert a new one and return it.
+    // The synchronization is the same as InsertConcurrently
+    Node<K, V>* GetOrInsertConcurrently(const K& key, V& value) {  // NOLINT
+        Node<K, V>* node = NewNode(key, value, RandomHeightConcurrently());
+        Node<K, V>* exist = LinkConcurrently(node, true);
+        if (exist != NULL) {
+            delete node;
+            return exist;
+        }
+        return node;
+    }
+
     bool IsEmpty() {
         if (head_->GetNextNoBarrier(0) == NULL) {
             return true;
@@ -237,6 +267,76 @@ class Skiplist {
         }
     }
 
+    // Replace the nodes from first to last (both included) with one node, the keys of the nodes before first
+    // must not be greater than the key of first. The next pointers of the replaced nodes are kept for the running
+    // readers, walk them from first to last to free. Need external synchronized
+    uint8_t Replace(Node<K, V>* first, Node<K, V>* last, const K& key, V& value) {  // NOLINT
+        Node<K, V>* pre[MaxHeight];
+        Node<K, V>* level_last[MaxHeight];
+        Node<K, V>* node = head_;
+        uint8_t level = GetMaxHeight() - 1;
+        while (true) {
+            Node<K, V>* next = node->GetNext(level);
+            if (next != NULL && next != first && compare_(next->GetKey(), first->GetKey()) < 0) {
+                node = next;
+            } else {
+                pre[level] = node;
+                if (level <= 0) {
+                    break;
+                }
+                level--;
+            }
+        }
+        // the nodes with the same key as first may be linked before it
+        for (Node<K, V>* cur = pre[0]->GetNextNoBarrier(0); cur != first; cur = cur->GetNextNoBarrier(0)) {
+            for (uint8_t i = 0; i < cur->Height(); i++) {
+                pre[i] = cur;
+            }
+        }
+        for (uint8_t i = 0; i < MaxHeight; i++) {
+            level_last[i] = NULL;
+        }
+        for (Node<K, V>* cur = first;; cur = cur->GetNextNoBarrier(0)) {
+            for (uint8_t i = 0; i < cur->Height(); i++) {
+                level_last[i] = cur;
+            }
+            if (cur == last) {
+                break;
+            }
+        }
+        uint8_t height = RandomHeight();
+        if (height > GetMaxHeight()) {
+            for (uint8_t i = GetMaxHeight(); i < height; i++) {
+                pre[i] = head_;
+            }
+            max_height_.store(height, std::memory_order_relaxed);
+        }
+        Node<K, V>* new_node = NewNode(key, value, height);
+        Node<K, V>* after[MaxHeight];
+        for (uint8_t i = 0; i < GetMaxHeight(); i++) {
+            after[i] = level_last[i] != NULL ? level_last[i]->GetNextNoBarrier(i) : pre[i]->GetNextNoBarrier(i);
+            if (i < height) {
+                new_node->SetNextNoBarrier(i, after[i]);
+            }
+        }
+        for (uint8_t i = 0; i < GetMaxHeight(); i++) {
+            pre[i]->SetNext(i, i < height ? new_node : after[i]);
+        }
+        if (last == tail_.load(std::memory_order_relaxed)) {
+            tail_.store(new_node, std::memory_order_release);
+        }
+        return height;
+    }
+
+    // Return the first node whose key is not less than key
+    Node<K, V>* LowerBound(const K& key) { return FindLessThan(key)->GetNext(0); }
+
+    // Return the last node whose key is less than key, NULL if there is none
+    Node<K, V>* GetLessThan(const K& key) {
+        Node<K, V>* node = FindLessThan(key);
+        return node == head_ ? NULL : node;
+    }
+
     const V& Get(const K& key) {
         Node<K, V>* node = FindEqual(key);
         return node->GetValue();
@@ -376,6 +476,55 @@ class Skiplist {
         return height;
     }
 
+    uint8_t RandomHeightConcurrently() {
+        static thread_local Random rand(
+            static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+        uint8_t height = 1;
+        while (height < MaxHeight && (rand.Next() % Branch) == 0) {
+            height++;
+        }
+        return height;
+    }
+
+    // Link the node level by level from the bottom with CAS, the node is visible once it is linked on level 0.
+    // If unique is set and the key exists, the node is not linked and the existing one is returned
+    Node<K, V>* LinkConcurrently(Node<K, V>* node, bool unique) {
+        const K& key = node->GetKey();
+        uint8_t height = node->Height();
+        uint8_t max_height = GetMaxHeight();
+        while (height > max_height &&
+               !max_height_.compare_exchange_weak(max_height, height, std::memory_order_relaxed)) {
+        }
+        Node<K, V>* pre[MaxHeight];
+        for (uint8_t i = 0; i < MaxHeight; i++) {
+            pre[i] = head_;
+        }
+        FindLessOrEqual(key, pre);
+        for (uint8_t i = 0; i < height; i++) {
+            while (true) {
+                // the nodes inserted after the search may be between pre and key now
+                Node<K, V>* next = pre[i]->GetNext(i);
+                while (IsAfterNode(key, next)) {
+                    pre[i] = next;
+                    next = next->GetNext(i);
+                }
+                if (i == 0 && unique && next != NULL && compare_(next->GetKey(), key) == 0) {
+                    return next;
+                }
+                node->SetNextNoBarrier(i, next);
+                if (pre[i]->CasNext(i, next, node)) {
+                    break;
+                }
+            }
+        }
+        // the tail only moves forward here, Split and Remove are not running at the same time
+        Node<K, V>* tail = tail_.load(std::memory_order_acquire);
+        while ((tail == NULL || tail == head_ || compare_(tail->GetKey(), key) < 0) &&
+               !tail_.compare_exchange_weak(tail, node, std::memory_order_acq_rel)) {
+        }
+        return NULL;
+    }
+
     Node<K, V>* FindLessOrEqual(const K& key, Node<K, V>** nodes) {
         assert(nodes != NULL);
         Node<K, V>* node = head_;
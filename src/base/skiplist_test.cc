@@ -17,6 +17,7 @@
 #include "base/skiplist.h"
 
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "base/slice.h"
@@ -663,6 +664,157 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, Replace) {
+    Comparator cmp;
+    Skiplist<uint32_t, uint32_t, Comparator> sl(12, 4, cmp);
+    for (uint32_t idx = 0; idx < 1000; idx++) {
+        uint32_t value = idx;
+        sl.Insert(idx, value);
+    }
+    Node<uint32_t, uint32_t>* first = sl.LowerBound(100);
+    ASSERT_EQ(100u, first->GetKey());
+    Node<uint32_t, uint32_t>* last = sl.LowerBound(199);
+    uint32_t value = 10000;
+    sl.Replace(first, last, 100, value);
+    // the replaced nodes are still linked to the list
+    ASSERT_EQ(200u, last->GetNext(0)->GetKey());
+    auto free_nodes = [](Node<uint32_t, uint32_t>* node, Node<uint32_t, uint32_t>* last) {
+        while (true) {
+            Node<uint32_t, uint32_t>* tmp = node;
+            node = node->GetNextNoBarrier(0);
+            delete tmp;
+            if (tmp == last) {
+                break;
+            }
+        }
+    };
+    free_nodes(first, last);
+    ASSERT_EQ(901u, sl.GetSize());
+    ASSERT_EQ(10000u, sl.Get(100));
+    ASSERT_EQ(99u, sl.Get(99));
+    ASSERT_EQ(200u, sl.Get(200));
+    ASSERT_EQ(-1, sl.Get(150, value));
+    for (uint32_t idx = 0; idx < 1000; idx++) {
+        if (idx > 100 && idx < 200) {
+            continue;
+        }
+        ASSERT_EQ(idx, sl.LowerBound(idx)->GetKey());
+    }
+
+    // replace the tail
+    first = sl.LowerBound(900);
+    last = sl.GetLast();
+    value = 20000;
+    sl.Replace(first, last, 900, value);
+    ASSERT_EQ(900u, sl.GetLast()->GetKey());
+    ASSERT_EQ(20000u, sl.GetLast()->GetValue());
+    ASSERT_EQ(802u, sl.GetSize());
+    free_nodes(first, last);
+
+    // the nodes of the same key are linked before first
+    for (uint32_t idx = 0; idx < 20; idx++) {
+        value = idx;
+        sl.Insert(500, value);
+    }
+    first = sl.LowerBound(500);
+    while (first->GetValue() != 500) {
+        first = first->GetNext(0);
+    }
+    value = 30000;
+    sl.Replace(first, first, 500, value);
+    free_nodes(first, first);
+    ASSERT_EQ(822u, sl.GetSize());
+    uint32_t cnt = 0;
+    Node<uint32_t, uint32_t>* node = sl.LowerBound(500);
+    for (; node->GetKey() == 500; node = node->GetNext(0)) {
+        cnt++;
+        value = node->GetValue();
+    }
+    ASSERT_EQ(21u, cnt);
+    ASSERT_EQ(30000u, value);
+    ASSERT_EQ(501u, node->GetKey());
+}
+
+TEST_F(SkiplistTest, InsertConcurrently) {
+    DescComparator cmp;
+    Skiplist<uint32_t, uint32_t, DescComparator> sl(12, 4, cmp);
+    uint32_t thread_num = 8;
+    uint32_t cnt = 10000;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&sl, i, thread_num, cnt] {
+            for (uint32_t idx = i; idx < cnt; idx += thread_num) {
+                uint32_t value = idx;
+                sl.InsertConcurrently(idx, value);
+                // the duplicated key
+                if (idx % 10 == 0) {
+                    sl.InsertConcurrently(idx, value);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(cnt + cnt / 10, sl.GetSize());
+    ASSERT_EQ(0u, sl.GetLast()->GetKey());
+    Skiplist<uint32_t, uint32_t, DescComparator>::Iterator* it = sl.NewIterator();
+    it->SeekToFirst();
+    uint32_t expect = cnt - 1;
+    while (it->Valid()) {
+        ASSERT_EQ(expect, it->GetKey());
+        ASSERT_EQ(expect, it->GetValue());
+        it->Next();
+        if (expect % 10 == 0) {
+            ASSERT_EQ(expect, it->GetKey());
+            it->Next();
+        }
+        expect--;
+    }
+    delete it;
+    for (uint32_t idx = 0; idx < cnt; idx++) {
+        it = sl.NewIterator();
+        it->Seek(idx);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(idx, it->GetKey());
+        delete it;
+    }
+    sl.Clear();
+}
+
+TEST_F(SkiplistTest, GetOrInsertConcurrently) {
+    SliceComparator cmp;
+    Skiplist<Slice, uint32_t, SliceComparator> sl(12, 4, cmp);
+    std::vector<std::string> keys;
+    for (uint32_t idx = 0; idx < 1000; idx++) {
+        keys.push_back("key" + std::to_string(idx));
+    }
+    std::atomic<uint32_t> insert_cnt(0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < 8; i++) {
+        threads.emplace_back([&sl, &keys, &insert_cnt, i] {
+            for (const auto& key : keys) {
+                uint32_t value = i;
+                Node<Slice, uint32_t>* node = sl.GetOrInsertConcurrently(Slice(key), value);
+                ASSERT_EQ(0, node->GetKey().compare(Slice(key)));
+                if (node->GetValue() == i) {
+                    insert_cnt.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(1000u, sl.GetSize());
+    ASSERT_EQ(1000u, insert_cnt.load());
+    for (const auto& key : keys) {
+        Node<Slice, uint32_t>* node = sl.LowerBound(Slice(key));
+        ASSERT_EQ(0, node->GetKey().compare(Slice(key)));
+    }
+    sl.Clear();
+}
+
 }  // namespace base
 }  // namespace openmldb
 
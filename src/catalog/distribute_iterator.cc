@@ -15,21 +15,120 @@
  */
 
 #include "catalog/distribute_iterator.h"
+
+#include <utility>
+
 #include "gflags/gflags.h"
 
 DECLARE_uint32(traverse_cnt_limit);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_uint32(max_traverse_pk_cnt);
+DECLARE_bool(traverse_prefetch);
+DECLARE_uint32(traverse_prefetch_partitions);
 
 namespace openmldb {
 namespace catalog {
 
 constexpr uint32_t INVALID_PID = UINT32_MAX;
 
+TraverseFuture::TraverseFuture(const std::shared_ptr<::openmldb::client::TabletClient>& client, uint32_t tid,
+                               uint32_t pid, const std::string& idx_name, const std::string& pk, uint64_t ts,
+                               bool skip_current_pk, uint32_t ts_pos)
+    : client_(client), tid_(tid), pid_(pid), idx_name_(idx_name), pk_(pk), ts_(ts),
+    skip_current_pk_(skip_current_pk), ts_pos_(ts_pos), callback_(nullptr) {
+    callback_ = new ::openmldb::RpcCallback<::openmldb::api::TraverseResponse>(
+        std::make_shared<::openmldb::api::TraverseResponse>(), std::make_shared<brpc::Controller>());
+    // one reference is released by the rpc when it's done, the other one by this future
+    callback_->Ref();
+    if (!client_->AsyncTraverse(tid_, pid_, idx_name_, pk_, ts_, FLAGS_traverse_cnt_limit, skip_current_pk_, ts_pos_,
+                                callback_)) {
+        callback_->UnRef();
+        callback_->UnRef();
+        callback_ = nullptr;
+    }
+}
+
+TraverseFuture::~TraverseFuture() {
+    if (callback_ != nullptr) {
+        brpc::StartCancel(callback_->GetController()->call_id());
+        callback_->UnRef();
+    }
+}
+
+std::shared_ptr<::openmldb::base::TraverseKvIterator> TraverseFuture::Get(uint32_t* count) {
+    if (callback_ == nullptr) {
+        return client_->Traverse(tid_, pid_, idx_name_, pk_, ts_, FLAGS_traverse_cnt_limit, skip_current_pk_, ts_pos_,
+                                 *count);
+    }
+    auto cntl = callback_->GetController();
+    auto response = callback_->GetResponse();
+    brpc::Join(cntl->call_id());
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> it;
+    if (!cntl->Failed() && response->code() == 0) {
+        *count = response->count();
+        it = std::make_shared<::openmldb::base::TraverseKvIterator>(response);
+    } else {
+        DLOG(WARNING) << "prefetched traverse failed. tid " << tid_ << " pid " << pid_ << " "
+                      << (cntl->Failed() ? cntl->ErrorText() : response->msg());
+    }
+    callback_->UnRef();
+    callback_ = nullptr;
+    return it;
+}
+
+std::shared_ptr<::openmldb::base::TraverseKvIterator> RemoteFirstPages::Get(const TabletClients& clients,
+                                                                            uint32_t pid, uint32_t* count) {
+    auto iter = clients.find(pid);
+    if (iter == clients.end()) {
+        return {};
+    }
+    pages_.erase(pages_.begin(), pages_.lower_bound(pid));
+    auto page = pages_.find(pid);
+    std::unique_ptr<TraverseFuture> future;
+    if (page != pages_.end()) {
+        future = std::move(page->second);
+        pages_.erase(page);
+    }
+    // keep the following partitions in flight while this one is iterated
+    auto next = iter;
+    for (uint32_t i = 0; i < FLAGS_traverse_prefetch_partitions && ++next != clients.end(); i++) {
+        if (pages_.find(next->first) == pages_.end()) {
+            pages_.emplace(next->first, std::make_unique<TraverseFuture>(next->second, tid_, next->first, idx_name_,
+                                                                         "", 0, false, 0));
+        }
+    }
+    if (future) {
+        return future->Get(count);
+    }
+    return iter->second->Traverse(tid_, pid, idx_name_, "", 0, FLAGS_traverse_cnt_limit, false, 0, *count);
+}
+
+// request the page following the current one while it is iterated
+static void PrefetchPage(const std::shared_ptr<::openmldb::client::TabletClient>& client, uint32_t tid, uint32_t pid,
+                         const std::string& idx_name, const std::string& pk, uint64_t ts, bool skip_current_pk,
+                         uint32_t ts_pos, std::unique_ptr<TraverseFuture>* next_page) {
+    next_page->reset();
+    if (FLAGS_traverse_prefetch && client) {
+        next_page->reset(new TraverseFuture(client, tid, pid, idx_name, pk, ts, skip_current_pk, ts_pos));
+    }
+}
+
+// the prefetched page if it's the one requested, or traverse it now
+static std::shared_ptr<::openmldb::base::TraverseKvIterator> TakePage(
+    const std::shared_ptr<::openmldb::client::TabletClient>& client, uint32_t tid, uint32_t pid,
+    const std::string& idx_name, const std::string& pk, uint64_t ts, bool skip_current_pk, uint32_t ts_pos,
+    std::unique_ptr<TraverseFuture>* next_page, uint32_t* count) {
+    auto page = std::move(*next_page);
+    if (page && page->Match(pid, pk, ts, skip_current_pk, ts_pos)) {
+        return page->Get(count);
+    }
+    return client->Traverse(tid, pid, idx_name, pk, ts, FLAGS_traverse_cnt_limit, skip_current_pk, ts_pos, *count);
+}
+
 FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), tables_(tables), tablet_clients_(tablet_clients), in_local_(true), cur_pid_(INVALID_PID),
-    it_(), kv_it_(), key_(0), last_ts_(0), last_pk_(), value_() {
+    it_(), kv_it_(), key_(0), last_ts_(0), last_pk_(), value_(), first_pages_(tid, "") {
 }
 
 void FullTableIterator::SeekToFirst() {
@@ -64,6 +163,8 @@ void FullTableIterator::Reset() {
     in_local_ = true;
     ResetValue();
     cnt_ = 0;
+    first_pages_.Clear();
+    next_page_.reset();
 }
 
 void FullTableIterator::EndLocal() {
@@ -141,17 +242,18 @@ bool FullTableIterator::NextFromRemote() {
         uint32_t count = 0;
         if (kv_it_) {
             if (!kv_it_->IsFinish()) {
-                kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
-                            FLAGS_traverse_cnt_limit, false, kv_it_->GetTSPos(), count);
+                uint32_t ts_pos = kv_it_->GetTSPos();
+                kv_it_ = TakePage(iter->second, tid_, cur_pid_, "", last_pk_, last_ts_, false, ts_pos, &next_page_,
+                                  &count);
                 DLOG(INFO) << "pid " << cur_pid_ << " last pk " << last_pk_ <<
-                    " key " << last_ts_ << " ts_pos " << kv_it_->GetTSPos() << " count " << count;
+                    " key " << last_ts_ << " ts_pos " << ts_pos << " count " << count;
             } else {
                 iter++;
                 kv_it_.reset();
                 continue;
             }
         } else {
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, 0, count);
+            kv_it_ = first_pages_.Get(tablet_clients_, cur_pid_, &count);
             DLOG(INFO) << "count " << count;
         }
         if (kv_it_ && kv_it_->Valid()) {
@@ -159,6 +261,10 @@ bool FullTableIterator::NextFromRemote() {
             last_ts_ = kv_it_->GetLastTS();
             response_vec_.emplace_back(kv_it_->GetResponse());
             key_ = kv_it_->GetKey();
+            if (!kv_it_->IsFinish()) {
+                PrefetchPage(iter->second, tid_, cur_pid_, "", last_pk_, last_ts_, false, kv_it_->GetTSPos(),
+                             &next_page_);
+            }
             break;
         }
         iter++;
@@ -193,13 +299,30 @@ DistributeWindowIterator::DistributeWindowIterator(uint32_t tid, uint32_t pid_nu
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), pid_num_(pid_num), tables_(tables), tablet_clients_(tablet_clients),
     index_(index), index_name_(index_name),
-    cur_pid_(0), it_(), kv_it_() {}
+    cur_pid_(0), it_(), kv_it_(), first_pages_(tid, index_name) {}
 
 void DistributeWindowIterator::Reset() {
     it_.reset();
     kv_it_.reset();
     cur_pid_ = INVALID_PID;
     pk_cnt_ = 0;
+    first_pages_.Clear();
+    next_page_.reset();
+}
+
+void DistributeWindowIterator::PrefetchNextPage() {
+    auto traverse_it = std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it_);
+    if (!traverse_it || traverse_it->IsFinish()) {
+        next_page_.reset();
+        return;
+    }
+    auto iter = tablet_clients_.find(cur_pid_);
+    if (iter == tablet_clients_.end()) {
+        return;
+    }
+    // the page following the last pk of this one, as Next requests it
+    PrefetchPage(iter->second, tid_, cur_pid_, index_name_, traverse_it->GetLastPK(), traverse_it->GetLastTS(), true,
+                 traverse_it->GetTSPos(), &next_page_);
 }
 
 // seek to the pos where key = `key` on success
@@ -227,7 +350,7 @@ void DistributeWindowIterator::Seek(const std::string& key) {
 DistributeWindowIterator::ItStat DistributeWindowIterator::SeekToFirstRemote() const {
     for (const auto& kv : tablet_clients_) {
         uint32_t count = 0;
-        auto it = kv.second->Traverse(tid_, kv.first, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, 0, count);
+        auto it = first_pages_.Get(tablet_clients_, kv.first, &count);
         if (it && it->Valid()) {
             DLOG(INFO) << "first pos in remote: pid=" << kv.first;
             return {kv.first, nullptr, it};
@@ -260,6 +383,7 @@ void DistributeWindowIterator::SeekToFirst() {
         response_vec_.push_back(stat.kv_it->GetResponse());
         kv_it_ = stat.kv_it;
         cur_pid_ = stat.pid;
+        PrefetchNextPage();
         return;
     }
     DLOG(INFO) << "empty window iterator";
@@ -343,11 +467,12 @@ void DistributeWindowIterator::Next() {
             return;
         }
         uint32_t count = 0;
-        kv_it_ = iter->second->Traverse(tid_, cur_pid_, index_name_, cur_pk, last_ts,
-                FLAGS_traverse_cnt_limit, true, ts_pos, count);
+        kv_it_ = TakePage(iter->second, tid_, cur_pid_, index_name_, cur_pk, last_ts, true, ts_pos, &next_page_,
+                          &count);
         DLOG(INFO) << "pid " << cur_pid_ << " last pk " << cur_pk << " key " << last_ts << " count " << count;
         if (kv_it_ && kv_it_->Valid()) {
             response_vec_.emplace_back(kv_it_->GetResponse());
+            PrefetchNextPage();
             return;
         }
         do {
@@ -357,11 +482,11 @@ void DistributeWindowIterator::Next() {
             }
             cur_pid_ = iter->first;
             uint32_t count = 0;
-            kv_it_ =
-                iter->second->Traverse(tid_, cur_pid_, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, 0, count);
+            kv_it_ = first_pages_.Get(tablet_clients_, cur_pid_, &count);
             DLOG(INFO) << "count " << count;
             if (kv_it_ && kv_it_->Valid()) {
                 response_vec_.emplace_back(kv_it_->GetResponse());
+                PrefetchNextPage();
                 break;
             }
             kv_it_.reset();
@@ -372,6 +497,7 @@ void DistributeWindowIterator::Next() {
             response_vec_.push_back(stat.kv_it->GetResponse());
             kv_it_ = stat.kv_it;
             cur_pid_ = stat.pid;
+            PrefetchNextPage();
             return;
         }
     }
@@ -437,13 +563,28 @@ RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std
         pk_ = kv_it_->GetPK();
         ts_ = kv_it_->GetKey();
         response_vec_.emplace_back(kv_it_->GetResponse());
-        auto traverse_it = std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it);
-        if (traverse_it) {
+        if (std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it)) {
             is_traverse_data_ = true;
         }
     }
 }
 
+void RemoteWindowIterator::PrefetchNextPage() {
+    auto traverse_it = std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it_);
+    // the next page is only needed if this one ends in the middle of the pk. it's requested once the
+    // consumer is past half of this one, so it arrives while the rest is read, and the window of a seek that
+    // ends early, e.g. a request row, costs no extra request. at most one page is in flight
+    if (!traverse_it || traverse_it->IsFinish() || traverse_it->GetLastPK() != pk_) {
+        next_page_.reset();
+        return;
+    }
+    if (!traverse_it->IsPastHalfPage()) {
+        return;
+    }
+    PrefetchPage(tablet_client_, tid_, pid_, index_name_, pk_, traverse_it->GetLastTS(), false,
+                 traverse_it->GetTSPos(), &next_page_);
+}
+
 bool RemoteWindowIterator::Valid() const {
     if (!kv_it_ || !kv_it_->Valid()) {
         return false;
@@ -457,13 +598,13 @@ bool RemoteWindowIterator::Valid() const {
 
 void RemoteWindowIterator::ScanRemote(uint64_t key, uint32_t ts_pos) {
     uint32_t count = 0;
-    kv_it_ = tablet_client_->Traverse(tid_, pid_, index_name_, pk_, key,
-                FLAGS_traverse_cnt_limit, false, ts_pos, count);
+    kv_it_ = TakePage(tablet_client_, tid_, pid_, index_name_, pk_, key, false, ts_pos, &next_page_, &count);
     DLOG(INFO) << "traverse key " << pk_ << " ts " << key << " from remote. tid "
         << tid_ << " pid " << pid_ << " ts_pos " << ts_pos;
     if (kv_it_ && kv_it_->Valid()) {
         ts_ = kv_it_->GetKey();
         response_vec_.emplace_back(kv_it_->GetResponse());
+        PrefetchNextPage();
     }
 }
 
@@ -497,6 +638,9 @@ void RemoteWindowIterator::Next() {
             return;
         }
         ts_ = kv_it_->GetKey();
+        if (is_traverse_data_ && !next_page_) {
+            PrefetchNextPage();
+        }
     } else {
         auto traverse_it = std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it_);
         ScanRemote(traverse_it->GetLastTS(), traverse_it->GetTSPos());
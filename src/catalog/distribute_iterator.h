@@ -32,6 +32,54 @@ namespace openmldb {
 namespace catalog {
 
 using Tables = std::map<uint32_t, std::shared_ptr<::openmldb::storage::Table>>;
+using TabletClients = std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>;
+
+// a traverse request of a remote partition sent ahead of its use
+class TraverseFuture {
+ public:
+    TraverseFuture(const std::shared_ptr<::openmldb::client::TabletClient>& client, uint32_t tid, uint32_t pid,
+                   const std::string& idx_name, const std::string& pk, uint64_t ts, bool skip_current_pk,
+                   uint32_t ts_pos);
+    ~TraverseFuture();
+    TraverseFuture(const TraverseFuture&) = delete;
+    TraverseFuture& operator=(const TraverseFuture&) = delete;
+
+    bool Match(uint32_t pid, const std::string& pk, uint64_t ts, bool skip_current_pk, uint32_t ts_pos) const {
+        return pid_ == pid && pk_ == pk && ts_ == ts && skip_current_pk_ == skip_current_pk && ts_pos_ == ts_pos;
+    }
+
+    // wait for the response, the same result as TabletClient::Traverse. it can be called only once
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> Get(uint32_t* count);
+
+ private:
+    std::shared_ptr<::openmldb::client::TabletClient> client_;
+    uint32_t tid_;
+    uint32_t pid_;
+    std::string idx_name_;
+    std::string pk_;
+    uint64_t ts_;
+    bool skip_current_pk_;
+    uint32_t ts_pos_;
+    // null if the request is not sent
+    ::openmldb::RpcCallback<::openmldb::api::TraverseResponse>* callback_;
+};
+
+// the first traverse pages of the remote partitions, at most FLAGS_traverse_prefetch_partitions of the
+// partitions following the one taken are requested ahead
+class RemoteFirstPages {
+ public:
+    RemoteFirstPages(uint32_t tid, const std::string& idx_name) : tid_(tid), idx_name_(idx_name) {}
+
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> Get(const TabletClients& clients, uint32_t pid,
+                                                              uint32_t* count);
+
+    void Clear() { pages_.clear(); }
+
+ private:
+    uint32_t tid_;
+    std::string idx_name_;
+    std::map<uint32_t, std::unique_ptr<TraverseFuture>> pages_;
+};
 
 class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hybridse::codec::Row> {
  public:
@@ -83,6 +131,8 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     bool valid_value_ = false;
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
     int64_t cnt_ = 0;
+    RemoteFirstPages first_pages_;
+    std::unique_ptr<TraverseFuture> next_page_;
 };
 
 class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
@@ -111,6 +161,8 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
  private:
     void ScanRemote(uint64_t key, uint32_t ts_pos);
 
+    void PrefetchNextPage();
+
     inline void ResetValue() {
         valid_value_ = false;
     }
@@ -137,6 +189,7 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
     bool is_traverse_data_;
     std::string pk_;
     mutable uint64_t ts_;
+    std::unique_ptr<TraverseFuture> next_page_;
 };
 
 class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
@@ -173,6 +226,8 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
 
     ItStat SeekToFirstRemote() const;
 
+    void PrefetchNextPage();
+
  private:
     const uint32_t tid_;
     const uint32_t pid_num_;
@@ -189,6 +244,8 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
     // underlaying data pointed by `kv_it_`
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
     int64_t pk_cnt_ = 0;
+    mutable RemoteFirstPages first_pages_;
+    std::unique_ptr<TraverseFuture> next_page_;
 };
 
 }  // namespace catalog
@@ -16,6 +16,7 @@
 
 #include "catalog/distribute_iterator.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <utility>
@@ -34,6 +35,7 @@ DECLARE_string(db_root_path);
 DECLARE_uint32(traverse_cnt_limit);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_uint32(max_traverse_pk_cnt);
+DECLARE_bool(traverse_prefetch);
 
 namespace openmldb {
 namespace catalog {
@@ -994,6 +996,117 @@ TEST_F(DistributeIteratorTest, IteratorZero) {
     FLAGS_traverse_cnt_limit = old_limit;
 }
 
+// counts the traverse requests served
+class TraverseCountTablet : public ::openmldb::tablet::TabletImpl {
+ public:
+    void Traverse(::google::protobuf::RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                  ::openmldb::api::TraverseResponse* response, ::google::protobuf::Closure* done) override {
+        traverse_cnt_++;
+        TabletImpl::Traverse(controller, request, response, done);
+    }
+
+    int GetTraverseCnt() const { return traverse_cnt_.load(); }
+
+ private:
+    std::atomic<int> traverse_cnt_{0};
+};
+
+TEST_F(DistributeIteratorTest, RemoteIteratorPrefetch) {
+    uint32_t old_limit = FLAGS_traverse_cnt_limit;
+    bool old_prefetch = FLAGS_traverse_prefetch;
+    FLAGS_traverse_cnt_limit = 7;
+    uint32_t tid = 3;
+    auto tables = std::make_shared<Tables>();
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::string endpoint = "127.0.0.1:9230";
+    FLAGS_endpoint = endpoint;
+    auto tablet = new TraverseCountTablet();
+    ASSERT_TRUE(tablet->Init(""));
+    brpc::Server server;
+    ASSERT_EQ(server.AddService(tablet, brpc::SERVER_OWNS_SERVICE), 0);
+    brpc::ServerOptions option;
+    ASSERT_EQ(server.Start(endpoint.c_str(), &option), 0);
+    ASSERT_TRUE(tablet->RegisterZK());
+    auto client = std::make_shared<openmldb::client::TabletClient>(endpoint, endpoint);
+    ASSERT_EQ(client->Init(), 0);
+    auto meta = CreateTableMeta(tid, 0);
+    ASSERT_TRUE(client->CreateTable(meta));
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{0, client}};
+    // the windows span several pages
+    int key_num = 5;
+    int row_num = 20;
+    for (int i = 0; i < key_num; i++) {
+        PutKey("card" + std::to_string(i), meta, client, row_num);
+    }
+
+    // all the rows of all the windows, and the traverse requests taken to read them
+    auto read_all = [&](std::vector<std::pair<std::string, int64_t>>* rows) {
+        int start_cnt = tablet->GetTraverseCnt();
+        {
+            DistributeWindowIterator w_it(tid, 1, tables, 0, "card", tablet_clients);
+            w_it.SeekToFirst();
+            while (w_it.Valid()) {
+                std::string key = w_it.GetKey().ToString();
+                auto it = w_it.GetValue();
+                it->SeekToFirst();
+                while (it->Valid()) {
+                    rows->emplace_back(key, it->GetKey());
+                    it->Next();
+                }
+                w_it.Next();
+            }
+        }
+        // the requests in flight are served before they are counted
+        sleep(1);
+        return tablet->GetTraverseCnt() - start_cnt;
+    };
+    FLAGS_traverse_prefetch = false;
+    std::vector<std::pair<std::string, int64_t>> expect_rows;
+    int expect_cnt = read_all(&expect_rows);
+    ASSERT_EQ(expect_rows.size(), static_cast<size_t>(key_num * row_num));
+    FLAGS_traverse_prefetch = true;
+    std::vector<std::pair<std::string, int64_t>> rows;
+    int cnt = read_all(&rows);
+    ASSERT_EQ(rows, expect_rows);
+    // every page prefetched is used
+    ASSERT_EQ(cnt, expect_cnt);
+
+    // a window read from a seek is not prefetched before its consumer is past half of the page
+    int start_cnt = tablet->GetTraverseCnt();
+    {
+        DistributeWindowIterator w_it(tid, 1, tables, 0, "card", tablet_clients);
+        w_it.Seek("card0");
+        ASSERT_TRUE(w_it.Valid());
+        auto it = w_it.GetValue();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(it->GetKey(), static_cast<uint64_t>(row_num));
+        it->Next();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(it->GetKey(), static_cast<uint64_t>(row_num - 1));
+    }
+    sleep(1);
+    ASSERT_EQ(tablet->GetTraverseCnt() - start_cnt, 1);
+    // and the next page is in flight once it is, while the rest of the page is read
+    start_cnt = tablet->GetTraverseCnt();
+    {
+        DistributeWindowIterator w_it(tid, 1, tables, 0, "card", tablet_clients);
+        w_it.Seek("card0");
+        ASSERT_TRUE(w_it.Valid());
+        auto it = w_it.GetValue();
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(it->GetKey(), static_cast<uint64_t>(row_num - i));
+            if (i < 3) {
+                it->Next();
+            }
+        }
+        sleep(1);
+        ASSERT_EQ(tablet->GetTraverseCnt() - start_cnt, 2);
+    }
+    FLAGS_traverse_cnt_limit = old_limit;
+    FLAGS_traverse_prefetch = old_prefetch;
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
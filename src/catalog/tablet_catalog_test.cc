@@ -17,6 +17,11 @@
 #include "catalog/tablet_catalog.h"
 
 #include <absl/strings/str_cat.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
 #include <vector>
 
 #include "base/fe_status.h"
@@ -27,6 +32,7 @@
 #include "schema/schema_adapter.h"
 #include "storage/mem_table.h"
 #include "storage/table.h"
+#include "tablet/parallel_executor.h"
 #include "vm/engine.h"
 
 namespace openmldb {
@@ -1229,6 +1235,140 @@ TEST_F(TabletCatalogTest, long_window_empty) {
     }
 }
 
+// counts the parallel runs and the bthreads the tasks run on
+class CountingExecutor : public ::openmldb::tablet::BthreadParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            runs_++;
+        }
+        std::vector<std::function<void()>> counted_tasks;
+        for (auto& task : tasks) {
+            counted_tasks.emplace_back([this, &task]() {
+                {
+                    std::lock_guard<std::mutex> lock(mu_);
+                    bthreads_.insert(bthread_self());
+                }
+                task();
+            });
+        }
+        BthreadParallelExecutor::RunAll(counted_tasks);
+    }
+
+    uint64_t runs() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return runs_;
+    }
+
+    size_t bthread_cnt() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return bthreads_.size();
+    }
+
+ private:
+    std::mutex mu_;
+    uint64_t runs_ = 0;
+    std::set<bthread_t> bthreads_;
+};
+
+static void* RunFunction(void* arg) {
+    (*static_cast<std::function<void()>*>(arg))();
+    return nullptr;
+}
+
+TEST_F(TabletCatalogTest, parallel_request_subtree_test) {
+    std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
+    ASSERT_TRUE(catalog->Init());
+    int num_pk = 4, num_ts = 50;
+    TestArgs args = PrepareTable("t1", num_pk, num_ts, true);
+    ASSERT_TRUE(catalog->AddTable(args.meta[0], args.tables[0]));
+    TestArgs args2 = PrepareTable("t2", num_pk, num_ts);
+    ASSERT_TRUE(catalog->AddTable(args2.meta[0], args2.tables[0]));
+
+    // the window of t1 and the window of t1 union t2 run concurrently
+    std::string sql =
+        "SELECT col1, sum(i32_col) OVER w1 AS s1, avg(d_col) OVER w1 AS a1, sum(i64_col) OVER w2 AS s2, "
+        "max(f_col) OVER w2 AS m2, count(s_col) OVER w2 AS n2 FROM t1 WINDOW "
+        "w1 AS (PARTITION BY col1 ORDER BY col2 ROWS BETWEEN 10 PRECEDING AND CURRENT ROW), "
+        "w2 AS (UNION t2 PARTITION BY col1 ORDER BY col2 ROWS_RANGE BETWEEN 20 PRECEDING AND CURRENT ROW);";
+
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(args.meta[0].column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    std::vector<std::string> request_bufs;
+    for (int i = 0; i <= num_pk; i++) {
+        for (int64_t ts : {1, 25, 50, 60}) {
+            std::string pk = "pk" + std::to_string(i);
+            std::string ts_str = std::to_string(ts);
+            std::string value;
+            value.resize(rb.CalTotalLength(pk.size() + ts_str.size()));
+            rb.SetBuffer(reinterpret_cast<int8_t*>(&(value[0])), value.size());
+            rb.AppendString(pk.c_str(), pk.size());
+            rb.AppendInt64(ts);
+            rb.AppendInt16(ts);
+            rb.AppendInt32(ts);
+            rb.AppendInt64(ts);
+            rb.AppendFloat(ts);
+            rb.AppendDouble(ts);
+            rb.AppendTimestamp(ts);
+            rb.AppendString(ts_str.c_str(), ts_str.size());
+            request_bufs.push_back(value);
+        }
+    }
+    std::vector<::hybridse::codec::Row> requests;
+    for (auto& buf : request_bufs) {
+        requests.emplace_back(::hybridse::base::RefCountedSlice::Create(buf.c_str(), buf.size()));
+    }
+
+    ::hybridse::base::Status status;
+    std::vector<std::string> expect;
+    {
+        ::hybridse::vm::Engine engine(catalog);
+        ::hybridse::vm::RequestRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "db1", session, status)) << status.msg;
+        for (auto& request : requests) {
+            ::hybridse::codec::Row output;
+            ASSERT_EQ(0, session.Run(request, &output));
+            expect.emplace_back(reinterpret_cast<const char*>(output.buf()), output.size());
+        }
+    }
+
+    auto executor = std::make_shared<CountingExecutor>();
+    ::hybridse::vm::EngineOptions options;
+    options.SetParallelExecutor(executor);
+    ::hybridse::vm::Engine engine(catalog, options);
+    std::atomic<int> mismatch{0};
+    std::function<void()> run = [&]() {
+        ::hybridse::vm::RequestRunSession session;
+        ::hybridse::base::Status status;
+        if (!engine.Get(sql, "db1", session, status)) {
+            mismatch++;
+            return;
+        }
+        for (int iter = 0; iter < 20; iter++) {
+            for (size_t i = 0; i < requests.size(); i++) {
+                ::hybridse::codec::Row output;
+                if (session.Run(requests[i], &output) != 0 ||
+                    expect[i] != std::string(reinterpret_cast<const char*>(output.buf()), output.size())) {
+                    mismatch++;
+                }
+            }
+        }
+    };
+    // requests run on bthreads concurrently as in the tablet
+    std::vector<bthread_t> tids(4);
+    for (auto& tid : tids) {
+        ASSERT_EQ(0, bthread_start_background(&tid, nullptr, RunFunction, &run));
+    }
+    for (auto tid : tids) {
+        bthread_join(tid, nullptr);
+    }
+    ASSERT_EQ(0, mismatch.load());
+    ASSERT_GE(executor->runs(), tids.size() * 20 * requests.size());
+    ASSERT_GT(executor->bthread_cnt(), tids.size());
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
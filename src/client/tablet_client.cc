@@ -263,6 +263,24 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
     return false;
 }
 
+bool TabletClient::PutBatch(const ::openmldb::api::PutBatchRequest& request,
+                            ::openmldb::api::PutBatchResponse* response, bool* unimplemented) {
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    cntl.set_max_retry(1);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, &cntl, &request, response);
+    if (ok && response->code() == 0) {
+        return true;
+    }
+    if (unimplemented != nullptr) {
+        // the tablets of the versions before PutBatch
+        *unimplemented = !ok && cntl.ErrorCode() == brpc::ENOMETHOD;
+    }
+    LOG(WARNING) << "fail to send put batch request for " << response->msg() << " and error code "
+                 << response->code() << ". tid " << request.tid() << " pid " << request.pid();
+    return false;
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value) {
     ::openmldb::api::PutRequest request;
     auto dim = request.add_dimensions();
@@ -880,23 +898,29 @@ bool TabletClient::DeleteBinlog(uint32_t tid, uint32_t pid, openmldb::common::St
     return true;
 }
 
+static void SetTraverseRequest(uint32_t tid, uint32_t pid, const std::string& idx_name, const std::string& pk,
+                               uint64_t ts, uint32_t limit, bool skip_current_pk, uint32_t ts_pos,
+                               ::openmldb::api::TraverseRequest* request) {
+    request->set_tid(tid);
+    request->set_pid(pid);
+    request->set_limit(limit);
+    if (!idx_name.empty()) {
+        request->set_idx_name(idx_name);
+    }
+    if (!pk.empty()) {
+        request->set_pk(pk);
+        request->set_ts(ts);
+        request->set_ts_pos(ts_pos);
+    }
+    request->set_skip_current_pk(skip_current_pk);
+}
+
 std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint32_t tid, uint32_t pid,
         const std::string& idx_name, const std::string& pk, uint64_t ts, uint32_t limit, bool skip_current_pk,
         uint32_t ts_pos, uint32_t& count) {
     ::openmldb::api::TraverseRequest request;
     auto response = std::make_shared<openmldb::api::TraverseResponse>();
-    request.set_tid(tid);
-    request.set_pid(pid);
-    request.set_limit(limit);
-    if (!idx_name.empty()) {
-        request.set_idx_name(idx_name);
-    }
-    if (!pk.empty()) {
-        request.set_pk(pk);
-        request.set_ts(ts);
-        request.set_ts_pos(ts_pos);
-    }
-    request.set_skip_current_pk(skip_current_pk);
+    SetTraverseRequest(tid, pid, idx_name, pk, ts, limit, skip_current_pk, ts_pos, &request);
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, &request, response.get(),
                                   FLAGS_request_timeout_ms, FLAGS_request_max_retry);
     if (!ok || response->code() != 0) {
@@ -906,6 +930,21 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
     return std::make_shared<openmldb::base::TraverseKvIterator>(response);
 }
 
+bool TabletClient::AsyncTraverse(uint32_t tid, uint32_t pid, const std::string& idx_name, const std::string& pk,
+                                 uint64_t ts, uint32_t limit, bool skip_current_pk, uint32_t ts_pos,
+                                 openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    ::openmldb::api::TraverseRequest request;
+    SetTraverseRequest(tid, pid, idx_name, pk, ts, limit, skip_current_pk, ts_pos, &request);
+    auto cntl = callback->GetController();
+    cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+    cntl->set_max_retry(FLAGS_request_max_retry);
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, cntl.get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::SetMode(bool mode) {
     ::openmldb::api::SetModeRequest request;
     ::openmldb::api::GeneralResponse response;
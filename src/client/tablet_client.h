@@ -81,6 +81,11 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
              const std::vector<std::pair<std::string, uint32_t>>& dimensions);
 
+    // return false if the request failed or some rows failed, check response->failed_idx for the rows.
+    // unimplemented is set if the tablet does not support PutBatch
+    bool PutBatch(const ::openmldb::api::PutBatchRequest& request, ::openmldb::api::PutBatchResponse* response,
+                  bool* unimplemented = nullptr);
+
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
              uint64_t& ts,                                                                          // NOLINT
              std::string& msg);                        ;                                             // NOLINT
@@ -193,6 +198,11 @@ class TabletClient : public Client {
             const std::string& idx_name, const std::string& pk, uint64_t ts,
             uint32_t limit, bool skip_current_pk, uint32_t ts_pos, uint32_t& count);  // NOLINT
 
+    // the same request as Traverse, `callback` runs when the response arrives
+    bool AsyncTraverse(uint32_t tid, uint32_t pid, const std::string& idx_name, const std::string& pk, uint64_t ts,
+                       uint32_t limit, bool skip_current_pk, uint32_t ts_pos,
+                       openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback);
+
     bool SetMode(bool mode);
 
     bool DeleteIndex(uint32_t tid, uint32_t pid, const std::string& idx_name, std::string* msg);
@@ -17,7 +17,6 @@
 #pragma once
 
 #include <gflags/gflags.h>
-#include <snappy.h>
 
 #include <map>
 #include <string>
@@ -29,6 +28,7 @@
 #include "boost/regex.hpp"
 #include "cmd/sdk_iterator.h"
 #include "codec/row_codec.h"
+#include "codec/row_compress.h"
 #include "codec/schema_codec.h"
 #include "codec/sdk_codec.h"
 #include "common/tprinter.h"
@@ -146,7 +146,8 @@ __attribute__((unused)) static void PrintColumnKey(
     stream << t;
 }
 
-__attribute__((unused)) static void ShowTableRows(bool is_compress, ::openmldb::codec::SDKCodec* codec,
+__attribute__((unused)) static void ShowTableRows(::openmldb::type::CompressType compress_type,
+                                                  ::openmldb::codec::SDKCodec* codec,
                                                   ::openmldb::cmd::SDKIterator* it) {
     std::vector<std::string> row = codec->GetColNames();
     if (!codec->HasTSCol()) {
@@ -161,8 +162,8 @@ __attribute__((unused)) static void ShowTableRows(bool is_compress, ::openmldb::
         std::vector<std::string> vrow;
         openmldb::base::Slice data = it->GetValue();
         std::string value;
-        if (is_compress) {
-            ::snappy::Uncompress(data.data(), data.size(), &value);
+        if (compress_type != ::openmldb::type::CompressType::kNoCompress) {
+            ::openmldb::codec::UncompressRow(compress_type, data.data(), data.size(), &value);
         } else {
             value.assign(data.data(), data.size());
         }
@@ -186,15 +187,13 @@ __attribute__((unused)) static void ShowTableRows(bool is_compress, ::openmldb::
 __attribute__((unused)) static void ShowTableRows(const ::openmldb::api::TableMeta& table_info,
                                                   ::openmldb::cmd::SDKIterator* it) {
     ::openmldb::codec::SDKCodec codec(table_info);
-    bool is_compress = table_info.compress_type() == ::openmldb::type::CompressType::kSnappy ? true : false;
-    ShowTableRows(is_compress, &codec, it);
+    ShowTableRows(table_info.compress_type(), &codec, it);
 }
 
 __attribute__((unused)) static void ShowTableRows(const ::openmldb::nameserver::TableInfo& table_info,
                                                   ::openmldb::cmd::SDKIterator* it) {
     ::openmldb::codec::SDKCodec codec(table_info);
-    bool is_compress = table_info.compress_type() == ::openmldb::type::CompressType::kSnappy ? true : false;
-    ShowTableRows(is_compress, &codec, it);
+    ShowTableRows(table_info.compress_type(), &codec, it);
 }
 
 __attribute__((unused)) static void ShowTableRows(const std::string& key, ::openmldb::cmd::SDKIterator* it,
@@ -209,9 +208,9 @@ __attribute__((unused)) static void ShowTableRows(const std::string& key, ::open
     uint32_t index = 1;
     while (it->Valid()) {
         std::string value = it->GetValue().ToString();
-        if (compress_type == ::openmldb::type::CompressType::kSnappy) {
+        if (compress_type != ::openmldb::type::CompressType::kNoCompress) {
             std::string uncompressed;
-            ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
+            ::openmldb::codec::UncompressRow(compress_type, value, &uncompressed);
             value = uncompressed;
         }
         row.clear();
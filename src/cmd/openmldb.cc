@@ -18,7 +18,6 @@
 #include <gflags/gflags.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
-#include <snappy.h>
 #include <unistd.h>
 
 #include <iostream>
@@ -46,6 +45,7 @@
 #include "cmd/display.h"
 #include "cmd/sdk_iterator.h"
 #include "cmd/sql_cmd.h"
+#include "codec/row_compress.h"
 #include "codec/schema_codec.h"
 #include "codec/sdk_codec.h"
 #include "common/timer.h"
@@ -341,9 +341,11 @@ int PutData(uint32_t tid, const std::map<uint32_t, std::vector<std::pair<std::st
         return ::openmldb::base::Status(-1, "Encode data error");
     }
 
-    if (table_info.compress_type() == ::openmldb::type::CompressType::kSnappy) {
+    if (table_info.compress_type() != ::openmldb::type::CompressType::kNoCompress) {
         std::string compressed;
-        ::snappy::Compress(value.c_str(), value.length(), &compressed);
+        if (!::openmldb::codec::CompressRow(table_info.compress_type(), value.c_str(), value.length(), &compressed)) {
+            return ::openmldb::base::Status(-1, "Compress data error");
+        }
         value = compressed;
     }
     const int tid = table_info.tid();
@@ -1394,9 +1396,9 @@ void HandleNSGet(const std::vector<std::string>& parts, ::openmldb::client::NsCl
             std::string msg;
             bool ok = tb_client->Get(tid, pid, key, timestamp, value, ts, msg);
             if (ok) {
-                if (tables[0].compress_type() == ::openmldb::type::CompressType::kSnappy) {
+                if (tables[0].compress_type() != ::openmldb::type::CompressType::kNoCompress) {
                     std::string uncompressed;
-                    ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
+                    ::openmldb::codec::UncompressRow(tables[0].compress_type(), value, &uncompressed);
                     value = uncompressed;
                 }
                 std::cout << "value :" << value << std::endl;
@@ -1445,9 +1447,9 @@ void HandleNSGet(const std::vector<std::string>& parts, ::openmldb::client::NsCl
                 return;
             }
         }
-        if (tables[0].compress_type() == ::openmldb::type::CompressType::kSnappy) {
+        if (tables[0].compress_type() != ::openmldb::type::CompressType::kNoCompress) {
             std::string uncompressed;
-            ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
+            ::openmldb::codec::UncompressRow(tables[0].compress_type(), value, &uncompressed);
             value.swap(uncompressed);
         }
         row.clear();
@@ -1847,9 +1849,9 @@ void HandleNSPreview(const std::vector<std::string>& parts, ::openmldb::client::
 
             if (no_schema) {
                 std::string value = it->GetValue().ToString();
-                if (tables[0].compress_type() == ::openmldb::type::CompressType::kSnappy) {
+                if (tables[0].compress_type() != ::openmldb::type::CompressType::kNoCompress) {
                     std::string uncompressed;
-                    ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
+                    ::openmldb::codec::UncompressRow(tables[0].compress_type(), value, &uncompressed);
                     value = uncompressed;
                 }
                 row.push_back(it->GetPK());
@@ -1860,8 +1862,9 @@ void HandleNSPreview(const std::vector<std::string>& parts, ::openmldb::client::
                     row.push_back(std::to_string(it->GetKey()));
                 }
                 std::string value;
-                if (tables[0].compress_type() == ::openmldb::type::CompressType::kSnappy) {
-                    ::snappy::Uncompress(it->GetValue().data(), it->GetValue().size(), &value);
+                if (tables[0].compress_type() != ::openmldb::type::CompressType::kNoCompress) {
+                    ::openmldb::codec::UncompressRow(tables[0].compress_type(), it->GetValue().data(),
+                                                     it->GetValue().size(), &value);
                 } else {
                     value.assign(it->GetValue().data(), it->GetValue().size());
                 }
@@ -3341,11 +3344,11 @@ void HandleClientPreview(const std::vector<std::string>& parts, ::openmldb::clie
         row.push_back(std::to_string(index));
         if (schema.empty()) {
             std::string value = it->GetValue().ToString();
-            if (table_status.compress_type() ==
-                ::openmldb::type::CompressType::kSnappy) {
+            if (table_status.compress_type() !=
+                ::openmldb::type::CompressType::kNoCompress) {
                 std::string uncompressed;
-                ::snappy::Uncompress(value.c_str(), value.length(),
-                                     &uncompressed);
+                ::openmldb::codec::UncompressRow(table_status.compress_type(), value,
+                                                 &uncompressed);
                 value = uncompressed;
             }
             row.push_back(it->GetPK());
@@ -3362,9 +3365,9 @@ void HandleClientPreview(const std::vector<std::string>& parts, ::openmldb::clie
                 return;
             }
             std::string value;
-            if (table_meta.compress_type() == ::openmldb::type::CompressType::kSnappy) {
-                ::snappy::Uncompress(it->GetValue().data(),
-                                     it->GetValue().size(), &value);
+            if (table_meta.compress_type() != ::openmldb::type::CompressType::kNoCompress) {
+                ::openmldb::codec::UncompressRow(table_meta.compress_type(), it->GetValue().data(),
+                                                 it->GetValue().size(), &value);
             } else {
                 value.assign(it->GetValue().data(), it->GetValue().size());
             }
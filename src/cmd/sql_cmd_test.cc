@@ -965,7 +965,7 @@ class DeployLongWindowEnv {
         *rs = std::move(res);
     }
 
- private:
+ protected:
     virtual void PrepareSchema() {
         ProcessSQLs(
             sr_, {"SET @@execute_mode='online';", absl::StrCat("create database ", db_), absl::StrCat("use ", db_),
@@ -2211,6 +2211,163 @@ TEST_P(DBSDKTest, DeployLongWindowsExecuteCountWhere3) {
     EXPECT_EQ(3, res->GetInt64Unsafe(11));
 }
 
+// different aggregations of one long window are merged in one scan, each on its own pre-aggr table
+TEST_P(DBSDKTest, DeployLongWindowsMultipleAggregates) {
+    auto cli = GetParam();
+    cs = cli->cs;
+    sr = cli->sr;
+
+    class DeployLongWindowMultiAggEnv : public DeployLongWindowEnv {
+     public:
+        explicit DeployLongWindowMultiAggEnv(sdk::SQLClusterRouter* sr) : DeployLongWindowEnv(sr) {}
+        ~DeployLongWindowMultiAggEnv() override {}
+
+        void Deploy() override {
+            ProcessSQLs(sr_, {absl::Substitute(R"(DEPLOY $0 options(long_windows='w1:2s')
+    SELECT
+        col1, col2,
+        sum(i64_col) over w1 as w1_sum,
+        avg(d_col) over w1 as w1_avg,
+        min(i32_col) over w1 as w1_min,
+        max(f_col) over w1 as w1_max,
+        count(s_col) over w1 as w1_count,
+        sum_where(i64_col, filter = 1) over w1 as w1_sum_where,
+        max_where(i16_col, i64_col < 9) over w1 as w1_max_where
+    FROM $1 WINDOW
+        w1 AS (PARTITION BY col1,col2 ORDER BY col3 ROWS_RANGE BETWEEN 6s PRECEDING AND CURRENT ROW);)",
+                                               dp_, table_)});
+        }
+
+        void TearDownPreAggTables() override {
+            absl::string_view pre_agg_db = openmldb::nameserver::PRE_AGG_DB;
+            ProcessSQLs(sr_, {
+                                 absl::StrCat("use ", pre_agg_db),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_sum_i64_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_avg_d_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_min_i32_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_max_f_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_count_s_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_sum_where_i64_col_filter"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_max_where_i16_col_i64_col"),
+                                 absl::StrCat("use ", db_),
+                                 absl::StrCat("drop deployment ", dp_),
+                             });
+        }
+    };
+
+    // request window [5s, 11s]
+    DeployLongWindowMultiAggEnv env(sr);
+    env.SetUp();
+    absl::Cleanup clean = [&env]() { env.TearDown(); };
+
+    std::shared_ptr<hybridse::sdk::ResultSet> res;
+    // ts 11, 11, 10, 9, 8, 7, 6, 5
+    env.CallDeploy(&res);
+    ASSERT_TRUE(res != nullptr) << "call deploy failed";
+
+    EXPECT_EQ(1, res->Size());
+    EXPECT_TRUE(res->Next());
+    EXPECT_EQ("str1", res->GetStringUnsafe(0));
+    EXPECT_EQ("str2", res->GetStringUnsafe(1));
+    EXPECT_EQ(67, res->GetInt64Unsafe(2));
+    EXPECT_DOUBLE_EQ(67.0 / 8, res->GetDoubleUnsafe(3));
+    EXPECT_EQ(5, res->GetInt32Unsafe(4));
+    EXPECT_FLOAT_EQ(11, res->GetFloatUnsafe(5));
+    EXPECT_EQ(8, res->GetInt64Unsafe(6));
+    // filter of the request row is null
+    EXPECT_EQ(5 + 7 + 9 + 11, res->GetInt64Unsafe(7));
+    EXPECT_EQ(8, res->GetInt16Unsafe(8));
+}
+
+// the rows of a union table are aggregated directly, the main table still uses its pre-aggr tables
+TEST_P(DBSDKTest, DeployLongWindowsWindowUnion) {
+    auto cli = GetParam();
+    cs = cli->cs;
+    sr = cli->sr;
+
+    class DeployLongWindowUnionEnv : public DeployLongWindowEnv {
+     public:
+        explicit DeployLongWindowUnionEnv(sdk::SQLClusterRouter* sr) : DeployLongWindowEnv(sr) {}
+        ~DeployLongWindowUnionEnv() override {}
+
+        void PrepareSchema() override {
+            union_table_ = absl::StrCat(table_, "_union");
+            for (const auto& table : {table_, union_table_}) {
+                ProcessSQLs(sr_, {"SET @@execute_mode='online';",
+                                  absl::StrCat("create database if not exists ", db_), absl::StrCat("use ", db_),
+                                  absl::StrCat("create table ", table,
+                                               "(col1 string, col2 string, col3 timestamp, i64_col bigint, i16_col "
+                                               "smallint, i32_col int, f_col float, d_col double, t_col timestamp, "
+                                               "s_col string, date_col date, filter int, "
+                                               "index(key=(col1,col2), ts=col3, abs_ttl=0, ttl_type=absolute)) "
+                                               "options(partitionnum=8);")});
+            }
+        }
+
+        void PrepareData() override {
+            DeployLongWindowEnv::PrepareData();
+            // union rows at ts i * 1000 + 500 with i64_col 100 * i, only 6500 and 8500 are in the request window
+            for (int i : {4, 6, 8, 12}) {
+                std::string insert = absl::StrCat("insert into ", union_table_, " values('str1', 'str2', ",
+                                                  i * 1000 + 500, ", ", 100 * i, ", ", i, ", ", i, ", ", i, ", ", i,
+                                                  ", ", i, ", '", i, "', '1900-01-01', ", i % 2, ");");
+                ::hybridse::sdk::Status s;
+                bool ok = sr_->ExecuteInsert(db_, insert, &s);
+                ASSERT_TRUE(ok && s.IsOK()) << s.msg << "\n" << s.trace;
+            }
+        }
+
+        void Deploy() override {
+            ProcessSQLs(sr_, {absl::Substitute(R"(DEPLOY $0 options(long_windows='w1:2s')
+    SELECT
+        col1, col2,
+        sum(i64_col) over w1 as w1_sum,
+        count(i64_col) over w1 as w1_count,
+        min(i64_col) over w1 as w1_min,
+        max(i64_col) over w1 as w1_max
+    FROM $1 WINDOW
+        w1 AS (UNION $2 PARTITION BY col1,col2 ORDER BY col3 ROWS_RANGE BETWEEN 6s PRECEDING AND CURRENT ROW);)",
+                                               dp_, table_, union_table_)});
+        }
+
+        void TearDownPreAggTables() override {
+            absl::string_view pre_agg_db = openmldb::nameserver::PRE_AGG_DB;
+            ProcessSQLs(sr_, {
+                                 absl::StrCat("use ", pre_agg_db),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_sum_i64_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_count_i64_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_min_i64_col"),
+                                 absl::StrCat("drop table pre_", db_, "_", dp_, "_w1_max_i64_col"),
+                                 absl::StrCat("use ", db_),
+                                 absl::StrCat("drop deployment ", dp_),
+                                 absl::StrCat("drop table ", union_table_),
+                             });
+        }
+
+     private:
+        std::string union_table_;
+    };
+
+    // request window [5s, 11s]
+    DeployLongWindowUnionEnv env(sr);
+    env.SetUp();
+    absl::Cleanup clean = [&env]() { env.TearDown(); };
+
+    std::shared_ptr<hybridse::sdk::ResultSet> res;
+    // main table ts 11, 11, 10, 9, 8, 7, 6, 5 and union table ts 8.5, 6.5
+    env.CallDeploy(&res);
+    ASSERT_TRUE(res != nullptr) << "call deploy failed";
+
+    EXPECT_EQ(1, res->Size());
+    EXPECT_TRUE(res->Next());
+    EXPECT_EQ("str1", res->GetStringUnsafe(0));
+    EXPECT_EQ("str2", res->GetStringUnsafe(1));
+    EXPECT_EQ(67 + 600 + 800, res->GetInt64Unsafe(2));
+    EXPECT_EQ(10, res->GetInt64Unsafe(3));
+    EXPECT_EQ(5, res->GetInt64Unsafe(4));
+    EXPECT_EQ(800, res->GetInt64Unsafe(5));
+}
+
 TEST_P(DBSDKTest, LongWindowMinMaxWhere) {
     auto cli = GetParam();
     cs = cli->cs;
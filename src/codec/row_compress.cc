@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "codec/row_compress.h"
+
+#include <lz4.h>
+#include <snappy.h>
+#include <string.h>
+
+#include "base/endianconv.h"
+
+namespace openmldb {
+namespace codec {
+
+// lz4 block format does not keep the raw length, so a lz4 row is prefixed with it
+static const uint32_t LZ4_RAW_SIZE_LENGTH = sizeof(uint32_t);
+
+bool CompressRow(::openmldb::type::CompressType compress_type, const char* data, size_t size, std::string* out) {
+    switch (compress_type) {
+        case ::openmldb::type::kNoCompress:
+            out->assign(data, size);
+            return true;
+        case ::openmldb::type::kSnappy:
+            ::snappy::Compress(data, size, out);
+            return true;
+        case ::openmldb::type::kLZ4: {
+            if (size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+                return false;
+            }
+            int bound = LZ4_compressBound(static_cast<int>(size));
+            out->resize(LZ4_RAW_SIZE_LENGTH + bound);
+            uint32_t raw_size = static_cast<uint32_t>(size);
+            memrev32ifbe(static_cast<void*>(&raw_size));
+            memcpy(&(*out)[0], static_cast<void*>(&raw_size), LZ4_RAW_SIZE_LENGTH);
+            int len = LZ4_compress_default(data, &(*out)[LZ4_RAW_SIZE_LENGTH], static_cast<int>(size), bound);
+            if (len <= 0) {
+                return false;
+            }
+            out->resize(LZ4_RAW_SIZE_LENGTH + len);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool UncompressRow(::openmldb::type::CompressType compress_type, const char* data, size_t size, std::string* out) {
+    switch (compress_type) {
+        case ::openmldb::type::kNoCompress:
+            out->assign(data, size);
+            return true;
+        case ::openmldb::type::kSnappy:
+            return ::snappy::Uncompress(data, size, out);
+        case ::openmldb::type::kLZ4: {
+            if (size < LZ4_RAW_SIZE_LENGTH) {
+                return false;
+            }
+            uint32_t raw_size = 0;
+            memcpy(static_cast<void*>(&raw_size), data, LZ4_RAW_SIZE_LENGTH);
+            memrev32ifbe(static_cast<void*>(&raw_size));
+            if (raw_size > static_cast<uint32_t>(LZ4_MAX_INPUT_SIZE)) {
+                return false;
+            }
+            out->resize(raw_size);
+            int len = LZ4_decompress_safe(data + LZ4_RAW_SIZE_LENGTH, &(*out)[0],
+                                          static_cast<int>(size - LZ4_RAW_SIZE_LENGTH), static_cast<int>(raw_size));
+            return len >= 0 && static_cast<uint32_t>(len) == raw_size;
+        }
+        default:
+            return false;
+    }
+}
+
+}  // namespace codec
+}  // namespace openmldb
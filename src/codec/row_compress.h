@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SRC_CODEC_ROW_COMPRESS_H_
+#define SRC_CODEC_ROW_COMPRESS_H_
+
+#include <string>
+
+#include "proto/type.pb.h"
+
+namespace openmldb {
+namespace codec {
+
+// compress a row with the compress type of the table. kNoCompress copies the row as it is
+bool CompressRow(::openmldb::type::CompressType compress_type, const char* data, size_t size, std::string* out);
+
+// the reverse of CompressRow, return false if the data is corrupted
+bool UncompressRow(::openmldb::type::CompressType compress_type, const char* data, size_t size, std::string* out);
+
+inline bool UncompressRow(::openmldb::type::CompressType compress_type, const std::string& data, std::string* out) {
+    return UncompressRow(compress_type, data.data(), data.size(), out);
+}
+
+}  // namespace codec
+}  // namespace openmldb
+#endif  // SRC_CODEC_ROW_COMPRESS_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "codec/row_compress.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace codec {
+
+class RowCompressTest : public ::testing::TestWithParam<::openmldb::type::CompressType> {};
+
+TEST_P(RowCompressTest, CompressAndUncompress) {
+    auto compress_type = GetParam();
+    std::string row;
+    for (int i = 0; i < 100; i++) {
+        row.append("card" + std::to_string(i % 10) + "|mcc" + std::to_string(i % 3) + "|");
+    }
+    for (const std::string& value : {row, std::string("a"), std::string()}) {
+        std::string compressed;
+        ASSERT_TRUE(CompressRow(compress_type, value.data(), value.size(), &compressed));
+        std::string uncompressed;
+        ASSERT_TRUE(UncompressRow(compress_type, compressed, &uncompressed));
+        ASSERT_EQ(value, uncompressed);
+        if (compress_type != ::openmldb::type::kNoCompress && value.size() > 100) {
+            ASSERT_LT(compressed.size(), value.size());
+        }
+    }
+}
+
+TEST_P(RowCompressTest, Corrupted) {
+    auto compress_type = GetParam();
+    if (compress_type == ::openmldb::type::kNoCompress) {
+        return;
+    }
+    std::string row(200, 'x');
+    std::string compressed;
+    ASSERT_TRUE(CompressRow(compress_type, row.data(), row.size(), &compressed));
+    std::string uncompressed;
+    ASSERT_FALSE(UncompressRow(compress_type, compressed.data(), compressed.size() / 2, &uncompressed));
+    ASSERT_FALSE(UncompressRow(compress_type, compressed.data(), 1, &uncompressed));
+}
+
+INSTANTIATE_TEST_SUITE_P(CompressType, RowCompressTest,
+                         ::testing::Values(::openmldb::type::kNoCompress, ::openmldb::type::kSnappy,
+                                           ::openmldb::type::kLZ4));
+
+}  // namespace codec
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
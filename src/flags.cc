@@ -63,6 +63,12 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_bool(gc_ttl_expiry_index, false,
+            "index the keys of the memtable segments with one ts column by the time of their oldest row, "
+            "so that the absolute ttl gc only visits the keys which may have expired rows");
+DEFINE_uint32(gc_ttl_key_budget, 0,
+              "the max keys visited by an indexed absolute ttl gc of a segment, the rest are left to the next gc. "
+              "0 means unlimited");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -71,6 +77,20 @@ DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
+DEFINE_uint32(aggr_flushed_bucket_cache_size, 4,
+              "the number of recently flushed buckets cached per key in pre-aggr, to update them by the "
+              "out-of-order rows without scanning the pre-aggr table. 0 means disable");
+DEFINE_uint32(aggr_flushed_bucket_cache_max_cnt, 100000,
+              "the max number of flushed buckets cached by a pre-aggr across all its keys");
+DEFINE_uint32(jit_obj_cache_size_mb, 0,
+              "the memory in MB of the compiled sql objects shared by all the deployments, 0 means disable");
+DEFINE_string(jit_obj_cache_dir, "",
+              "the dir to persist the compiled sql objects so that they are loaded after restart. "
+              "empty means memory only");
+DEFINE_uint32(jit_obj_cache_dir_size_mb, 1024,
+              "the max disk size in MB of jit_obj_cache_dir, the least recently used objects are removed beyond it");
+DEFINE_bool(enable_parallel_request_subtree, false,
+            "run the independent windows, last joins and subqueries of a request concurrently on bthreads");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
@@ -80,8 +100,15 @@ DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview")
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_int32(binlog_sync_max_inflight, 1,
+             "the max count of inflight sync requests to a follower. set it greater than 1 after all tablets "
+             "support pipelined sync");
+DEFINE_uint32(binlog_sync_window_byte_size, 8 * 1024 * 1024,
+              "the max byte size of inflight sync requests to a follower");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
+DEFINE_bool(binlog_group_commit, false, "merge the concurrent binlog appends of a table and write them by one writer");
+DEFINE_bool(binlog_sync_on_commit, false, "sync binlog to disk before the put returns");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time. unit is milliseconds");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time. unit is milliseconds");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000,
@@ -106,10 +133,17 @@ DEFINE_int32(request_max_retry, 3, "max retry time when request error");
 DEFINE_int32(request_timeout_ms, 20000,
              "rpc request timeout of misc. unit is milliseconds");
 DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error. unit is milliseconds");
+DEFINE_uint32(put_batch_max_rows, 1000, "the max rows of a PutBatch request sent by the sdk");
+DEFINE_uint32(put_batch_max_bytes, 32 * 1024 * 1024,
+              "the max bytes of a PutBatch request sent by the sdk, below the max body size of brpc");
 
 DEFINE_uint32(max_traverse_pk_cnt, 5000, "max traverse iter pk cnt");
 DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
 DEFINE_uint32(traverse_cnt_limit, 1000, "limit traverse cnt");
+DEFINE_bool(traverse_prefetch, true, "request the next page of a remote traverse while the current one is iterated");
+DEFINE_uint32(traverse_prefetch_partitions, 4,
+              "the number of remote partitions whose first traverse page is requested ahead of the one iterated "
+              "in full table and window scans, 0 means disable");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
 
@@ -127,10 +161,17 @@ DEFINE_int32(make_snapshot_check_interval, 1000 * 60 * 10,
              "config the interval to check making snapshot time. unit is milliseconds");
 DEFINE_int32(make_snapshot_threshold_offset, 100000, "config the offset to reach the threshold");
 DEFINE_uint32(make_snapshot_max_deleted_keys, 1000000, "config the max deleted keys store when make snapshot");
+DEFINE_uint32(make_snapshot_max_delta_num, 0,
+              "config the max delta snapshots kept on the base snapshot. a delta only holds the binlog since "
+              "the last snapshot, the base is rewritten when the limit is reached. 0 means disabled. "
+              "enable it only after all tablets and tools are upgraded, set it back to 0 and make a snapshot "
+              "before downgrading");
 DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
-DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib, zstd");
+DEFINE_int32(snapshot_zstd_level, 3,
+             "Compression level of zstd snapshot, higher level gives smaller snapshot but slower");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000,
@@ -148,6 +189,15 @@ DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
+DEFINE_uint32(mem_table_slab_size, 0,
+              "the slab size of memtable row allocator, rounded up to a power of two. 0 means disable slab");
+DEFINE_uint32(mem_table_cold_age, 0,
+              "the rows older than it in minutes are packed into compressed cold blocks during gc, "
+              "only for the index with absolute ttl. 0 means disable");
+DEFINE_uint32(mem_table_cold_block_row_cnt, 256, "the max row count of a cold block");
+DEFINE_uint32(mem_table_key_filter_bits_per_key, 0,
+              "the bits per pk of the bloom filter in each memtable segment that skips the lookups of absent pks. "
+              "0 means disable");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
 
 // rocksdb
@@ -164,6 +214,8 @@ DEFINE_bool(verify_compression, false, "For debug");
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_bool(load_table_parallel, false,
+            "decode and put the snapshot and binlog records of memory table by partition threads while loading");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000,
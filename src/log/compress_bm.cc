@@ -0,0 +1,168 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <lz4.h>
+#include <snappy.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include <string>
+
+#include "base/random.h"
+#include "benchmark/benchmark.h"
+#include "codec/row_compress.h"
+#include "log/log_format.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace log {
+
+enum BlockCodec { kBlockSnappy = 0, kBlockZlib, kBlockZstd, kBlockLZ4 };
+
+static ::openmldb::api::LogEntry GenLogEntry(::openmldb::base::Random* rand, uint64_t offset) {
+    ::openmldb::api::LogEntry entry;
+    entry.set_log_index(offset);
+    entry.set_term(5);
+    entry.set_ts(1650000000000 + offset * 10);
+    std::string pk = "card" + std::to_string(rand->Skewed(10));
+    auto dimension = entry.add_dimensions();
+    dimension->set_key(pk);
+    dimension->set_idx(0);
+    entry.set_value(pk + "|mcc" + std::to_string(rand->Uniform(100)) + "|" + std::to_string(rand->Uniform(100000)) +
+                    ".00|shanghai|" + std::string(32, 'a' + offset % 3));
+    return entry;
+}
+
+// the entries of a snapshot block, rows of a few hot pks with similar values
+static std::string GenLogEntryBlock() {
+    ::openmldb::base::Random rand(0xdeadbeef);
+    std::string block;
+    uint64_t offset = 1;
+    while (block.size() < kCompressBlockSize) {
+        std::string data;
+        GenLogEntry(&rand, offset++).SerializeToString(&data);
+        block.append(data);
+    }
+    block.resize(kCompressBlockSize);
+    return block;
+}
+
+static size_t CompressBlock(BlockCodec codec, const std::string& block, std::string* out, int level) {
+    switch (codec) {
+        case kBlockSnappy: {
+            out->resize(snappy::MaxCompressedLength(block.size()));
+            size_t len = 0;
+            snappy::RawCompress(block.data(), block.size(), &(*out)[0], &len);
+            return len;
+        }
+        case kBlockZlib: {
+            uLongf len = compressBound(block.size());
+            out->resize(len);
+            compress2(reinterpret_cast<Bytef*>(&(*out)[0]), &len, reinterpret_cast<const Bytef*>(block.data()),
+                      block.size(), level);
+            return len;
+        }
+        case kBlockZstd: {
+            out->resize(ZSTD_compressBound(block.size()));
+            return ZSTD_compress(&(*out)[0], out->size(), block.data(), block.size(), level);
+        }
+        case kBlockLZ4: {
+            out->resize(LZ4_compressBound(block.size()));
+            return LZ4_compress_default(block.data(), &(*out)[0], block.size(), out->size());
+        }
+    }
+    return 0;
+}
+
+static void UncompressBlock(BlockCodec codec, const std::string& compressed, size_t len, std::string* out) {
+    switch (codec) {
+        case kBlockSnappy:
+            snappy::RawUncompress(compressed.data(), len, &(*out)[0]);
+            break;
+        case kBlockZlib: {
+            uLongf dest_len = out->size();
+            uncompress(reinterpret_cast<Bytef*>(&(*out)[0]), &dest_len,
+                       reinterpret_cast<const Bytef*>(compressed.data()), len);
+            break;
+        }
+        case kBlockZstd:
+            ZSTD_decompress(&(*out)[0], out->size(), compressed.data(), len);
+            break;
+        case kBlockLZ4:
+            LZ4_decompress_safe(compressed.data(), &(*out)[0], len, out->size());
+            break;
+    }
+}
+
+// state.range(0) is the codec and state.range(1) is the level for zlib and zstd
+static void BM_CompressBlock(benchmark::State& state) {  // NOLINT
+    auto codec = static_cast<BlockCodec>(state.range(0));
+    std::string block = GenLogEntryBlock();
+    std::string compressed;
+    size_t len = 0;
+    for (auto _ : state) {
+        len = CompressBlock(codec, block, &compressed, state.range(1));
+        benchmark::DoNotOptimize(len);
+    }
+    state.SetBytesProcessed(state.iterations() * block.size());
+    state.counters["ratio"] = static_cast<double>(block.size()) / len;
+}
+
+static void BM_UncompressBlock(benchmark::State& state) {  // NOLINT
+    auto codec = static_cast<BlockCodec>(state.range(0));
+    std::string block = GenLogEntryBlock();
+    std::string compressed;
+    size_t len = CompressBlock(codec, block, &compressed, state.range(1));
+    std::string uncompressed(block.size(), '\0');
+    for (auto _ : state) {
+        UncompressBlock(codec, compressed, len, &uncompressed);
+        benchmark::DoNotOptimize(uncompressed.data());
+    }
+    state.SetBytesProcessed(state.iterations() * block.size());
+}
+
+// the per row compression of a table, state.range(0) is ::openmldb::type::CompressType
+static void BM_CompressRow(benchmark::State& state) {  // NOLINT
+    auto compress_type = static_cast<::openmldb::type::CompressType>(state.range(0));
+    ::openmldb::base::Random rand(0xdeadbeef);
+    std::string row = GenLogEntry(&rand, 1).value();
+    std::string compressed;
+    std::string uncompressed;
+    for (auto _ : state) {
+        ::openmldb::codec::CompressRow(compress_type, row.data(), row.size(), &compressed);
+        ::openmldb::codec::UncompressRow(compress_type, compressed, &uncompressed);
+    }
+    state.SetBytesProcessed(state.iterations() * row.size());
+    state.counters["ratio"] = static_cast<double>(row.size()) / compressed.size();
+}
+
+BENCHMARK(BM_CompressBlock)
+    ->Args({kBlockSnappy, 0})
+    ->Args({kBlockZlib, Z_DEFAULT_COMPRESSION})
+    ->Args({kBlockZstd, 1})
+    ->Args({kBlockZstd, 3})
+    ->Args({kBlockZstd, 9})
+    ->Args({kBlockLZ4, 0});
+BENCHMARK(BM_UncompressBlock)
+    ->Args({kBlockSnappy, 0})
+    ->Args({kBlockZlib, Z_DEFAULT_COMPRESSION})
+    ->Args({kBlockZstd, 3})
+    ->Args({kBlockLZ4, 0});
+BENCHMARK(BM_CompressRow)->Arg(::openmldb::type::kSnappy)->Arg(::openmldb::type::kLZ4);
+
+}  // namespace log
+}  // namespace openmldb
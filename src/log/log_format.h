@@ -41,7 +41,7 @@ enum RecordType {
     kEofType = 5
 };
 
-enum CompressType { kNoCompress = 0, kZlib = 1, kSnappy = 2 };
+enum CompressType { kNoCompress = 0, kZlib = 1, kSnappy = 2, kZstd = 3 };
 
 static const int kMaxRecordType = kEofType;
 
@@ -62,6 +62,7 @@ static const uint32_t kHeaderSizeOfCompressBlock = 64;
 
 static const std::string ZLIB_COMPRESS_SUFFIX = ".zlib";      // NOLINT
 static const std::string SNAPPY_COMPRESS_SUFFIX = ".snappy";  // NOLINT
+static const std::string ZSTD_COMPRESS_SUFFIX = ".zstd";      // NOLINT
 
 }  // namespace log
 }  // namespace openmldb
@@ -25,6 +25,9 @@
 #include <snappy.h>
 #include <stdio.h>
 #include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
 
 #include "base/endianconv.h"
 #include "base/glog_wrapper.h"
@@ -60,11 +63,16 @@ Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t
         block_size_ = kCompressBlockSize;
         uncompress_buf_ = new char[block_size_];
         header_size_ = kHeaderSizeForCompress;
+        // the codec is only known from the block header, so hold the largest output of any of them
+        max_compress_len_ = std::max({static_cast<uint32_t>(snappy::MaxCompressedLength(block_size_)),
+                                      static_cast<uint32_t>(compressBound(block_size_)),
+                                      static_cast<uint32_t>(ZSTD_compressBound(block_size_))});
     } else {
         block_size_ = kBlockSize;
         header_size_ = kHeaderSize;
+        max_compress_len_ = block_size_;
     }
-    backing_store_ = new char[block_size_];
+    backing_store_ = new char[max_compress_len_];
     DLOG(INFO) << "block_size_: " << block_size_ << ", "
                << "header_size_: " << header_size_ << ", "
                << "compressed_: " << compressed_;
@@ -296,6 +304,11 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
             memcpy(static_cast<void*>(&compress_type), data + sizeof(uint32_t), 1);
             DLOG(INFO) << "compress_len: " << compress_len << ", "
                        << "compress_type: " << compress_type;
+            if (compress_len > max_compress_len_) {
+                PDLOG(WARNING, "bad record when reading block, compress_len: %u, max_compress_len: %u", compress_len,
+                      max_compress_len_);
+                return kBadRecord;
+            }
             // read compressed data
             Slice block;
             status = file_->Read(compress_len, &block, backing_store_);
@@ -332,6 +345,16 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
                     }
                     break;
                 }
+                case kZstd: {
+                    size_t res = ZSTD_decompress(uncompress_buf_, block_size_, block_data, compress_len);
+                    if (ZSTD_isError(res)) {
+                        PDLOG(WARNING, "bad record when uncompress block, error: %s, compress type: %d",
+                              ZSTD_getErrorName(res), compress_type);
+                        return kBadRecord;
+                    }
+                    uncompress_len = static_cast<int32_t>(res);
+                    break;
+                }
                 default: {
                     PDLOG(WARNING, "unsupported compress type: %d", compress_type);
                     return kBadRecord;
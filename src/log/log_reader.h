@@ -113,6 +113,8 @@ class Reader {
     bool compressed_;
     uint32_t block_size_;
     uint32_t header_size_;
+    // size of backing_store_, the max length of a compressed block
+    uint32_t max_compress_len_;
     // buffer for uncompressed block
     char* uncompress_buf_;
 
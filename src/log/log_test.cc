@@ -24,6 +24,7 @@
 #include <iostream>
 #include <vector>
 
+#include "base/endianconv.h"
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "config.h"  // NOLINT
@@ -141,6 +142,8 @@ std::string GetWritePath(const std::string& path) {
         return path + openmldb::log::ZLIB_COMPRESS_SUFFIX;
     } else if (FLAGS_snapshot_compression == "snappy") {
         return path + openmldb::log::SNAPPY_COMPRESS_SUFFIX;
+    } else if (FLAGS_snapshot_compression == "zstd") {
+        return path + openmldb::log::ZSTD_COMPRESS_SUFFIX;
     } else {
         return path;
     }
@@ -285,6 +288,74 @@ TEST_F(LogWRTest, TestLogEntry) {
     }
 }
 
+TEST_F(LogWRTest, TestIncompressibleBlock) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = GetWritePath(log_dir + "/" + fname);
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    // random bytes fill more than one block, the compressed blocks are larger than the raw ones
+    std::vector<std::string> values;
+    for (int i = 0; i < 3; i++) {
+        std::string value(block_size_ / 2, '\0');
+        for (auto& c : value) {
+            c = static_cast<char>(rand() % 256);  // NOLINT
+        }
+        ASSERT_TRUE(writer.AddRecord(value).ok());
+        values.push_back(value);
+    }
+    if (FLAGS_snapshot_compression != "off") {
+        writer.EndLog();
+    }
+    wf->Flush();
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(fname, fd_r);
+    Reader reader(rf, NULL, true, 0, compressed_);
+    std::string scratch;
+    for (const auto& expect : values) {
+        Slice value;
+        Status status = reader.ReadRecord(&value, &scratch);
+        ASSERT_TRUE(status.ok()) << status.ToString();
+        ASSERT_EQ(expect, value.ToString());
+    }
+}
+
+TEST_F(LogWRTest, TestBadCompressLen) {
+    if (FLAGS_snapshot_compression == "off") {
+        return;
+    }
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = GetWritePath(log_dir + "/" + fname);
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    // a corrupted block header claims a block larger than any codec can produce
+    char header[kHeaderSizeOfCompressBlock] = {0};
+    uint32_t compress_len = 4 * block_size_;
+    memrev32ifbe(static_cast<void*>(&compress_len));
+    memcpy(header, static_cast<void*>(&compress_len), sizeof(uint32_t));
+    header[sizeof(uint32_t)] = static_cast<char>(writer.GetCompressType());
+    wf->Append(Slice(header, kHeaderSizeOfCompressBlock));
+    wf->Append(Slice(std::string(4 * block_size_, 'a')));
+    wf->Flush();
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(fname, fd_r);
+    Reader reader(rf, NULL, true, 0, compressed_);
+    std::string scratch;
+    Slice value;
+    Status status = reader.ReadRecord(&value, &scratch);
+    ASSERT_FALSE(status.ok());
+    ASSERT_FALSE(status.IsEof());
+}
+
 TEST_F(LogWRTest, TestWait) {
     std::string log_dir = "/tmp/" + GenRand() + "/";
     ::openmldb::base::MkdirRecur(log_dir);
@@ -418,7 +489,7 @@ int main(int argc, char** argv) {
     ::openmldb::base::SetLogLevel(DEBUG);
     ::testing::InitGoogleTest(&argc, argv);
     int ret = 0;
-    std::vector<std::string> vec{"off", "zlib", "snappy"};
+    std::vector<std::string> vec{"off", "zlib", "snappy", "zstd"};
     for (size_t i = 0; i < vec.size(); i++) {
         std::cout << "compress type: " << vec[i] << std::endl;
         FLAGS_snapshot_compression = vec[i];
@@ -20,15 +20,19 @@
 
 #include "log/log_writer.h"
 
+#include <gflags/gflags.h>
 #include <snappy.h>
 #include <stdint.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include "base/endianconv.h"
 #include "base/glog_wrapper.h"
 #include "log/coding.h"
 #include "log/crc32c.h"
 
+DECLARE_int32(snapshot_zstd_level);
+
 namespace openmldb {
 namespace log {
 
@@ -50,7 +54,7 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[GetCompressBound()];
     } else {
         block_size_ = kBlockSize;
     }
@@ -69,7 +73,7 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t de
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[GetCompressBound()];
     } else {
         block_size_ = kBlockSize;
     }
@@ -264,6 +268,17 @@ Status Writer::CompressRecord() {
             compress_len = static_cast<int32_t>(dest_len);
             break;
         }
+        case kZstd: {
+            size_t dest_len = ZSTD_compress(compress_buf_, GetCompressBound(), buffer_, block_size_,
+                                            FLAGS_snapshot_zstd_level);
+            if (ZSTD_isError(dest_len)) {
+                s = Status::InvalidRecord(Slice(std::string("compress failed, error: ") + ZSTD_getErrorName(dest_len)));
+                PDLOG(WARNING, "write error, compress_type: %d, msg: %s", compress_type_, s.ToString().c_str());
+                return s;
+            }
+            compress_len = static_cast<int32_t>(dest_len);
+            break;
+        }
         default: {
             s = Status::InvalidRecord(Slice("unsupported compress type: " + compress_type_));
             PDLOG(WARNING, "write error, compress_type: %d, msg: %s", compress_type_, s.ToString().c_str());
@@ -302,11 +317,27 @@ CompressType Writer::GetCompressType(const std::string& compress_type) {
         return kZlib;
     } else if (compress_type == "snappy") {
         return kSnappy;
+    } else if (compress_type == "zstd") {
+        return kZstd;
     } else {
         return kNoCompress;
     }
 }
 
+uint32_t Writer::GetCompressBound() const {
+    // an incompressible block may expand, so the output buffer is larger than a block
+    switch (compress_type_) {
+        case kSnappy:
+            return snappy::MaxCompressedLength(block_size_);
+        case kZlib:
+            return compressBound(block_size_);
+        case kZstd:
+            return ZSTD_compressBound(block_size_);
+        default:
+            return block_size_;
+    }
+}
+
 Status Writer::AppendInternal(WritableFile* wf, int32_t leftover) {
     Slice fill_slice("\x00\x00\x00\x00\x00\x00", leftover);
     if (compress_type_ == kNoCompress) {
@@ -77,6 +77,7 @@ class Writer {
     // buffer for compressed block
     char* compress_buf_;
     Status CompressRecord();
+    uint32_t GetCompressBound() const;
     Status AppendInternal(WritableFile* wf, int leftover);
 
     Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
@@ -2311,10 +2311,7 @@ int NameServerImpl::SetPartitionInfo(TableInfo& table_info) {
 int NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmldb::nameserver::TableInfo>& table_info,
                                         bool is_leader, std::map<uint32_t, std::vector<std::string>>& endpoint_map,
                                         uint64_t term) {
-    ::openmldb::type::CompressType compress_type = ::openmldb::type::CompressType::kNoCompress;
-    if (table_info->compress_type() == ::openmldb::type::kSnappy) {
-        compress_type = ::openmldb::type::CompressType::kSnappy;
-    }
+    ::openmldb::type::CompressType compress_type = table_info->compress_type();
     ::openmldb::api::TableMeta table_meta;
     table_meta.set_db(table_info->db());
     table_meta.set_name(table_info->name());
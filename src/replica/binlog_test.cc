@@ -129,7 +129,7 @@ int main(int argc, char** argv) {
     ::openmldb::base::SetLogLevel(DEBUG);
     ::google::ParseCommandLineFlags(&argc, &argv, true);
     int ret = 0;
-    std::vector<std::string> vec{"off", "zlib", "snappy"};
+    std::vector<std::string> vec{"off", "zlib", "snappy", "zstd"};
     for (size_t i = 0; i < vec.size(); i++) {
         std::cout << "compress type: " << vec[i] << std::endl;
         FLAGS_db_root_path = "/tmp/" + GenRand();
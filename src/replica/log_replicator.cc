@@ -35,6 +35,8 @@
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_bool(binlog_group_commit);
+DECLARE_bool(binlog_sync_on_commit);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -59,7 +61,8 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      append_head_(nullptr) {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -398,7 +401,7 @@ int LogReplicator::DelReplicateNode(const std::string& endpoint) {
     return 0;
 }
 
-void LogReplicator::GetReplicateInfo(std::map<std::string, uint64_t>& info_map) {
+void LogReplicator::GetReplicateInfo(std::map<std::string, ReplicateNodeInfo>& info_map) {
     std::lock_guard<bthread::Mutex> lock(mu_);
     if (role_ != kLeaderNode) {
         DEBUGLOG("cur table is not leader");
@@ -408,10 +411,21 @@ void LogReplicator::GetReplicateInfo(std::map<std::string, uint64_t>& info_map)
         return;
     }
     for (const auto& node : nodes_) {
-        info_map.insert(std::make_pair(node->GetEndPoint(), node->GetLastSyncOffset()));
+        info_map.insert(std::make_pair(node->GetEndPoint(), node->GetInfo(GetOffset())));
     }
 }
 
+bool LogReplicator::WaitOffset(uint64_t log_offset, uint32_t timeout_ms) {
+    uint64_t end_time = ::baidu::common::timer::get_micros() + timeout_ms * 1000ul;
+    while (GetOffset() < log_offset) {
+        if (::baidu::common::timer::get_micros() >= end_time) {
+            return false;
+        }
+        bthread_usleep(1000);
+    }
+    return true;
+}
+
 bool LogReplicator::DelAllReplicateNode() {
     std::vector<std::shared_ptr<ReplicateNode>> copied_nodes = nodes_;
     {
@@ -434,32 +448,128 @@ bool LogReplicator::DelAllReplicateNode() {
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry, ::google::protobuf::Closure* done) {
-    std::lock_guard<std::mutex> lock(wmu_);
-    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
-        bool ok = RollWLogFile();
-        if (!ok) {
-            return false;
+    size_t written = 0;
+    return Append(&entry, 1, done, &written);
+}
+
+bool LogReplicator::AppendEntries(std::vector<LogEntry>& entries, ::google::protobuf::Closure* done) {
+    size_t written = 0;
+    bool ok = Append(entries.data(), entries.size(), done, &written);
+    if (!ok) {
+        entries.erase(entries.begin() + written, entries.end());
+    }
+    return ok;
+}
+
+bool LogReplicator::Append(LogEntry* entries, size_t cnt, ::google::protobuf::Closure* done, size_t* written) {
+    AppendTask task(entries, cnt, done);
+    if (FLAGS_binlog_group_commit) {
+        GroupCommit(&task);
+    } else {
+        AppendTask* tasks[] = {&task};
+        CommitTasks(tasks, 1);
+    }
+    *written = task.written;
+    return task.ok;
+}
+
+void LogReplicator::GroupCommit(AppendTask* task) {
+    AppendTask* head = append_head_.load(std::memory_order_relaxed);
+    do {
+        task->next = head;
+    } while (!append_head_.compare_exchange_weak(head, task, std::memory_order_release, std::memory_order_relaxed));
+    if (head == nullptr) {
+        // the first task pushed to the empty queue becomes the leader
+        LeadGroupCommit({task});
+        return;
+    }
+    task->event.wait();
+    if (!task->batch.empty()) {
+        LeadGroupCommit(std::move(task->batch));
+    }
+}
+
+void LogReplicator::LeadGroupCommit(std::vector<AppendTask*> batch) {
+    CommitTasks(batch.data(), batch.size());
+    AppendTask* last = batch.back();
+    AppendTask* expected = last;
+    AppendTask* next_leader = nullptr;
+    if (!append_head_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+        // new tasks are pushed on top of the last one, collect them in fifo order
+        std::vector<AppendTask*> next_batch;
+        for (AppendTask* cur = expected; cur != last; cur = cur->next) {
+            next_batch.push_back(cur);
         }
+        std::reverse(next_batch.begin(), next_batch.end());
+        next_leader = next_batch.front();
+        next_leader->batch.swap(next_batch);
+    }
+    // the writers are woken up after the cas, so the address of the last task
+    // can not be reused by a new task before it
+    for (size_t i = 1; i < batch.size(); i++) {
+        batch[i]->event.signal();
     }
-    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
-    entry.set_log_index(1 + cur_offset);
+    if (next_leader != nullptr) {
+        next_leader->event.signal();
+    }
+}
+
+void LogReplicator::CommitTasks(AppendTask* const* tasks, size_t cnt) {
+    std::lock_guard<std::mutex> lock(wmu_);
     std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer);
-    ::openmldb::log::Status status = wh_->Write(slice);
-    if (!status.ok()) {
-        PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
-        return false;
+    bool has_written = false;
+    bool ok = true;
+    for (size_t i = 0; i < cnt; i++) {
+        AppendTask* task = tasks[i];
+        if (ok) {
+            task->written = WriteEntries(task->entries, task->cnt, &buffer);
+            ok = task->written == task->cnt;
+            has_written = has_written || task->written > 0;
+        }
+        task->ok = ok;
     }
-    log_offset_.fetch_add(1, std::memory_order_relaxed);
-    if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
-                                     // sync to remote replica
-        follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
+    if (has_written && FLAGS_binlog_sync_on_commit) {
+        ::openmldb::log::Status status = SyncLog();
+        if (!status.ok()) {
+            // the appends report the failure, but log_offset_ has moved past the entries written
+            PDLOG(WARNING, "fail to sync data for path %s. %s", path_.c_str(), status.ToString().c_str());
+            for (size_t i = 0; i < cnt; i++) {
+                tasks[i]->ok = false;
+            }
+        }
     }
-    if (done) {
-        done->Run();
+    for (size_t i = 0; i < cnt; i++) {
+        if (tasks[i]->done && tasks[i]->written > 0) {
+            tasks[i]->done->Run();
+        }
     }
-    return true;
+}
+
+size_t LogReplicator::WriteEntries(LogEntry* entries, size_t cnt, std::string* buffer) {
+    size_t written = 0;
+    for (; written < cnt; written++) {
+        if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+            if (!RollWLogFile()) {
+                break;
+            }
+        }
+        LogEntry& entry = entries[written];
+        entry.set_log_index(1 + log_offset_.load(std::memory_order_relaxed));
+        buffer->clear();
+        entry.AppendToString(buffer);
+        ::openmldb::log::Status status = wh_->Write(::openmldb::base::Slice(*buffer));
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+            break;
+        }
+        log_offset_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (written > 0 && local_endpoints_.empty()) {  // if local replica are dead, leader direct
+                                                    // sync to remote replica
+        follower_offset_.store(log_offset_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return written;
 }
 
 bool LogReplicator::RollWLogFile() {
@@ -28,6 +28,7 @@
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
+#include "bthread/countdown_event.h"
 #include "common/thread_pool.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
@@ -54,7 +55,7 @@ class LogReplicator {
                   const std::map<std::string, std::string>& real_ep_map,
                   const ReplicatorRole& role);
 
-    ~LogReplicator();
+    virtual ~LogReplicator();
 
     bool Init();
 
@@ -63,9 +64,15 @@ class LogReplicator {
     // the slave node receives master log entries
     bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
 
-    // the master node append entry
+    // the master node append entry. with binlog_group_commit the concurrent appends are
+    // queued and written by one leader writer, done is run by the leader in log index order
     bool AppendEntry(::openmldb::api::LogEntry& entry, ::google::protobuf::Closure* done = nullptr);  // NOLINT
 
+    // the master node append entries with contiguous log index under one lock.
+    // if it fails in the middle, the entries not written are erased and done still runs for the written ones
+    bool AppendEntries(std::vector<::openmldb::api::LogEntry>& entries,  // NOLINT
+                       ::google::protobuf::Closure* done = nullptr);
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -82,7 +89,11 @@ class LogReplicator {
 
     int DelReplicateNode(const std::string& endpoint);
 
-    void GetReplicateInfo(std::map<std::string, uint64_t>& info_map);  // NOLINT
+    void GetReplicateInfo(std::map<std::string, ReplicateNodeInfo>& info_map);  // NOLINT
+
+    // the follower waits the preceding requests of a pipelined leader to be applied.
+    // return false if the offset is still less than log_offset after timeout
+    bool WaitOffset(uint64_t log_offset, uint32_t timeout_ms);
 
     void MatchLogOffset();
 
@@ -110,9 +121,42 @@ class LogReplicator {
 
     const std::string& GetLogPath() {return log_path_;}
 
+ protected:
+    // sync the binlog written to disk. virtual for the tests to inject failures
+    virtual ::openmldb::log::Status SyncLog() { return wh_->Sync(); }
+
  private:
+    // a pending append which lives on the stack of the writer
+    struct AppendTask {
+        AppendTask(LogEntry* e, size_t n, ::google::protobuf::Closure* d)
+            : entries(e), cnt(n), written(0), done(d), ok(false), next(nullptr), event(1), batch() {}
+        LogEntry* entries;
+        size_t cnt;
+        size_t written;
+        ::google::protobuf::Closure* done;
+        bool ok;
+        AppendTask* next;
+        bthread::CountdownEvent event;
+        // not empty if the task is woken up to be the leader of the batch
+        std::vector<AppendTask*> batch;
+    };
+
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    bool Append(LogEntry* entries, size_t cnt, ::google::protobuf::Closure* done, size_t* written);
+
+    void GroupCommit(AppendTask* task);
+
+    // commit the batch and hand over the tasks queued meanwhile to the next leader
+    void LeadGroupCommit(std::vector<AppendTask*> batch);
+
+    // write, sync and run the closures of the tasks in order. the closures of the entries written run even if
+    // the sync fails, the entries are in the binlog and replicated to the followers
+    void CommitTasks(AppendTask* const* tasks, size_t cnt);
+
+    // write entries with contiguous log index and return the count written. wmu_ must be held
+    size_t WriteEntries(LogEntry* entries, size_t cnt, std::string* buffer);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -139,6 +183,8 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+    // the newest task of the group commit queue, nullptr if there is no leader
+    std::atomic<AppendTask*> append_head_;
 };
 
 }  // namespace replica
@@ -25,7 +25,9 @@
 #include <unistd.h>
 
 #include <filesystem>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/status.h"
@@ -48,6 +50,10 @@ using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
 DECLARE_int32(binlog_single_file_max_size);
+DECLARE_bool(binlog_group_commit);
+DECLARE_bool(binlog_sync_on_commit);
+DECLARE_int32(binlog_sync_batch_size);
+DECLARE_int32(binlog_sync_max_inflight);
 
 namespace openmldb {
 namespace replica {
@@ -86,6 +92,16 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
         uint64_t last_log_offset = replicator_.GetOffset();
+        if (request->pre_log_index() > last_log_offset) {
+            if (!replicator_.WaitOffset(request->pre_log_index(), 100)) {
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("log index is not continuous");
+                response->set_log_offset(replicator_.GetOffset());
+                done->Run();
+                return;
+            }
+            last_log_offset = replicator_.GetOffset();
+        }
         for (int32_t i = 0; i < request->entries_size(); i++) {
             if (request->entries(i).log_index() <= last_log_offset) {
                 continue;
@@ -150,6 +166,126 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+class IndexClosure : public Closure {
+ public:
+    IndexClosure(const ::openmldb::api::LogEntry* entry, std::vector<uint64_t>* indexes)
+        : entry_(entry), indexes_(indexes) {}
+    // run under the write lock of the replicator
+    void Run() override { indexes_->push_back(entry_->log_index()); }
+
+ private:
+    const ::openmldb::api::LogEntry* entry_;
+    std::vector<uint64_t>* indexes_;
+};
+
+TEST_F(LogReplicatorTest, GroupCommit) {
+    FLAGS_binlog_group_commit = true;
+    FLAGS_binlog_sync_on_commit = true;
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() {
+        FLAGS_binlog_group_commit = false;
+        FLAGS_binlog_sync_on_commit = false;
+        std::filesystem::remove_all(folder);
+    };
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    int thread_num = 16;
+    int num = 500;
+    std::vector<uint64_t> indexes;
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num; i++) {
+                if (i % 10 == 0) {
+                    std::vector<::openmldb::api::LogEntry> entries(3);
+                    for (auto& entry : entries) {
+                        entry.set_pk(absl::StrCat("key", t));
+                        entry.set_value("value");
+                        entry.set_ts(i);
+                    }
+                    IndexClosure closure(&entries.back(), &indexes);
+                    if (!replicator.AppendEntries(entries, &closure) || entries.size() != 3) {
+                        failed++;
+                    }
+                } else {
+                    ::openmldb::api::LogEntry entry;
+                    entry.set_pk(absl::StrCat("key", t));
+                    entry.set_value("value");
+                    entry.set_ts(i);
+                    IndexClosure closure(&entry, &indexes);
+                    if (!replicator.AppendEntry(entry, &closure)) {
+                        failed++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, failed.load());
+    uint64_t total = thread_num * (num + num / 10 * 2);
+    ASSERT_EQ(total, replicator.GetOffset());
+    // the closures run in log index order
+    ASSERT_EQ(static_cast<size_t>(thread_num * num), indexes.size());
+    for (size_t i = 1; i < indexes.size(); i++) {
+        ASSERT_LT(indexes[i - 1], indexes[i]);
+    }
+    ASSERT_EQ(total, indexes.back());
+
+    LogReader reader(replicator.GetLogPart(), replicator.GetLogPath(), false);
+    ASSERT_TRUE(reader.SetOffset(0));
+    ::openmldb::api::LogEntry entry;
+    std::string buffer;
+    ::openmldb::base::Slice record;
+    uint64_t cnt = 0;
+    while (true) {
+        buffer.clear();
+        ::openmldb::log::Status status = reader.ReadNextRecord(&record, &buffer);
+        if (!status.ok()) {
+            break;
+        }
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(++cnt, entry.log_index());
+    }
+    ASSERT_EQ(total, cnt);
+}
+
+class SyncFailReplicator : public LogReplicator {
+ public:
+    SyncFailReplicator(const std::string& path, const std::map<std::string, std::string>& map)
+        : LogReplicator(1, 1, path, map, kLeaderNode) {}
+
+ protected:
+    ::openmldb::log::Status SyncLog() override { return ::openmldb::log::Status::IOError("injected sync failure"); }
+};
+
+TEST_F(LogReplicatorTest, SyncFailure) {
+    FLAGS_binlog_sync_on_commit = true;
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() {
+        FLAGS_binlog_sync_on_commit = false;
+        std::filesystem::remove_all(folder);
+    };
+    SyncFailReplicator replicator(folder, map);
+    ASSERT_TRUE(replicator.Init());
+    std::vector<uint64_t> indexes;
+    for (int i = 0; i < 3; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_pk("key");
+        entry.set_value("value");
+        entry.set_ts(i);
+        IndexClosure closure(&entry, &indexes);
+        // the append fails, but the entry is written and its closure runs
+        ASSERT_FALSE(replicator.AppendEntry(entry, &closure));
+    }
+    ASSERT_EQ(3u, replicator.GetOffset());
+    ASSERT_EQ(std::vector<uint64_t>({1, 2, 3}), indexes);
+}
+
 TEST_F(LogReplicatorTest, LogReader) {
     // set to 1 MB, every binlog file will be a little larger than 2 MB
     // as the checking logic is: (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size
@@ -731,6 +867,72 @@ TEST_F(LogReplicatorTest, Leader_Remove_local_follower) {
     }
 }
 
+TEST_F(LogReplicatorTest, PipelinedSync) {
+    FLAGS_binlog_sync_batch_size = 4;
+    FLAGS_binlog_sync_max_inflight = 8;
+    absl::Cleanup reset = []() {
+        FLAGS_binlog_sync_batch_size = 32;
+        FLAGS_binlog_sync_max_inflight = 1;
+    };
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string follower_addr = "127.0.0.1:18531";
+    {
+        std::string folder = "/tmp/" + GenRand() + "/";
+        MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(1, 1, folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair(follower_addr, ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    int num = 1000;
+    for (int i = 0; i < num; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, "test_pk", &entry);
+        entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+        entry.set_ts(i + 1);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+        if (i % 100 == 0) {
+            leader.Notify();
+        }
+    }
+    leader.Notify();
+    std::map<std::string, ReplicateNodeInfo> info_map;
+    for (int i = 0; i < 100; i++) {
+        info_map.clear();
+        leader.GetReplicateInfo(info_map);
+        if (info_map[follower_addr].offset == static_cast<uint64_t>(num)) {
+            break;
+        }
+        usleep(100 * 1000);
+    }
+    ASSERT_EQ(static_cast<uint64_t>(num), info_map[follower_addr].offset);
+    ASSERT_EQ(0u, info_map[follower_addr].lag);
+    ASSERT_EQ(0u, info_map[follower_addr].inflight_cnt);
+    leader.DelAllReplicateNode();
+    ASSERT_EQ(num, static_cast<int>(table->GetRecordCnt()));
+    Ticket ticket;
+    TableIterator* it = table->NewIterator(0, "test_pk", ticket);
+    it->SeekToFirst();
+    for (int i = num; i > 0; i--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(static_cast<uint64_t>(i), it->GetKey());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    delete it;
+}
+
 }  // namespace replica
 }  // namespace openmldb
 
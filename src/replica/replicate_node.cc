@@ -19,11 +19,15 @@
 #include <gflags/gflags.h>
 
 #include <algorithm>
+#include <utility>
 
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "brpc/callback.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_int32(binlog_sync_max_inflight);
+DECLARE_uint32(binlog_sync_window_byte_size);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -52,6 +56,11 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
                              std::atomic<uint64_t>* follower_offset, const std::string& real_point)
     : log_reader_(logs, log_path, false),
       cache_(),
+      inflight_(),
+      inflight_cnt_(0),
+      inflight_byte_size_(0),
+      read_offset_(0),
+      read_buffer_(),
       endpoint_(point),
       last_sync_offset_(0),
       log_matched_(false),
@@ -120,6 +129,7 @@ void ReplicateNode::SyncData() {
             while (last_sync_offset_ >= leader_log_offset_->load(std::memory_order_relaxed)) {
                 cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
                 if (!is_running_.load(std::memory_order_relaxed)) {
+                    RecycleInflight();
                     PDLOG(INFO,
                           "replicate log to endpoint %s for table #tid %u #pid "
                           "%u exist",
@@ -138,6 +148,7 @@ void ReplicateNode::SyncData() {
             coffee_time = FLAGS_binlog_coffee_time;
         }
     }
+    RecycleInflight();
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
@@ -149,6 +160,15 @@ std::string ReplicateNode::GetEndPoint() { return endpoint_; }
 
 uint64_t ReplicateNode::GetLastSyncOffset() { return last_sync_offset_; }
 
+ReplicateNodeInfo ReplicateNode::GetInfo(uint64_t leader_offset) {
+    ReplicateNodeInfo info;
+    info.offset = last_sync_offset_;
+    info.lag = leader_offset > info.offset ? leader_offset - info.offset : 0;
+    info.inflight_cnt = inflight_cnt_.load(std::memory_order_relaxed);
+    info.inflight_byte_size = inflight_byte_size_.load(std::memory_order_relaxed);
+    return info;
+}
+
 void ReplicateNode::SetLastSyncOffset(uint64_t offset) { last_sync_offset_ = offset; }
 
 int ReplicateNode::MatchLogOffsetFromNode() {
@@ -162,6 +182,7 @@ int ReplicateNode::MatchLogOffsetFromNode() {
                                        FLAGS_request_timeout_ms, FLAGS_request_max_retry);
     if (ret && response.code() == 0) {
         last_sync_offset_ = response.log_offset();
+        read_offset_ = last_sync_offset_;
         log_matched_ = true;
         log_reader_.SetOffset(last_sync_offset_);
         PDLOG(INFO, "match node %s log offset %lu for table tid %u pid %u", endpoint_.c_str(), last_sync_offset_, tid_,
@@ -174,83 +195,122 @@ int ReplicateNode::MatchLogOffsetFromNode() {
 
 int ReplicateNode::SyncData(uint64_t log_offset) {
     DEBUGLOG("node[%s] offset[%lu] log offset[%lu]", endpoint_.c_str(), last_sync_offset_, log_offset);
-    if (log_offset <= last_sync_offset_) {
+    if (log_offset <= last_sync_offset_ && inflight_.empty()) {
         PDLOG(WARNING, "log offset [%lu] le last sync offset [%lu], do nothing", log_offset, last_sync_offset_);
         return 1;
     }
-    ::openmldb::api::AppendEntriesRequest request;
-    ::openmldb::api::AppendEntriesResponse response;
-    uint64_t sync_log_offset = last_sync_offset_;
-    bool request_from_cache = false;
     bool need_wait = false;
-    if (cache_.size() > 0) {
-        request_from_cache = true;
-        request = cache_[0];
-        if (request.entries_size() <= 0) {
-            cache_.clear();
-            PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
-            return -1;
+    // fill the window, the requests are sent in log index order and applied by the follower in order
+    uint32_t max_inflight = std::max(FLAGS_binlog_sync_max_inflight, 1);
+    while (inflight_.size() < max_inflight &&
+           (inflight_.empty() || inflight_byte_size_.load(std::memory_order_relaxed) <
+                                     FLAGS_binlog_sync_window_byte_size)) {
+        auto inflight = std::make_unique<InflightRequest>();
+        ::openmldb::api::AppendEntriesRequest& request = inflight->request;
+        if (!cache_.empty()) {
+            request.Swap(&cache_.front());
+            cache_.pop_front();
+            if (request.entries_size() <= 0) {
+                PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
+                continue;
+            }
+            const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
+            if (entry.log_index() <= last_sync_offset_) {
+                DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
+                continue;
+            }
+            PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
+        } else {
+            if (read_offset_ >= log_offset) {
+                break;
+            }
+            need_wait = ReadEntries(log_offset, &request);
+            if (request.entries_size() <= 0) {
+                break;
+            }
         }
-        const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
-        if (entry.log_index() <= last_sync_offset_) {
-            DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
-            cache_.clear();
-            return -1;
+        SendInflight(std::move(inflight));
+        if (need_wait) {
+            break;
         }
-        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
-        sync_log_offset = entry.log_index();
-    } else {
-        request.set_tid(tid_);
-        request.set_pid(pid_);
-        request.set_pre_log_index(last_sync_offset_);
-        if (!FLAGS_zk_cluster.empty()) {
-            request.set_term(term_->load(std::memory_order_relaxed));
+    }
+    if (inflight_.empty()) {
+        return need_wait ? 1 : 0;
+    }
+    // wait the oldest request
+    std::unique_ptr<InflightRequest>& front = inflight_.front();
+    brpc::Join(front->cntl.call_id());
+    const ::openmldb::api::AppendEntriesResponse& response = front->response;
+    if (!front->cntl.Failed() && response.code() == 0) {
+        uint64_t sync_log_offset = front->request.entries(front->request.entries_size() - 1).log_index();
+        DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
+        last_sync_offset_ = std::max(last_sync_offset_, sync_log_offset);
+        if (!rep_node_.load(std::memory_order_relaxed) &&
+            (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
+            follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
-        for (uint64_t i = 0; i < batchSize;) {
-            std::string buffer;
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
-            if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
-                }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
-                    continue;
-                }
-                // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
-                    PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
-                    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                        log_reader_.GoBackToStart();
-                        go_back_cnt_ = 0;
-                        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                    } else {
-                        log_reader_.GoBackToLastBlock();
-                        go_back_cnt_++;
-                    }
-                    need_wait = true;
-                    break;
-                }
-                sync_log_offset = entry->log_index();
-            } else if (status.IsWaitRecord()) {
-                DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
-                need_wait = true;
+        inflight_cnt_.fetch_sub(1, std::memory_order_relaxed);
+        inflight_byte_size_.fetch_sub(front->byte_size, std::memory_order_relaxed);
+        inflight_.pop_front();
+        // keep draining the inflight requests without the coffee time
+        return need_wait && inflight_.empty() ? 1 : 0;
+    }
+    if (front->cntl.Failed()) {
+        PDLOG(WARNING, "fail to sync log to node %s. %s tid %u pid %u", endpoint_.c_str(),
+              front->cntl.ErrorText().c_str(), tid_, pid_);
+    } else {
+        PDLOG(WARNING, "fail to sync log to node %s. code %d msg %s tid %u pid %u", endpoint_.c_str(),
+              response.code(), response.msg().c_str(), tid_, pid_);
+    }
+    bool behind = !front->cntl.Failed() && response.has_log_offset() &&
+                  response.log_offset() < front->request.pre_log_index();
+    uint64_t follower_log_offset = response.log_offset();
+    RecycleInflight();
+    if (behind) {
+        // the follower misses some entries, sync again from its offset
+        PDLOG(WARNING, "node %s is behind, sync from offset %lu. tid %u pid %u", endpoint_.c_str(),
+              follower_log_offset, tid_, pid_);
+        cache_.clear();
+        last_sync_offset_ = follower_log_offset;
+        read_offset_ = follower_log_offset;
+        log_reader_.SetOffset(follower_log_offset);
+    }
+    return 1;
+}
+
+bool ReplicateNode::ReadEntries(uint64_t log_offset, ::openmldb::api::AppendEntriesRequest* request) {
+    request->set_tid(tid_);
+    request->set_pid(pid_);
+    request->set_pre_log_index(read_offset_);
+    if (!FLAGS_zk_cluster.empty()) {
+        request->set_term(term_->load(std::memory_order_relaxed));
+    }
+    uint32_t batch_size = log_offset - read_offset_;
+    batch_size = std::min(batch_size, (uint32_t)FLAGS_binlog_sync_batch_size);
+    ::openmldb::base::Slice record;
+    for (uint64_t i = 0; i < batch_size;) {
+        // the buffer is reused by the records which span blocks
+        read_buffer_.clear();
+        ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &read_buffer_);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry* entry = request->add_entries();
+            if (!entry->ParseFromArray(record.data(), static_cast<int>(record.size()))) {
+                PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
                 break;
-            } else if (status.IsInvalidRecord()) {
-                DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
+            }
+            DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+            if (entry->log_index() <= read_offset_) {
+                DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
+                request->mutable_entries()->RemoveLast();
+                continue;
+            }
+            // the log index should incr by 1
+            if ((read_offset_ + 1) != entry->log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", read_offset_ + 1,
+                      entry->log_index(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
                 if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
                     log_reader_.GoBackToStart();
                     go_back_cnt_ = 0;
@@ -259,41 +319,62 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
                     log_reader_.GoBackToLastBlock();
                     go_back_cnt_++;
                 }
-                break;
-            } else {
-                PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                break;
-            }
-            i++;
-            go_back_cnt_ = 0;
-        }
-    }
-    if (request.entries_size() > 0) {
-        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
-                                           FLAGS_request_timeout_ms, FLAGS_request_max_retry);
-        if (ret && response.code() == 0) {
-            DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
-            last_sync_offset_ = sync_log_offset;
-            if (!rep_node_.load(std::memory_order_relaxed) &&
-                (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
-                follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
+                return true;
             }
-            if (request_from_cache) {
-                cache_.clear();
+            read_offset_ = entry->log_index();
+        } else if (status.IsWaitRecord()) {
+            DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
+            return true;
+        } else if (status.IsInvalidRecord()) {
+            DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                log_reader_.GoBackToStart();
+                go_back_cnt_ = 0;
+                PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+            } else {
+                log_reader_.GoBackToLastBlock();
+                go_back_cnt_++;
             }
+            return true;
         } else {
-            if (!request_from_cache) {
-                cache_.push_back(request);
-            }
-            need_wait = true;
-            PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+            PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            return true;
         }
+        i++;
+        go_back_cnt_ = 0;
     }
-    if (need_wait) {
-        return 1;
+    return false;
+}
+
+void ReplicateNode::SendInflight(std::unique_ptr<InflightRequest> inflight) {
+    inflight->byte_size = inflight->request.ByteSizeLong();
+    inflight->cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    if (FLAGS_request_max_retry > 0) {
+        inflight->cntl.set_max_retry(FLAGS_request_max_retry);
+    }
+    rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &inflight->cntl, &inflight->request,
+                            &inflight->response, brpc::DoNothing());
+    inflight_cnt_.fetch_add(1, std::memory_order_relaxed);
+    inflight_byte_size_.fetch_add(inflight->byte_size, std::memory_order_relaxed);
+    inflight_.push_back(std::move(inflight));
+}
+
+void ReplicateNode::RecycleInflight() {
+    std::deque<::openmldb::api::AppendEntriesRequest> requests;
+    for (auto& inflight : inflight_) {
+        brpc::Join(inflight->cntl.call_id());
+        requests.emplace_back();
+        requests.back().Swap(&inflight->request);
+    }
+    inflight_.clear();
+    inflight_cnt_.store(0, std::memory_order_relaxed);
+    inflight_byte_size_.store(0, std::memory_order_relaxed);
+    // the inflight requests are older than the ones left in cache_
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+        requests.emplace_back();
+        requests.back().Swap(&(*it));
     }
-    return 0;
+    cache_.swap(requests);
 }
 
 void ReplicateNode::Stop() {
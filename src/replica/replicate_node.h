@@ -18,6 +18,8 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -36,6 +38,14 @@ namespace replica {
 using ::openmldb::log::LogReader;
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
+struct ReplicateNodeInfo {
+    uint64_t offset = 0;
+    // the count of entries not synced yet
+    uint64_t lag = 0;
+    uint32_t inflight_cnt = 0;
+    uint64_t inflight_byte_size = 0;
+};
+
 class ReplicateNode {
  public:
     ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid, uint32_t pid,
@@ -63,6 +73,8 @@ class ReplicateNode {
 
     int GetLogIndex();
 
+    ReplicateNodeInfo GetInfo(uint64_t leader_offset);
+
     void Stop();
 
     ReplicateNode(const ReplicateNode&) = delete;
@@ -70,11 +82,33 @@ class ReplicateNode {
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
  private:
+    struct InflightRequest {
+        ::openmldb::api::AppendEntriesRequest request;
+        ::openmldb::api::AppendEntriesResponse response;
+        brpc::Controller cntl;
+        uint64_t byte_size = 0;
+    };
+
     int MatchLogOffsetFromNode();
 
+    // read the entries after read_offset_ into request. return true if the reader has to wait
+    bool ReadEntries(uint64_t log_offset, ::openmldb::api::AppendEntriesRequest* request);
+
+    void SendInflight(std::unique_ptr<InflightRequest> inflight);
+
+    // wait all inflight requests and move the requests not synced to cache_ in order
+    void RecycleInflight();
+
  private:
     LogReader log_reader_;
-    std::vector<::openmldb::api::AppendEntriesRequest> cache_;
+    // the requests to resend in log index order
+    std::deque<::openmldb::api::AppendEntriesRequest> cache_;
+    std::deque<std::unique_ptr<InflightRequest>> inflight_;
+    std::atomic<uint32_t> inflight_cnt_;
+    std::atomic<uint64_t> inflight_byte_size_;
+    // the last log index has been read from binlog
+    uint64_t read_offset_;
+    std::string read_buffer_;
     std::string endpoint_;
     uint64_t last_sync_offset_;
     bool log_matched_;
@@ -19,7 +19,9 @@
 #include <algorithm>
 #include <fstream>
 #include <future>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -58,6 +60,8 @@
 
 DECLARE_string(bucket_size);
 DECLARE_uint32(replica_num);
+DECLARE_uint32(put_batch_max_rows);
+DECLARE_uint32(put_batch_max_bytes);
 
 namespace openmldb {
 namespace sdk {
@@ -1297,6 +1301,9 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
         return false;
     }
     std::vector<size_t> fails;
+    std::vector<std::shared_ptr<SQLInsertRow>> rows;
+    // the position in default_maps of rows
+    std::vector<size_t> row_pos;
     for (size_t i = 0; i < default_maps.size(); i++) {
         auto row = std::make_shared<SQLInsertRow>(table_info, schema, default_maps[i], str_lengths[i]);
         if (!row) {
@@ -1314,10 +1321,22 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             fails.push_back(i);
             continue;
         }
-        if (!PutRow(table_info->tid(), row, tablets, status)) {
-            LOG(WARNING) << "fail to put row[" << i << "] due to: " << status->msg;
-            fails.push_back(i);
-            continue;
+        rows.push_back(row);
+        row_pos.push_back(i);
+    }
+    if (rows.size() == 1) {
+        if (!PutRow(table_info->tid(), rows[0], tablets, status)) {
+            LOG(WARNING) << "fail to put row[" << row_pos[0] << "] due to: " << status->msg;
+            fails.push_back(row_pos[0]);
+        }
+    } else if (!rows.empty()) {
+        std::vector<size_t> put_fails;
+        if (!PutRows(table_info->tid(), rows, tablets, &put_fails, status)) {
+            LOG(WARNING) << "fail to put " << put_fails.size() << " rows due to: " << status->msg;
+            for (auto pos : put_fails) {
+                fails.push_back(row_pos[pos]);
+            }
+            std::sort(fails.begin(), fails.end());
         }
     }
     if (!fails.empty()) {
@@ -1364,6 +1383,95 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               std::vector<size_t>* fails, ::hybridse::sdk::Status* status) {
+    RET_FALSE_IF_NULL_AND_WARN(status, "output status is nullptr");
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    // the rows of a partition are split into requests bounded by rows and bytes, so that a large insert does not
+    // exceed the max body size of brpc
+    struct PutBatchChunk {
+        ::openmldb::api::PutBatchRequest request;
+        // the position in rows of every row in request
+        std::vector<size_t> pos;
+        uint64_t byte_size = 0;
+    };
+    std::map<uint32_t, std::vector<PutBatchChunk>> chunks;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const auto& row = rows[i];
+        for (const auto& kv : row->GetDimensions()) {
+            auto& pid_chunks = chunks[kv.first];
+            uint64_t row_size = row->GetRow().size();
+            for (const auto& dim : kv.second) {
+                row_size += dim.first.size() + sizeof(uint32_t);
+            }
+            if (pid_chunks.empty() || pid_chunks.back().pos.size() >= FLAGS_put_batch_max_rows ||
+                pid_chunks.back().byte_size + row_size > FLAGS_put_batch_max_bytes) {
+                pid_chunks.emplace_back();
+            }
+            auto& chunk = pid_chunks.back();
+            auto put_row = chunk.request.add_rows();
+            put_row->set_time(cur_ts);
+            put_row->set_value(row->GetRow());
+            for (const auto& dim : kv.second) {
+                auto dimension = put_row->add_dimensions();
+                dimension->set_key(dim.first);
+                dimension->set_idx(dim.second);
+            }
+            chunk.pos.push_back(i);
+            chunk.byte_size += row_size;
+        }
+    }
+    std::set<size_t> failed_set;
+    for (auto& kv : chunks) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            SET_STATUS_AND_WARN(status, StatusCode::kCmdError, "fail to get tablet client. pid " + std::to_string(pid));
+            for (const auto& chunk : kv.second) {
+                failed_set.insert(chunk.pos.begin(), chunk.pos.end());
+            }
+            continue;
+        }
+        for (auto& chunk : kv.second) {
+            chunk.request.set_tid(tid);
+            chunk.request.set_pid(pid);
+            ::openmldb::api::PutBatchResponse response;
+            bool unimplemented = false;
+            DLOG(INFO) << "put " << chunk.request.rows_size() << " rows to endpoint " << client->GetEndpoint();
+            if (client->PutBatch(chunk.request, &response, &unimplemented)) {
+                continue;
+            }
+            if (unimplemented) {
+                // the tablet is of an old version, put the rows one by one
+                for (size_t idx = 0; idx < chunk.pos.size(); idx++) {
+                    const auto& row = rows[chunk.pos[idx]];
+                    if (!client->Put(tid, pid, cur_ts, row->GetRow(), row->GetDimensions().at(pid))) {
+                        SET_STATUS_AND_WARN(status, StatusCode::kCmdError,
+                                            "fail to make a put request to table. tid " + std::to_string(tid));
+                        failed_set.insert(chunk.pos[idx]);
+                    }
+                }
+                continue;
+            }
+            SET_STATUS_AND_WARN(status, StatusCode::kCmdError,
+                                "fail to make a put batch request to table. tid " + std::to_string(tid));
+            if (response.failed_idx_size() > 0) {
+                for (auto idx : response.failed_idx()) {
+                    failed_set.insert(chunk.pos[idx]);
+                }
+            } else {
+                failed_set.insert(chunk.pos.begin(), chunk.pos.end());
+            }
+        }
+    }
+    fails->insert(fails->end(), failed_set.begin(), failed_set.end());
+    return failed_set.empty();
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
     RET_FALSE_IF_NULL_AND_WARN(status, "output status is nullptr");
@@ -1379,11 +1487,18 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + cache->GetTableName() + " tablet";
             return false;
         }
+        std::vector<std::shared_ptr<SQLInsertRow>> row_vec;
         for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(cache->GetTableId(), row, tablets, status)) {
-                return false;
-            }
+            row_vec.push_back(rows->GetRow(i));
+        }
+        std::vector<size_t> fails;
+        if (!PutRows(cache->GetTableId(), row_vec, tablets, &fails, status)) {
+            // for peek
+            absl::Span<const size_t> slice(fails.data(), fails.size() > 10 ? 10 : fails.size());
+            SET_STATUS_AND_WARN(status, StatusCode::kCmdError,
+                                absl::StrCat("insert rows ", fails.size(), " failed, failed rows peek: ",
+                                             absl::StrJoin(slice, ","), ". last error: ", status->msg));
+            return false;
         }
         return true;
     } else {
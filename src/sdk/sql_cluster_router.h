@@ -263,6 +263,12 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // put rows grouped by partition with PutBatch requests bounded by put_batch_max_rows and put_batch_max_bytes.
+    // falls back to Put for the tablets without PutBatch. the positions of the rows failed are appended to fails
+    bool PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 std::vector<size_t>* fails, ::hybridse::sdk::Status* status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
                                        hybridse::vm::EngineMode engine_mode);
@@ -30,6 +30,8 @@
 #include "storage/table.h"
 
 DECLARE_bool(binlog_notify_on_put);
+DECLARE_uint32(aggr_flushed_bucket_cache_size);
+DECLARE_uint32(aggr_flushed_bucket_cache_max_cnt);
 namespace openmldb {
 namespace storage {
 
@@ -97,7 +99,45 @@ Aggregator::Aggregator(const ::openmldb::api::TableMeta& base_meta, const ::open
 
 Aggregator::~Aggregator() {}
 
+void Aggregator::Reserve(const std::string& key, uint64_t offset) {
+    auto& stripe = GetStripe(key);
+    std::lock_guard<bthread::Mutex> lock(stripe.turn_mu);
+    stripe.pending_offsets.push_back(offset);
+}
+
 bool Aggregator::Update(const std::string& key, const std::string& row, const uint64_t& offset, bool recover) {
+    if (recover) {
+        return UpdateInTurn(key, row, offset, recover);
+    }
+    // a reserved update waits for the updates reserved before it in the stripe, and always gives up its turn
+    auto& stripe = GetStripe(key);
+    bool reserved = WaitForTurn(&stripe, offset);
+    bool ok = UpdateInTurn(key, row, offset, recover);
+    if (reserved) {
+        ReleaseTurn(&stripe);
+    }
+    return ok;
+}
+
+bool Aggregator::WaitForTurn(BufferMapStripe* stripe, uint64_t offset) {
+    std::unique_lock<bthread::Mutex> lock(stripe->turn_mu);
+    auto& pending = stripe->pending_offsets;
+    if (!std::binary_search(pending.begin(), pending.end(), offset)) {
+        return false;
+    }
+    while (pending.front() != offset) {
+        stripe->turn_cv.wait(lock);
+    }
+    return true;
+}
+
+void Aggregator::ReleaseTurn(BufferMapStripe* stripe) {
+    std::lock_guard<bthread::Mutex> lock(stripe->turn_mu);
+    stripe->pending_offsets.pop_front();
+    stripe->turn_cv.notify_all();
+}
+
+bool Aggregator::UpdateInTurn(const std::string& key, const std::string& row, uint64_t offset, bool recover) {
     if (!recover && GetStat() != AggrStat::kInited) {
         PDLOG(WARNING, "Aggregator status is not kInited");
         return false;
@@ -118,10 +158,17 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
             return false;
         }
     }
-    std::string filter_key = "";
-    if (filter_col_idx_ != -1) {
-        if (!base_row_view_.IsNULL(row_ptr, filter_col_idx_)) {
-            base_row_view_.GetStrValue(row_ptr, filter_col_idx_, &filter_key);
+    absl::string_view filter_key;
+    std::string filter_str;
+    if (filter_col_idx_ != -1 && !base_row_view_.IsNULL(row_ptr, filter_col_idx_)) {
+        char* ch = nullptr;
+        uint32_t length = 0;
+        // string filter columns are referenced in place, others are formatted
+        if (base_row_view_.GetValue(row_ptr, filter_col_idx_, &ch, &length) == 0) {
+            filter_key = absl::string_view(ch, length);
+        } else {
+            base_row_view_.GetStrValue(row_ptr, filter_col_idx_, &filter_str);
+            filter_key = filter_str;
         }
     }
 
@@ -130,25 +177,7 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
         return false;
     }
 
-    AggrBufferLocked* aggr_buffer_lock;
-    {
-        std::lock_guard<std::mutex> lock(mu_);
-        auto it = aggr_buffer_map_.find(key);
-        if (it == aggr_buffer_map_.end()) {
-            auto insert_pair = aggr_buffer_map_[key].emplace(filter_key, AggrBufferLocked{});
-            aggr_buffer_lock = &insert_pair.first->second;
-        } else {
-            auto& filter_map = it->second;
-            auto filter_it = filter_map.find(filter_key);
-            if (filter_it == filter_map.end()) {
-                auto insert_pair = filter_map.emplace(filter_key, AggrBufferLocked{});
-                aggr_buffer_lock = &insert_pair.first->second;
-            } else {
-                aggr_buffer_lock = &filter_it->second;
-            }
-        }
-    }
-
+    AggrBufferLocked* aggr_buffer_lock = GetOrCreateBuffer(key, filter_key);
     std::unique_lock<std::mutex> lock(*aggr_buffer_lock->mu_);
     AggrBuffer& aggr_buffer = aggr_buffer_lock->buffer_;
 
@@ -173,12 +202,12 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
 
     if (cur_ts < aggr_buffer.ts_begin_) {
         // handle the case that the current timestamp is smaller than the begin timestamp in aggregate buffer
-        lock.unlock();
         if (recover) {
             // avoid out-of-order duplicate writes during the recovery phase
             return true;
         }
-        bool ok = UpdateFlushedBuffer(key, filter_key, row_ptr, cur_ts, offset);
+        // keep the lock, the cached buckets must be rewritten in the order they are updated
+        bool ok = UpdateFlushedBuffer(key, filter_key, row_ptr, cur_ts, offset, aggr_buffer_lock);
         if (!ok) {
             PDLOG(ERROR, "Update flushed buffer failed");
             return false;
@@ -195,9 +224,9 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
         if (window_type_ == WindowType::kRowsRange) {
             aggr_buffer.ts_end_ = aggr_buffer.ts_begin_ + window_size_ - 1;
         }
-        lock.unlock();
+        // flush in the lock, so that an out-of-order row of this bucket is written after it
         FlushAggrBuffer(key, filter_key, flush_buffer);
-        lock.lock();
+        CacheFlushedBuffer(flush_buffer, aggr_buffer_lock);
     }
 
     aggr_buffer.aggr_cnt_++;
@@ -213,11 +242,34 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
     return true;
 }
 
+AggrBufferLocked* Aggregator::GetOrCreateBuffer(absl::string_view key, absl::string_view filter_key) {
+    auto& stripe = GetStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mu);
+    auto it = stripe.buffer_map.find(key);
+    if (it == stripe.buffer_map.end()) {
+        it = stripe.buffer_map.emplace(std::string(key), FilterMap()).first;
+    }
+    auto& filter_map = it->second;
+    auto filter_it = filter_map.find(filter_key);
+    if (filter_it == filter_map.end()) {
+        filter_it = filter_map.emplace(std::string(filter_key), AggrBufferLocked{}).first;
+    }
+    return &filter_it->second;
+}
+
 bool Aggregator::Delete(const std::string& key) {
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        // erase from the aggr_buffer_map_
-        aggr_buffer_map_.erase(key);
+        auto& stripe = GetStripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mu);
+        auto it = stripe.buffer_map.find(key);
+        if (it != stripe.buffer_map.end()) {
+            for (auto& filter_it : it->second) {
+                std::lock_guard<std::mutex> buffer_lock(*filter_it.second.mu_);
+                cached_bucket_cnt_.fetch_sub(filter_it.second.flushed_buffers_.size(), std::memory_order_relaxed);
+            }
+            // erase from the aggr_buffer_map_
+            stripe.buffer_map.erase(it);
+        }
     }
 
     // delete the entries from the pre-aggr table
@@ -248,18 +300,19 @@ bool Aggregator::Delete(const std::string& key) {
 
 bool Aggregator::FlushAll() {
     // TODO(nauta): optimize the flush process
-    std::unique_lock<std::mutex> lock(mu_);
     std::unordered_map<std::string, std::unordered_map<std::string, AggrBuffer>> flushed_buffer_map;
-    for (auto& it : aggr_buffer_map_) {
-        for (auto& filter_it : it.second) {
-            auto& aggr_buffer = filter_it.second.buffer_;
-            if (aggr_buffer.aggr_cnt_ == 0) {
-                continue;
+    for (auto& stripe : aggr_buffer_map_) {
+        std::lock_guard<std::mutex> lock(stripe.mu);
+        for (auto& it : stripe.buffer_map) {
+            for (auto& filter_it : it.second) {
+                auto& aggr_buffer = filter_it.second.buffer_;
+                if (aggr_buffer.aggr_cnt_ == 0) {
+                    continue;
+                }
+                flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
             }
-            flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
         }
     }
-    lock.unlock();
     for (auto& it : flushed_buffer_map) {
         for (auto& filter_it : it.second) {
             if (!FlushAggrBuffer(it.first, filter_it.first, filter_it.second)) {
@@ -301,8 +354,7 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
         if (!aggr_row_view_.IsNULL(data_ptr, 6)) {
             aggr_row_view_.GetStrValue(data_ptr, 6, &filter_key);
         }
-        auto insert_pair = aggr_buffer_map_[pk].insert(std::make_pair(filter_key, AggrBufferLocked{}));
-        auto& buffer = insert_pair.first->second.buffer_;
+        auto& buffer = GetOrCreateBuffer(pk, filter_key)->buffer_;
         auto val = it->GetValue();
         int8_t* aggr_row_ptr = reinterpret_cast<int8_t*>(const_cast<char*>(val.data()));
         bool ok = GetAggrBufferFromRowView(aggr_row_view_, aggr_row_ptr, &buffer);
@@ -395,12 +447,13 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
 bool Aggregator::GetAggrBuffer(const std::string& key, AggrBuffer** buffer) { return GetAggrBuffer(key, "", buffer); }
 
 bool Aggregator::GetAggrBuffer(const std::string& key, const std::string& filter_key, AggrBuffer** buffer) {
-    std::lock_guard<std::mutex> lock(mu_);
-    auto it = aggr_buffer_map_.find(key);
-    if (it == aggr_buffer_map_.end()) {
+    auto& stripe = GetStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mu);
+    auto it = stripe.buffer_map.find(key);
+    if (it == stripe.buffer_map.end()) {
         return false;
     }
-    *buffer = &aggr_buffer_map_[key][filter_key].buffer_;
+    *buffer = &it->second[filter_key].buffer_;
     return true;
 }
 
@@ -431,9 +484,10 @@ bool Aggregator::GetAggrBufferFromRowView(const codec::RowView& row_view, const
     return true;
 }
 
-bool Aggregator::EncodeAggrBuffer(const std::string& key, const std::string& filter_key,
+bool Aggregator::EncodeAggrBuffer(const std::string& key, absl::string_view filter_key,
         const AggrBuffer& buffer, const std::string& aggr_val, std::string* encoded_row) {
     if (encoded_row == nullptr) return false;
+    std::lock_guard<std::mutex> lock(encode_mu_);
     int str_length = key.size() + aggr_val.size() + filter_key.size();
     uint32_t row_size = row_builder_.CalTotalLength(str_length);
     encoded_row->resize(row_size);
@@ -464,14 +518,14 @@ bool Aggregator::EncodeAggrBuffer(const std::string& key, const std::string& fil
         return false;
     }
     if (!filter_key.empty()) {
-        return row_builder_.SetString(row_ptr, row_size, 6, filter_key.c_str(), filter_key.size());
+        return row_builder_.SetString(row_ptr, row_size, 6, filter_key.data(), filter_key.size());
     } else {
         return row_builder_.SetNULL(row_ptr, row_size, 6);
     }
     return true;
 }
 
-bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filter_key, const AggrBuffer& buffer) {
+bool Aggregator::FlushAggrBuffer(const std::string& key, absl::string_view filter_key, const AggrBuffer& buffer) {
     std::string encoded_row;
     std::string aggr_val;
     if (!EncodeAggrVal(buffer, &aggr_val)) {
@@ -506,8 +560,53 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
     return true;
 }
 
-bool Aggregator::UpdateFlushedBuffer(const std::string& key, const std::string& filter_key, const int8_t* base_row_ptr,
-                                     int64_t cur_ts, uint64_t offset) {
+void Aggregator::CacheFlushedBuffer(const AggrBuffer& buffer, AggrBufferLocked* aggr_buffer_lock) {
+    auto& flushed_buffers = aggr_buffer_lock->flushed_buffers_;
+    while (!flushed_buffers.empty() && flushed_buffers.size() >= FLAGS_aggr_flushed_bucket_cache_size) {
+        flushed_buffers.pop_front();
+        cached_bucket_cnt_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (FLAGS_aggr_flushed_bucket_cache_size == 0) {
+        return;
+    }
+    // at the cap a key only replaces its own oldest bucket, so the cache keeps the latest flushed ones
+    if (cached_bucket_cnt_.load(std::memory_order_relaxed) >= FLAGS_aggr_flushed_bucket_cache_max_cnt) {
+        if (flushed_buffers.empty()) {
+            return;
+        }
+        flushed_buffers.pop_front();
+    } else {
+        cached_bucket_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    flushed_buffers.emplace_back(buffer);
+}
+
+bool Aggregator::UpdateFlushedBuffer(const std::string& key, absl::string_view filter_key, const int8_t* base_row_ptr,
+                                     int64_t cur_ts, uint64_t offset, AggrBufferLocked* aggr_buffer_lock) {
+    if (aggr_buffer_lock != nullptr) {
+        // the same bucket as the seek below, the one of the largest begin covering cur_ts
+        AggrBuffer* cached = nullptr;
+        for (auto& buffer : aggr_buffer_lock->flushed_buffers_) {
+            if (buffer.ts_begin_ <= cur_ts && cur_ts <= buffer.ts_end_ &&
+                (cached == nullptr || buffer.ts_begin_ >= cached->ts_begin_)) {
+                cached = &buffer;
+            }
+        }
+        if (cached != nullptr) {
+            // the cached bucket is the latest stored one, update it without scanning the pre-aggr table
+            cached->aggr_cnt_ += 1;
+            cached->binlog_offset_ = std::max(cached->binlog_offset_, offset);
+            if (!UpdateAggrVal(base_row_view_, base_row_ptr, cached)) {
+                PDLOG(ERROR, "UpdateAggrVal failed");
+                return false;
+            }
+            if (!FlushAggrBuffer(key, filter_key, *cached)) {
+                PDLOG(ERROR, "FlushAggrBuffer failed");
+                return false;
+            }
+            return true;
+        }
+    }
     auto it = aggr_table_->NewTraverseIterator(0);
     // If there is no repetition of ts, `seek` will locate to the position that less than ts.
     it->Seek(key, cur_ts + 1);
@@ -558,6 +657,7 @@ bool Aggregator::UpdateFlushedBuffer(const std::string& key, const std::string&
     }
 
     if (!tmp_buffer.IsInited()) {
+        tmp_buffer.data_type_ = aggr_col_type_;
         tmp_buffer.ts_begin_ = AlignedStart(cur_ts);
         if (window_type_ == WindowType::kRowsRange) {
             tmp_buffer.ts_end_ = tmp_buffer.ts_begin_ + window_size_ - 1;
@@ -578,6 +678,9 @@ bool Aggregator::UpdateFlushedBuffer(const std::string& key, const std::string&
         PDLOG(ERROR, "FlushAggrBuffer failed");
         return false;
     }
+    if (aggr_buffer_lock != nullptr) {
+        CacheFlushedBuffer(tmp_buffer, aggr_buffer_lock);
+    }
     return true;
 }
 
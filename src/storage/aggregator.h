@@ -17,12 +17,20 @@
 #ifndef SRC_STORAGE_AGGREGATOR_H_
 #define SRC_STORAGE_AGGREGATOR_H_
 
+#include <array>
+#include <deque>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "bthread/condition_variable.h"
 #include "codec/codec.h"
 #include "proto/tablet.pb.h"
 #include "proto/type.pb.h"
@@ -115,6 +123,9 @@ class AggrBuffer {
 struct AggrBufferLocked {
     std::unique_ptr<std::mutex> mu_;
     AggrBuffer buffer_;
+    // the recently flushed buckets as stored in the pre-aggr table, the latest at the back. a list allocates
+    // nothing until a bucket is cached, the buffers of the keys without late rows stay small
+    std::list<AggrBuffer> flushed_buffers_;
     AggrBufferLocked() : mu_(std::make_unique<std::mutex>()), buffer_() {}
 };
 
@@ -127,6 +138,11 @@ class Aggregator {
 
     ~Aggregator();
 
+    // Reserves the turn of the update of key at offset. The reservations must be made in the order of the
+    // offsets, e.g. in the lock of the base replicator, then the reserved updates of the keys of a stripe are
+    // applied in that order by Update, which can run out of the lock.
+    void Reserve(const std::string& key, uint64_t offset);
+
     bool Update(const std::string& key, const std::string& row, const uint64_t& offset, bool recover = false);
 
     bool Delete(const std::string& key);
@@ -153,6 +169,8 @@ class Aggregator {
 
     uint32_t GetAggrTid() { return aggr_table_->GetId(); }
 
+    uint64_t GetCachedBucketCnt() const { return cached_bucket_cnt_.load(std::memory_order_relaxed); }
+
     // set the filter column info that not initialized in constructor
     bool SetFilter(absl::string_view filter_col);
 
@@ -160,8 +178,20 @@ class Aggregator {
     codec::Schema base_table_schema_;
     codec::Schema aggr_table_schema_;
 
-    using FilterMap = std::unordered_map<std::string, AggrBufferLocked>;  // filter_column -> aggregator buffer
-    std::unordered_map<std::string, FilterMap> aggr_buffer_map_;          // key -> filter_map
+    // node map, the buffers must stay in place while the stripe lock is released
+    using FilterMap = absl::node_hash_map<std::string, AggrBufferLocked>;  // filter_column -> aggregator buffer
+    struct BufferMapStripe {
+        std::mutex mu;
+        absl::flat_hash_map<std::string, FilterMap> buffer_map;  // key -> filter_map
+        // the reserved offsets not updated yet, in increasing order. the puts wait on bthread primitives, so that
+        // the one at the front is not starved of workers by the ones waiting for it
+        bthread::Mutex turn_mu;
+        bthread::ConditionVariable turn_cv;
+        std::deque<uint64_t> pending_offsets;
+    };
+    // the buffers are striped by the hash of the key, so that the puts of different keys do not contend on one lock
+    static constexpr uint32_t kBufferMapStripes = 64;
+    std::array<BufferMapStripe, kBufferMapStripes> aggr_buffer_map_;
     std::mutex mu_;
     DataType aggr_col_type_;
     DataType ts_col_type_;
@@ -169,18 +199,28 @@ class Aggregator {
     std::shared_ptr<Table> aggr_table_;
     std::shared_ptr<LogReplicator> aggr_replicator_;
     std::atomic<AggrStat> status_;
+    // the flushed buckets cached by all the keys, capped by aggr_flushed_bucket_cache_max_cnt
+    std::atomic<uint64_t> cached_bucket_cnt_{0};
 
     bool GetAggrBufferFromRowView(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* buffer);
-    bool FlushAggrBuffer(const std::string& key, const std::string& filter_key, const AggrBuffer& aggr_buffer);
-    bool UpdateFlushedBuffer(const std::string& key, const std::string& filter_key, const int8_t* base_row_ptr,
-                             int64_t cur_ts, uint64_t offset);
+    BufferMapStripe& GetStripe(absl::string_view key) {
+        return aggr_buffer_map_[absl::Hash<absl::string_view>{}(key) % kBufferMapStripes];
+    }
+    AggrBufferLocked* GetOrCreateBuffer(absl::string_view key, absl::string_view filter_key);
+    bool WaitForTurn(BufferMapStripe* stripe, uint64_t offset);
+    void ReleaseTurn(BufferMapStripe* stripe);
+    bool UpdateInTurn(const std::string& key, const std::string& row, uint64_t offset, bool recover);
+    bool FlushAggrBuffer(const std::string& key, absl::string_view filter_key, const AggrBuffer& aggr_buffer);
+    bool UpdateFlushedBuffer(const std::string& key, absl::string_view filter_key, const int8_t* base_row_ptr,
+                             int64_t cur_ts, uint64_t offset, AggrBufferLocked* aggr_buffer_lock = nullptr);
+    void CacheFlushedBuffer(const AggrBuffer& buffer, AggrBufferLocked* aggr_buffer_lock);
     bool CheckBufferFilled(int64_t cur_ts, int64_t buffer_end, int32_t buffer_cnt);
 
  private:
     virtual bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) = 0;
     virtual bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) = 0;
     virtual bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) = 0;
-    bool EncodeAggrBuffer(const std::string& key, const std::string& filter_key,
+    bool EncodeAggrBuffer(const std::string& key, absl::string_view filter_key,
             const AggrBuffer& buffer, const std::string& aggr_val, std::string* encoded_row);
     int64_t AlignedStart(int64_t ts) {
         if (window_type_ == WindowType::kRowsRange) {
@@ -209,6 +249,9 @@ class Aggregator {
 
     codec::RowView base_row_view_;
     codec::RowView aggr_row_view_;
+    // the row builder keeps the offsets of the row being encoded, the buffers of different stripes are flushed
+    // concurrently
+    std::mutex encode_mu_;
     codec::RowBuilder row_builder_;
 };
 
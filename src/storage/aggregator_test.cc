@@ -14,15 +14,25 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <tuple>
 #include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "base/file_util.h"
+#include "bthread/bthread.h"
 #include "codec/schema_codec.h"
 #include "common/timer.h"
+#include "gflags/gflags.h"
 #include "storage/aggregator.h"
 #include "storage/mem_table.h"
+
+DECLARE_uint32(aggr_flushed_bucket_cache_size);
+DECLARE_uint32(aggr_flushed_bucket_cache_max_cnt);
+
 namespace openmldb {
 namespace storage {
 
@@ -804,6 +814,169 @@ TEST_F(AggregatorTest, OutOfOrder) {
     ::openmldb::base::RemoveDirRecursive(folder);
 }
 
+TEST_F(AggregatorTest, OutOfOrderCachedBucket) {
+    // the buckets updated from the cache are the same as the ones from the pre-aggr table
+    for (uint32_t cache_size : {0, 4}) {
+        FLAGS_aggr_flushed_bucket_cache_size = cache_size;
+        std::map<std::string, std::string> map;
+        std::string folder = "/tmp/" + GenRand() + "/";
+        ::openmldb::api::TableMeta base_table_meta;
+        base_table_meta.set_tid(counter++);
+        AddDefaultAggregatorBaseSchema(&base_table_meta);
+        ::openmldb::api::TableMeta aggr_table_meta;
+        aggr_table_meta.set_tid(counter++);
+        AddDefaultAggregatorSchema(&aggr_table_meta);
+        std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+        aggr_table->Init();
+        std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+            aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+        replicator->Init();
+        auto aggr = CreateAggregator(base_table_meta, aggr_table_meta, aggr_table, replicator, 0, "col3", "sum",
+                                     "ts_col", "1s");
+        std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+            base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+        base_replicator->Init();
+        aggr->Init(base_replicator);
+        codec::RowBuilder row_builder(base_table_meta.column_desc());
+        ASSERT_TRUE(UpdateAggr(aggr, &row_builder));
+        std::string key = "id1|id2";
+        ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+        // the bucket 49 was flushed last, the bucket 20 is out of the cache
+        std::vector<std::pair<int64_t, int32_t>> late_rows = {{49 * 1000 + 1, 100}, {49 * 1000 + 2, 10},
+                                                               {20 * 1000, 100}, {20 * 1000 + 1, 10}};
+        uint64_t offset = 101;
+        for (const auto& late_row : late_rows) {
+            std::string encoded_row;
+            uint32_t row_size = row_builder.CalTotalLength(6);
+            encoded_row.resize(row_size);
+            row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+            (void)row_builder.AppendString("id1", 3);
+            (void)row_builder.AppendString("id2", 3);
+            (void)row_builder.AppendTimestamp(late_row.first);
+            (void)row_builder.AppendInt32(late_row.second);
+            (void)row_builder.AppendInt16(late_row.second);
+            (void)row_builder.AppendInt64(late_row.second);
+            (void)row_builder.AppendFloat(static_cast<float>(late_row.second));
+            (void)row_builder.AppendDouble(static_cast<double>(late_row.second));
+            (void)row_builder.AppendDate(late_row.second);
+            (void)row_builder.AppendNULL();
+            (void)row_builder.AppendNULL();
+            (void)row_builder.AppendInt32(0);
+            ASSERT_TRUE(aggr->Update(key, encoded_row, offset++));
+        }
+        ASSERT_EQ(aggr_table->GetRecordCnt(), 54);
+        // bucket -> (cnt, sum) of the latest stored row
+        std::vector<std::tuple<int64_t, int32_t, int32_t>> expected = {{49 * 1000, 4, 98 + 99 + 110},
+                                                                      {20 * 1000, 4, 40 + 41 + 110}};
+        for (const auto& bucket : expected) {
+            auto it = aggr_table->NewTraverseIterator(0);
+            it->Seek(key, std::get<0>(bucket) + 1);
+            ASSERT_TRUE(it->Valid());
+            std::string data = it->GetValue().ToString();
+            codec::RowView row_view(aggr_table_meta.column_desc(),
+                                    reinterpret_cast<int8_t*>(const_cast<char*>(data.c_str())), data.size());
+            int64_t ts_start = 0;
+            int32_t cnt = 0;
+            char* ch = NULL;
+            uint32_t ch_length = 0;
+            row_view.GetTimestamp(1, &ts_start);
+            row_view.GetInt32(3, &cnt);
+            row_view.GetString(4, &ch, &ch_length);
+            ASSERT_EQ(ts_start, std::get<0>(bucket)) << "cache size " << cache_size;
+            ASSERT_EQ(cnt, std::get<1>(bucket)) << "cache size " << cache_size;
+            ASSERT_EQ(*reinterpret_cast<int64_t*>(ch), std::get<2>(bucket)) << "cache size " << cache_size;
+        }
+        ::openmldb::base::RemoveDirRecursive(folder);
+    }
+    FLAGS_aggr_flushed_bucket_cache_size = 4;
+}
+
+TEST_F(AggregatorTest, CachedBucketCap) {
+    FLAGS_aggr_flushed_bucket_cache_max_cnt = 3;
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    ::openmldb::api::TableMeta base_table_meta;
+    base_table_meta.set_tid(counter++);
+    AddDefaultAggregatorBaseSchema(&base_table_meta);
+    ::openmldb::api::TableMeta aggr_table_meta;
+    aggr_table_meta.set_tid(counter++);
+    AddDefaultAggregatorSchema(&aggr_table_meta);
+    std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+    aggr_table->Init();
+    std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+        aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+    replicator->Init();
+    auto aggr =
+        CreateAggregator(base_table_meta, aggr_table_meta, aggr_table, replicator, 0, "col3", "sum", "ts_col", "1s");
+    std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+        base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+    base_replicator->Init();
+    aggr->Init(base_replicator);
+    codec::RowBuilder row_builder(base_table_meta.column_desc());
+    uint64_t offset = 0;
+    auto update = [&](const std::string& key, int64_t ts, int32_t val) {
+        std::string encoded_row;
+        uint32_t row_size = row_builder.CalTotalLength(6);
+        encoded_row.resize(row_size);
+        row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+        (void)row_builder.AppendString("id1", 3);
+        (void)row_builder.AppendString("id2", 3);
+        (void)row_builder.AppendTimestamp(ts);
+        (void)row_builder.AppendInt32(val);
+        (void)row_builder.AppendInt16(val);
+        (void)row_builder.AppendInt64(val);
+        (void)row_builder.AppendFloat(static_cast<float>(val));
+        (void)row_builder.AppendDouble(static_cast<double>(val));
+        (void)row_builder.AppendDate(val);
+        (void)row_builder.AppendNULL();
+        (void)row_builder.AppendNULL();
+        (void)row_builder.AppendInt32(0);
+        return aggr->Update(key, encoded_row, ++offset);
+    };
+    // two rows per bucket, the buckets 0 - 8 are flushed
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(update("a", i * 500, i));
+    }
+    ASSERT_EQ(aggr->GetCachedBucketCnt(), 3u);
+    // the cap is reached, the key b caches nothing
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(update("b", i * 500, i));
+    }
+    ASSERT_EQ(aggr->GetCachedBucketCnt(), 3u);
+
+    // the late rows of the cached and the not cached buckets are stored the same
+    ASSERT_TRUE(update("a", 7 * 1000 + 1, 100));
+    ASSERT_TRUE(update("b", 7 * 1000 + 1, 100));
+    ASSERT_EQ(aggr->GetCachedBucketCnt(), 3u);
+    for (const std::string key : {"a", "b"}) {
+        auto it = aggr_table->NewTraverseIterator(0);
+        it->Seek(key, 7 * 1000 + 1);
+        ASSERT_TRUE(it->Valid());
+        std::string data = it->GetValue().ToString();
+        codec::RowView row_view(aggr_table_meta.column_desc(),
+                                reinterpret_cast<int8_t*>(const_cast<char*>(data.c_str())), data.size());
+        int64_t ts_start = 0;
+        int32_t cnt = 0;
+        char* ch = NULL;
+        uint32_t ch_length = 0;
+        row_view.GetTimestamp(1, &ts_start);
+        row_view.GetInt32(3, &cnt);
+        row_view.GetString(4, &ch, &ch_length);
+        ASSERT_EQ(ts_start, 7 * 1000) << key;
+        ASSERT_EQ(cnt, 3) << key;
+        ASSERT_EQ(*reinterpret_cast<int64_t*>(ch), 14 + 15 + 100) << key;
+    }
+
+    // the buckets of a deleted key are released
+    ASSERT_TRUE(aggr->Delete("a"));
+    ASSERT_EQ(aggr->GetCachedBucketCnt(), 0u);
+    ASSERT_TRUE(update("b", 20 * 500, 20));
+    ASSERT_TRUE(update("b", 21 * 500, 21));
+    ASSERT_EQ(aggr->GetCachedBucketCnt(), 1u);
+    FLAGS_aggr_flushed_bucket_cache_max_cnt = 100000;
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
 TEST_F(AggregatorTest, OutOfOrderCountWhere) {
     std::map<std::string, std::string> map;
     std::string folder = "/tmp/" + GenRand() + "/";
@@ -1133,6 +1306,149 @@ TEST_F(AggregatorTest, FlushAll) {
     ASSERT_EQ(last_buffer->aggr_cnt_, 1);
 }
 
+TEST_F(AggregatorTest, StringFilterUpdate) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    ::openmldb::api::TableMeta base_table_meta;
+    base_table_meta.set_tid(counter++);
+    AddDefaultAggregatorBaseSchema(&base_table_meta);
+    ::openmldb::api::TableMeta aggr_table_meta;
+    aggr_table_meta.set_tid(counter++);
+    AddDefaultAggregatorSchema(&aggr_table_meta);
+    std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+    aggr_table->Init();
+    std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+        aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+    replicator->Init();
+    // the string filter key is referenced in the row
+    auto aggr = CreateAggregator(base_table_meta, aggr_table_meta, aggr_table, replicator, 0, "col3", "count_where",
+                                 "ts_col", "1s", "col9");
+    std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+        base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+    base_replicator->Init();
+    aggr->Init(base_replicator);
+    codec::RowBuilder row_builder(base_table_meta.column_desc());
+    ASSERT_TRUE(UpdateAggr(aggr, &row_builder));
+    CheckCountWhereAggrResult(aggr_table, aggr, 1);
+    AggrBuffer* last_buffer;
+    ASSERT_TRUE(aggr->GetAggrBuffer("id1|id2", "abc", &last_buffer));
+    ASSERT_EQ(last_buffer->aggr_cnt_, 1);
+    ASSERT_EQ(last_buffer->binlog_offset_, 100);
+    ASSERT_TRUE(aggr->GetAggrBuffer("id1|id2", "hello", &last_buffer));
+    ASSERT_EQ(last_buffer->aggr_cnt_, 1);
+    ASSERT_EQ(last_buffer->binlog_offset_, 99);
+    ASSERT_TRUE(aggr->GetAggrBuffer("id1|id2", "0", &last_buffer));
+    ASSERT_FALSE(last_buffer->IsInited());
+
+    // the filter keys stored in the pre-aggr table are copies, not the rows updated
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    std::map<std::string, int> bucket_cnt;
+    while (it->Valid()) {
+        auto val = it->GetValue();
+        codec::RowView row_view(aggr_table_meta.column_desc(), reinterpret_cast<int8_t*>(const_cast<char*>(val.data())),
+                                val.size());
+        std::string fk;
+        row_view.GetStrValue(6, &fk);
+        bucket_cnt[fk]++;
+        it->Next();
+    }
+    ASSERT_EQ(bucket_cnt.size(), 2u);
+    ASSERT_EQ(bucket_cnt["abc"], 50);
+    ASSERT_EQ(bucket_cnt["hello"], 49);
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+void* RunFunction(void* args) {
+    (*reinterpret_cast<std::function<void()>*>(args))();
+    return nullptr;
+}
+
+TEST_F(AggregatorTest, ConcurrentUpdate) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    ::openmldb::api::TableMeta base_table_meta;
+    base_table_meta.set_tid(counter++);
+    AddDefaultAggregatorBaseSchema(&base_table_meta);
+    ::openmldb::api::TableMeta aggr_table_meta;
+    aggr_table_meta.set_tid(counter++);
+    AddDefaultAggregatorSchema(&aggr_table_meta);
+    std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+    aggr_table->Init();
+    std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+        aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+    replicator->Init();
+    auto aggr = CreateAggregator(base_table_meta, aggr_table_meta, aggr_table, replicator, 0, "col3", "sum", "ts_col",
+                                 "1s", "col9");
+    std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+        base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+    base_replicator->Init();
+    aggr->Init(base_replicator);
+
+    // the puts run on bthreads as in the tablet: the offsets are taken and reserved in a lock as in the
+    // replicator, then the keys shared by all the bthreads are updated out of it. an update out of the order
+    // of the offsets of its key fails
+    int bthread_num = 8;
+    int key_num = 4;
+    int row_num = 200;
+    bthread::Mutex mu;
+    uint64_t log_offset = 0;
+    std::map<std::pair<std::string, std::string>, std::pair<int64_t, int64_t>> expect;  // (key, filter) -> (cnt, sum)
+    std::atomic<int> failed{0};
+    std::function<void()> put = [&]() {
+        codec::RowBuilder row_builder(base_table_meta.column_desc());
+        std::string encoded_row;
+        for (int i = 0; i < row_num; i++) {
+            std::string id = "id" + std::to_string(i % key_num);
+            std::string filter = i % 3 == 0 ? "a" : "bc";
+            uint32_t row_size = row_builder.CalTotalLength(id.size() + 3 + filter.size());
+            encoded_row.resize(row_size);
+            row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+            (void)row_builder.AppendString(id.c_str(), id.size());
+            (void)row_builder.AppendString("id2", 3);
+            (void)row_builder.AppendTimestamp(i);
+            (void)row_builder.AppendInt32(i);
+            (void)row_builder.AppendInt16(i);
+            (void)row_builder.AppendInt64(i);
+            (void)row_builder.AppendFloat(static_cast<float>(i));
+            (void)row_builder.AppendDouble(static_cast<double>(i));
+            (void)row_builder.AppendDate(i);
+            (void)row_builder.AppendString(filter.c_str(), filter.size());
+            (void)row_builder.AppendNULL();
+            (void)row_builder.AppendInt32(i % 2);
+            uint64_t offset = 0;
+            {
+                std::lock_guard<bthread::Mutex> lock(mu);
+                offset = ++log_offset;
+                aggr->Reserve(id, offset);
+                auto& val = expect[{id, filter}];
+                val.first++;
+                val.second += i;
+            }
+            if (!aggr->Update(id, encoded_row, offset)) {
+                failed++;
+            }
+        }
+    };
+    std::vector<bthread_t> tids(bthread_num);
+    for (auto& tid : tids) {
+        ASSERT_EQ(0, bthread_start_background(&tid, nullptr, RunFunction, &put));
+    }
+    for (auto tid : tids) {
+        bthread_join(tid, nullptr);
+    }
+    ASSERT_EQ(failed.load(), 0);
+    ASSERT_EQ(aggr_table->GetRecordCnt(), 0);
+    ASSERT_EQ(expect.size(), static_cast<size_t>(key_num * 2));
+    for (const auto& kv : expect) {
+        AggrBuffer* buffer;
+        ASSERT_TRUE(aggr->GetAggrBuffer(kv.first.first, kv.first.second, &buffer));
+        ASSERT_EQ(buffer->aggr_cnt_, kv.second.first);
+        ASSERT_EQ(buffer->aggr_val_.vlong, kv.second.second);
+    }
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -17,6 +17,7 @@
 #include "storage/binlog.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -29,9 +30,14 @@
 #include "gflags/gflags.h"
 #include "log/log_writer.h"
 #include "log/status.h"
+#include "storage/parallel_loader.h"
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
+DECLARE_bool(load_table_parallel);
+DECLARE_uint32(load_table_batch);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(load_table_queue_size);
 
 namespace openmldb {
 namespace storage {
@@ -50,8 +56,15 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
     uint64_t succ_cnt = 0;
     uint64_t failed_cnt = 0;
     uint64_t consumed = ::baidu::common::timer::now_time();
+    uint64_t start_time = ::baidu::common::timer::get_micros();
     int last_log_index = log_reader.GetLogIndex();
     bool reach_end_log = true;
+    // the entries are put by partition threads, deletes wait all the entries before them to be put
+    std::unique_ptr<ParallelLoader> loader;
+    if (FLAGS_load_table_parallel && table->GetStorageMode() == ::openmldb::common::kMemory) {
+        loader = std::make_unique<ParallelLoader>(table, FLAGS_load_table_thread_num, FLAGS_load_table_queue_size,
+                                                  FLAGS_load_table_batch);
+    }
     while (true) {
         buffer.clear();
         ::openmldb::base::Slice record;
@@ -107,16 +120,23 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                   cur_offset, entry.log_index(), tid, pid);
         }
 
+        cur_offset = entry.log_index();
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             if (entry.dimensions_size() == 0) {
                 PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
             } else {
+                if (loader) {
+                    loader->Wait();
+                }
                 table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
             }
+        } else if (loader) {
+            auto put_entry = new ::openmldb::api::LogEntry();
+            put_entry->Swap(&entry);
+            loader->AddEntry(put_entry);
         } else {
             table->Put(entry);
         }
-        cur_offset = entry.log_index();
         succ_cnt++;
         if (succ_cnt % 100000 == 0) {
             PDLOG(INFO,
@@ -128,6 +148,16 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             table->SchedGc();
         }
     }
+    if (loader) {
+        uint64_t read_done_time = ::baidu::common::timer::get_micros();
+        loader->Stop();
+        uint64_t end_time = ::baidu::common::timer::get_micros();
+        PDLOG(INFO,
+              "recover table tid %u pid %u from binlog done. total %lu ms, read %lu ms, wait put %lu ms, "
+              "put %lu ms in all %u threads",
+              tid, pid, (end_time - start_time) / 1000, (read_done_time - start_time) / 1000,
+              (end_time - read_done_time) / 1000, loader->GetPutTime() / 1000, FLAGS_load_table_thread_num);
+    }
     latest_offset = cur_offset;
     if (!reach_end_log) {
         int log_index = log_reader.GetLogIndex();
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/cold_block.h"
+
+#include <stdlib.h>
+
+#include <snappy.h>
+
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+static void PutVarint64(uint64_t value, std::string* dst) {
+    while (value >= 0x80) {
+        dst->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    dst->push_back(static_cast<char>(value));
+}
+
+static bool GetVarint64(const char** cur, const char* limit, uint64_t* value) {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift <= 63 && *cur < limit; shift += 7) {
+        uint64_t byte = static_cast<uint8_t>(**cur);
+        (*cur)++;
+        result |= (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+DataBlock* NewColdBlock(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& rows, uint32_t owned_cnt) {
+    if (rows.empty()) {
+        return nullptr;
+    }
+    std::string columns;
+    uint64_t pre_ts = rows.front().first;
+    for (const auto& row : rows) {
+        PutVarint64(pre_ts - row.first, &columns);
+        pre_ts = row.first;
+    }
+    for (const auto& row : rows) {
+        PutVarint64(row.second.size(), &columns);
+    }
+    for (const auto& row : rows) {
+        columns.append(row.second.data(), row.second.size());
+    }
+    ColdBlockHeader header;
+    header.row_cnt = rows.size();
+    header.owned_cnt = owned_cnt;
+    header.max_ts = rows.front().first;
+    header.min_ts = rows.back().first;
+    char* data = new char[sizeof(ColdBlockHeader) + snappy::MaxCompressedLength(columns.size())];
+    memcpy(data, &header, sizeof(ColdBlockHeader));
+    size_t compressed_len = 0;
+    snappy::RawCompress(columns.data(), columns.size(), data + sizeof(ColdBlockHeader), &compressed_len);
+    uint32_t size = sizeof(ColdBlockHeader) + compressed_len;
+    // shrink to fit, the block lives as long as the rows
+    DataBlock* block = new DataBlock(1, data, size);
+    delete[] data;
+    block->cold = 1;
+    return block;
+}
+
+bool ColdBlock::Decode(const DataBlock* block) {
+    if (block == nullptr || block->cold == 0 || block->size < sizeof(ColdBlockHeader)) {
+        return false;
+    }
+    ColdBlockHeader header = GetColdBlockHeader(block->data);
+    const char* compressed = block->data + sizeof(ColdBlockHeader);
+    size_t compressed_len = block->size - sizeof(ColdBlockHeader);
+    size_t len = 0;
+    if (!snappy::GetUncompressedLength(compressed, compressed_len, &len)) {
+        return false;
+    }
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(len == 0 ? 1 : len));
+    buf_ = ::hybridse::base::RefCountedSlice::CreateManaged(buf, len);
+    if (!snappy::RawUncompress(compressed, compressed_len, reinterpret_cast<char*>(buf))) {
+        return false;
+    }
+    ts_.resize(header.row_cnt);
+    offset_.resize(header.row_cnt + 1);
+    const char* cur = buf_.data();
+    const char* limit = buf_.data() + buf_.size();
+    uint64_t ts = header.max_ts;
+    for (uint32_t i = 0; i < header.row_cnt; i++) {
+        uint64_t delta = 0;
+        if (!GetVarint64(&cur, limit, &delta)) {
+            return false;
+        }
+        ts -= delta;
+        ts_[i] = ts;
+    }
+    // offset_ is filled with the sizes first and turned into offsets below
+    for (uint32_t i = 0; i < header.row_cnt; i++) {
+        uint64_t size = 0;
+        if (!GetVarint64(&cur, limit, &size)) {
+            return false;
+        }
+        offset_[i + 1] = size;
+    }
+    offset_[0] = cur - buf_.data();
+    for (uint32_t i = 1; i <= header.row_cnt; i++) {
+        offset_[i] += offset_[i - 1];
+    }
+    return offset_[header.row_cnt] <= buf_.size();
+}
+
+uint32_t ColdBlock::Seek(uint64_t time) const {
+    uint32_t low = 0;
+    uint32_t high = ts_.size();
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (ts_[mid] > time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+}  // namespace storage
+}  // namespace openmldb
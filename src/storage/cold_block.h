@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COLD_BLOCK_H_
+#define SRC_STORAGE_COLD_BLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/fe_slice.h"
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+struct DataBlock;
+
+// a cold block packs the old rows of one key entry into a single DataBlock. the layout is
+// | header | snappy(ts column | size column | value column) |
+// the ts column is delta encoded in desc order, the sizes are varints and the values are concatenated
+struct ColdBlockHeader {
+    uint32_t row_cnt;
+    // the count of rows whose original DataBlock was freed when the block was built, the other rows
+    // are still held by other indexes and will be counted there
+    uint32_t owned_cnt;
+    uint64_t max_ts;
+    uint64_t min_ts;
+};
+
+// rows must be sorted by ts in desc order
+DataBlock* NewColdBlock(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& rows, uint32_t owned_cnt);
+
+inline ColdBlockHeader GetColdBlockHeader(const char* data) {
+    ColdBlockHeader header;
+    memcpy(&header, data, sizeof(ColdBlockHeader));
+    return header;
+}
+
+// the decoded rows of a cold block. The rows are in one ref counted buffer, a row shared by
+// GetSharedRow keeps the buffer alive after the ColdBlock is deleted
+class ColdBlock {
+ public:
+    ColdBlock() : buf_(), ts_(), offset_() {}
+
+    bool Decode(const DataBlock* block);
+
+    inline uint32_t GetRowCnt() const { return ts_.size(); }
+
+    inline uint64_t GetMinTs() const { return ts_.empty() ? 0 : ts_.back(); }
+
+    inline const uint64_t& GetTs(uint32_t pos) const { return ts_[pos]; }
+
+    inline ::openmldb::base::Slice GetRow(uint32_t pos) const {
+        return ::openmldb::base::Slice(buf_.data() + offset_[pos], offset_[pos + 1] - offset_[pos]);
+    }
+
+    inline ::hybridse::base::RefCountedSlice GetSharedRow(uint32_t pos) const {
+        return buf_.SubSlice(offset_[pos], offset_[pos + 1] - offset_[pos]);
+    }
+
+    // return the position of the first row whose ts is not greater than time
+    uint32_t Seek(uint64_t time) const;
+
+ private:
+    ::hybridse::base::RefCountedSlice buf_;
+    std::vector<uint64_t> ts_;
+    std::vector<uint32_t> offset_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COLD_BLOCK_H_
@@ -15,11 +15,11 @@
  */
 
 #include "storage/disk_table.h"
-#include <snappy.h>
 #include <utility>
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
+#include "codec/row_compress.h"
 #include "config.h"  // NOLINT
 
 DECLARE_bool(disable_wal);
@@ -219,8 +219,11 @@ bool DiskTable::Put(const std::string& pk, uint64_t time, const char* data, uint
 bool DiskTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
     const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
     std::string uncompress_data;
-    if (GetCompressType() == openmldb::type::kSnappy) {
-        snappy::Uncompress(value.data(), value.size(), &uncompress_data);
+    if (GetCompressType() != openmldb::type::kNoCompress) {
+        if (!codec::UncompressRow(GetCompressType(), value, &uncompress_data)) {
+            PDLOG(WARNING, "uncompress value failed. tid %u pid %u", id_, pid_);
+            return false;
+        }
         data = reinterpret_cast<const int8_t*>(uncompress_data.data());
     }
     uint8_t version = codec::RowView::GetSchemaVersion(data);
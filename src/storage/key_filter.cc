@@ -0,0 +1,96 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/key_filter.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t KEY_FILTER_SEED = 0xe17a1465;
+static const uint32_t WORDS_PER_BLOCK = 8;
+static const uint32_t BITS_PER_BLOCK = WORDS_PER_BLOCK * 64;
+
+KeyFilter::KeyFilter(uint64_t capacity, uint32_t bits_per_key)
+    : capacity_(std::max<uint64_t>(capacity, 1)),
+      bits_per_key_(std::max<uint32_t>(bits_per_key, 1)),
+      probe_cnt_(1),
+      block_cnt_(1),
+      bits_(nullptr) {
+    // ln2 * bits_per_key probes give the lowest false positive rate
+    probe_cnt_ = std::min<uint32_t>(std::max<uint32_t>(bits_per_key_ * 69 / 100, 1), 30);
+    block_cnt_ = std::max<uint64_t>((capacity_ * bits_per_key_ + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK, 1);
+    bits_ = new std::atomic<uint64_t>[block_cnt_ * WORDS_PER_BLOCK];
+    for (uint64_t i = 0; i < block_cnt_ * WORDS_PER_BLOCK; i++) {
+        bits_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+KeyFilter::~KeyFilter() { delete[] bits_; }
+
+void KeyFilter::Add(const ::openmldb::base::Slice& key) {
+    uint64_t hash = ::openmldb::base::MurmurHash64A(key.data(), key.size(), KEY_FILTER_SEED);
+    std::atomic<uint64_t>* block = bits_ + ((hash >> 32) % block_cnt_) * WORDS_PER_BLOCK;
+    uint32_t h = static_cast<uint32_t>(hash);
+    uint32_t delta = (h >> 17) | (h << 15);
+    for (uint32_t i = 0; i < probe_cnt_; i++) {
+        uint32_t pos = h % BITS_PER_BLOCK;
+        uint64_t mask = 1ull << (pos % 64);
+        std::atomic<uint64_t>& word = block[pos / 64];
+        // skip the write if the bit is set already, most of the keys put are not new
+        if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+            word.fetch_or(mask, std::memory_order_relaxed);
+        }
+        h += delta;
+    }
+}
+
+bool KeyFilter::MayContain(const ::openmldb::base::Slice& key) const {
+    uint64_t hash = ::openmldb::base::MurmurHash64A(key.data(), key.size(), KEY_FILTER_SEED);
+    const std::atomic<uint64_t>* block = bits_ + ((hash >> 32) % block_cnt_) * WORDS_PER_BLOCK;
+    uint32_t h = static_cast<uint32_t>(hash);
+    uint32_t delta = (h >> 17) | (h << 15);
+    for (uint32_t i = 0; i < probe_cnt_; i++) {
+        uint32_t pos = h % BITS_PER_BLOCK;
+        if ((block[pos / 64].load(std::memory_order_relaxed) & (1ull << (pos % 64))) == 0) {
+            return false;
+        }
+        h += delta;
+    }
+    return true;
+}
+
+double KeyFilter::GetFalsePositiveRate() const {
+    uint64_t set_cnt = 0;
+    for (uint64_t i = 0; i < block_cnt_ * WORDS_PER_BLOCK; i++) {
+        set_cnt += __builtin_popcountll(bits_[i].load(std::memory_order_relaxed));
+    }
+    double ratio = static_cast<double>(set_cnt) / (block_cnt_ * BITS_PER_BLOCK);
+    return pow(ratio, probe_cnt_);
+}
+
+double KeyFilter::GetDesignedFalsePositiveRate() const {
+    double bits_per_key = static_cast<double>(block_cnt_ * BITS_PER_BLOCK) / capacity_;
+    return pow(1 - exp(-static_cast<double>(probe_cnt_) / bits_per_key), probe_cnt_);
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_KEY_FILTER_H_
+#define SRC_STORAGE_KEY_FILTER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+// a blocked bloom filter of the pks in a segment. all the bits of a key are in one 512 bits block,
+// so a lookup touches one cache line. Add and MayContain can run concurrently
+class KeyFilter {
+ public:
+    KeyFilter(uint64_t capacity, uint32_t bits_per_key);
+    ~KeyFilter();
+
+    KeyFilter(const KeyFilter&) = delete;
+    KeyFilter& operator=(const KeyFilter&) = delete;
+
+    void Add(const ::openmldb::base::Slice& key);
+
+    // false means the key is absent for sure
+    bool MayContain(const ::openmldb::base::Slice& key) const;
+
+    inline uint64_t GetCapacity() const { return capacity_; }
+
+    inline uint32_t GetBitsPerKey() const { return bits_per_key_; }
+
+    // estimated by the ratio of the set bits
+    double GetFalsePositiveRate() const;
+
+    // the false positive rate when the filter holds capacity keys
+    double GetDesignedFalsePositiveRate() const;
+
+ private:
+    const uint64_t capacity_;
+    const uint32_t bits_per_key_;
+    uint32_t probe_cnt_;
+    uint64_t block_cnt_;
+    std::atomic<uint64_t>* bits_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_KEY_FILTER_H_
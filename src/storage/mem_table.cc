@@ -16,13 +16,13 @@
 
 #include "storage/mem_table.h"
 
-#include <snappy.h>
 #include <algorithm>
 #include <utility>
 
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "base/slice.h"
+#include "codec/row_compress.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "storage/record.h"
@@ -34,6 +34,9 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(mem_table_slab_size);
+DECLARE_uint32(mem_table_cold_age);
+DECLARE_uint32(mem_table_cold_block_row_cnt);
 
 namespace openmldb {
 namespace storage {
@@ -121,6 +124,10 @@ bool MemTable::Init() {
         segments_[i] = seg_arr;
         key_entry_max_height_ = cur_key_entry_max_height;
     }
+    if (FLAGS_mem_table_slab_size > 0) {
+        slab_allocator_ = std::make_unique<SlabAllocator>(FLAGS_mem_table_slab_size, seg_cnt_);
+        PDLOG(INFO, "enable slab allocator, slab size %u. tid %u pid %u", slab_allocator_->GetSlabSize(), id_, pid_);
+    }
     PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d", name_.c_str(), id_, pid_, seg_cnt_);
     return true;
 }
@@ -143,7 +150,9 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     return true;
 }
 
-bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+bool MemTable::ParseRow(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                        std::map<int32_t, Slice>* inner_index_key_map, std::map<int32_t, uint64_t>* ts_map,
+                        uint32_t* real_ref_cnt) {
     if (dimensions.empty()) {
         PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
         return false;
@@ -152,20 +161,22 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
         return false;
     }
-    std::map<int32_t, Slice> inner_index_key_map;
     for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
         int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
         if (inner_pos < 0) {
             PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", iter->idx(), id_, pid_);
             return false;
         }
-        inner_index_key_map.emplace(inner_pos, iter->key());
+        inner_index_key_map->emplace(inner_pos, iter->key());
     }
-    uint32_t real_ref_cnt = 0;
+    *real_ref_cnt = 0;
     const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
     std::string uncompress_data;
-    if (GetCompressType() == openmldb::type::kSnappy) {
-        snappy::Uncompress(value.data(), value.size(), &uncompress_data);
+    if (GetCompressType() != openmldb::type::kNoCompress) {
+        if (!codec::UncompressRow(GetCompressType(), value, &uncompress_data)) {
+            PDLOG(WARNING, "uncompress value failed. tid %u pid %u", id_, pid_);
+            return false;
+        }
         data = reinterpret_cast<const int8_t*>(uncompress_data.data());
     }
     uint8_t version = codec::RowView::GetSchemaVersion(data);
@@ -174,8 +185,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "invalid schema version %u, tid %u pid %u", version, id_, pid_);
         return false;
     }
-    std::map<int32_t, uint64_t> ts_map;
-    for (const auto& kv : inner_index_key_map) {
+    for (const auto& kv : *inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         if (!inner_index) {
             PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", kv.first, id_, pid_);
@@ -195,41 +205,91 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
                     PDLOG(WARNING, "ts %ld is negative. tid %u pid %u", ts, id_, pid_);
                     return false;
                 }
-                ts_map.emplace(ts_col->GetId(), ts);
+                ts_map->emplace(ts_col->GetId(), ts);
             }
             if (index_def->IsReady()) {
-                real_ref_cnt++;
+                (*real_ref_cnt)++;
             }
         }
     }
-    if (ts_map.empty()) {
+    return !ts_map->empty();
+}
+
+bool MemTable::NeedPut(int32_t inner_pos) {
+    auto inner_index = table_index_.GetInnerIndex(inner_pos);
+    for (const auto& index_def : inner_index->GetIndex()) {
+        if (index_def->IsReady()) {
+            // TODO(hw): if we don't find this ts(has_found_ts==false), but it's ready, will put too?
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t MemTable::GetSegIdx(const Slice& key) const {
+    if (seg_cnt_ > 1) {
+        return ::openmldb::base::hash(key.data(), key.size(), SEED) % seg_cnt_;
+    }
+    return 0;
+}
+
+bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    std::map<int32_t, Slice> inner_index_key_map;
+    std::map<int32_t, uint64_t> ts_map;
+    uint32_t real_ref_cnt = 0;
+    if (!ParseRow(time, value, dimensions, &inner_index_key_map, &ts_map, &real_ref_cnt)) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    // rows with the same first dimension go to the same slab shard as their segment
+    uint32_t shard = GetSegIdx(inner_index_key_map.begin()->second);
+    auto* block = NewDataBlock(slab_allocator_.get(), shard, real_ref_cnt, value.c_str(), value.length());
+    uint32_t record_size = GetRecordSize(block);
     for (const auto& kv : inner_index_key_map) {
-        auto inner_index = table_index_.GetInnerIndex(kv.first);
-        bool need_put = false;
-        for (const auto& index_def : inner_index->GetIndex()) {
-            if (index_def->IsReady()) {
-                // TODO(hw): if we don't find this ts(has_found_ts==false), but it's ready, will put too?
-                need_put = true;
-                break;
-            }
-        }
-        if (need_put) {
-            uint32_t seg_idx = 0;
-            if (seg_cnt_ > 1) {
-                seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
-            }
-            Segment* segment = segments_[kv.first][seg_idx];
-            segment->Put(::openmldb::base::Slice(kv.second), ts_map, block);
+        if (NeedPut(kv.first)) {
+            Segment* segment = segments_[kv.first][GetSegIdx(kv.second)];
+            segment->Put(kv.second, ts_map, block);
         }
     }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(record_size);
     return true;
 }
 
+void MemTable::PutBatch(const ::google::protobuf::RepeatedPtrField<::openmldb::api::PutRequest>& rows,
+                        std::vector<uint32_t>* failed_idx) {
+    std::vector<std::map<int32_t, uint64_t>> ts_maps(rows.size());
+    // group the rows by segment, so every segment is locked only once
+    std::map<std::pair<int32_t, uint32_t>, std::vector<SegmentPutRow>> segment_rows;
+    uint64_t record_cnt = 0;
+    uint64_t record_byte_size = 0;
+    for (int i = 0; i < rows.size(); i++) {
+        const auto& row = rows.Get(i);
+        std::map<int32_t, Slice> inner_index_key_map;
+        uint32_t real_ref_cnt = 0;
+        if (!ParseRow(row.time(), row.value(), row.dimensions(), &inner_index_key_map, &ts_maps[i],
+                      &real_ref_cnt)) {
+            failed_idx->push_back(i);
+            continue;
+        }
+        uint32_t shard = GetSegIdx(inner_index_key_map.begin()->second);
+        auto* block = NewDataBlock(slab_allocator_.get(), shard, real_ref_cnt, row.value().c_str(),
+                                   row.value().length());
+        record_byte_size += GetRecordSize(block);
+        record_cnt++;
+        for (const auto& kv : inner_index_key_map) {
+            if (NeedPut(kv.first)) {
+                segment_rows[std::make_pair(kv.first, GetSegIdx(kv.second))].push_back(
+                    SegmentPutRow{kv.second, &ts_maps[i], block});
+            }
+        }
+    }
+    for (const auto& kv : segment_rows) {
+        segments_[kv.first.first][kv.first.second]->Put(kv.second);
+    }
+    record_cnt_.fetch_add(record_cnt, std::memory_order_relaxed);
+    record_byte_size_.fetch_add(record_byte_size);
+}
+
 bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
@@ -271,6 +331,14 @@ void MemTable::SchedGc() {
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
+    uint64_t cold_row_cnt = 0;
+    uint64_t cold_freed_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    uint64_t cold_time = 0;
+    if (FLAGS_mem_table_cold_age > 0) {
+        cold_time = ::baidu::common::timer::get_micros() / 1000 -
+                    static_cast<uint64_t>(FLAGS_mem_table_cold_age) * 60 * 1000;
+    }
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (uint32_t i = 0; i < inner_indexs->size(); i++) {
         const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
@@ -326,6 +394,12 @@ void MemTable::SchedGc() {
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
+            if (cold_time > 0 && ttl_st_map.size() == 1 &&
+                ttl_st_map.begin()->second.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+                segment->ConvertToCold(cold_time, FLAGS_mem_table_cold_block_row_cnt, cold_row_cnt,
+                                       cold_freed_byte_size, cold_byte_size);
+            }
+            segment->RebuildKeyFilter();
             seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
             PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
                   name_.c_str(), id_, pid_);
@@ -334,10 +408,22 @@ void MemTable::SchedGc() {
     consumed = ::baidu::common::timer::get_micros() - consumed;
     record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
     record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
+    record_byte_size_.fetch_add(cold_byte_size, std::memory_order_relaxed);
+    record_byte_size_.fetch_sub(cold_freed_byte_size, std::memory_order_relaxed);
     PDLOG(INFO,
           "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
           "table %s tid %u pid %u",
           gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+    if (cold_row_cnt > 0) {
+        PDLOG(INFO,
+              "convert %lu rows to cold blocks, freed byte size %lu, cold byte size %lu for table %s tid %u pid %u",
+              cold_row_cnt, cold_freed_byte_size, cold_byte_size, name_.c_str(), id_, pid_);
+    }
+    if (slab_allocator_) {
+        PDLOG(INFO, "slab cnt %lu, reserved byte size %lu, record byte size %lu for table %s tid %u pid %u",
+              slab_allocator_->GetSlabCnt(), slab_allocator_->GetReservedByteSize(), GetRecordByteSize(),
+              name_.c_str(), id_, pid_);
+    }
     UpdateTTL();
 }
 
@@ -574,6 +660,28 @@ bool MemTable::GetRecordIdxCnt(uint32_t idx, uint64_t** stat, uint32_t* size) {
     return true;
 }
 
+bool MemTable::GetKeyFilterFpr(uint32_t idx, double* fpr) {
+    if (fpr == nullptr) {
+        return false;
+    }
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx);
+    if (!index_def || !index_def->IsReady()) {
+        return false;
+    }
+    uint32_t inner_idx = index_def->GetInnerPos();
+    double total = 0;
+    for (uint32_t i = 0; i < seg_cnt_; i++) {
+        double seg_fpr = 0;
+        if (!segments_[inner_idx][i]->GetKeyFilterFpr(&seg_fpr)) {
+            return false;
+        }
+        total += seg_fpr;
+    }
+    // the pks are spread evenly by hash, so the segments are looked up evenly too
+    *fpr = total / seg_cnt_;
+    return true;
+}
+
 bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
     // TODO(denglong): support ttl type and merge index
     auto table_meta = GetTableMeta();
@@ -852,6 +960,10 @@ void MemTableTraverseIterator::Next() {
 uint64_t MemTableTraverseIterator::GetCount() const { return traverse_cnt_; }
 
 void MemTableTraverseIterator::NextPK() {
+    if (it_ != nullptr) {
+        // the values returned may be still in use
+        it_->MoveDecoded(&cold_blocks_);
+    }
     delete it_;
     it_ = nullptr;
     do {
@@ -879,12 +991,12 @@ void MemTableTraverseIterator::NextPK() {
         }
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
             ticket_.Push(entry);
+            it_ = new TimeEntriesIterator(&entry->entries, segments_[seg_idx_]->GetColdTsHint());
         } else {
-            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+            it_ = new TimeEntriesIterator(&((KeyEntry*)pk_it_->GetValue())->entries,  // NOLINT
+                                          segments_[seg_idx_]->GetColdTsHint());
         }
         it_->SeekToFirst();
         record_idx_ = 1;
@@ -915,11 +1027,11 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
             ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
+            it_ = new TimeEntriesIterator(&entry->entries, segments_[seg_idx_]->GetColdTsHint());
         } else {
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
+            it_ = new TimeEntriesIterator(&((KeyEntry*)pk_it_->GetValue())->entries,  // NOLINT
+                                          segments_[seg_idx_]->GetColdTsHint());
         }
         if (spk.compare(pk_it_->GetKey()) != 0) {
             it_->SeekToFirst();
@@ -955,7 +1067,7 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
 }
 
 openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
-    return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    return it_->GetValue();
 }
 
 uint64_t MemTableTraverseIterator::GetKey() const {
@@ -989,11 +1101,11 @@ void MemTableTraverseIterator::SeekToFirst() {
             if (segments_[seg_idx_]->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
                 ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
+                it_ = new TimeEntriesIterator(&entry->entries, segments_[seg_idx_]->GetColdTsHint());
             } else {
                 ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-                it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
+                it_ = new TimeEntriesIterator(&((KeyEntry*)pk_it_->GetValue())->entries,  // NOLINT
+                                              segments_[seg_idx_]->GetColdTsHint());
             }
             it_->SeekToFirst();
             traverse_cnt_++;
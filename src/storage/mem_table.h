@@ -26,6 +26,7 @@
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/segment.h"
+#include "storage/slab_allocator.h"
 #include "storage/table.h"
 #include "storage/ticket.h"
 #include "vm/catalog.h"
@@ -58,12 +59,14 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    TimeEntriesIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     TTLSt expire_value_;
     Ticket ticket_;
     uint64_t traverse_cnt_;
+    // the cold blocks decoded by the iterators of the visited pks
+    std::vector<std::unique_ptr<ColdBlock>> cold_blocks_;
 };
 
 class MemTable : public Table {
@@ -82,6 +85,9 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    void PutBatch(const ::google::protobuf::RepeatedPtrField<::openmldb::api::PutRequest>& rows,
+                  std::vector<uint32_t>* failed_idx) override;
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -110,15 +116,26 @@ class MemTable : public Table {
     uint64_t GetRecordIdxByteSize() override;
     uint64_t GetRecordPkCnt() override;
 
+    // the estimated false positive rate of the key filters of the index, false if the filter is disabled
+    bool GetKeyFilterFpr(uint32_t idx, double* fpr);
+
     void SetCompressType(::openmldb::type::CompressType compress_type);
     ::openmldb::type::CompressType GetCompressType();
 
     uint64_t GetRecordByteSize() const override { return record_byte_size_.load(std::memory_order_relaxed); }
 
+    // the bytes reserved by slabs, 0 if slab allocator is disabled
+    uint64_t GetSlabReservedByteSize() const {
+        return slab_allocator_ ? slab_allocator_->GetReservedByteSize() : 0;
+    }
+
     uint64_t GetRecordCnt() const override { return record_cnt_.load(std::memory_order_relaxed); }
 
     inline uint32_t GetSegCnt() const { return seg_cnt_; }
 
+    // the segment of key in every index
+    uint32_t GetSegIdx(const Slice& key) const;
+
     inline void SetExpire(bool is_expire) { enable_gc_.store(is_expire, std::memory_order_relaxed); }
 
     uint64_t GetExpireTime(const TTLSt& ttl_st) override;
@@ -136,6 +153,13 @@ class MemTable : public Table {
  private:
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
+    // decode the ts of row and map dimensions to inner index positions
+    bool ParseRow(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                  std::map<int32_t, Slice>* inner_index_key_map, std::map<int32_t, uint64_t>* ts_map,
+                  uint32_t* real_ref_cnt);
+
+    bool NeedPut(int32_t inner_pos);
+
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
  private:
@@ -147,6 +171,8 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    // must be destroyed after all the segments released
+    std::unique_ptr<SlabAllocator> slab_allocator_;
 };
 
 }  // namespace storage
@@ -20,7 +20,6 @@
 #ifdef DISALLOW_COPY_AND_ASSIGN
 #undef DISALLOW_COPY_AND_ASSIGN
 #endif
-#include <snappy.h>
 #include <unistd.h>
 
 #include <set>
@@ -34,12 +33,14 @@
 #include "base/taskpool.hpp"
 #include "boost/bind.hpp"
 #include "codec/row_codec.h"
+#include "codec/row_compress.h"
 #include "common/thread_pool.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/parallel_loader.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -47,9 +48,11 @@ using ::openmldb::codec::SchemaCodec;
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
 DECLARE_uint32(make_snapshot_max_deleted_keys);
+DECLARE_uint32(make_snapshot_max_delta_num);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
+DECLARE_bool(load_table_parallel);
 DECLARE_string(snapshot_compression);
 
 namespace openmldb {
@@ -60,7 +63,7 @@ const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
-    : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
+    : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path), base_offset_(0) {}
 
 bool MemTableSnapshot::Init() {
     snapshot_path_ = db_root_path_ + "/" + std::to_string(tid_) + "_" + std::to_string(pid_) + "/snapshot/";
@@ -84,9 +87,12 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
-        latest_offset = manifest.offset();
+        for (const auto& file : GetSnapshotFiles(manifest)) {
+            RecoverFromSnapshot(file.name(), file.count(), table);
+        }
+        latest_offset = GetManifestOffset(manifest);
         offset_ = latest_offset;
+        base_offset_ = manifest.offset();
     }
     return true;
 }
@@ -96,7 +102,11 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     std::string full_path = snapshot_path_ + "/" + snapshot_name;
     std::atomic<uint64_t> g_succ_cnt(0);
     std::atomic<uint64_t> g_failed_cnt(0);
-    RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    if (FLAGS_load_table_parallel) {
+        RecoverSingleSnapshotParallel(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    } else {
+        RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    }
     PDLOG(INFO, "[Recover] progress done stat: success count %lu, failed count %lu",
           g_succ_cnt.load(std::memory_order_relaxed), g_failed_cnt.load(std::memory_order_relaxed));
     if (g_succ_cnt.load(std::memory_order_relaxed) != expect_cnt) {
@@ -174,6 +184,72 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
     load_pool_.Stop();
 }
 
+void MemTableSnapshot::RecoverSingleSnapshotParallel(const std::string& path, std::shared_ptr<Table> table,
+                                                     std::atomic<uint64_t>* g_succ_cnt,
+                                                     std::atomic<uint64_t>* g_failed_cnt) {
+    if (table == NULL) {
+        PDLOG(WARNING, "table input is NULL");
+        return;
+    }
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    ParallelLoader loader(table, FLAGS_load_table_thread_num, FLAGS_load_table_queue_size, FLAGS_load_table_batch);
+    bool compressed = IsCompressed(path);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    std::string buffer;
+    uint64_t read_failed_cnt = 0;
+    uint64_t read_time = 0;
+    std::vector<std::string*> records;
+    records.reserve(FLAGS_load_table_batch);
+    while (true) {
+        uint64_t read_start = ::baidu::common::timer::get_micros();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            read_time += ::baidu::common::timer::get_micros() - read_start;
+            break;
+        }
+        if (!status.ok()) {
+            read_time += ::baidu::common::timer::get_micros() - read_start;
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            read_failed_cnt++;
+            continue;
+        }
+        records.push_back(new std::string(record.data(), record.size()));
+        read_time += ::baidu::common::timer::get_micros() - read_start;
+        if (records.size() >= FLAGS_load_table_batch) {
+            loader.AddRecords(std::move(records));
+            records.clear();
+            records.reserve(FLAGS_load_table_batch);
+        }
+    }
+    loader.AddRecords(std::move(records));
+    // will close the fd atomic
+    delete seq_file;
+    uint64_t read_done_time = ::baidu::common::timer::get_micros();
+    loader.Stop();
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    uint64_t failed_cnt = loader.GetFailedCnt() + read_failed_cnt;
+    PDLOG(INFO,
+          "read path %s for table tid %u pid %u completed, succ_cnt %lu, failed_cnt %lu. "
+          "total %lu ms, read %lu ms, wait put %lu ms, decode %lu ms and put %lu ms in all %u threads",
+          path.c_str(), tid_, pid_, loader.GetSuccCnt(), failed_cnt, (end_time - start_time) / 1000,
+          read_time / 1000, (end_time - read_done_time) / 1000, loader.GetDecodeTime() / 1000,
+          loader.GetPutTime() / 1000, FLAGS_load_table_thread_num);
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(loader.GetSuccCnt(), std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+    }
+}
+
 void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std::vector<std::string*> recordPtr,
                            std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
     ::openmldb::api::LogEntry entry;
@@ -341,67 +417,17 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     return cur_offset;
 }
 
-int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
-                                   uint64_t term) {
-    if (making_snapshot_.load(std::memory_order_acquire)) {
-        PDLOG(INFO, "snapshot is doing now!");
-        return 0;
-    }
-    if (end_offset > 0 && end_offset <= offset_) {
-        PDLOG(WARNING, "end_offset %lu less than or equal offset_ %lu, do nothing", end_offset, offset_);
-        return -1;
-    }
-    making_snapshot_.store(true, std::memory_order_release);
-    std::string now_time = ::openmldb::base::GetNowTime();
-    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
-    if (FLAGS_snapshot_compression != "off") {
-        snapshot_name.append(".");
-        snapshot_name.append(FLAGS_snapshot_compression);
-    }
-    std::string snapshot_name_tmp = snapshot_name + ".tmp";
-    std::string full_path = snapshot_path_ + snapshot_name;
-    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
-    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
-        making_snapshot_.store(false, std::memory_order_release);
-        return -1;
-    }
-    uint64_t collected_offset = CollectDeletedKey(end_offset);
-    uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
-    ::openmldb::api::Manifest manifest;
-    bool has_error = false;
-    uint64_t write_count = 0;
-    uint64_t expired_key_num = 0;
-    uint64_t deleted_key_num = 0;
-    uint64_t last_term = term;
-    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
-    if (result == 0) {
-        // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
-            has_error = true;
-        }
-        last_term = manifest.term();
-        DEBUGLOG("old manifest term is %lu", last_term);
-    } else if (result < 0) {
-        // parse manifest error
-        has_error = true;
-    }
-
-    // get deleted index
-    std::set<uint32_t> deleted_index;
-    for (const auto& it : table->GetAllIndex()) {
-        if (it->GetStatus() == ::openmldb::storage::IndexStatus::kDeleted) {
-            deleted_index.insert(it->GetId());
-        }
-    }
+int MemTableSnapshot::DumpBinlog(std::shared_ptr<Table> table, WriteHandle* wh, uint64_t end_offset,
+                                 bool stop_on_delete, const std::set<uint32_t>& deleted_index, uint64_t* cur_offset,
+                                 uint64_t* last_term, uint64_t* write_count, uint64_t* expired_key_num,
+                                 uint64_t* deleted_key_num) {
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
     log_reader.SetOffset(offset_);
-    uint64_t cur_offset = offset_;
+    uint64_t offset = offset_;
     std::string buffer;
     std::string tmp_buf;
-    while (!has_error && cur_offset < collected_offset) {
+    int ret = 0;
+    while (offset < end_offset) {
         buffer.clear();
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
@@ -410,45 +436,49 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
             if (!entry.ParseFromString(record.ToString())) {
                 PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
                       ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
-                has_error = true;
+                ret = -1;
                 break;
             }
-            if (entry.log_index() <= cur_offset) {
+            if (entry.log_index() <= offset) {
                 continue;
             }
-            if (cur_offset + 1 != entry.log_index()) {
+            if (offset + 1 != entry.log_index()) {
                 PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u",
-                        cur_offset + 1, entry.log_index(), tid_, pid_);
+                        offset + 1, entry.log_index(), tid_, pid_);
                 continue;
             }
-            cur_offset = entry.log_index();
+            offset = entry.log_index();
             if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                if (stop_on_delete) {
+                    ret = 1;
+                    break;
+                }
                 continue;
             }
             if (entry.has_term()) {
-                last_term = entry.term();
+                *last_term = entry.term();
             }
-            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
-            if (ret == 1) {
-                deleted_key_num++;
+            int remove_ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
+            if (remove_ret == 1) {
+                (*deleted_key_num)++;
                 continue;
-            } else if (ret == 2) {
+            } else if (remove_ret == 2) {
                 record.reset(tmp_buf.data(), tmp_buf.size());
             }
             if (table->IsExpire(entry)) {
-                expired_key_num++;
+                (*expired_key_num)++;
                 continue;
             }
-            ::openmldb::log::Status status = wh->Write(record);
+            status = wh->Write(record);
             if (!status.ok()) {
-                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                PDLOG(WARNING, "fail to write snapshot. tid %u pid %u status[%s]", tid_, pid_,
                       status.ToString().c_str());
-                has_error = true;
+                ret = -1;
                 break;
             }
-            write_count++;
-            if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
-                PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
+            (*write_count)++;
+            if ((*write_count + *expired_key_num + *deleted_key_num) % KEY_NUM_DISPLAY == 0) {
+                PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", *write_count, *expired_key_num);
             }
         } else if (status.IsEof()) {
             continue;
@@ -461,17 +491,102 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 PDLOG(WARNING,
                       "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
                       "end_log_index[%d] cur_offset[%lu]",
-                      tid_, pid_, cur_log_index, end_log_index, cur_offset);
+                      tid_, pid_, cur_log_index, end_log_index, offset);
                 continue;
             }
             DEBUGLOG("has read all record!");
             break;
         } else {
             PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
-            has_error = true;
+            ret = -1;
             break;
         }
     }
+    *cur_offset = offset;
+    return ret;
+}
+
+int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
+                                   uint64_t term) {
+    if (making_snapshot_.load(std::memory_order_acquire)) {
+        PDLOG(INFO, "snapshot is doing now!");
+        return 0;
+    }
+    if (end_offset > 0 && end_offset <= offset_) {
+        PDLOG(WARNING, "end_offset %lu less than or equal offset_ %lu, do nothing", end_offset, offset_);
+        return -1;
+    }
+    making_snapshot_.store(true, std::memory_order_release);
+    if (FLAGS_make_snapshot_max_delta_num > 0) {
+        ::openmldb::api::Manifest manifest;
+        if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) == 0 &&
+            static_cast<uint32_t>(manifest.deltas_size()) < FLAGS_make_snapshot_max_delta_num) {
+            int ret = MakeDeltaSnapshot(table, manifest, end_offset, &out_offset);
+            if (ret <= 0) {
+                making_snapshot_.store(false, std::memory_order_release);
+                return ret;
+            }
+            PDLOG(INFO, "binlog has deleted keys, rewrite the base snapshot. tid %u pid %u", tid_, pid_);
+        }
+    }
+    std::string now_time = ::openmldb::base::GetNowTime();
+    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
+    if (FLAGS_snapshot_compression != "off") {
+        snapshot_name.append(".");
+        snapshot_name.append(FLAGS_snapshot_compression);
+    }
+    std::string snapshot_name_tmp = snapshot_name + ".tmp";
+    std::string full_path = snapshot_path_ + snapshot_name;
+    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
+    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        making_snapshot_.store(false, std::memory_order_release);
+        return -1;
+    }
+    uint64_t collected_offset = CollectDeletedKey(end_offset);
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    ::openmldb::api::Manifest manifest;
+    bool has_error = false;
+    uint64_t write_count = 0;
+    uint64_t expired_key_num = 0;
+    uint64_t deleted_key_num = 0;
+    uint64_t last_term = term;
+    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    if (result == 0) {
+        // filter old snapshot and merge the deltas into it
+        for (const auto& file : GetSnapshotFiles(manifest)) {
+            uint64_t count = 0;
+            uint64_t expired_num = 0;
+            uint64_t deleted_num = 0;
+            if (TTLSnapshot(table, file, wh, count, expired_num, deleted_num) < 0) {
+                has_error = true;
+                break;
+            }
+            write_count += count;
+            expired_key_num += expired_num;
+            deleted_key_num += deleted_num;
+        }
+        last_term = GetManifestTerm(manifest);
+        DEBUGLOG("old manifest term is %lu", last_term);
+    } else if (result < 0) {
+        // parse manifest error
+        has_error = true;
+    }
+
+    // get deleted index
+    std::set<uint32_t> deleted_index;
+    for (const auto& it : table->GetAllIndex()) {
+        if (it->GetStatus() == ::openmldb::storage::IndexStatus::kDeleted) {
+            deleted_index.insert(it->GetId());
+        }
+    }
+    uint64_t cur_offset = offset_;
+    if (!has_error && DumpBinlog(table, wh, collected_offset, false, deleted_index, &cur_offset, &last_term,
+                                 &write_count, &expired_key_num, &deleted_key_num) < 0) {
+        has_error = true;
+    }
     if (wh != NULL) {
         wh->EndLog();
         delete wh;
@@ -484,11 +599,8 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
+                // delete old snapshot and its deltas
+                RemoveSnapshotFiles(manifest, snapshot_name);
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -497,6 +609,7 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                       snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
                       deleted_key_num);
                 offset_ = cur_offset;
+                base_offset_ = cur_offset;
                 out_offset = cur_offset;
             } else {
                 PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
@@ -514,6 +627,103 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     return ret;
 }
 
+int MemTableSnapshot::MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                                        uint64_t end_offset, uint64_t* out_offset) {
+    // the entries of a deleted index in the base snapshot can only be dropped by rewriting it
+    for (const auto& index : table->GetAllIndex()) {
+        if (index->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
+            return 1;
+        }
+    }
+    std::string tmp_name = "delta_" + std::to_string(offset_) + ".sdb.tmp";
+    std::string tmp_file_path = snapshot_path_ + tmp_name;
+    FILE* fd = fopen(tmp_file_path.c_str(), "wb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        return -1;
+    }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, tmp_name, fd);
+    std::set<uint32_t> deleted_index;
+    uint64_t cur_offset = offset_;
+    uint64_t last_term = GetManifestTerm(manifest);
+    uint64_t write_count = 0;
+    uint64_t expired_key_num = 0;
+    uint64_t deleted_key_num = 0;
+    int ret = DumpBinlog(table, wh, end_offset > 0 ? end_offset : UINT64_MAX, true, deleted_index, &cur_offset,
+                         &last_term, &write_count, &expired_key_num, &deleted_key_num);
+    wh->EndLog();
+    delete wh;
+    if (ret != 0 || cur_offset == offset_) {
+        unlink(tmp_file_path.c_str());
+        if (ret == 0) {
+            DEBUGLOG("no new binlog since offset %lu. tid %u pid %u", offset_, tid_, pid_);
+            *out_offset = offset_;
+        }
+        return ret;
+    }
+    std::string delta_name = "delta_" + std::to_string(offset_ + 1) + "_" + std::to_string(cur_offset) + ".sdb";
+    if (FLAGS_snapshot_compression != "off") {
+        delta_name.append(".");
+        delta_name.append(FLAGS_snapshot_compression);
+    }
+    std::string full_path = snapshot_path_ + delta_name;
+    if (rename(tmp_file_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "rename[%s] failed", delta_name.c_str());
+        unlink(tmp_file_path.c_str());
+        return -1;
+    }
+    ::openmldb::api::Manifest new_manifest(manifest);
+    ::openmldb::api::SnapshotDelta* delta = new_manifest.add_deltas();
+    delta->set_offset(cur_offset);
+    delta->set_name(delta_name);
+    delta->set_count(write_count);
+    delta->set_term(last_term);
+    // offset and term stay the ones of the base snapshot, the readers without delta support replay the binlog
+    // from there
+    if (GenManifest(new_manifest) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
+        unlink(full_path.c_str());
+        return -1;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO,
+          "make delta snapshot[%s] success. update offset from %lu to %lu. "
+          "use %lu second. write key %lu expired key %lu. delta num %d",
+          delta_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
+          new_manifest.deltas_size());
+    offset_ = cur_offset;
+    *out_offset = cur_offset;
+    return 0;
+}
+
+void MemTableSnapshot::RemoveSnapshotFiles(const ::openmldb::api::Manifest& manifest, const std::string& keep_name) {
+    for (const auto& file : GetSnapshotFiles(manifest)) {
+        if (file.name() != keep_name) {
+            DEBUGLOG("old snapshot[%s] has deleted", file.name().c_str());
+            unlink((snapshot_path_ + file.name()).c_str());
+        }
+    }
+}
+
+std::vector<::openmldb::api::Manifest> MemTableSnapshot::GetSnapshotFiles(const ::openmldb::api::Manifest& manifest) {
+    std::vector<::openmldb::api::Manifest> files;
+    if (!manifest.has_name()) {
+        return files;
+    }
+    files.emplace_back(manifest);
+    files.back().clear_deltas();
+    for (const auto& delta : manifest.deltas()) {
+        ::openmldb::api::Manifest file;
+        file.set_offset(delta.offset());
+        file.set_name(delta.name());
+        file.set_count(delta.count());
+        file.set_term(delta.term());
+        files.push_back(file);
+    }
+    return files;
+}
+
 int MemTableSnapshot::RemoveDeletedKey(const ::openmldb::api::LogEntry& entry, const std::set<uint32_t>& deleted_index,
                                        std::string* buffer) {
     uint64_t cur_offset = entry.log_index();
@@ -722,8 +932,8 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         if (!(entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete)) {
             std::string buff;
             openmldb::base::Slice data;
-            if (table->GetCompressType() == openmldb::type::kSnappy) {
-                snappy::Uncompress(entry.value().data(), entry.value().size(), &buff);
+            if (table->GetCompressType() != openmldb::type::kNoCompress) {
+                codec::UncompressRow(table->GetCompressType(), entry.value(), &buff);
                 data.reset(buff.data(), buff.size());
             } else {
                 data.reset(entry.value().data(), entry.value().size());
@@ -1025,8 +1235,8 @@ base::Status MemTableSnapshot::ExtractIndexFromBinlog(std::shared_ptr<Table> tab
             if (!(entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete)) {
                 std::string buff;
                 openmldb::base::Slice data;
-                if (table->GetCompressType() == openmldb::type::kSnappy) {
-                    snappy::Uncompress(entry.value().data(), entry.value().size(), &buff);
+                if (table->GetCompressType() != openmldb::type::kNoCompress) {
+                    codec::UncompressRow(table->GetCompressType(), entry.value(), &buff);
                     data.reset(buff.data(), buff.size());
                 } else {
                     data.reset(entry.value().data(), entry.value().size());
@@ -1128,11 +1338,20 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
         DLOG(INFO) << "begin extract index data from snapshot";
-        if (!ExtractIndexFromSnapshot(table, manifest, wh, indexs, partition_num,
-                    &write_count, &expired_key_num, &deleted_key_num).OK()) {
-            has_error = true;
+        for (const auto& file : GetSnapshotFiles(manifest)) {
+            uint64_t count = 0;
+            uint64_t expired_num = 0;
+            uint64_t deleted_num = 0;
+            if (!ExtractIndexFromSnapshot(table, file, wh, indexs, partition_num,
+                        &count, &expired_num, &deleted_num).OK()) {
+                has_error = true;
+                break;
+            }
+            write_count += count;
+            expired_key_num += expired_num;
+            deleted_key_num += deleted_num;
         }
-        last_term = manifest.term();
+        last_term = GetManifestTerm(manifest);
         DLOG(INFO) << "old manifest term is " << last_term;
     } else if (result < 0) {
         // parse manifest error
@@ -1160,11 +1379,8 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
+                // delete old snapshot and its deltas
+                RemoveSnapshotFiles(manifest, snapshot_name);
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -1172,6 +1388,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
                       snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
                       deleted_key_num);
                 offset_ = cur_offset;
+                base_offset_ = cur_offset;
                 *out_offset = cur_offset;
             } else {
                 PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
@@ -1251,11 +1468,20 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
         DLOG(INFO) << "begin extract index data from snapshot";
-        if (ExtractIndexFromSnapshot(table, manifest, wh, column_key, idx, partition_num, max_idx, index_cols,
-                                     write_count, expired_key_num, deleted_key_num) < 0) {
-            has_error = true;
+        for (const auto& file : GetSnapshotFiles(manifest)) {
+            uint64_t count = 0;
+            uint64_t expired_num = 0;
+            uint64_t deleted_num = 0;
+            if (ExtractIndexFromSnapshot(table, file, wh, column_key, idx, partition_num, max_idx, index_cols,
+                                         count, expired_num, deleted_num) < 0) {
+                has_error = true;
+                break;
+            }
+            write_count += count;
+            expired_key_num += expired_num;
+            deleted_key_num += deleted_num;
         }
-        last_term = manifest.term();
+        last_term = GetManifestTerm(manifest);
         DLOG(INFO) << "old manifest term is " << last_term;
     } else if (result < 0) {
         // parse manifest error
@@ -1426,11 +1652,8 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
+                // delete old snapshot and its deltas
+                RemoveSnapshotFiles(manifest, snapshot_name);
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -1439,6 +1662,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
                       snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
                       deleted_key_num);
                 offset_ = cur_offset;
+                base_offset_ = cur_offset;
                 out_offset = cur_offset;
             } else {
                 PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
@@ -1544,65 +1768,67 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
     if (ret == -1) {
         return false;
     }
-    *snapshot_offset = manifest.offset();
-    std::string path = snapshot_path_ + "/" + manifest.name();
-    uint64_t succ_cnt = 0;
-    uint64_t failed_cnt = 0;
-    FILE* fd = fopen(path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
-        return false;
-    }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-    bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    *snapshot_offset = GetManifestOffset(manifest);
     ::openmldb::api::LogEntry entry;
     std::string buffer;
     std::string entry_buff;
     DLOG(INFO) << "begin dump snapshot index data";
-    while (true) {
-        buffer.clear();
-        ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-        if (status.IsWaitRecord() || status.IsEof()) {
-            PDLOG(INFO,
-                  "read path %s for table tid %u pid %u completed, succ_cnt "
-                  "%lu, failed_cnt %lu",
-                  path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
-            break;
-        }
-        if (!status.ok()) {
-            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                  status.ToString().c_str());
-            failed_cnt++;
-            continue;
-        }
-        entry_buff.assign(record.data(), record.size());
-        if (!entry.ParseFromString(entry_buff)) {
-            PDLOG(WARNING, "fail to parse record for tid %u, pid %u", tid_, pid_);
-            failed_cnt++;
-            continue;
-        }
-        uint32_t index_pid = 0;
-        if (!PackNewIndexEntry(table, index_cols, max_idx, idx, partition_num, &entry, &index_pid)) {
-            DLOG(INFO) << "pack new entry fail in snapshot";
-            continue;
-        }
-        std::string entry_str;
-        entry.SerializeToString(&entry_str);
-        ::openmldb::base::Slice new_record(entry_str);
-        status = whs[index_pid]->Write(new_record);
-        if (!status.ok()) {
-            delete seq_file;
-            PDLOG(WARNING,
-                  "fail to dump index entrylog in snapshot to pid[%u]. tid "
-                  "%u pid %u",
-                  index_pid, tid_, pid_);
+    for (const auto& file : GetSnapshotFiles(manifest)) {
+        std::string path = snapshot_path_ + "/" + file.name();
+        uint64_t succ_cnt = 0;
+        uint64_t failed_cnt = 0;
+        FILE* fd = fopen(path.c_str(), "rb");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
             return false;
         }
-        succ_cnt++;
+        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+        bool compressed = IsCompressed(path);
+        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+        while (true) {
+            buffer.clear();
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+            if (status.IsWaitRecord() || status.IsEof()) {
+                PDLOG(INFO,
+                      "read path %s for table tid %u pid %u completed, succ_cnt "
+                      "%lu, failed_cnt %lu",
+                      path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                      status.ToString().c_str());
+                failed_cnt++;
+                continue;
+            }
+            entry_buff.assign(record.data(), record.size());
+            if (!entry.ParseFromString(entry_buff)) {
+                PDLOG(WARNING, "fail to parse record for tid %u, pid %u", tid_, pid_);
+                failed_cnt++;
+                continue;
+            }
+            uint32_t index_pid = 0;
+            if (!PackNewIndexEntry(table, index_cols, max_idx, idx, partition_num, &entry, &index_pid)) {
+                DLOG(INFO) << "pack new entry fail in snapshot";
+                continue;
+            }
+            std::string entry_str;
+            entry.SerializeToString(&entry_str);
+            ::openmldb::base::Slice new_record(entry_str);
+            status = whs[index_pid]->Write(new_record);
+            if (!status.ok()) {
+                delete seq_file;
+                PDLOG(WARNING,
+                      "fail to dump index entrylog in snapshot to pid[%u]. tid "
+                      "%u pid %u",
+                      index_pid, tid_, pid_);
+                return false;
+            }
+            succ_cnt++;
+        }
+        delete seq_file;
     }
-    delete seq_file;
     return true;
 }
 
@@ -1761,8 +1987,8 @@ int MemTableSnapshot::DecodeData(std::shared_ptr<Table> table, const openmldb::a
                                  std::vector<std::string>& row) {
     std::string buff;
     openmldb::base::Slice data;
-    if (table->GetCompressType() == openmldb::type::kSnappy) {
-        snappy::Uncompress(entry.value().data(), entry.value().size(), &buff);
+    if (table->GetCompressType() != openmldb::type::kNoCompress) {
+        codec::UncompressRow(table->GetCompressType(), entry.value(), &buff);
         data.reset(buff.data(), buff.size());
     } else {
         data.reset(entry.value().data(), entry.value().size());
@@ -1790,7 +2016,8 @@ int MemTableSnapshot::DecodeData(std::shared_ptr<Table> table, const openmldb::a
 
 bool MemTableSnapshot::IsCompressed(const std::string& path) {
     if (path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
-        path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
+        path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos ||
+        path.find(openmldb::log::ZSTD_COMPRESS_SUFFIX) != std::string::npos) {
         return true;
     }
     return false;
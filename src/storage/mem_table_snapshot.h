@@ -48,6 +48,8 @@ class MemTableSnapshot : public Snapshot {
 
     bool Init() override;
 
+    uint64_t GetBaseOffset() override { return base_offset_; }
+
     bool Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) override;
 
     void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
@@ -115,13 +117,34 @@ class MemTableSnapshot : public Snapshot {
     int RemoveDeletedKey(const ::openmldb::api::LogEntry& entry, const std::set<uint32_t>& deleted_index,
                          std::string* buffer);
 
+    // the base snapshot and then the deltas on it in the recover order, each with its name and count
+    static std::vector<::openmldb::api::Manifest> GetSnapshotFiles(const ::openmldb::api::Manifest& manifest);
+
  private:
     // load single snapshot to table
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // load single snapshot with ParallelLoader, the records are decoded and put by multiple threads
+    void RecoverSingleSnapshotParallel(const std::string& path, std::shared_ptr<Table> table,
+                                       std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // write the binlog after offset_ and up to end_offset(0 means all) to wh. return 1 if stop_on_delete
+    // is set and a delete entry is met, the records written before are kept in wh
+    int DumpBinlog(std::shared_ptr<Table> table, WriteHandle* wh, uint64_t end_offset, bool stop_on_delete,
+                   const std::set<uint32_t>& deleted_index, uint64_t* cur_offset, uint64_t* last_term,
+                   uint64_t* write_count, uint64_t* expired_key_num, uint64_t* deleted_key_num);
+
+    // append a delta with the binlog since the last snapshot to the manifest. the delta only has put entries,
+    // return 1 if the binlog has deleted keys or index and the base snapshot should be rewritten
+    int MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                          uint64_t end_offset, uint64_t* out_offset);
+
+    // unlink the base and delta files of an old manifest except keep_name
+    void RemoveSnapshotFiles(const ::openmldb::api::Manifest& manifest, const std::string& keep_name);
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
@@ -132,6 +155,8 @@ class MemTableSnapshot : public Snapshot {
     std::string log_path_;
     std::map<std::string, uint64_t> deleted_keys_;
     std::string db_root_path_;
+    // the offset of the base snapshot without the deltas
+    uint64_t base_offset_;
 };
 
 }  // namespace storage
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/parallel_loader.h"
+
+#include <utility>
+
+#include "base/glog_wrapper.h"
+#include "base/hash.h"
+#include "boost/bind.hpp"
+#include "common/timer.h"
+
+namespace openmldb {
+namespace storage {
+
+ParallelLoader::ParallelLoader(std::shared_ptr<Table> table, uint32_t thread_num, uint32_t queue_size,
+                               uint32_t batch_size)
+    : table_(table),
+      mem_table_(std::dynamic_pointer_cast<MemTable>(table)),
+      batch_size_(batch_size == 0 ? 1 : batch_size),
+      decode_pool_(thread_num == 0 ? 1 : thread_num, queue_size),
+      put_pools_(),
+      batches_(),
+      pending_cnt_(0),
+      succ_cnt_(0),
+      failed_cnt_(0),
+      decode_time_(0),
+      put_time_(0),
+      mu_(),
+      cv_(),
+      stopped_(false) {
+    uint32_t partition_num = thread_num == 0 ? 1 : thread_num;
+    for (uint32_t i = 0; i < partition_num; i++) {
+        put_pools_.emplace_back(new ::openmldb::base::TaskPool(1, queue_size));
+    }
+    batches_.resize(partition_num);
+}
+
+ParallelLoader::~ParallelLoader() { Stop(); }
+
+void ParallelLoader::AddRecords(std::vector<std::string*> records) {
+    if (records.empty()) {
+        return;
+    }
+    pending_cnt_.fetch_add(records.size(), std::memory_order_relaxed);
+    decode_pool_.AddTask(boost::bind(&ParallelLoader::Decode, this, std::move(records)));
+}
+
+void ParallelLoader::AddEntry(::openmldb::api::LogEntry* entry) {
+    pending_cnt_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t partition = GetPartition(*entry);
+    auto& batch = batches_[partition];
+    batch.push_back(entry);
+    if (batch.size() >= batch_size_) {
+        put_pools_[partition]->AddTask(boost::bind(&ParallelLoader::PutEntries, this, std::move(batch)));
+        batch.clear();
+    }
+}
+
+void ParallelLoader::Wait() {
+    for (uint32_t i = 0; i < batches_.size(); i++) {
+        if (!batches_[i].empty()) {
+            put_pools_[i]->AddTask(boost::bind(&ParallelLoader::PutEntries, this, std::move(batches_[i])));
+            batches_[i].clear();
+        }
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return pending_cnt_.load(std::memory_order_acquire) == 0; });
+}
+
+void ParallelLoader::Stop() {
+    if (stopped_) {
+        return;
+    }
+    Wait();
+    stopped_ = true;
+    decode_pool_.Stop();
+    for (auto& pool : put_pools_) {
+        pool->Stop();
+    }
+}
+
+void ParallelLoader::Decode(std::vector<std::string*> records) {
+    uint64_t start = ::baidu::common::timer::get_micros();
+    std::vector<std::vector<::openmldb::api::LogEntry*>> batches(put_pools_.size());
+    uint64_t failed_cnt = 0;
+    for (auto record : records) {
+        auto entry = new ::openmldb::api::LogEntry();
+        if (!entry->ParseFromString(*record)) {
+            delete entry;
+            failed_cnt++;
+        } else {
+            batches[GetPartition(*entry)].push_back(entry);
+        }
+        delete record;
+    }
+    decode_time_.fetch_add(::baidu::common::timer::get_micros() - start, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < batches.size(); i++) {
+        if (!batches[i].empty()) {
+            put_pools_[i]->AddTask(boost::bind(&ParallelLoader::PutEntries, this, std::move(batches[i])));
+        }
+    }
+    if (failed_cnt > 0) {
+        failed_cnt_.fetch_add(failed_cnt, std::memory_order_relaxed);
+        Done(failed_cnt);
+    }
+}
+
+void ParallelLoader::PutEntries(std::vector<::openmldb::api::LogEntry*> entries) {
+    uint64_t start = ::baidu::common::timer::get_micros();
+    for (auto entry : entries) {
+        uint64_t cnt = succ_cnt_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (cnt % 100000 == 0) {
+            PDLOG(INFO, "[Recover] put %lu entries. tid %u pid %u", cnt, table_->GetId(), table_->GetPid());
+        }
+        table_->Put(*entry);
+        delete entry;
+    }
+    put_time_.fetch_add(::baidu::common::timer::get_micros() - start, std::memory_order_relaxed);
+    Done(entries.size());
+}
+
+uint32_t ParallelLoader::GetPartition(const ::openmldb::api::LogEntry& entry) const {
+    const std::string& key = entry.dimensions_size() > 0 ? entry.dimensions(0).key() : entry.pk();
+    if (mem_table_) {
+        return mem_table_->GetSegIdx(Slice(key)) % put_pools_.size();
+    }
+    return ::openmldb::base::hash(key.c_str(), key.length(), 0) % put_pools_.size();
+}
+
+void ParallelLoader::Done(uint64_t cnt) {
+    if (pending_cnt_.fetch_sub(cnt, std::memory_order_acq_rel) == cnt) {
+        std::lock_guard<std::mutex> lock(mu_);
+        cv_.notify_all();
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
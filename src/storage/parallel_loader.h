@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "base/taskpool.hpp"
+#include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
+#include "storage/table.h"
+
+namespace openmldb {
+namespace storage {
+
+// load the records of snapshot and binlog with multiple threads. the records are decoded on
+// a pool and the entries are put by partition threads. the partition of an entry is decided
+// by the segment of its first dimension, so a segment of the first index is only written by
+// one thread while loading
+class ParallelLoader {
+ public:
+    ParallelLoader(std::shared_ptr<Table> table, uint32_t thread_num, uint32_t queue_size, uint32_t batch_size);
+    ~ParallelLoader();
+    ParallelLoader(const ParallelLoader&) = delete;
+    ParallelLoader& operator=(const ParallelLoader&) = delete;
+
+    // take the ownership of the serialized entries and decode them on the pool
+    void AddRecords(std::vector<std::string*> records);
+
+    // take the ownership of the decoded entry
+    void AddEntry(::openmldb::api::LogEntry* entry);
+
+    // block until all entries added have been put
+    void Wait();
+
+    void Stop();
+
+    inline uint64_t GetSuccCnt() const { return succ_cnt_.load(std::memory_order_relaxed); }
+
+    inline uint64_t GetFailedCnt() const { return failed_cnt_.load(std::memory_order_relaxed); }
+
+    // the time spent by all threads. unit is microseconds
+    inline uint64_t GetDecodeTime() const { return decode_time_.load(std::memory_order_relaxed); }
+
+    inline uint64_t GetPutTime() const { return put_time_.load(std::memory_order_relaxed); }
+
+ private:
+    void Decode(std::vector<std::string*> records);
+
+    void PutEntries(std::vector<::openmldb::api::LogEntry*> entries);
+
+    uint32_t GetPartition(const ::openmldb::api::LogEntry& entry) const;
+
+    void Done(uint64_t cnt);
+
+ private:
+    std::shared_ptr<Table> table_;
+    // the segments are only known for memory table
+    std::shared_ptr<MemTable> mem_table_;
+    uint32_t batch_size_;
+    ::openmldb::base::TaskPool decode_pool_;
+    std::vector<std::unique_ptr<::openmldb::base::TaskPool>> put_pools_;
+    // the entries added by AddEntry and not dispatched yet
+    std::vector<std::vector<::openmldb::api::LogEntry*>> batches_;
+    std::atomic<uint64_t> pending_cnt_;
+    std::atomic<uint64_t> succ_cnt_;
+    std::atomic<uint64_t> failed_cnt_;
+    std::atomic<uint64_t> decode_time_;
+    std::atomic<uint64_t> put_time_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopped_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
@@ -30,6 +30,15 @@ static const uint32_t KEY_ENTRY_PTR_SIZE = sizeof(KeyEntry*);
 
 static inline uint32_t GetRecordSize(uint32_t value_size) { return value_size + DATA_BLOCK_BYTE_SIZE; }
 
+// the block and its value share one aligned allocation in slab
+static inline uint32_t GetSlabRecordSize(uint32_t value_size) {
+    return SlabAlignSize(value_size + DATA_BLOCK_BYTE_SIZE);
+}
+
+static inline uint32_t GetRecordSize(const DataBlock* block) {
+    return block->slab_shift == 0 ? GetRecordSize(block->size) : GetSlabRecordSize(block->size);
+}
+
 // the input height which is the height of skiplist node
 static inline uint32_t GetRecordPkIdxSize(uint8_t height, uint32_t key_size, uint8_t key_entry_max_height) {
     return height * 8 + ENTRY_NODE_SIZE + KEY_ENTRY_BYTE_SIZE + key_size + key_entry_max_height * 8 + DATA_NODE_SIZE;
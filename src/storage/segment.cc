@@ -16,7 +16,9 @@
 
 #include "storage/segment.h"
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
@@ -27,11 +29,64 @@
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_uint32(mem_table_key_filter_bits_per_key);
+DECLARE_int32(gc_interval);
+DECLARE_bool(gc_ttl_expiry_index);
+DECLARE_uint32(gc_ttl_key_budget);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+static const uint64_t KEY_FILTER_MIN_CAPACITY = 1024;
+static const uint32_t EXPIRY_PENDING_MIN_SIZE = 1024;
+static const uint32_t EXPIRY_PENDING_MAX_SIZE = 1 << 20;
+// the node of std::map with the vector of a bucket
+static const uint32_t EXPIRY_BUCKET_BYTE_SIZE = 64;
+
+// the ts of the oldest row of the node, a cold block is keyed by the ts of its newest row
+static inline uint64_t GetOldestTs(::openmldb::base::Node<uint64_t, DataBlock*>* node) {
+    const DataBlock* block = node->GetValue();
+    return block->cold != 0 ? GetColdBlockHeader(block->data).min_ts : node->GetKey();
+}
+
+// the node of the oldest rows, null if there is none. the tail is the head of the list after it is split empty
+static inline ::openmldb::base::Node<uint64_t, DataBlock*>* GetOldestNode(TimeEntries* entries) {
+    auto* node = entries->GetLast();
+    return node == nullptr || node->GetValue() == nullptr ? nullptr : node;
+}
+
+// return the cold block whose time range covers time but with the max ts greater than time. only the late
+// rows of the block could be between the block and the seek position of time
+static ::openmldb::base::Node<uint64_t, DataBlock*>* FindColdNode(TimeEntries* entries, uint64_t time,
+                                                                  uint64_t cold_ts) {
+    if (time >= cold_ts) {
+        return nullptr;
+    }
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entries->GetLessThan(time);
+    while (node != nullptr && node->GetKey() <= cold_ts) {
+        // a late row may have the same ts as the block, GetLessThan skips the nodes of the same key
+        for (auto* cur = entries->LowerBound(node->GetKey()); cur != nullptr && cur->GetKey() == node->GetKey();
+             cur = cur->GetNext(0)) {
+            if (cur->GetValue()->cold != 0) {
+                if (GetColdBlockHeader(cur->GetValue()->data).min_ts <= time) {
+                    return cur;
+                }
+                return nullptr;
+            }
+        }
+        node = entries->GetLessThan(node->GetKey());
+    }
+    return nullptr;
+}
+
+static KeyFilter* NewKeyFilter(uint64_t capacity) {
+    if (FLAGS_mem_table_key_filter_bits_per_key == 0) {
+        return nullptr;
+    }
+    return new KeyFilter(capacity, FLAGS_mem_table_key_filter_bits_per_key);
+}
+
 Segment::Segment()
     : entries_(nullptr),
       mu_(),
@@ -40,7 +95,11 @@ Segment::Segment()
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      cold_ts_(0),
+      key_filter_(NewKeyFilter(KEY_FILTER_MIN_CAPACITY)),
+      building_key_filter_(nullptr),
+      retired_key_filters_() {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
@@ -55,7 +114,11 @@ Segment::Segment(uint8_t height)
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      cold_ts_(0),
+      key_filter_(NewKeyFilter(KEY_FILTER_MIN_CAPACITY)),
+      building_key_filter_(nullptr),
+      retired_key_filters_() {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
@@ -69,7 +132,11 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      cold_ts_(0),
+      key_filter_(NewKeyFilter(KEY_FILTER_MIN_CAPACITY)),
+      building_key_filter_(nullptr),
+      retired_key_filters_() {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
@@ -81,6 +148,11 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 Segment::~Segment() {
     delete entries_;
     delete entry_free_list_;
+    delete key_filter_.load(std::memory_order_relaxed);
+    for (const auto& kv : retired_key_filters_) {
+        delete kv.second;
+    }
+    GcRetiredNodes(UINT64_MAX);
 }
 
 uint64_t Segment::Release() {
@@ -130,6 +202,16 @@ uint64_t Segment::Release() {
     }
     delete f_it;
     entry_free_list_->Clear();
+    GcRetiredNodes(UINT64_MAX);
+    {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        expiry_armed_ = false;
+        expiry_pending_.reset();
+        expiry_pending_cnt_.store(0, std::memory_order_relaxed);
+        expiry_keys_.clear();
+        expiry_buckets_.clear();
+        expiry_byte_size_ = 0;
+    }
     idx_cnt_.store(0);
     idx_byte_size_.store(0);
     pk_cnt_.store(0);
@@ -196,12 +278,13 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
+    std::shared_lock<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
     PutUnlock(key, time, row);
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
     void* entry = nullptr;
+    ::openmldb::base::Node<Slice, void*>* node = nullptr;
     uint32_t byte_size = 0;
     int ret = entries_->Get(key, entry);
     if (ret < 0 || entry == nullptr) {
@@ -209,13 +292,36 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
         memcpy(pk, key.data(), key.size());
         // need to delete memory when free node
         Slice skey(pk, key.size());
-        entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
-        uint8_t height = entries_->Insert(skey, entry);
-        byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
-        pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        KeyEntry* new_entry = new KeyEntry(key_entry_max_height_);
+        void* value = (void*)new_entry;  // NOLINT
+        AddToKeyFilter(skey);
+        node = entries_->GetOrInsertConcurrently(skey, value);
+        entry = node->GetValue();
+        if (entry != (void*)new_entry) {  // NOLINT
+            // another writer has created the entry
+            delete new_entry;
+            delete[] pk;
+        } else {
+            byte_size += GetRecordPkIdxSize(node->Height(), key.size(), key_entry_max_height_);
+            pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (expiry_armed_) {
+        // gc takes the exclusive lock, so the oldest row can not change under the shared one except by other puts
+        auto* last = GetOldestNode(&((KeyEntry*)entry)->entries);  // NOLINT
+        if (last == nullptr || time < GetOldestTs(last)) {
+            if (node == nullptr) {
+                // the key can not be removed under the shared lock
+                node = entries_->LowerBound(key);
+            }
+            uint64_t pos = expiry_pending_cnt_.fetch_add(1, std::memory_order_relaxed);
+            if (pos < expiry_pending_size_) {
+                expiry_pending_[pos].store(node, std::memory_order_relaxed);
+            }
+        }
     }
     idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
+    uint8_t height = ((KeyEntry*)entry)->entries.InsertConcurrently(time, row);  // NOLINT
     ((KeyEntry*)entry)                                               // NOLINT
         ->count_.fetch_add(1, std::memory_order_relaxed);
     byte_size += GetRecordTsIdxSize(height);
@@ -225,7 +331,7 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
-    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
+    std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);  // TODO(hw): need lock?
     int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
@@ -239,6 +345,7 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
                 entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
             }
             auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
+            AddToKeyFilter(skey);
             uint8_t height = entries_->Insert(skey, entry_arr);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
@@ -254,19 +361,32 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
 }
 
 void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
-    uint32_t ts_size = ts_map.size();
-    if (ts_size == 0) {
+    if (ts_map.empty()) {
+        return;
+    }
+    std::shared_lock<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+    PutUnlock(key, ts_map, row);
+}
+
+void Segment::Put(const std::vector<SegmentPutRow>& rows) {
+    std::shared_lock<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+    for (const auto& row : rows) {
+        PutUnlock(row.key, *row.ts_map, row.row);
+    }
+}
+
+void Segment::PutUnlock(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
+    if (ts_map.empty()) {
         return;
     }
     if (ts_cnt_ == 1) {
         auto pos = ts_map.find(ts_idx_map_.begin()->first);
         if (pos != ts_map.end()) {
-            Put(key, pos->second, row);
+            PutUnlock(key, pos->second, row);
         }
         return;
     }
     void* entry_arr = nullptr;
-    std::lock_guard<std::mutex> lock(mu_);
     for (const auto& kv : ts_map) {
         uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
@@ -283,13 +403,25 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
                 }
-                entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
-                byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-                pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+                void* value = (void*)entry_arr_tmp;  // NOLINT
+                AddToKeyFilter(skey);
+                auto node = entries_->GetOrInsertConcurrently(skey, value);
+                entry_arr = node->GetValue();
+                if (entry_arr != value) {
+                    // another writer has created the entries
+                    for (uint32_t i = 0; i < ts_cnt_; i++) {
+                        delete entry_arr_tmp[i];
+                    }
+                    delete[] entry_arr_tmp;
+                    delete[] pk;
+                } else {
+                    byte_size +=
+                        GetRecordPkMultiIdxSize(node->Height(), key.size(), key_entry_max_height_, ts_cnt_);
+                    pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+                }
             }
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
+        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.InsertConcurrently(  // NOLINT
             kv.second, row);
         ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
             1, std::memory_order_relaxed);
@@ -302,7 +434,7 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
 bool Segment::Delete(const Slice& key) {
     ::openmldb::base::Node<Slice, void*>* entry_node = nullptr;
     {
-        std::lock_guard<std::mutex> lock(mu_);
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
         entry_node = entries_->Remove(key);
         if (entry_node == nullptr) {
             return false;
@@ -323,12 +455,19 @@ void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint6
         idx_byte_size_.fetch_sub(GetRecordTsIdxSize(tmp->Height()));
         node = node->GetNextNoBarrier(0);
         DEBUGLOG("delete key %lu with height %u", tmp->GetKey(), tmp->Height());
-        if (tmp->GetValue()->dim_cnt_down > 1) {
+        if (tmp->GetValue()->cold != 0) {
+            // a cold block is only referenced by this index
+            ColdBlockHeader header = GetColdBlockHeader(tmp->GetValue()->data);
+            gc_idx_cnt += header.row_cnt - 1;
+            gc_record_cnt += header.owned_cnt;
+            gc_record_byte_size += GetRecordSize(tmp->GetValue());
+            FreeDataBlock(tmp->GetValue());
+        } else if (tmp->GetValue()->dim_cnt_down > 1) {
             tmp->GetValue()->dim_cnt_down--;
         } else {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
-            gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
-            delete tmp->GetValue();
+            gc_record_byte_size += GetRecordSize(tmp->GetValue());
+            FreeDataBlock(tmp->GetValue());
             gc_record_cnt++;
         }
         delete tmp;
@@ -388,8 +527,16 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
         std::lock_guard<std::mutex> lock(gc_mu_);
         node = entry_free_list_->Split(version);
     }
+    if (node != nullptr && expiry_armed_) {
+        // the freed nodes may be handed off by Put still
+        DrainExpiryPending();
+    }
     while (node != nullptr) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
+        if (expiry_armed_) {
+            std::lock_guard<std::mutex> lock(expiry_mu_);
+            expiry_keys_.erase(entry_node);
+        }
         FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         delete entry_node;
         ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
@@ -406,11 +553,131 @@ void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t
     }
     uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
     GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcKeyFilter(free_list_version);
+    GcRetiredNodes(free_list_version);
+}
+
+void Segment::AddToKeyFilter(const Slice& key) {
+    KeyFilter* filter = key_filter_.load(std::memory_order_acquire);
+    if (filter != nullptr) {
+        filter->Add(key);
+    }
+    filter = building_key_filter_.load(std::memory_order_acquire);
+    if (filter != nullptr) {
+        filter->Add(key);
+    }
+}
+
+void Segment::RebuildKeyFilter() {
+    KeyFilter* filter = key_filter_.load(std::memory_order_acquire);
+    if (filter == nullptr) {
+        return;
+    }
+    uint64_t pk_cnt = pk_cnt_.load(std::memory_order_relaxed);
+    bool too_full = filter->GetFalsePositiveRate() > 2 * filter->GetDesignedFalsePositiveRate();
+    bool too_sparse = filter->GetCapacity() > KEY_FILTER_MIN_CAPACITY && pk_cnt * 4 < filter->GetCapacity();
+    if (!too_full && !too_sparse) {
+        return;
+    }
+    uint64_t capacity = std::max(pk_cnt * 2, KEY_FILTER_MIN_CAPACITY);
+    KeyFilter* new_filter = new KeyFilter(capacity, filter->GetBitsPerKey());
+    {
+        // the writers after it see the building filter, and the keys put before are in entries_
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+        building_key_filter_.store(new_filter, std::memory_order_release);
+    }
+    std::unique_ptr<KeyEntries::Iterator> it(entries_->NewIterator());
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        new_filter->Add(it->GetKey());
+    }
+    {
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+        key_filter_.store(new_filter, std::memory_order_release);
+        building_key_filter_.store(nullptr, std::memory_order_release);
+    }
+    {
+        // the readers may still hold the old filter
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        retired_key_filters_.emplace_back(gc_version_.load(std::memory_order_relaxed), filter);
+    }
+    DEBUGLOG("rebuild key filter with capacity %lu for %lu pks", capacity, pk_cnt);
+}
+
+void Segment::RetireNodes(::openmldb::base::Node<uint64_t, DataBlock*>* first,
+                          ::openmldb::base::Node<uint64_t, DataBlock*>* last) {
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    retired_nodes_.emplace_back(gc_version_.load(std::memory_order_relaxed), std::make_pair(first, last));
+}
+
+void Segment::GcRetiredNodes(uint64_t version) {
+    std::vector<std::pair<::openmldb::base::Node<uint64_t, DataBlock*>*, ::openmldb::base::Node<uint64_t, DataBlock*>*>>
+        ranges;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        auto it = retired_nodes_.begin();
+        while (it != retired_nodes_.end()) {
+            if (it->first <= version) {
+                ranges.push_back(it->second);
+                it = retired_nodes_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const auto& range : ranges) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = range.first;
+        while (true) {
+            ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
+            node = node->GetNextNoBarrier(0);
+            if (tmp->GetValue()->dim_cnt_down > 1) {
+                tmp->GetValue()->dim_cnt_down--;
+            } else {
+                FreeDataBlock(tmp->GetValue());
+            }
+            delete tmp;
+            if (tmp == range.second) {
+                break;
+            }
+        }
+    }
+}
+
+void Segment::GcKeyFilter(uint64_t version) {
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    auto it = retired_key_filters_.begin();
+    while (it != retired_key_filters_.end()) {
+        if (it->first <= version) {
+            delete it->second;
+            it = retired_key_filters_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool Segment::GetKeyFilterFpr(double* fpr) const {
+    KeyFilter* filter = key_filter_.load(std::memory_order_acquire);
+    if (filter == nullptr || fpr == nullptr) {
+        return false;
+    }
+    *fpr = filter->GetFalsePositiveRate();
+    return true;
 }
 
 void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                         uint64_t& gc_record_byte_size) {
     uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    if (ttl_st.ttl_type != ::openmldb::storage::TTLType::kAbsoluteTime || ttl_st.abs_ttl == 0) {
+        // the ttl may have been updated
+        ClearExpiryIndex();
+    }
+    if (ttl_st.ttl_type != ::openmldb::storage::TTLType::kAbsoluteTime &&
+        cold_ts_.load(std::memory_order_relaxed) > 0) {
+        // the gc by count splits the time list by nodes, but a cold block is one node of many rows. only the
+        // absolute ttl converts rows to cold blocks and UpdateTTL refuses to change the ttl type
+        PDLOG(WARNING, "skip the gc of ttl type %d on a segment with cold blocks", ttl_st.ttl_type);
+        return;
+    }
     switch (ttl_st.ttl_type) {
         case ::openmldb::storage::TTLType::kAbsoluteTime: {
             if (ttl_st.abs_ttl == 0) {
@@ -485,7 +752,7 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = nullptr;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByPos(keep_cnt);
             }
@@ -531,7 +798,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = nullptr;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
                         SplitList(entry, kv.second.abs_ttl, &node);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -540,7 +807,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     }
@@ -552,7 +819,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = nullptr;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
@@ -565,7 +832,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = nullptr;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -597,7 +864,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             bool is_empty = true;
             ::openmldb::base::Node<Slice, void*>* entry_node = nullptr;
             {
-                std::lock_guard<std::mutex> lock(mu_);
+                std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     if (!entry_arr[i]->entries.IsEmpty()) {
                         is_empty = false;
@@ -626,9 +893,62 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
     }
 }
 
+void Segment::GcKey4TTL(const Slice& key, KeyEntry* entry, uint64_t time, uint64_t& gc_idx_cnt,
+                        uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+    if (node == nullptr) {
+        return;
+    } else if (GetOldestTs(node) > time) {
+        DEBUGLOG(
+            "[Gc4TTL] segment gc with key %lu need not ttl, last node "
+            "key %lu",
+            time, node->GetKey());
+        return;
+    }
+    node = nullptr;
+    ::openmldb::base::Node<Slice, void*>* entry_node = nullptr;
+    uint64_t entry_gc_idx_cnt = 0;
+    {
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+        uint64_t cold_ts = cold_ts_.load(std::memory_order_relaxed);
+        if (cold_ts > 0 && entry->refs_.load(std::memory_order_acquire) <= 0) {
+            // a cold block is keyed by its max ts, drop its expired rows before the split
+            auto* cold_node = FindColdNode(&entry->entries, time, cold_ts);
+            if (cold_node != nullptr) {
+                entry_gc_idx_cnt += TrimColdBlock(entry, cold_node, time, gc_record_cnt, gc_record_byte_size);
+            }
+        }
+        SplitList(entry, time, &node);
+        if (entry->entries.IsEmpty()) {
+            entry_node = entries_->Remove(key);
+        }
+    }
+    if (entry_node != nullptr) {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+    }
+    FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+    gc_idx_cnt += entry_gc_idx_cnt;
+}
+
 // fast gc with no global pause
 void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                      uint64_t& gc_record_byte_size) {
+    bool use_index = ts_cnt_ == 1 && FLAGS_gc_ttl_expiry_index;
+    if (use_index && expiry_armed_) {
+        DrainExpiryPending();
+        if (!expiry_lost_) {
+            Gc4TTLByIndex(time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            return;
+        }
+        PDLOG(INFO, "the expiry index lost keys with %u pending slots, rebuild it", expiry_pending_size_);
+    }
+    ClearExpiryIndex();
+    if (use_index) {
+        // arm before the scan, the puts racing with it hand off their keys themselves
+        ArmExpiryIndex();
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
@@ -637,33 +957,19 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == nullptr) {
-            continue;
-        } else if (node->GetKey() > time) {
-            DEBUGLOG(
-                "[Gc4TTL] segment gc with key %lu need not ttl, last node "
-                "key %lu",
-                time, node->GetKey());
-            continue;
-        }
-        node = nullptr;
-        ::openmldb::base::Node<Slice, void*>* entry_node = nullptr;
-        {
-            std::lock_guard<std::mutex> lock(mu_);
-            SplitList(entry, time, &node);
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+        GcKey4TTL(key, entry, time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        if (use_index && !entry->entries.IsEmpty()) {
+            auto* node = entries_->LowerBound(key);
+            // skip the key deleted since
+            if (node != nullptr && node->GetValue() == entry) {
+                std::lock_guard<std::mutex> lock(expiry_mu_);
+                FileExpiryKey(node);
             }
         }
-        if (entry_node != nullptr) {
-            std::lock_guard<std::mutex> lock(gc_mu_);
-            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
-        }
-        uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
-        gc_idx_cnt += entry_gc_idx_cnt;
+    }
+    if (use_index) {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        UpdateExpiryByteSize();
     }
     DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
@@ -671,6 +977,159 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
     delete it;
 }
 
+void Segment::Gc4TTLByIndex(uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                            uint64_t& gc_record_byte_size) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    uint64_t budget = FLAGS_gc_ttl_key_budget;
+    std::vector<::openmldb::base::Node<Slice, void*>*> nodes;
+    {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        // the bucket holding time may have rows not newer than it too
+        auto end = expiry_buckets_.upper_bound(time / expiry_bucket_ms_);
+        auto it = expiry_buckets_.begin();
+        while (it != end && (budget == 0 || nodes.size() < budget)) {
+            auto& bucket = it->second;
+            while (!bucket.empty() && (budget == 0 || nodes.size() < budget)) {
+                auto* node = bucket.back();
+                bucket.pop_back();
+                auto key_it = expiry_keys_.find(node);
+                if (key_it != expiry_keys_.end() && key_it->second == it->first) {
+                    nodes.push_back(node);
+                    expiry_keys_.erase(key_it);
+                }
+            }
+            if (!bucket.empty()) {
+                break;
+            }
+            it = expiry_buckets_.erase(it);
+        }
+    }
+    for (auto*& node : nodes) {
+        const Slice& key = node->GetKey();
+        // a deleted node is not freed before it is dropped from the index, but the key may be put again since
+        if (entries_->LowerBound(key) != node) {
+            node = nullptr;
+            continue;
+        }
+        KeyEntry* entry = (KeyEntry*)node->GetValue();  // NOLINT
+        GcKey4TTL(key, entry, time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        if (entry->entries.IsEmpty()) {
+            node = nullptr;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(expiry_mu_);
+        for (auto* node : nodes) {
+            if (node != nullptr) {
+                FileExpiryKey(node);
+            }
+        }
+        UpdateExpiryByteSize();
+    }
+    DEBUGLOG("[Gc4TTLByIndex] segment gc with key %lu, visit %lu keys, consumed %lu, count %lu", time, nodes.size(),
+             (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
+    idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+}
+
+void Segment::ArmExpiryIndex() {
+    uint32_t size = EXPIRY_PENDING_MIN_SIZE;
+    if (expiry_lost_) {
+        size = std::min(expiry_pending_size_ * 2, EXPIRY_PENDING_MAX_SIZE);
+        expiry_lost_ = false;
+    } else if (expiry_pending_size_ > 0) {
+        size = expiry_pending_size_;
+    }
+    std::unique_ptr<std::atomic<::openmldb::base::Node<Slice, void*>*>[]> pending(
+        new std::atomic<::openmldb::base::Node<Slice, void*>*>[size]);
+    std::lock_guard<std::mutex> lock(expiry_mu_);
+    expiry_bucket_ms_ = FLAGS_gc_interval > 0 ? FLAGS_gc_interval * 60 * 1000ULL : 60 * 1000ULL;
+    {
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> put_lock(mu_);
+        expiry_pending_ = std::move(pending);
+        expiry_pending_size_ = size;
+        expiry_pending_cnt_.store(0, std::memory_order_relaxed);
+        expiry_armed_ = true;
+    }
+    UpdateExpiryByteSize();
+}
+
+void Segment::ClearExpiryIndex() {
+    if (!expiry_armed_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(expiry_mu_);
+    {
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> put_lock(mu_);
+        expiry_armed_ = false;
+    }
+    expiry_pending_.reset();
+    expiry_pending_cnt_.store(0, std::memory_order_relaxed);
+    // release the memory of the map as well
+    decltype(expiry_keys_)().swap(expiry_keys_);
+    expiry_buckets_.clear();
+    UpdateExpiryByteSize();
+}
+
+void Segment::DrainExpiryPending() {
+    std::vector<::openmldb::base::Node<Slice, void*>*> nodes;
+    nodes.reserve(expiry_pending_size_);
+    uint64_t cnt = 0;
+    {
+        std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+        cnt = expiry_pending_cnt_.load(std::memory_order_relaxed);
+        uint64_t size = std::min<uint64_t>(cnt, expiry_pending_size_);
+        for (uint64_t i = 0; i < size; i++) {
+            nodes.push_back(expiry_pending_[i].load(std::memory_order_relaxed));
+        }
+        expiry_pending_cnt_.store(0, std::memory_order_relaxed);
+    }
+    if (cnt > expiry_pending_size_) {
+        expiry_lost_ = true;
+    }
+    std::lock_guard<std::mutex> lock(expiry_mu_);
+    for (auto* node : nodes) {
+        FileExpiryKey(node);
+    }
+    UpdateExpiryByteSize();
+}
+
+void Segment::FileExpiryKey(::openmldb::base::Node<Slice, void*>* node) {
+    auto* last = GetOldestNode(&((KeyEntry*)node->GetValue())->entries);  // NOLINT
+    if (last == nullptr) {
+        return;
+    }
+    uint64_t bucket = GetOldestTs(last) / expiry_bucket_ms_;
+    auto it = expiry_keys_.find(node);
+    if (it == expiry_keys_.end()) {
+        expiry_keys_.emplace(node, bucket);
+    } else if (it->second > bucket) {
+        it->second = bucket;
+    } else {
+        // the gc of the older bucket files the key again
+        return;
+    }
+    expiry_buckets_[bucket].push_back(node);
+}
+
+void Segment::UpdateExpiryByteSize() {
+    uint64_t byte_size = 0;
+    if (expiry_pending_) {
+        byte_size += expiry_pending_size_ * sizeof(std::atomic<::openmldb::base::Node<Slice, void*>*>);
+    }
+    // a slot of flat_hash_map has one control byte
+    byte_size += expiry_keys_.capacity() * (sizeof(decltype(expiry_keys_)::value_type) + 1);
+    for (const auto& kv : expiry_buckets_) {
+        byte_size += EXPIRY_BUCKET_BYTE_SIZE + kv.second.capacity() * sizeof(::openmldb::base::Node<Slice, void*>*);
+    }
+    if (byte_size > expiry_byte_size_) {
+        idx_byte_size_.fetch_add(byte_size - expiry_byte_size_, std::memory_order_relaxed);
+    } else {
+        idx_byte_size_.fetch_sub(expiry_byte_size_ - byte_size, std::memory_order_relaxed);
+    }
+    expiry_byte_size_ = byte_size;
+}
+
 void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                             uint64_t& gc_record_byte_size) {
     if (time == 0 || keep_cnt == 0) {
@@ -696,7 +1155,7 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         }
         node = nullptr;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
             }
@@ -741,7 +1200,7 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         node = nullptr;
         ::openmldb::base::Node<Slice, void*>* entry_node = nullptr;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             }
@@ -766,12 +1225,137 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     delete it;
 }
 
+uint32_t Segment::TrimColdBlock(KeyEntry* entry, ::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t time,
+                                uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    DataBlock* block = node->GetValue();
+    ColdBlock cold;
+    if (!cold.Decode(block)) {
+        PDLOG(WARNING, "fail to decode cold block with size %u", block->size);
+        return 0;
+    }
+    uint32_t pos = cold.Seek(time);
+    if (pos == 0 || pos >= cold.GetRowCnt()) {
+        return 0;
+    }
+    std::vector<std::pair<uint64_t, Slice>> rows;
+    rows.reserve(pos);
+    for (uint32_t i = 0; i < pos; i++) {
+        rows.emplace_back(cold.GetTs(i), cold.GetRow(i));
+    }
+    uint32_t dropped = cold.GetRowCnt() - pos;
+    // the owned rows are not known one by one, the dropped rows are counted as owned first
+    uint32_t owned_cnt = GetColdBlockHeader(block->data).owned_cnt;
+    uint32_t owned_dropped = std::min(owned_cnt, dropped);
+    DataBlock* trimmed = NewColdBlock(rows, owned_cnt - owned_dropped);
+    uint8_t height = entry->entries.Replace(node, node, node->GetKey(), trimmed);
+    idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+    idx_byte_size_.fetch_sub(GetRecordTsIdxSize(node->Height()), std::memory_order_relaxed);
+    uint64_t old_size = GetRecordSize(block);
+    uint64_t new_size = GetRecordSize(trimmed);
+    gc_record_byte_size += old_size > new_size ? old_size - new_size : 0;
+    gc_record_cnt += owned_dropped;
+    RetireNodes(node, node);
+    return dropped;
+}
+
+void Segment::ConvertToCold(uint64_t time, uint32_t block_row_cnt, uint64_t& cold_row_cnt,
+                            uint64_t& freed_byte_size, uint64_t& cold_byte_size) {
+    if (ts_cnt_ > 1 || time == 0 || block_row_cnt < 2) {
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = cold_row_cnt;
+    std::vector<std::pair<uint64_t, Slice>> rows;
+    std::vector<std::pair<::openmldb::base::Node<uint64_t, DataBlock*>*, ::openmldb::base::Node<uint64_t, DataBlock*>*>>
+        replaced;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        it->Next();
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+        if (node == nullptr || node->GetKey() > time) {
+            continue;
+        }
+        replaced.clear();
+        {
+            std::lock_guard<::openmldb::base::WriterPreferredSharedMutex> lock(mu_);
+            // skip entry that ocupied by reader
+            if (entry->refs_.load(std::memory_order_acquire) > 0) {
+                continue;
+            }
+            // the hot rows not older than the min ts of the previous cold block are put after the block
+            // was built, leave them to be merged by TimeEntriesIterator
+            uint64_t late_ts = UINT64_MAX;
+            node = FindColdNode(&entry->entries, time, cold_ts_.load(std::memory_order_relaxed));
+            if (node != nullptr) {
+                late_ts = GetColdBlockHeader(node->GetValue()->data).min_ts;
+            }
+            node = entry->entries.LowerBound(time);
+            while (node != nullptr) {
+                if (node->GetValue()->cold != 0) {
+                    late_ts = GetColdBlockHeader(node->GetValue()->data).min_ts;
+                    node = node->GetNext(0);
+                    continue;
+                } else if (node->GetKey() >= late_ts) {
+                    node = node->GetNext(0);
+                    continue;
+                }
+                ::openmldb::base::Node<uint64_t, DataBlock*>* first = node;
+                ::openmldb::base::Node<uint64_t, DataBlock*>* last = node;
+                uint32_t owned_cnt = 0;
+                rows.clear();
+                while (node != nullptr && node->GetValue()->cold == 0 && rows.size() < block_row_cnt) {
+                    DataBlock* block = node->GetValue();
+                    rows.emplace_back(node->GetKey(), Slice(block->data, block->size));
+                    if (block->dim_cnt_down <= 1) {
+                        owned_cnt++;
+                    }
+                    last = node;
+                    node = node->GetNext(0);
+                }
+                if (rows.size() < 2) {
+                    continue;
+                }
+                DataBlock* cold_block = NewColdBlock(rows, owned_cnt);
+                if (first->GetKey() > cold_ts_.load(std::memory_order_relaxed)) {
+                    cold_ts_.store(first->GetKey(), std::memory_order_release);
+                }
+                uint8_t height = entry->entries.Replace(first, last, first->GetKey(), cold_block);
+                idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+                cold_byte_size += GetRecordSize(cold_block);
+                cold_row_cnt += rows.size();
+                late_ts = rows.back().first;
+                replaced.emplace_back(first, last);
+            }
+        }
+        for (const auto& range : replaced) {
+            node = range.first;
+            while (true) {
+                idx_byte_size_.fetch_sub(GetRecordTsIdxSize(node->Height()), std::memory_order_relaxed);
+                if (node->GetValue()->dim_cnt_down <= 1) {
+                    freed_byte_size += GetRecordSize(node->GetValue());
+                }
+                if (node == range.second) {
+                    break;
+                }
+                node = node->GetNextNoBarrier(0);
+            }
+            // a reader may have taken the entry after the check of refs
+            RetireNodes(range.first, range.second);
+        }
+    }
+    delete it;
+    DEBUGLOG("[ConvertToCold] segment convert with key %lu consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, cold_row_cnt - old);
+}
+
 int Segment::GetCount(const Slice& key, uint64_t& count) {
     if (ts_cnt_ > 1) {
         return -1;
     }
     void* entry = nullptr;
-    if (entries_->Get(key, entry) < 0 || entry == nullptr) {
+    if (!MayContain(key) || entries_->Get(key, entry) < 0 || entry == nullptr) {
         return -1;
     }
     count = ((KeyEntry*)entry)->count_.load(std::memory_order_relaxed);  // NOLINT
@@ -787,7 +1371,7 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
         return GetCount(key, count);
     }
     void* entry_arr = nullptr;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
+    if (!MayContain(key) || entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
         return -1;
     }
     count = ((KeyEntry**)entry_arr)[pos->second]->count_.load(  // NOLINT
@@ -801,11 +1385,11 @@ MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
         return new MemTableIterator(nullptr);
     }
     void* entry = nullptr;
-    if (entries_->Get(key, entry) < 0 || entry == nullptr) {
+    if (!MayContain(key) || entries_->Get(key, entry) < 0 || entry == nullptr) {
         return new MemTableIterator(nullptr);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    ticket.Push((KeyEntry*)entry);  // NOLINT
+    return new MemTableIterator(new TimeEntriesIterator(&((KeyEntry*)entry)->entries, GetColdTsHint()));  // NOLINT
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
@@ -817,14 +1401,155 @@ MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& t
         return NewIterator(key, ticket);
     }
     void* entry_arr = nullptr;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
+    if (!MayContain(key) || entries_->Get(key, entry_arr) < 0 || entry_arr == nullptr) {
         return new MemTableIterator(nullptr);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    KeyEntry* entry = ((KeyEntry**)entry_arr)[pos->second];  // NOLINT
+    ticket.Push(entry);
+    return new MemTableIterator(new TimeEntriesIterator(&entry->entries, GetColdTsHint()));
+}
+
+TimeEntriesIterator::TimeEntriesIterator(TimeEntries* entries, const std::atomic<uint64_t>* cold_ts)
+    : entries_(entries),
+      it_(entries->NewIterator()),
+      cold_ts_(cold_ts),
+      cold_block_(nullptr),
+      cold_header_(),
+      cold_(nullptr),
+      cold_failed_(false),
+      cold_pos_(0),
+      cur_cold_(false),
+      decoded_() {}
+
+TimeEntriesIterator::~TimeEntriesIterator() { delete it_; }
+
+void TimeEntriesIterator::EnterCold(const DataBlock* block) {
+    cold_block_ = block;
+    cold_header_ = GetColdBlockHeader(block->data);
+    cold_ = nullptr;
+    cold_failed_ = false;
+    cold_pos_ = 0;
+}
+
+const ColdBlock* TimeEntriesIterator::DecodeCold() const {
+    if (cold_ != nullptr || cold_failed_ || cold_block_ == nullptr) {
+        return cold_;
+    }
+    if (!decoded_.empty() && decoded_.back().first == cold_block_) {
+        cold_ = decoded_.back().second.get();
+        return cold_;
+    }
+    std::unique_ptr<ColdBlock> cold(new ColdBlock());
+    if (!cold->Decode(cold_block_)) {
+        PDLOG(WARNING, "fail to decode cold block with size %u", cold_block_->size);
+        cold_failed_ = true;
+        return nullptr;
+    }
+    decoded_.emplace_back(cold_block_, std::move(cold));
+    cold_ = decoded_.back().second.get();
+    return cold_;
+}
+
+::hybridse::base::RefCountedSlice TimeEntriesIterator::GetSharedColdValue() const {
+    const ColdBlock* cold = DecodeCold();
+    if (!cur_cold_ || cold == nullptr) {
+        return ::hybridse::base::RefCountedSlice();
+    }
+    return cold->GetSharedRow(cold_pos_);
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+void TimeEntriesIterator::MoveDecoded(std::vector<std::unique_ptr<ColdBlock>>* blocks) {
+    for (auto& kv : decoded_) {
+        blocks->push_back(std::move(kv.second));
+    }
+    decoded_.clear();
+    cold_block_ = nullptr;
+    cold_ = nullptr;
+    cur_cold_ = false;
+}
+
+void TimeEntriesIterator::Settle() {
+    while (true) {
+        if (cold_block_ != nullptr) {
+            bool cold_valid = cold_pos_ < GetColdRowCnt();
+            bool late_valid = it_->Valid() && it_->GetKey() >= cold_header_.min_ts && !IsColdNode();
+            if (cold_valid || late_valid) {
+                cur_cold_ = cold_valid && (!late_valid || GetColdTs(cold_pos_) >= it_->GetKey());
+                return;
+            }
+            cold_block_ = nullptr;
+            cold_ = nullptr;
+        }
+        cur_cold_ = false;
+        if (!IsColdNode()) {
+            return;
+        }
+        EnterCold(it_->GetValue());
+        it_->Next();
+    }
+}
+
+void TimeEntriesIterator::Next() {
+    if (cur_cold_) {
+        cold_pos_++;
+    } else {
+        it_->Next();
+    }
+    Settle();
+}
+
+void TimeEntriesIterator::Seek(uint64_t time) {
+    cold_block_ = nullptr;
+    cold_ = nullptr;
+    cur_cold_ = false;
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node =
+        FindColdNode(entries_, time, cold_ts_->load(std::memory_order_acquire));
+    if (node != nullptr) {
+        EnterCold(node->GetValue());
+        // no need to decode if the seek stops at the first row
+        if (time < cold_header_.max_ts) {
+            const ColdBlock* cold = DecodeCold();
+            cold_pos_ = cold == nullptr ? 0 : cold->Seek(time);
+        }
+    }
+    it_->Seek(time);
+    Settle();
+}
+
+void TimeEntriesIterator::SeekToFirst() {
+    cold_block_ = nullptr;
+    cold_ = nullptr;
+    cur_cold_ = false;
+    it_->SeekToFirst();
+    Settle();
+}
+
+void TimeEntriesIterator::SeekToLast() {
+    cold_block_ = nullptr;
+    cold_ = nullptr;
+    cur_cold_ = false;
+    it_->SeekToLast();
+    uint64_t cold_ts = cold_ts_->load(std::memory_order_acquire);
+    if (cold_ts == 0 || !it_->Valid() || it_->GetKey() > cold_ts) {
+        return;
+    }
+    // the last row may be in a cold block, seek to the min ts and step to the end
+    uint64_t time = it_->GetKey();
+    if (it_->GetValue()->cold != 0) {
+        time = GetColdBlockHeader(it_->GetValue()->data).min_ts;
+    }
+    Seek(time);
+    uint32_t cnt = 0;
+    for (; Valid(); Next()) {
+        cnt++;
+    }
+    Seek(time);
+    for (uint32_t i = 1; i < cnt; i++) {
+        Next();
+    }
+}
+
+MemTableIterator::MemTableIterator(TimeEntriesIterator* it) : it_(it) {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != nullptr) {
@@ -853,9 +1578,7 @@ void MemTableIterator::Next() {
     it_->Next();
 }
 
-::openmldb::base::Slice MemTableIterator::GetValue() const {
-    return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
-}
+::openmldb::base::Slice MemTableIterator::GetValue() const { return it_->GetValue(); }
 
 uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
 
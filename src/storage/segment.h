@@ -21,13 +21,22 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <new>
+#include <shared_mutex>  // NOLINT
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "base/shared_mutex.h"
 #include "base/skiplist.h"
 #include "base/slice.h"
 #include "proto/tablet.pb.h"
+#include "storage/cold_block.h"
 #include "storage/iterator.h"
+#include "storage/key_filter.h"
 #include "storage/schema.h"
+#include "storage/slab_allocator.h"
 #include "storage/ticket.h"
 
 namespace openmldb {
@@ -43,16 +52,21 @@ class Ticket;
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // log2 of the slab size if the block is allocated by SlabAllocator, 0 if it's on heap
+    uint8_t slab_shift;
+    // 1 if data is a cold block packing many rows, see cold_block.h
+    uint8_t cold;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(nullptr) {
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), slab_shift(0), cold(0), size(len), data(nullptr) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(nullptr) {
+        : dim_cnt_down(dim_cnt), slab_shift(0), cold(0), size(len), data(nullptr) {
         if (skip_copy) {
             data = input;
         } else {
@@ -62,11 +76,45 @@ struct DataBlock {
     }
 
     ~DataBlock() {
-        delete[] data;
+        if (slab_shift == 0) {
+            delete[] data;
+        }
         data = nullptr;
     }
+
+ private:
+    // the payload follows the block in the same slab
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len, uint8_t shift)
+        : dim_cnt_down(dim_cnt), slab_shift(shift), cold(0), size(len), data(reinterpret_cast<char*>(this + 1)) {
+        memcpy(data, input, len);
+    }
+
+    friend DataBlock* NewDataBlock(SlabAllocator* allocator, uint32_t shard, uint8_t dim_cnt, const char* input,
+                                   uint32_t len);
 };
 
+// allocate the block and its payload from allocator, fallback to heap if allocator is null or len is too large
+inline DataBlock* NewDataBlock(SlabAllocator* allocator, uint32_t shard, uint8_t dim_cnt, const char* input,
+                               uint32_t len) {
+    if (allocator != nullptr) {
+        char* mem = allocator->Allocate(shard, sizeof(DataBlock) + len);
+        if (mem != nullptr) {
+            return new (mem) DataBlock(dim_cnt, input, len, allocator->GetSlabShift());
+        }
+    }
+    return new DataBlock(dim_cnt, input, len);
+}
+
+inline void FreeDataBlock(DataBlock* block) {
+    if (block->slab_shift == 0) {
+        delete block;
+        return;
+    }
+    uint8_t slab_shift = block->slab_shift;
+    block->~DataBlock();
+    SlabAllocator::Free(block, slab_shift);
+}
+
 // the desc time comparator
 struct TimeComparator {
     int operator() (uint64_t a, uint64_t b) const {
@@ -82,9 +130,98 @@ struct TimeComparator {
 static const TimeComparator tcmp;
 typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEntries;
 
+// the row count of a node in TimeEntries
+inline uint32_t GetRowCnt(const DataBlock* block) {
+    return block->cold == 0 ? 1 : GetColdBlockHeader(block->data).row_cnt;
+}
+
+// iterate the rows of TimeEntries. the rows of a cold block are merged with the rows put into the time
+// range of the block after it was built, which are linked right after the block. A cold block is decoded
+// only when a value or a row other than the first one is read, the ts of the first row is in the header,
+// so a window that ends at the first row of the block doesn't decompress it
+class TimeEntriesIterator {
+ public:
+    // cold_ts is the max ts of the cold blocks in the segment, 0 if there is no cold block. it is only a hint
+    // to bound the seek, loaded again by each seek since a conversion may raise it meanwhile. whether a node is
+    // a cold block is decided by the node itself
+    TimeEntriesIterator(TimeEntries* entries, const std::atomic<uint64_t>* cold_ts);
+    ~TimeEntriesIterator();
+    TimeEntriesIterator(const TimeEntriesIterator&) = delete;
+    TimeEntriesIterator& operator=(const TimeEntriesIterator&) = delete;
+
+    inline bool Valid() const { return cur_cold_ || it_->Valid(); }
+
+    void Next();
+
+    inline const uint64_t& GetKey() const { return cur_cold_ ? GetColdTs(cold_pos_) : it_->GetKey(); }
+
+    // the value of a cold row is valid until the iterator is deleted
+    inline Slice GetValue() const {
+        if (cur_cold_) {
+            const ColdBlock* cold = DecodeCold();
+            return cold == nullptr ? Slice() : cold->GetRow(cold_pos_);
+        }
+        DataBlock* block = it_->GetValue();
+        return Slice(block->data, block->size);
+    }
+
+    inline bool IsColdValue() const { return cur_cold_; }
+
+    // the value of a cold row which shares the decoded block instead of copying the row, it is
+    // valid after the iterator is deleted
+    ::hybridse::base::RefCountedSlice GetSharedColdValue() const;
+
+    // move out the decoded blocks, so the values returned are still valid after the iterator is deleted
+    void MoveDecoded(std::vector<std::unique_ptr<ColdBlock>>* blocks);
+
+    void Seek(uint64_t time);
+
+    void SeekToFirst();
+
+    void SeekToLast();
+
+ private:
+    inline bool IsColdNode() const { return it_->Valid() && it_->GetValue()->cold != 0; }
+
+    // start to iterate the rows of a cold block without decoding it
+    void EnterCold(const DataBlock* block);
+
+    // decode the current cold block if not yet, nullptr if fail
+    const ColdBlock* DecodeCold() const;
+
+    inline uint32_t GetColdRowCnt() const { return cold_failed_ ? 0 : cold_header_.row_cnt; }
+
+    // the ts of the first row is the max ts in the header
+    inline const uint64_t& GetColdTs(uint32_t pos) const {
+        if (pos == 0 && cold_ == nullptr) {
+            return cold_header_.max_ts;
+        }
+        const ColdBlock* cold = DecodeCold();
+        return cold == nullptr ? cold_header_.min_ts : cold->GetTs(pos);
+    }
+
+    // move to the next row if it_ is on a cold node or the current cold block has been consumed
+    void Settle();
+
+ private:
+    TimeEntries* entries_;
+    TimeEntries::Iterator* it_;
+    const std::atomic<uint64_t>* cold_ts_;
+    // the cold block iterated, nullptr if not in a cold block
+    const DataBlock* cold_block_;
+    ColdBlockHeader cold_header_;
+    // the decoded cold_block_, nullptr until a row of it is read
+    mutable const ColdBlock* cold_;
+    mutable bool cold_failed_;
+    uint32_t cold_pos_;
+    bool cur_cold_;
+    // the decoded blocks are kept as the values returned may be still in use
+    mutable std::vector<std::pair<const DataBlock*, std::unique_ptr<ColdBlock>>> decoded_;
+};
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    explicit MemTableIterator(TimeEntriesIterator* it);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -95,7 +232,7 @@ class MemTableIterator : public TableIterator {
     void SeekToLast() override;
 
  private:
-    TimeEntries::Iterator* it_;
+    TimeEntriesIterator* it_;
 };
 
 class KeyEntry {
@@ -110,13 +247,13 @@ class KeyEntry {
         TimeEntries::Iterator* it = entries.NewIterator();
         it->SeekToFirst();
         while (it->Valid()) {
-            cnt += 1;
             DataBlock* block = it->GetValue();
+            cnt += GetRowCnt(block);
             // Avoid double free
             if (block->dim_cnt_down > 1) {
                 block->dim_cnt_down--;
             } else {
-                delete block;
+                FreeDataBlock(block);
             }
             it->Next();
         }
@@ -145,6 +282,13 @@ struct SliceComparator {
 typedef ::openmldb::base::Skiplist<::openmldb::base::Slice, void*, SliceComparator> KeyEntries;
 typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<Slice, void*>*, TimeComparator> KeyEntryNodeList;
 
+// one row of Segment batch put
+struct SegmentPutRow {
+    Slice key;
+    const std::map<int32_t, uint64_t>* ts_map;
+    DataBlock* row;
+};
+
 class Segment {
  public:
     Segment();
@@ -157,12 +301,16 @@ class Segment {
 
     void Put(const Slice& key, uint64_t time, DataBlock* row);
 
+    // the caller should hold mu_, either shared or exclusive
     void PutUnlock(const Slice& key, uint64_t time, DataBlock* row);
 
     void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row);
 
     void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
+    // put all the rows with the shared lock taken once
+    void Put(const std::vector<SegmentPutRow>& rows);
+
     bool Delete(const Slice& key);
 
     uint64_t Release();
@@ -240,7 +388,31 @@ class Segment {
 
     void ReleaseAndCount(const std::vector<size_t>& id_vec);
 
+    // pack the rows not newer than time into cold blocks of at most block_row_cnt rows. only the segment
+    // with one ts column is supported
+    void ConvertToCold(uint64_t time, uint32_t block_row_cnt, uint64_t& cold_row_cnt,  // NOLINT
+                       uint64_t& freed_byte_size, uint64_t& cold_byte_size);          // NOLINT
+
+    // the max ts of the cold blocks, 0 if there is no cold block
+    inline uint64_t GetColdTs() const { return cold_ts_.load(std::memory_order_acquire); }
+    inline const std::atomic<uint64_t>* GetColdTsHint() const { return &cold_ts_; }
+
+    // false means the key is absent for sure. always true if the key filter is disabled
+    inline bool MayContain(const Slice& key) const {
+        KeyFilter* filter = key_filter_.load(std::memory_order_acquire);
+        return filter == nullptr || filter->MayContain(key);
+    }
+
+    // rebuild the key filter when it is too full or too sparse for the current pks. the writers are
+    // blocked only when the new filter is published, the keys are added to it without the lock
+    void RebuildKeyFilter();
+
+    // return false if the key filter is disabled
+    bool GetKeyFilterFpr(double* fpr) const;
+
  private:
+    void PutUnlock(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
+
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
                   uint64_t& gc_record_byte_size);  // NOLINT
@@ -253,10 +425,43 @@ class Segment {
                    uint64_t& gc_record_cnt,         // NOLINT
                    uint64_t& gc_record_byte_size);  // NOLINT
 
+    void AddToKeyFilter(const Slice& key);
+
+    void GcKeyFilter(uint64_t version);
+
+    // the nodes from first to last are unlinked from a time list, free them after the readers are done
+    void RetireNodes(::openmldb::base::Node<uint64_t, DataBlock*>* first,
+                     ::openmldb::base::Node<uint64_t, DataBlock*>* last);
+    void GcRetiredNodes(uint64_t version);
+
+    // gc the rows of the key not newer than time, the entry is removed if it becomes empty
+    void GcKey4TTL(const Slice& key, KeyEntry* entry, uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                   uint64_t& gc_record_cnt,                                                 // NOLINT
+                   uint64_t& gc_record_byte_size);                                          // NOLINT
+    // drop the rows not newer than time from the cold block of node by rebuilding it with the other rows.
+    // mu_ must be held, return the count of the rows dropped
+    uint32_t TrimColdBlock(KeyEntry* entry, ::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t time,
+                           uint64_t& gc_record_cnt,         // NOLINT
+                           uint64_t& gc_record_byte_size);  // NOLINT
+    // gc the keys of the expired buckets of the expiry index only
+    void Gc4TTLByIndex(uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                       uint64_t& gc_record_cnt,              // NOLINT
+                       uint64_t& gc_record_byte_size);       // NOLINT
+    void ArmExpiryIndex();
+    void ClearExpiryIndex();
+    // move the keys handed off by Put to the buckets
+    void DrainExpiryPending();
+    // file the key by its oldest row, expiry_mu_ must be held
+    void FileExpiryKey(::openmldb::base::Node<Slice, void*>* node);
+    // account the memory of the index in idx_byte_size_, expiry_mu_ must be held
+    void UpdateExpiryByteSize();
+
  private:
     KeyEntries* entries_;
-    // only Put need mutex
-    std::mutex mu_;
+    // Put takes the shared lock and inserts with CAS, so the writers of one segment run concurrently.
+    // gc, Delete and the other structural changes of the skiplists take the exclusive lock. The lock prefers the
+    // writer, so a gc waits for the puts in flight only and is not starved by a stream of puts
+    ::openmldb::base::WriterPreferredSharedMutex mu_;
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
@@ -268,6 +473,35 @@ class Segment {
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    std::atomic<uint64_t> cold_ts_;
+    std::atomic<KeyFilter*> key_filter_;
+    // not null while RebuildKeyFilter is running, Put adds the new keys to it too
+    std::atomic<KeyFilter*> building_key_filter_;
+    // the replaced filters with the gc version, freed like the entries in entry_free_list_. guarded by gc_mu_
+    std::vector<std::pair<uint64_t, KeyFilter*>> retired_key_filters_;
+    // the nodes replaced by cold blocks with the gc version, a reader which refs the entry after the check of
+    // ConvertToCold may still walk them. freed like the entries in entry_free_list_. guarded by gc_mu_
+    std::vector<std::pair<uint64_t, std::pair<::openmldb::base::Node<uint64_t, DataBlock*>*,
+                                              ::openmldb::base::Node<uint64_t, DataBlock*>*>>>
+        retired_nodes_;
+    // the keys by the time bucket of their oldest row, for the absolute ttl gc of a segment with one ts column.
+    // it is armed by the first absolute ttl gc, which scans all the keys once; after that Put hands off the keys
+    // whose oldest row changes. the index refers to the key nodes of entries_, a removed node is dropped from it
+    // before it is freed by GcEntryFreeList. a key is never in a newer bucket than its oldest row
+    bool expiry_armed_ = false;  // changed with the exclusive lock of mu_ by gc only
+    uint64_t expiry_bucket_ms_ = 0;
+    // the slots of the hand off, a put claims one by expiry_pending_cnt_ under the shared lock of mu_ and gc drains
+    // them under the exclusive one. if they are not enough, the index lost keys and is rebuilt by a full scan
+    std::unique_ptr<std::atomic<::openmldb::base::Node<Slice, void*>*>[]> expiry_pending_;
+    uint32_t expiry_pending_size_ = 0;
+    std::atomic<uint64_t> expiry_pending_cnt_{0};
+    bool expiry_lost_ = false;
+    std::mutex expiry_mu_;
+    // guarded by expiry_mu_. the bucket of each filed key node, the other copies of the node in expiry_buckets_ are
+    // stale and skipped without touching the node
+    absl::flat_hash_map<::openmldb::base::Node<Slice, void*>*, uint64_t> expiry_keys_;
+    std::map<uint64_t, std::vector<::openmldb::base::Node<Slice, void*>*>> expiry_buckets_;
+    uint64_t expiry_byte_size_ = 0;
 };
 
 }  // namespace storage
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "base/random.h"
+#include "benchmark/benchmark.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+static Segment* segment = nullptr;
+static std::mutex segment_mu;
+static std::vector<std::string> keys;
+
+// state.range(0) is the count of keys, 1 means all the writers put into one key entry
+static void SetUp(const benchmark::State& state) {
+    segment = new Segment();
+    keys.clear();
+    for (int64_t i = 0; i < state.range(0); i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+}
+
+static void TearDown() {
+    segment->Release();
+    delete segment;
+    segment = nullptr;
+}
+
+static void PutRows(benchmark::State& state, bool with_mutex) {  // NOLINT
+    if (state.thread_index == 0) {
+        SetUp(state);
+    }
+    ::openmldb::base::Random rand(state.thread_index + 1);
+    std::string value(128, 'a');
+    uint64_t ts = 1000000000 * (state.thread_index + 1);
+    for (auto _ : state) {
+        // skew the keys so that a few of them take the most writes
+        const std::string& key = keys[rand.Skewed(20) % keys.size()];
+        if (with_mutex) {
+            // the same as the Put before it takes the shared lock
+            std::lock_guard<std::mutex> lock(segment_mu);
+            segment->Put(::openmldb::base::Slice(key), ts++, value.c_str(), value.size());
+        } else {
+            segment->Put(::openmldb::base::Slice(key), ts++, value.c_str(), value.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        TearDown();
+    }
+}
+
+static void BM_SegmentPut(benchmark::State& state) {  // NOLINT
+    PutRows(state, false);
+}
+
+static void BM_SegmentPutWithMutex(benchmark::State& state) {  // NOLINT
+    PutRows(state, true);
+}
+
+BENCHMARK(BM_SegmentPut)->Arg(1)->Arg(1000)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_SegmentPutWithMutex)->Arg(1)->Arg(1000)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace storage
+}  // namespace openmldb
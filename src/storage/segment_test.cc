@@ -16,8 +16,13 @@
 
 #include "storage/segment.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
@@ -26,6 +31,12 @@
 
 using ::openmldb::base::Slice;
 
+DECLARE_uint32(mem_table_key_filter_bits_per_key);
+DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_int32(gc_interval);
+DECLARE_bool(gc_ttl_expiry_index);
+DECLARE_uint32(gc_ttl_key_budget);
+
 namespace openmldb {
 namespace storage {
 
@@ -190,6 +201,172 @@ TEST_F(SegmentTest, Iterator) {
     ASSERT_TRUE(it->Valid());
 }
 
+TEST_F(SegmentTest, ConvertToCold) {
+    Segment segment;
+    Slice pk("pk");
+    for (uint64_t ts = 1; ts <= 1000; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    segment.Put(Slice("pk2"), 1, "test", 4);
+    uint64_t idx_byte_size = segment.GetIdxByteSize();
+    uint64_t cold_row_cnt = 0;
+    uint64_t freed_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.ConvertToCold(500, 100, cold_row_cnt, freed_byte_size, cold_byte_size);
+    // the single row of pk2 is kept
+    ASSERT_EQ(500u, cold_row_cnt);
+    ASSERT_GT(freed_byte_size, 0u);
+    ASSERT_GT(cold_byte_size, 0u);
+    ASSERT_EQ(500u, segment.GetColdTs());
+    ASSERT_LT(segment.GetIdxByteSize(), idx_byte_size);
+    ASSERT_EQ(1001u, segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(1000u, count);
+
+    auto check_value = [](MemTableIterator* it, uint64_t ts) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(ts, it->GetKey());
+        ASSERT_EQ("value" + std::to_string(ts), it->GetValue().ToString());
+    };
+    Ticket ticket;
+    std::unique_ptr<MemTableIterator> it(segment.NewIterator(pk, ticket));
+    it->SeekToFirst();
+    for (uint64_t ts = 1000; ts >= 1; ts--) {
+        check_value(it.get(), ts);
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    it->Seek(1000);
+    check_value(it.get(), 1000);
+    it->Seek(450);
+    check_value(it.get(), 450);
+    it->Next();
+    check_value(it.get(), 449);
+    it->Seek(401);
+    check_value(it.get(), 401);
+    it->Next();
+    check_value(it.get(), 400);
+    it->SeekToLast();
+    check_value(it.get(), 1);
+    it.reset();
+    ticket.Pop();
+
+    // the late rows are merged with the cold block covering them
+    segment.Put(pk, 450, "late450", 7);
+    segment.Put(pk, 401, "late401", 7);
+    segment.Put(pk, 500, "late500", 7);
+    segment.ConvertToCold(500, 100, cold_row_cnt, freed_byte_size, cold_byte_size);
+    ASSERT_EQ(500u, cold_row_cnt);
+    it.reset(segment.NewIterator(pk, ticket));
+    it->SeekToFirst();
+    uint64_t pre_ts = UINT64_MAX;
+    uint32_t cnt = 0;
+    while (it->Valid()) {
+        ASSERT_LE(it->GetKey(), pre_ts);
+        pre_ts = it->GetKey();
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(1003u, cnt);
+    it->Seek(460);
+    check_value(it.get(), 460);
+    it->Seek(450);
+    ASSERT_EQ(450u, it->GetKey());
+    it->Next();
+    ASSERT_EQ(450u, it->GetKey());
+    ASSERT_EQ("late450", it->GetValue().ToString());
+    it->Next();
+    check_value(it.get(), 449);
+    it->Seek(401);
+    check_value(it.get(), 401);
+    it->Next();
+    ASSERT_EQ("late401", it->GetValue().ToString());
+    it->Next();
+    check_value(it.get(), 400);
+    it.reset();
+    ticket.Pop();
+
+    // the expired rows of a cold block are dropped by rebuilding the block
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(450, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // the rows [500, 451] of the block [500, 401] are kept with the late row 500, the other rows of pk and pk2
+    // are freed
+    ASSERT_EQ(453u, gc_idx_cnt);
+    ASSERT_EQ(453u, gc_record_cnt);
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(551u, count);
+    it.reset(segment.NewIterator(pk, ticket));
+    it->Seek(451);
+    check_value(it.get(), 451);
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    it->Seek(450);
+    ASSERT_FALSE(it->Valid());
+    it.reset();
+    ticket.Pop();
+    segment.Gc4TTL(500, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(504u, gc_idx_cnt);
+    ASSERT_EQ(504u, gc_record_cnt);
+    ASSERT_EQ(500u, segment.GetIdxCnt());
+    it.reset(segment.NewIterator(pk, ticket));
+    it->Seek(500);
+    ASSERT_FALSE(it->Valid());
+    it->SeekToLast();
+    check_value(it.get(), 501);
+    it.reset();
+    ticket.Pop();
+
+    // the gc by count is refused while there are cold blocks
+    segment.ExecuteGc(TTLSt(0, 1, ::openmldb::storage::TTLType::kLatestTime), gc_idx_cnt, gc_record_cnt,
+                      gc_record_byte_size);
+    ASSERT_EQ(504u, gc_idx_cnt);
+    ASSERT_EQ(500u, segment.GetIdxCnt());
+}
+
+TEST_F(SegmentTest, ConvertToColdSharedBlock) {
+    Segment segment;
+    Slice pk("pk");
+    std::vector<DataBlock*> blocks;
+    for (uint64_t ts = 1; ts <= 10; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        // the block is shared with another index
+        blocks.push_back(new DataBlock(2, value.c_str(), value.size()));
+        segment.Put(pk, ts, blocks.back());
+    }
+    uint64_t cold_row_cnt = 0;
+    uint64_t freed_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.ConvertToCold(10, 100, cold_row_cnt, freed_byte_size, cold_byte_size);
+    ASSERT_EQ(10u, cold_row_cnt);
+    ASSERT_EQ(0u, freed_byte_size);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the replaced rows are released after the readers of the gc versions before are done
+    for (auto block : blocks) {
+        ASSERT_EQ(2, block->dim_cnt_down);
+    }
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    for (auto block : blocks) {
+        ASSERT_EQ(1, block->dim_cnt_down);
+    }
+    segment.Gc4TTL(10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(10u, gc_idx_cnt);
+    // the rows are counted by the other index
+    ASSERT_EQ(0u, gc_record_cnt);
+    ASSERT_EQ(cold_byte_size, gc_record_byte_size);
+    for (auto block : blocks) {
+        delete block;
+    }
+}
+
 TEST_F(SegmentTest, TestGc4Head) {
     Segment segment;
     uint64_t gc_idx_cnt = 0;
@@ -235,6 +412,77 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, Gc4TTLByExpiryIndex) {
+    FLAGS_gc_ttl_expiry_index = true;
+    // the buckets of the expiry index are one minute
+    FLAGS_gc_interval = 1;
+    Segment segment;
+    // the rows of pk<i> are in the minutes [i, i + 4]
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        for (int j = 0; j < 5; j++) {
+            segment.Put(Slice(pk), (i + j) * 60000 + 1, "test", 4);
+        }
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the first gc scans all the keys and arms the index
+    segment.Gc4TTL(60000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(1u, gc_idx_cnt);
+    // a late row moves pk9 to the first bucket
+    segment.Put(Slice("pk9"), 1, "late", 4);
+    segment.Gc4TTL(120000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(4u, gc_idx_cnt);
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(Slice("pk9"), count));
+    ASSERT_EQ(5u, count);
+
+    // the budgeted gc visits one key a time and leaves the rest to the next ones
+    FLAGS_gc_ttl_key_budget = 1;
+    uint64_t last_gc_idx_cnt = gc_idx_cnt;
+    segment.Gc4TTL(600000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_GT(gc_idx_cnt, last_gc_idx_cnt);
+    ASSERT_LE(gc_idx_cnt, last_gc_idx_cnt + 5);
+    for (int i = 0; i < 20; i++) {
+        segment.Gc4TTL(600000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    FLAGS_gc_ttl_key_budget = 0;
+    // the same rows as a full scan, the minutes of the rows of pk<i> not later than 9
+    ASSERT_EQ(41u, gc_idx_cnt);
+    ASSERT_EQ(41u, gc_record_cnt);
+    ASSERT_EQ(10u, segment.GetIdxCnt());
+    for (int i = 0; i < 10; i++) {
+        count = 0;
+        segment.GetCount(Slice("pk" + std::to_string(i)), count);
+        ASSERT_EQ(static_cast<uint64_t>(i < 6 ? 0 : i - 5), count);
+    }
+
+    // an indexed key is freed and a new key is put after the index is armed
+    ASSERT_TRUE(segment.Delete(Slice("pk9")));
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(45u, gc_idx_cnt);
+    segment.Put(Slice("pk10"), 700000, "test", 4);
+    segment.Gc4TTL(720000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // the minutes 10 and 11 of pk6, pk7 and pk8, and pk10
+    ASSERT_EQ(51u, gc_idx_cnt);
+    ASSERT_EQ(1u, segment.GetIdxCnt());
+    count = 0;
+    ASSERT_EQ(0, segment.GetCount(Slice("pk8"), count));
+    ASSERT_EQ(1u, count);
+
+    // the memory of the index is counted in the index bytes and released with it
+    uint64_t idx_byte_size = segment.GetIdxByteSize();
+    FLAGS_gc_ttl_expiry_index = false;
+    segment.Gc4TTL(720000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(51u, gc_idx_cnt);
+    ASSERT_LT(segment.GetIdxByteSize(), idx_byte_size);
+    FLAGS_gc_interval = 120;
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -397,6 +645,185 @@ int GetCount(Segment* segment, int idx) {
     return count;
 }
 
+TEST_F(SegmentTest, ConcurrentPut) {
+    Segment segment;
+    uint32_t thread_num = 8;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&segment, i] {
+            for (uint64_t ts = 1; ts <= 1000; ts++) {
+                std::string pk = "pk" + std::to_string(ts % 10);
+                segment.Put(Slice(pk), ts * 10 + i, "test", 4);
+            }
+        });
+    }
+    // gc runs with the writers
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    threads.emplace_back([&segment, &gc_idx_cnt, &gc_record_cnt, &gc_record_byte_size] {
+        for (uint64_t time = 0; time <= 5000; time += 10) {
+            segment.Gc4TTL(time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+    });
+    for (auto& t : threads) {
+        t.join();
+    }
+    segment.Gc4TTL(5000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // the rows newer than 5000 are left
+    ASSERT_EQ(10, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(4007, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(4007, GetCount(&segment, 0));
+    ASSERT_EQ(3993, (int64_t)gc_idx_cnt);
+    Ticket ticket;
+    std::unique_ptr<MemTableIterator> it(segment.NewIterator("pk1", ticket));
+    it->SeekToFirst();
+    uint64_t last_ts = UINT64_MAX;
+    uint64_t cnt = 0;
+    while (it->Valid()) {
+        ASSERT_LT(it->GetKey(), last_ts);
+        last_ts = it->GetKey();
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(400, (int64_t)cnt);
+
+    std::vector<uint32_t> ts_idx_vec = {1, 3};
+    Segment multi_ts_segment(8, ts_idx_vec);
+    threads.clear();
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&multi_ts_segment, i] {
+            for (uint64_t ts = 1; ts <= 1000; ts++) {
+                std::string pk = "pk" + std::to_string(ts % 10);
+                std::map<int32_t, uint64_t> ts_map = {{1, ts * 10 + i}, {3, ts * 10 + i}};
+                multi_ts_segment.Put(Slice(pk), ts_map, new DataBlock(2, "test", 4));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(10, (int64_t)multi_ts_segment.GetPkCnt());
+    ASSERT_EQ(8000, GetCount(&multi_ts_segment, 1));
+    ASSERT_EQ(8000, GetCount(&multi_ts_segment, 3));
+}
+
+TEST_F(SegmentTest, GcNotStarvedByPuts) {
+    Segment segment;
+    std::atomic<bool> stop(false);
+    std::atomic<bool> timeout(false);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < 8; i++) {
+        threads.emplace_back([&segment, &stop, &timeout, i] {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            uint64_t ts = 1;
+            while (!stop.load()) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    timeout.store(true);
+                    break;
+                }
+                std::string pk = "pk" + std::to_string(ts % 10);
+                segment.Put(Slice(pk), ts++ * 10 + i, "test", 4);
+            }
+        });
+    }
+    // the exclusive lock of gc is taken while the writers keep putting
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    for (uint64_t time = 0; time < 100; time++) {
+        segment.Gc4TTL(time * 100, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_FALSE(timeout.load());
+}
+
+TEST_F(SegmentTest, KeyFilter) {
+    FLAGS_mem_table_key_filter_bits_per_key = 10;
+    Segment segment;
+    FLAGS_mem_table_key_filter_bits_per_key = 0;
+    double fpr = 1;
+    ASSERT_TRUE(segment.GetKeyFilterFpr(&fpr));
+    ASSERT_EQ(0, fpr);
+    for (uint32_t i = 0; i < 500; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        segment.Put(Slice(pk), 9527, "test", 4);
+    }
+    uint32_t positive_cnt = 0;
+    for (uint32_t i = 0; i < 10000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        if (i < 500) {
+            ASSERT_TRUE(segment.MayContain(Slice(pk)));
+        } else if (segment.MayContain(Slice(pk))) {
+            positive_cnt++;
+        }
+    }
+    ASSERT_LT(positive_cnt, 9500u * 0.05);
+    {
+        Ticket ticket;
+        std::unique_ptr<MemTableIterator> it(segment.NewIterator("pk1", ticket));
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        it.reset(segment.NewIterator("pk10000", ticket));
+        it->SeekToFirst();
+        ASSERT_FALSE(it->Valid());
+    }
+
+    // the filter is rebuilt with a larger capacity when it is too full
+    for (uint32_t i = 500; i < 10000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        segment.Put(Slice(pk), 9527, "test", 4);
+    }
+    double full_fpr = 0;
+    ASSERT_TRUE(segment.GetKeyFilterFpr(&full_fpr));
+    segment.RebuildKeyFilter();
+    ASSERT_TRUE(segment.GetKeyFilterFpr(&fpr));
+    ASSERT_LT(fpr, full_fpr);
+    for (uint32_t i = 0; i < 10000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        ASSERT_TRUE(segment.MayContain(Slice(pk)));
+    }
+    positive_cnt = 0;
+    for (uint32_t i = 10000; i < 20000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        if (segment.MayContain(Slice(pk))) {
+            positive_cnt++;
+        }
+    }
+    ASSERT_LT(positive_cnt, 10000u * 0.05);
+
+    // the keys put during the rebuild are kept
+    std::thread writer([&segment] {
+        for (uint32_t i = 20000; i < 30000; i++) {
+            std::string pk = "pk" + std::to_string(i);
+            segment.Put(Slice(pk), 9527, "test", 4);
+            segment.RebuildKeyFilter();
+        }
+    });
+    for (uint32_t i = 30000; i < 40000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        segment.Put(Slice(pk), 9527, "test", 4);
+    }
+    writer.join();
+    for (uint32_t i = 20000; i < 40000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        ASSERT_TRUE(segment.MayContain(Slice(pk)));
+    }
+
+    // the old filters are freed by gc
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    for (uint32_t i = 0; i <= FLAGS_gc_deleted_pk_version_delta; i++) {
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    segment.Release();
+}
+
 TEST_F(SegmentTest, ReleaseAndCount) {
     std::vector<uint32_t> ts_idx_vec = {1, 3};
     Segment segment(8, ts_idx_vec);
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/slab_allocator.h"
+
+#include <stdlib.h>
+
+#include <mutex>  // NOLINT
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t MIN_SLAB_SIZE = 4096;
+
+SlabAllocator::SlabAllocator(uint32_t slab_size, uint32_t shard_cnt)
+    : slab_shift_(0), slab_size_(MIN_SLAB_SIZE), max_alloc_size_(0), shards_(shard_cnt == 0 ? 1 : shard_cnt),
+      slab_cnt_(0) {
+    while (slab_size_ < slab_size && slab_size_ < (1u << 31)) {
+        slab_size_ <<= 1;
+    }
+    while ((1u << slab_shift_) < slab_size_) {
+        slab_shift_++;
+    }
+    // large records make holes too big, put them on heap
+    max_alloc_size_ = slab_size_ / 4;
+    for (auto& shard : shards_) {
+        shard.cur = nullptr;
+        shard.offset = 0;
+    }
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (auto& shard : shards_) {
+        if (shard.cur != nullptr) {
+            Unref(shard.cur);
+            shard.cur = nullptr;
+        }
+    }
+}
+
+SlabHeader* SlabAllocator::NewSlab() {
+    void* mem = aligned_alloc(slab_size_, slab_size_);
+    if (mem == nullptr) {
+        return nullptr;
+    }
+    SlabHeader* slab = reinterpret_cast<SlabHeader*>(mem);
+    slab->refs.store(1, std::memory_order_relaxed);
+    slab->allocator = this;
+    slab_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return slab;
+}
+
+void SlabAllocator::Unref(SlabHeader* slab) {
+    if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        slab->allocator->slab_cnt_.fetch_sub(1, std::memory_order_relaxed);
+        free(slab);
+    }
+}
+
+char* SlabAllocator::Allocate(uint32_t shard_idx, uint32_t size) {
+    uint32_t real_size = SlabAlignSize(size);
+    if (real_size > max_alloc_size_) {
+        return nullptr;
+    }
+    Shard& shard = shards_[shard_idx % shards_.size()];
+    std::lock_guard<::openmldb::base::SpinMutex> lock(shard.mu);
+    if (shard.cur == nullptr || shard.offset + real_size > slab_size_) {
+        SlabHeader* slab = NewSlab();
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        // release the open ref, the old slab will be freed with its last allocation
+        if (shard.cur != nullptr) {
+            Unref(shard.cur);
+        }
+        shard.cur = slab;
+        shard.offset = SLAB_HEADER_SIZE;
+    }
+    char* ptr = reinterpret_cast<char*>(shard.cur) + shard.offset;
+    shard.offset += real_size;
+    shard.cur->refs.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+void SlabAllocator::Free(const void* ptr, uint8_t slab_shift) {
+    if (ptr == nullptr) {
+        return;
+    }
+    uintptr_t mask = ~((static_cast<uintptr_t>(1) << slab_shift) - 1);
+    Unref(reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(ptr) & mask));
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_SLAB_ALLOCATOR_H_
+#define SRC_STORAGE_SLAB_ALLOCATOR_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "base/spinlock.h"
+
+namespace openmldb {
+namespace storage {
+
+class SlabAllocator;
+
+// the header lives at the beginning of every slab. a slab is aligned to its
+// size, so the header of any allocation can be found by masking the address
+struct SlabHeader {
+    // one ref for every live allocation plus one while the slab is still open for allocating
+    std::atomic<uint32_t> refs;
+    SlabAllocator* allocator;
+};
+
+static const uint32_t SLAB_ALIGN = 8;
+static const uint32_t SLAB_HEADER_SIZE = (sizeof(SlabHeader) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+
+static inline uint32_t SlabAlignSize(uint32_t size) { return (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1); }
+
+// bump allocator for small objects with the same lifecycle, eg DataBlock of a memtable.
+// a slab is freed as a whole once all allocations in it have been freed
+class SlabAllocator {
+ public:
+    // slab_size will be rounded up to a power of two
+    SlabAllocator(uint32_t slab_size, uint32_t shard_cnt);
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    // return nullptr if size is too large for the slab, the caller should fallback to heap
+    char* Allocate(uint32_t shard, uint32_t size);
+
+    // free the memory returned by Allocate. slab_shift is the value of GetSlabShift
+    static void Free(const void* ptr, uint8_t slab_shift);
+
+    inline uint8_t GetSlabShift() const { return slab_shift_; }
+
+    inline uint32_t GetSlabSize() const { return slab_size_; }
+
+    // the bytes reserved by all slabs in use, including the unused tail and the freed holes
+    inline uint64_t GetReservedByteSize() const { return slab_cnt_.load(std::memory_order_relaxed) * slab_size_; }
+
+    inline uint64_t GetSlabCnt() const { return slab_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct Shard {
+        ::openmldb::base::SpinMutex mu;
+        SlabHeader* cur;
+        uint32_t offset;
+    };
+
+    SlabHeader* NewSlab();
+    static void Unref(SlabHeader* slab);
+
+ private:
+    uint8_t slab_shift_;
+    uint32_t slab_size_;
+    uint32_t max_alloc_size_;
+    std::vector<Shard> shards_;
+    std::atomic<uint64_t> slab_cnt_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_SLAB_ALLOCATOR_H_
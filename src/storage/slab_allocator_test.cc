@@ -0,0 +1,116 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/slab_allocator.h"
+
+#include <string>
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "gtest/gtest.h"
+#include "storage/record.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+class SlabAllocatorTest : public ::testing::Test {
+ public:
+    SlabAllocatorTest() {}
+    ~SlabAllocatorTest() {}
+};
+
+TEST_F(SlabAllocatorTest, SlabSize) {
+    SlabAllocator allocator(5000, 1);
+    ASSERT_EQ(8192u, allocator.GetSlabSize());
+    ASSERT_EQ(13, allocator.GetSlabShift());
+    SlabAllocator min_allocator(0, 0);
+    ASSERT_EQ(4096u, min_allocator.GetSlabSize());
+}
+
+TEST_F(SlabAllocatorTest, AllocateAndFree) {
+    SlabAllocator allocator(4096, 2);
+    ASSERT_EQ(0u, allocator.GetSlabCnt());
+    // too large for the slab
+    ASSERT_EQ(nullptr, allocator.Allocate(0, 2048));
+    std::vector<char*> ptrs;
+    for (int i = 0; i < 100; i++) {
+        char* ptr = allocator.Allocate(0, 100);
+        ASSERT_TRUE(ptr != nullptr);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % SLAB_ALIGN);
+        ptrs.push_back(ptr);
+    }
+    uint64_t slab_cnt = allocator.GetSlabCnt();
+    ASSERT_GT(slab_cnt, 1u);
+    ASSERT_EQ(slab_cnt * 4096, allocator.GetReservedByteSize());
+    for (auto ptr : ptrs) {
+        SlabAllocator::Free(ptr, allocator.GetSlabShift());
+    }
+    // the open slab is kept for the following allocations
+    ASSERT_EQ(1u, allocator.GetSlabCnt());
+    ASSERT_TRUE(allocator.Allocate(1, 100) != nullptr);
+    ASSERT_EQ(2u, allocator.GetSlabCnt());
+}
+
+TEST_F(SlabAllocatorTest, DataBlock) {
+    SlabAllocator allocator(4096, 1);
+    std::string value = "test_value";
+    DataBlock* block = NewDataBlock(&allocator, 0, 2, value.c_str(), value.size());
+    ASSERT_EQ(allocator.GetSlabShift(), block->slab_shift);
+    ASSERT_EQ(2, block->dim_cnt_down);
+    ASSERT_EQ(value, std::string(block->data, block->size));
+    ASSERT_EQ(SlabAlignSize(value.size() + sizeof(DataBlock)), GetRecordSize(block));
+    FreeDataBlock(block);
+
+    std::string large_value(2048, 'a');
+    block = NewDataBlock(&allocator, 0, 1, large_value.c_str(), large_value.size());
+    ASSERT_EQ(0, block->slab_shift);
+    ASSERT_EQ(GetRecordSize(large_value.size()), GetRecordSize(block));
+    FreeDataBlock(block);
+
+    block = NewDataBlock(nullptr, 0, 1, value.c_str(), value.size());
+    ASSERT_EQ(0, block->slab_shift);
+    FreeDataBlock(block);
+}
+
+TEST_F(SlabAllocatorTest, SegmentGc) {
+    SlabAllocator allocator(4096, 1);
+    Segment segment;
+    std::string value(100, 'v');
+    for (int i = 0; i < 200; i++) {
+        std::string key = "key" + std::to_string(i % 10);
+        segment.Put(Slice(key), 1000 + i, NewDataBlock(&allocator, 0, 1, value.c_str(), value.size()));
+    }
+    ASSERT_GT(allocator.GetSlabCnt(), 1u);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(1100, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(101u, gc_record_cnt);
+    ASSERT_EQ(101u * GetSlabRecordSize(value.size()), gc_record_byte_size);
+    segment.Gc4TTL(2000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(200u, gc_record_cnt);
+    ASSERT_EQ(1u, allocator.GetSlabCnt());
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::openmldb::base::SetLogLevel(INFO);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -38,9 +38,20 @@ class Snapshot {
     virtual bool Recover(std::shared_ptr<Table> table,
                          uint64_t& latest_offset) = 0;  // NOLINT
     uint64_t GetOffset() { return offset_; }
+    // the binlog after this offset is needed to recover the table without the snapshot deltas
+    virtual uint64_t GetBaseOffset() { return offset_; }
     int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
+    int GenManifest(const ::openmldb::api::Manifest& manifest);
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
+    // the offset and term covered by the snapshot with its deltas. Manifest.offset and term are the ones of the
+    // base snapshot, so that the readers without delta support replay the binlog from the base
+    static uint64_t GetManifestOffset(const ::openmldb::api::Manifest& manifest) {
+        return manifest.deltas_size() > 0 ? manifest.deltas(manifest.deltas_size() - 1).offset() : manifest.offset();
+    }
+    static uint64_t GetManifestTerm(const ::openmldb::api::Manifest& manifest) {
+        return manifest.deltas_size() > 0 ? manifest.deltas(manifest.deltas_size() - 1).term() : manifest.term();
+    }
 
  protected:
     uint32_t tid_;
@@ -42,6 +42,9 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(load_table_parallel);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(make_snapshot_max_delta_num);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -853,6 +856,145 @@ TEST_F(SnapshotTest, MakeSnapshot) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeDeltaSnapshot) {
+    FLAGS_make_snapshot_max_delta_num = 2;
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(11, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 11, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/11_0/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/11_0/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    int count = 0;
+    auto put_rows = [&](int num) {
+        for (int i = 0; i < num; i++, count++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count), "value", count + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+    };
+    auto get_manifest = [&]() {
+        ::openmldb::api::Manifest manifest;
+        GetManifest(snapshot_path + "MANIFEST", &manifest);
+        return manifest;
+    };
+    auto get_file_num = [&]() {
+        std::vector<std::string> vec;
+        ::openmldb::base::GetFileName(snapshot_path, vec);
+        return vec.size();
+    };
+    uint64_t offset_value = 0;
+    // the first snapshot has no base, it is a full one
+    put_rows(10);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    auto manifest = get_manifest();
+    ASSERT_EQ(10u, manifest.offset());
+    ASSERT_EQ(10u, manifest.count());
+    ASSERT_EQ(0, manifest.deltas_size());
+
+    put_rows(10);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(20u, offset_value);
+    manifest = get_manifest();
+    // offset is of the base, so the readers without delta support replay the binlog from there
+    ASSERT_EQ(10u, manifest.offset());
+    ASSERT_EQ(20u, Snapshot::GetManifestOffset(manifest));
+    ASSERT_EQ(10u, snapshot.GetBaseOffset());
+    ASSERT_EQ(10u, manifest.count());
+    ASSERT_EQ(1, manifest.deltas_size());
+    ASSERT_EQ(20u, manifest.deltas(0).offset());
+    ASSERT_EQ(10u, manifest.deltas(0).count());
+    ASSERT_EQ(1u, manifest.deltas(0).term());
+    // base, delta and MANIFEST
+    ASSERT_EQ(3u, get_file_num());
+
+    // nothing new, the manifest keeps the same
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(20u, offset_value);
+    ASSERT_EQ(1, get_manifest().deltas_size());
+    ASSERT_EQ(3u, get_file_num());
+
+    // a deleted key in the binlog rewrites the base snapshot with the deltas
+    put_rows(5);
+    {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key("key15");
+        dimension->set_idx(0);
+        entry.set_term(1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest = get_manifest();
+    ASSERT_EQ(26u, manifest.offset());
+    ASSERT_EQ(24u, manifest.count());
+    ASSERT_EQ(0, manifest.deltas_size());
+    ASSERT_EQ(2u, get_file_num());
+
+    put_rows(5);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    put_rows(5);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest = get_manifest();
+    ASSERT_EQ(26u, manifest.offset());
+    ASSERT_EQ(36u, Snapshot::GetManifestOffset(manifest));
+    ASSERT_EQ(26u, snapshot.GetBaseOffset());
+    ASSERT_EQ(24u, manifest.count());
+    ASSERT_EQ(2, manifest.deltas_size());
+    ASSERT_EQ(31u, manifest.deltas(0).offset());
+    ASSERT_EQ(36u, manifest.deltas(1).offset());
+    ASSERT_EQ(4u, get_file_num());
+
+    // recover applies the base and then the deltas
+    {
+        LogParts* new_log_part = new LogParts(12, 4, scmp);
+        MemTableSnapshot new_snapshot(11, 0, new_log_part, FLAGS_db_root_path);
+        new_snapshot.Init();
+        std::shared_ptr<MemTable> new_table =
+            std::make_shared<MemTable>("tx_log", 11, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        new_table->Init();
+        uint64_t latest_offset = 0;
+        ASSERT_TRUE(new_snapshot.Recover(new_table, latest_offset));
+        ASSERT_EQ(36u, latest_offset);
+        ASSERT_EQ(34u, new_table->GetRecordCnt());
+        Ticket ticket;
+        TableIterator* it = new_table->NewIterator("key15", ticket);
+        it->SeekToFirst();
+        ASSERT_FALSE(it->Valid());
+        delete it;
+        it = new_table->NewIterator("key34", ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(35u, it->GetKey());
+        delete it;
+    }
+
+    // the deltas reach the limit, merge them into a new base
+    put_rows(5);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest = get_manifest();
+    ASSERT_EQ(41u, manifest.offset());
+    ASSERT_EQ(41u, snapshot.GetBaseOffset());
+    ASSERT_EQ(39u, manifest.count());
+    ASSERT_EQ(0, manifest.deltas_size());
+    ASSERT_EQ(2u, get_file_num());
+    FLAGS_make_snapshot_max_delta_num = 0;
+}
+
 TEST_F(SnapshotTest, MakeSnapshot_with_delete_index) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 3, log_part, FLAGS_db_root_path);
@@ -1703,6 +1845,94 @@ TEST_F(SnapshotTest, Recover_large_snapshot_and_binlog) {
     delete it;
 }
 
+TEST_F(SnapshotTest, Recover_parallel) {
+    std::string binlog_dir = FLAGS_db_root_path + "/102_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 100;
+    uint32_t count = 0;
+    auto write_entry = [&](const std::string& key, uint64_t ts) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, key, "value" + std::to_string(ts), ts, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        return wh->Write(::openmldb::base::Slice(buffer)).ok();
+    };
+    for (; count < 2000; count++) {
+        ASSERT_TRUE(write_entry("key" + std::to_string(count % key_num), count + 1));
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    for (; count < 3000; count++) {
+        ASSERT_TRUE(write_entry("key" + std::to_string(count % key_num), count + 1));
+    }
+    // the rows of key0 before the delete are removed
+    offset++;
+    ::openmldb::api::LogEntry delete_entry;
+    delete_entry.set_log_index(offset);
+    delete_entry.set_method_type(::openmldb::api::MethodType::kDelete);
+    ::openmldb::api::Dimension* dimension = delete_entry.add_dimensions();
+    dimension->set_key("key0");
+    dimension->set_idx(0);
+    std::string buffer;
+    delete_entry.SerializeToString(&buffer);
+    ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    for (; count < 3100; count++) {
+        ASSERT_TRUE(write_entry("key0", count + 1));
+    }
+    wh->Sync();
+
+    FLAGS_load_table_parallel = true;
+    FLAGS_load_table_thread_num = 4;
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    uint64_t snapshot_offset = 0;
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(new_table, snapshot_offset));
+    ASSERT_EQ(2000u, snapshot_offset);
+    ASSERT_EQ(2000u, new_table->GetRecordCnt());
+    Binlog binlog(log_part, binlog_dir);
+    ASSERT_TRUE(binlog.RecoverFromBinlog(new_table, snapshot_offset, latest_offset));
+    FLAGS_load_table_parallel = false;
+    FLAGS_load_table_thread_num = 3;
+    ASSERT_EQ(3101u, latest_offset);
+
+    Ticket ticket;
+    TableIterator* it = new_table->NewIterator("key0", ticket);
+    it->SeekToFirst();
+    uint64_t ts = 3100;
+    while (it->Valid()) {
+        ASSERT_EQ(ts, it->GetKey());
+        ts--;
+        it->Next();
+    }
+    ASSERT_EQ(3000u, ts);
+    delete it;
+    it = new_table->NewIterator("key1", ticket);
+    it->SeekToFirst();
+    uint32_t row_cnt = 0;
+    while (it->Valid()) {
+        row_cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(30u, row_cnt);
+    delete it;
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -1712,7 +1942,7 @@ int main(int argc, char** argv) {
     ::google::ParseCommandLineFlags(&argc, &argv, true);
     ::openmldb::base::SetLogLevel(DEBUG);
     int ret = 0;
-    std::vector<std::string> vec{"off", "zlib", "snappy"};
+    std::vector<std::string> vec{"off", "zlib", "snappy", "zstd"};
     for (size_t i = 0; i < vec.size(); i++) {
         std::cout << "compress type: " << vec[i] << std::endl;
         FLAGS_db_root_path = "/tmp/" + std::to_string(::openmldb::storage::GenRand());
@@ -69,6 +69,16 @@ Table::Table(::openmldb::common::StorageMode storage_mode, const std::string& na
     AddVersionSchema(*table_meta_);
 }
 
+void Table::PutBatch(const ::google::protobuf::RepeatedPtrField<::openmldb::api::PutRequest>& rows,
+                     std::vector<uint32_t>* failed_idx) {
+    for (int i = 0; i < rows.size(); i++) {
+        const auto& row = rows.Get(i);
+        if (!Put(row.time(), row.value(), row.dimensions())) {
+            failed_idx->push_back(i);
+        }
+    }
+}
+
 void Table::AddVersionSchema(const ::openmldb::api::TableMeta& table_meta) {
     auto new_versions = std::make_shared<std::map<int32_t, std::shared_ptr<Schema>>>();
     new_versions->insert(std::make_pair(1, std::make_shared<Schema>(table_meta.column_desc())));
@@ -57,6 +57,10 @@ class Table {
         return Put(entry.ts(), entry.value(), entry.dimensions());
     }
 
+    // put the rows one by one, the position of failed rows is appended to failed_idx
+    virtual void PutBatch(const ::google::protobuf::RepeatedPtrField<::openmldb::api::PutRequest>& rows,
+                          std::vector<uint32_t>* failed_idx);
+
     virtual bool Delete(const std::string& pk, uint32_t idx) = 0;
 
     virtual TableIterator* NewIterator(const std::string& pk,
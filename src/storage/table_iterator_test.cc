@@ -25,6 +25,7 @@
 
 DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
+DECLARE_uint32(mem_table_key_filter_bits_per_key);
 
 namespace openmldb {
 namespace storage {
@@ -450,6 +451,32 @@ TEST_P(TableIteratorTest, SeekNonExistent) {
     ASSERT_EQ(0, now - wit->GetKey());
 }
 
+TEST(TableIteratorKeyFilterTest, SeekAbsentKey) {
+    FLAGS_mem_table_key_filter_bits_per_key = 10;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    MemTable table("tx_log", 1, 1, 1, mapping, 0, ::openmldb::type::kAbsoluteTime);
+    table.Init();
+    FLAGS_mem_table_key_filter_bits_per_key = 0;
+    for (int i = 0; i < 5; i += 2) {
+        std::string key = "card" + std::to_string(i);
+        table.Put(key, 1, key.c_str(), key.size());
+    }
+    std::unique_ptr<::hybridse::vm::WindowIterator> it(table.NewWindowIterator(0));
+    // an absent key lands on the next pk
+    it->Seek("card1");
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("card2", it->GetKey().ToString());
+    it->Next();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("card4", it->GetKey().ToString());
+    it->Seek("card2");
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("card2", it->GetKey().ToString());
+    it->Seek("card5");
+    ASSERT_FALSE(it->Valid());
+}
+
 INSTANTIATE_TEST_CASE_P(TestMemAndHDD, TableIteratorTest,
                         ::testing::Values(::openmldb::common::kMemory, ::openmldb::common::kHDD));
 
@@ -45,7 +45,13 @@ const uint64_t& MemTableWindowIterator::GetKey() const {
 }
 
 const ::hybridse::codec::Row& MemTableWindowIterator::GetValue() {
-    row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+    if (it_->IsColdValue()) {
+        // the rows may be kept after the iterator is deleted, share the decoded block instead of copying
+        row_ = ::hybridse::codec::Row(it_->GetSharedColdValue());
+    } else {
+        Slice value = it_->GetValue();
+        row_.Reset(reinterpret_cast<const int8_t*>(value.data()), value.size());
+    }
     return row_;
 }
 
@@ -112,6 +118,7 @@ void MemTableKeyIterator::Seek(const std::string& key) {
         seg_idx_ = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
     }
     Slice spk(key);
+    // Seek is a lower bound, a key absent in the filter can not skip it
     pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
     pk_it_->Seek(spk);
     if (!pk_it_->Valid()) {
@@ -128,15 +135,15 @@ void MemTableKeyIterator::Next() {
 }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = nullptr;
+    TimeEntriesIterator* it = nullptr;
+    const std::atomic<uint64_t>* cold_ts = segments_[seg_idx_]->GetColdTsHint();
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
         ticket_.Push(entry);
+        it = new TimeEntriesIterator(&entry->entries, cold_ts);
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        it = new TimeEntriesIterator(&((KeyEntry*)pk_it_->GetValue())->entries, cold_ts);  // NOLINT
     }
     it->SeekToFirst();
     return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
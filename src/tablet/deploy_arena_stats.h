@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_DEPLOY_ARENA_STATS_H_
+#define SRC_TABLET_DEPLOY_ARENA_STATS_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "bvar/bvar.h"
+
+namespace openmldb {
+namespace tablet {
+
+// the memory allocated by the jit run steps of the requests of each deployment. They are exposed
+// as bvar deploy_<db>_<name>_arena_bytes, the total bytes, and deploy_<db>_<name>_arena_max_bytes,
+// the max bytes of a request in the last minute
+class DeployArenaStats {
+ public:
+    void Record(const std::string& db, const std::string& name, uint64_t bytes) {
+        const std::string key = absl::StrCat(db, ".", name);
+        std::shared_ptr<Stat> stat;
+        {
+            absl::ReaderMutexLock lock(&mu_);
+            auto it = stats_.find(key);
+            if (it != stats_.end()) {
+                stat = it->second;
+            }
+        }
+        if (!stat) {
+            absl::MutexLock lock(&mu_);
+            auto& entry = stats_[key];
+            if (!entry) {
+                entry = std::make_shared<Stat>(absl::StrCat("deploy_", db, "_", name));
+            }
+            stat = entry;
+        }
+        stat->bytes << static_cast<int64_t>(bytes);
+        stat->max_bytes << static_cast<int64_t>(bytes);
+    }
+
+    void Delete(const std::string& db, const std::string& name) {
+        absl::MutexLock lock(&mu_);
+        stats_.erase(absl::StrCat(db, ".", name));
+    }
+
+ private:
+    struct Stat {
+        explicit Stat(const std::string& prefix)
+            : bytes(prefix, "arena_bytes"), max_bytes(), max_bytes_window(prefix, "arena_max_bytes", &max_bytes, 60) {}
+
+        bvar::Adder<int64_t> bytes;
+        bvar::Maxer<int64_t> max_bytes;
+        bvar::Window<bvar::Maxer<int64_t>> max_bytes_window;
+    };
+
+    absl::Mutex mu_;
+    // shared with the requests recording, a request of a dropped deployment may be still running
+    absl::flat_hash_map<std::string, std::shared_ptr<Stat>> stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_DEPLOY_ARENA_STATS_H_
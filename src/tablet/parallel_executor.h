@@ -0,0 +1,64 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_PARALLEL_EXECUTOR_H_
+#define SRC_TABLET_PARALLEL_EXECUTOR_H_
+
+#include <functional>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "vm/engine.h"
+
+namespace openmldb {
+namespace tablet {
+
+// runs the independent input subtrees of a request on bthreads. The first task runs on
+// the calling bthread, so a request with two branches starts only one bthread
+class BthreadParallelExecutor : public ::hybridse::vm::ParallelExecutor {
+ public:
+    void RunAll(const std::vector<std::function<void()>>& tasks) override {
+        if (tasks.empty()) {
+            return;
+        }
+        std::vector<bthread_t> tids;
+        tids.reserve(tasks.size() - 1);
+        for (size_t i = 1; i < tasks.size(); i++) {
+            bthread_t tid;
+            auto* task = const_cast<std::function<void()>*>(&tasks[i]);
+            if (bthread_start_background(&tid, nullptr, RunTask, task) == 0) {
+                tids.push_back(tid);
+            } else {
+                (*task)();
+            }
+        }
+        tasks[0]();
+        for (auto tid : tids) {
+            bthread_join(tid, nullptr);
+        }
+    }
+
+ private:
+    static void* RunTask(void* arg) {
+        (*static_cast<std::function<void()>*>(arg))();
+        return nullptr;
+    }
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+
+#endif  // SRC_TABLET_PARALLEL_EXECUTOR_H_
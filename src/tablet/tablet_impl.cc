@@ -58,6 +58,7 @@
 #include "storage/binlog.h"
 #include "storage/segment.h"
 #include "tablet/file_sender.h"
+#include "tablet/parallel_executor.h"
 #include "storage/table.h"
 #include "storage/disk_table_snapshot.h"
 #include "absl/cleanup/cleanup.h"
@@ -96,6 +97,10 @@ DECLARE_uint32(task_check_interval);
 DECLARE_uint32(load_index_max_wait_time);
 DECLARE_bool(use_name);
 DECLARE_bool(enable_distsql);
+DECLARE_uint32(jit_obj_cache_size_mb);
+DECLARE_bool(enable_parallel_request_subtree);
+DECLARE_string(jit_obj_cache_dir);
+DECLARE_uint32(jit_obj_cache_dir_size_mb);
 DECLARE_string(snapshot_compression);
 DECLARE_string(file_compression);
 
@@ -108,6 +113,7 @@ DECLARE_int32(zk_keep_alive_check_interval);
 
 DECLARE_int32(binlog_sync_to_disk_interval);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_int32(binlog_sync_wait_time);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(max_traverse_cnt);
@@ -125,6 +131,9 @@ static const uint32_t SEED = 0xe17a1465;
 
 static constexpr const char DEPLOY_STATS[] = "deploy_stats";
 
+// the key of TableRegistry
+static inline uint64_t TableUid(uint32_t tid, uint32_t pid) { return static_cast<uint64_t>(tid) << 32 | pid; }
+
 TabletImpl::TabletImpl()
     : tables_(),
       mu_(),
@@ -207,10 +216,16 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.jit_options().SetObjCacheCapacity(static_cast<uint64_t>(FLAGS_jit_obj_cache_size_mb) << 20);
+    options.jit_options().SetObjCacheDir(FLAGS_jit_obj_cache_dir);
+    options.jit_options().SetObjCacheDirCapacity(static_cast<uint64_t>(FLAGS_jit_obj_cache_dir_size_mb) << 20);
+    if (FLAGS_enable_parallel_request_subtree) {
+        options.SetParallelExecutor(std::make_shared<BthreadParallelExecutor>());
+    }
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
-    std::set<std::string> snapshot_compression_set{"off", "zlib", "snappy"};
+    std::set<std::string> snapshot_compression_set{"off", "zlib", "snappy", "zstd"};
     if (snapshot_compression_set.find(FLAGS_snapshot_compression) == snapshot_compression_set.end()) {
         LOG(ERROR) << "wrong snapshot_compression: " << FLAGS_snapshot_compression;
         return false;
@@ -326,6 +341,7 @@ void TabletImpl::UpdateTTL(RpcController* ctrl, const ::openmldb::api::UpdateTTL
     uint64_t abs_ttl = ttl.abs_ttl();
     uint64_t lat_ttl = ttl.lat_ttl();
     const auto& index_name = request->index_name();
+    // the ttl type is never changed, the rows converted to cold blocks by the absolute ttl gc rely on it
     if (index_name.empty()) {
         for (const auto& index : table->GetAllIndex()) {
             if (index->GetTTLType() != ::openmldb::storage::TTLSt::ConvertTTLType(ttl.ttl_type())) {
@@ -479,7 +495,7 @@ int32_t TabletImpl::GetIndex(const ::openmldb::api::GetRequest* request, const :
     bool enable_project = false;
     openmldb::codec::RowProject row_project(vers_schema, request->projection());
     if (request->projection().size() > 0) {
-        if (meta.compress_type() == ::openmldb::type::kSnappy) {
+        if (meta.compress_type() != ::openmldb::type::kNoCompress) {
             return -1;
         }
         bool ok = row_project.Init();
@@ -768,15 +784,21 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
             entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
         }
 
-        // Aggregator update assumes that binlog_offset is strictly increasing
-        // so the update should be protected within the replicator lock
-        // in case there will be other Put jump into the middle
-        auto update_aggr = [this, &request, &ok, &entry]() {
-            ok = UpdateAggrs(request->tid(), request->pid(), request->value(),
-                               request->dimensions(), entry.log_index());
+        // Aggregator update assumes that binlog_offset of a key is strictly increasing, so the turn of
+        // the update is reserved within the replicator lock, and the aggregators are updated in that
+        // order after the lock is released
+        auto aggrs = GetAggregators(request->tid(), request->pid());
+        bool appended = false;
+        auto reserve_aggr = [this, &aggrs, &request, &appended, &entry]() {
+            ReserveAggrs(aggrs, request->dimensions(), entry.log_index());
+            appended = true;
         };
-        UpdateAggrClosure closure(update_aggr);
+        UpdateAggrClosure closure(reserve_aggr);
         replicator->AppendEntry(entry, &closure);
+        if (appended) {
+            ok = UpdateAggrs(request->tid(), request->pid(), aggrs, request->value(), request->dimensions(),
+                             entry.log_index());
+        }
         if (!ok) {
             response->set_code(::openmldb::base::ReturnCode::kError);
             response->set_msg("update aggr failed");
@@ -815,6 +837,129 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table does not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table does not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    for (const auto& row : request->rows()) {
+        if (row.dimensions_size() <= 0 || CheckDimessionPut(&row, table->GetIdxCnt()) != 0) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+            response->set_msg("invalid dimension parameter");
+            return;
+        }
+    }
+    std::vector<uint32_t> failed_idx;
+    table->PutBatch(request->rows(), &failed_idx);
+    for (auto idx : failed_idx) {
+        response->add_failed_idx(idx);
+    }
+    if (failed_idx.size() == static_cast<size_t>(request->rows_size())) {
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed");
+        return;
+    }
+
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+    } else {
+        std::vector<::openmldb::api::LogEntry> entries;
+        entries.reserve(request->rows_size() - failed_idx.size());
+        uint64_t term = replicator->GetLeaderTerm();
+        auto failed_iter = failed_idx.begin();
+        for (int i = 0; i < request->rows_size(); i++) {
+            if (failed_iter != failed_idx.end() && *failed_iter == static_cast<uint32_t>(i)) {
+                failed_iter++;
+                continue;
+            }
+            const auto& row = request->rows(i);
+            entries.emplace_back();
+            auto& entry = entries.back();
+            entry.set_ts(row.time());
+            entry.set_value(row.value());
+            entry.set_term(term);
+            entry.mutable_dimensions()->CopyFrom(row.dimensions());
+        }
+        // the entries are appended with contiguous offsets under the replicator lock, where the turns
+        // of the aggregator updates are reserved, so aggregators still see strictly increasing offsets
+        auto aggrs = GetAggregators(tid, pid);
+        auto reserve_aggr = [this, &aggrs, &entries, &replicator]() {
+            uint64_t log_offset = replicator->GetOffset();
+            // the entries written are a prefix, the entry failed has an offset out of the log
+            for (const auto& entry : entries) {
+                if (entry.log_index() == 0 || entry.log_index() > log_offset) {
+                    break;
+                }
+                ReserveAggrs(aggrs, entry.dimensions(), entry.log_index());
+            }
+        };
+        UpdateAggrClosure closure(reserve_aggr);
+        bool appended = replicator->AppendEntries(entries, &closure);
+        // the entries written have been reserved and are updated even if the append fails
+        bool ok = true;
+        for (const auto& entry : entries) {
+            ok = UpdateAggrs(tid, pid, aggrs, entry.value(), entry.dimensions(), entry.log_index()) && ok;
+        }
+        if (!appended) {
+            PDLOG(WARNING, "fail to append %u entries, %u written. tid %u pid %u", request->rows_size(),
+                  entries.size(), tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("append binlog failed");
+            return;
+        }
+        if (!ok) {
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("update aggr failed");
+            return;
+        }
+        if (FLAGS_binlog_notify_on_put) {
+            replicator->Notify();
+        }
+    }
+    if (failed_idx.empty()) {
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+    } else {
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed");
+    }
+
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. row cnt %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    // update global var in standalone mode
+    if (!IsClusterMode() && table->GetDB() == openmldb::nameserver::INFORMATION_SCHEMA_DB &&
+        table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
+        UpdateGlobalVarTable();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().empty()) {
@@ -917,7 +1062,7 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
     bool enable_project = false;
     ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
     if (request->projection().size() > 0) {
-        if (meta.compress_type() == ::openmldb::type::kSnappy) {
+        if (meta.compress_type() != ::openmldb::type::kNoCompress) {
             LOG(WARNING) << "project on compress row data do not eing supported";
             return -1;
         }
@@ -1004,7 +1149,7 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
     bool enable_project = false;
     ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
     if (!request->projection().empty()) {
-        if (meta.compress_type() == ::openmldb::type::kSnappy) {
+        if (meta.compress_type() != ::openmldb::type::kNoCompress) {
             LOG(WARNING) << "project on compress row data, not supported";
             return -1;
         }
@@ -1886,6 +2031,9 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     } else {
         run_ret = session.Run(input_rows, output_rows);
     }
+    if (request->is_procedure() && IsCollectDeployStatsEnabled()) {
+        deploy_arena_stats_.Record(request->db(), request->sp_name(), session.GetArenaBytes());
+    }
     if (run_ret != 0) {
         response->set_msg(status.msg);
         response->set_code(::openmldb::base::kSQLRunError);
@@ -2233,6 +2381,19 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
+    if (request->pre_log_index() > last_log_offset) {
+        // a pipelined leader has several requests inflight, wait the preceding ones to be applied
+        if (!replicator->WaitOffset(request->pre_log_index(), FLAGS_binlog_sync_wait_time)) {
+            last_log_offset = replicator->GetOffset();
+            PDLOG(WARNING, "log index is not continuous. pre_log_index %lu cur log_offset %lu tid %u pid %u",
+                  request->pre_log_index(), last_log_offset, tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("log index is not continuous");
+            response->set_log_offset(last_log_offset);
+            return;
+        }
+        last_log_offset = replicator->GetOffset();
+    }
     for (int32_t i = 0; i < request->entries_size(); i++) {
         const auto& entry = request->entries(i);
         if (entry.log_index() <= last_log_offset) {
@@ -2416,6 +2577,10 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                             }
                         }
                         delete[] stats;
+                        double key_filter_fpr = 0;
+                        if (mem_table->GetKeyFilterFpr(index_def->GetId(), &key_filter_fpr)) {
+                            ts_idx_status->set_key_filter_fpr(key_filter_fpr);
+                        }
                     }
                     status->set_idx_cnt(record_idx_cnt);
                 }
@@ -2504,7 +2669,8 @@ void TabletImpl::MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_o
         uint64_t offset = 0;
         ret = snapshot->MakeSnapshot(table, offset, end_offset, replicator->GetLeaderTerm());
         if (ret == 0) {
-            replicator->SetSnapshotLogPartIndex(offset);
+            // keep the binlog after the base snapshot for the readers without delta support
+            replicator->SetSnapshotLogPartIndex(snapshot->GetBaseOffset());
         }
     }
     {
@@ -2822,6 +2988,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        ::openmldb::api::Manifest manifest;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2831,7 +2998,6 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
             }
             google::protobuf::io::FileInputStream fileInput(fd);
             fileInput.SetCloseOnDelete(true);
-            ::openmldb::api::Manifest manifest;
             if (!google::protobuf::TextFormat::Parse(&fileInput, &manifest)) {
                 PDLOG(WARNING, "parse manifest failed. tid[%u] pid[%u]", tid, pid);
                 break;
@@ -2839,9 +3005,16 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
             snapshot_file = manifest.name();
         }
         if (table->GetStorageMode() == common::kMemory) {
-            // send snapshot file
-            if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
-                PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
+            // send snapshot file and the deltas on it
+            bool send_failed = false;
+            for (const auto& file : ::openmldb::storage::MemTableSnapshot::GetSnapshotFiles(manifest)) {
+                if (sender.SendFile(file.name(), full_path + file.name()) < 0) {
+                    PDLOG(WARNING, "send snapshot %s failed. tid[%u] pid[%u]", file.name().c_str(), tid, pid);
+                    send_failed = true;
+                    break;
+                }
+            }
+            if (send_failed) {
                 break;
             }
         } else {
@@ -3122,7 +3295,7 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
 
             table->SetTableStat(::openmldb::storage::kNormal);
             replicator->SetOffset(latest_offset);
-            replicator->SetSnapshotLogPartIndex(snapshot->GetOffset());
+            replicator->SetSnapshotLogPartIndex(snapshot->GetBaseOffset());
             replicator->StartSyncing();
             table->SchedGc();
             gc_pool_.DelayTask(FLAGS_gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
@@ -3274,20 +3447,26 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
         }
         std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
         {
-            std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-            engine_->ClearCacheLocked(table->GetTableMeta()->db());
-            tables_[tid].erase(pid);
-            replicators_[tid].erase(pid);
-            snapshots_[tid].erase(pid);
-            if (tables_[tid].empty()) {
-                tables_.erase(tid);
-            }
-            if (replicators_[tid].empty()) {
-                replicators_.erase(tid);
-            }
-            if (snapshots_[tid].empty()) {
-                snapshots_.erase(tid);
+            std::lock_guard<std::mutex> registry_lock(registry_mu_);
+            {
+                std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+                engine_->ClearCacheLocked(table->GetTableMeta()->db());
+                tables_[tid].erase(pid);
+                replicators_[tid].erase(pid);
+                snapshots_[tid].erase(pid);
+                if (tables_[tid].empty()) {
+                    tables_.erase(tid);
+                }
+                if (replicators_[tid].empty()) {
+                    replicators_.erase(tid);
+                }
+                if (snapshots_[tid].empty()) {
+                    snapshots_.erase(tid);
+                }
             }
+            // Modify waits for the readers, keep it out of spin_mutex_
+            auto del_entry = [tid, pid](TableRegistry& registry) { return registry.erase(TableUid(tid, pid)); };
+            table_registry_.Modify(del_entry);
         }
         if (replicator) {
             replicator->DelAllReplicateNode();
@@ -3474,7 +3653,7 @@ void TabletImpl::GetTableFollower(RpcController* controller, const ::openmldb::a
         return;
     }
     response->set_offset(replicator->GetOffset());
-    std::map<std::string, uint64_t> info_map;
+    std::map<std::string, ::openmldb::replica::ReplicateNodeInfo> info_map;
     replicator->GetReplicateInfo(info_map);
     if (info_map.empty()) {
         response->set_msg("has no follower");
@@ -3483,7 +3662,10 @@ void TabletImpl::GetTableFollower(RpcController* controller, const ::openmldb::a
     for (const auto& kv : info_map) {
         ::openmldb::api::FollowerInfo* follower_info = response->add_follower_info();
         follower_info->set_endpoint(kv.first);
-        follower_info->set_offset(kv.second);
+        follower_info->set_offset(kv.second.offset);
+        follower_info->set_lag(kv.second.lag);
+        follower_info->set_inflight_cnt(kv.second.inflight_cnt);
+        follower_info->set_inflight_byte_size(kv.second.inflight_byte_size);
     }
     response->set_msg("ok");
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -3517,8 +3699,8 @@ int32_t TabletImpl::GetSnapshotOffset(uint32_t tid, uint32_t pid, openmldb::comm
         PDLOG(WARNING, "snapshot file[%s] does not exist", snapshot_file.c_str());
         return 0;
     }
-    offset = manifest.offset();
-    term = manifest.term();
+    offset = Snapshot::GetManifestOffset(manifest);
+    term = Snapshot::GetManifestTerm(manifest);
     return 0;
 }
 void TabletImpl::GetAllSnapshotOffset(RpcController* controller, const ::openmldb::api::EmptyRequest* request,
@@ -3830,7 +4012,8 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         msg.assign("fail to get table db root path");
         return -1;
     }
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+    std::lock_guard<std::mutex> registry_lock(registry_mu_);
+    std::unique_lock<SpinMutex> spin_lock(spin_mutex_);
     std::shared_ptr<Table> table = GetTableUnLock(tid, pid);
     if (table) {
         PDLOG(WARNING, "table with tid[%u] and pid[%u] exists", tid, pid);
@@ -3906,6 +4089,13 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
             RefreshAggrCatalog();
         }
     }
+    spin_lock.unlock();
+    // Modify waits for the readers, keep it out of spin_mutex_
+    auto add_entry = [&](TableRegistry& registry) {
+        registry[TableUid(tid, pid)] = TableEntry{table, replicator, snapshot};
+        return 1;
+    };
+    table_registry_.Modify(add_entry);
     return 0;
 }
 
@@ -4119,8 +4309,12 @@ void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
 }
 
 std::shared_ptr<Snapshot> TabletImpl::GetSnapshot(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetSnapshotUnLock(tid, pid);
+    butil::DoublyBufferedData<TableRegistry>::ScopedPtr registry;
+    if (table_registry_.Read(&registry) != 0) {
+        return std::shared_ptr<Snapshot>();
+    }
+    auto it = registry->find(TableUid(tid, pid));
+    return it != registry->end() ? it->second.snapshot : std::shared_ptr<Snapshot>();
 }
 
 std::shared_ptr<Snapshot> TabletImpl::GetSnapshotUnLock(uint32_t tid, uint32_t pid) {
@@ -4146,13 +4340,21 @@ std::shared_ptr<LogReplicator> TabletImpl::GetReplicatorUnLock(uint32_t tid, uin
 }
 
 std::shared_ptr<LogReplicator> TabletImpl::GetReplicator(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetReplicatorUnLock(tid, pid);
+    butil::DoublyBufferedData<TableRegistry>::ScopedPtr registry;
+    if (table_registry_.Read(&registry) != 0) {
+        return std::shared_ptr<LogReplicator>();
+    }
+    auto it = registry->find(TableUid(tid, pid));
+    return it != registry->end() ? it->second.replicator : std::shared_ptr<LogReplicator>();
 }
 
 std::shared_ptr<Table> TabletImpl::GetTable(uint32_t tid, uint32_t pid) {
-    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-    return GetTableUnLock(tid, pid);
+    butil::DoublyBufferedData<TableRegistry>::ScopedPtr registry;
+    if (table_registry_.Read(&registry) != 0) {
+        return std::shared_ptr<Table>();
+    }
+    auto it = registry->find(TableUid(tid, pid));
+    return it != registry->end() ? it->second.table : std::shared_ptr<Table>();
 }
 
 std::shared_ptr<Table> TabletImpl::GetTableUnLock(uint32_t tid, uint32_t pid) {
@@ -4180,26 +4382,41 @@ std::shared_ptr<Aggrs> TabletImpl::GetAggregatorsUnLock(uint32_t tid, uint32_t p
     return std::shared_ptr<Aggrs>();
 }
 
-bool TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& value,
-                 const ::openmldb::storage::Dimensions& dimensions, uint64_t log_offset) {
-    auto aggrs = GetAggregators(tid, pid);
+void TabletImpl::ReserveAggrs(const std::shared_ptr<Aggrs>& aggrs, const ::openmldb::storage::Dimensions& dimensions,
+                              uint64_t log_offset) {
+    if (!aggrs) {
+        return;
+    }
+    for (auto iter = dimensions.begin(); iter != dimensions.end(); ++iter) {
+        for (const auto& aggr : *aggrs) {
+            if (aggr->GetIndexPos() == iter->idx()) {
+                aggr->Reserve(iter->key(), log_offset);
+            }
+        }
+    }
+}
+
+bool TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const std::shared_ptr<Aggrs>& aggrs,
+                             const std::string& value, const ::openmldb::storage::Dimensions& dimensions,
+                             uint64_t log_offset) {
     if (!aggrs) {
         return true;
     }
+    // every aggregator is updated even after a failure, to give up the turns reserved
+    bool ok = true;
     for (auto iter = dimensions.begin(); iter != dimensions.end(); ++iter) {
         for (const auto& aggr : *aggrs) {
             if (aggr->GetIndexPos() != iter->idx()) {
                 continue;
             }
-            auto ok = aggr->Update(iter->key(), value, log_offset);
-            if (!ok) {
+            if (!aggr->Update(iter->key(), value, log_offset)) {
                 PDLOG(WARNING, "update aggr failed. tid[%u] pid[%u] index[%u] key[%s] value[%s]",
                      tid, pid, iter->idx(), iter->key().c_str(), value.c_str());
-                return false;
+                ok = false;
             }
         }
     }
-    return true;
+    return ok;
 }
 
 
@@ -5429,6 +5646,7 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
         } else {
             LOG(INFO) << "deleted deploy collector for " << collector_key;
         }
+        deploy_arena_stats_.Delete(db_name, sp_name);
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -5456,6 +5674,9 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     } else {
         ret = session.Run(row, &output);
     }
+    if (request.is_procedure() && IsCollectDeployStatsEnabled()) {
+        deploy_arena_stats_.Record(request.db(), request.sp_name(), session.GetArenaBytes());
+    }
     if (ret != 0) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to run sql");
@@ -5825,6 +6046,30 @@ bool TabletImpl::CreateAggregatorInternal(const ::openmldb::api::CreateAggregato
         msg.assign("table does not exist");
         return false;
     }
+    uint64_t uid = (uint64_t) base_meta->tid() << 32 | base_meta->pid();
+    // a pre-aggr table shared by several deployments must be updated by exactly one aggregator. Init replays the
+    // binlog into the pre-aggr table, so the concurrent creations are serialized rather than dropped after Init
+    std::lock_guard<std::mutex> create_lock(create_aggr_mu_);
+    auto exists = [&]() {
+        auto it = aggregators_.find(uid);
+        if (it == aggregators_.end()) {
+            return false;
+        }
+        for (const auto& aggr : *it->second) {
+            if (aggr->GetAggrTid() == request->aggr_table_tid()) {
+                PDLOG(INFO, "aggregator of aggr table tid %u already exists on base table tid %u, pid %u",
+                      request->aggr_table_tid(), base_meta->tid(), base_meta->pid());
+                return true;
+            }
+        }
+        return false;
+    };
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        if (exists()) {
+            return true;
+        }
+    }
     auto aggr_replicator = GetReplicator(request->aggr_table_tid(), request->aggr_table_pid());
     auto aggregator = ::openmldb::storage::CreateAggregator(*base_meta, *aggr_table->GetTableMeta(),
                                                             aggr_table, aggr_replicator, request->index_pos(),
@@ -5840,9 +6085,11 @@ bool TabletImpl::CreateAggregatorInternal(const ::openmldb::api::CreateAggregato
     if (!aggregator->Init(base_replicator)) {
         PDLOG(WARNING, "aggregator init failed");
     }
-    uint64_t uid = (uint64_t) base_meta->tid() << 32 | base_meta->pid();
     {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        if (exists()) {
+            return true;
+        }
         if (aggregators_.find(uid) == aggregators_.end()) {
             aggregators_.emplace(uid, std::make_shared<Aggrs>());
         }
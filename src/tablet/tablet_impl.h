@@ -28,7 +28,9 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "base/spinlock.h"
+#include "butil/containers/doubly_buffered_data.h"
 #include "catalog/tablet_catalog.h"
 #include "common/thread_pool.h"
 #include "nameserver/system_table.h"
@@ -41,6 +43,7 @@
 #include "storage/mem_table_snapshot.h"
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
+#include "tablet/deploy_arena_stats.h"
 #include "tablet/file_receiver.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
@@ -71,6 +74,15 @@ typedef std::map<uint32_t, std::map<uint32_t, std::shared_ptr<LogReplicator>>> R
 typedef std::map<uint32_t, std::map<uint32_t, std::shared_ptr<Snapshot>>> Snapshots;
 typedef std::map<uint64_t, std::shared_ptr<Aggrs>> Aggregators;
 
+// the table, replicator and snapshot of a partition
+struct TableEntry {
+    std::shared_ptr<Table> table;
+    std::shared_ptr<LogReplicator> replicator;
+    std::shared_ptr<Snapshot> snapshot;
+};
+// tid << 32 | pid -> entry
+typedef absl::flat_hash_map<uint64_t, TableEntry> TableRegistry;
+
 class TabletImpl : public ::openmldb::api::TabletServer {
  public:
     TabletImpl();
@@ -86,6 +98,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -425,7 +440,10 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                                   openmldb::api::SQLBatchRequestQueryResponse* response,
                                   butil::IOBuf& buf);  // NOLINT
 
-    bool UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& value,
+    void ReserveAggrs(const std::shared_ptr<Aggrs>& aggrs, const ::openmldb::storage::Dimensions& dimensions,
+                      uint64_t log_offset);
+
+    bool UpdateAggrs(uint32_t tid, uint32_t pid, const std::shared_ptr<Aggrs>& aggrs, const std::string& value,
                      const ::openmldb::storage::Dimensions& dimensions, uint64_t log_offset);
 
     bool CreateAggregatorInternal(const ::openmldb::api::CreateAggregatorRequest* request,
@@ -458,7 +476,13 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     ThreadPool gc_pool_;
     Replicators replicators_;
     Snapshots snapshots_;
+    // a copy of tables_, replicators_ and snapshots_ read by GetTable, GetReplicator and GetSnapshot without
+    // spin_mutex_. it's modified after them under registry_mu_, which is taken before spin_mutex_
+    butil::DoublyBufferedData<TableRegistry> table_registry_;
+    std::mutex registry_mu_;
     Aggregators aggregators_;
+    // serializes the creation of the aggregators
+    std::mutex create_aggr_mu_;
     ZkClient* zk_client_;
     ThreadPool keep_alive_pool_;
     ThreadPool task_pool_;
@@ -491,6 +515,7 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<std::map<std::string, std::string>> global_variables_;
 
     std::unique_ptr<openmldb::statistics::DeployQueryTimeCollector> deploy_collector_;
+    DeployArenaStats deploy_arena_stats_;
 };
 
 }  // namespace tablet
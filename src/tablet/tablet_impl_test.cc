@@ -24,6 +24,8 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <utility>
 
 #include "absl/cleanup/cleanup.h"
@@ -252,6 +254,19 @@ int PutKVData(uint32_t tid, uint32_t pid, const std::string& key, const std::str
     return presponse.code();
 }
 
+uint64_t GetTableOffset(uint32_t tid, uint32_t pid, TabletImpl* tablet) {
+    ::openmldb::api::GetTableStatusRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    ::openmldb::api::GetTableStatusResponse response;
+    MockClosure closure;
+    tablet->GetTableStatus(NULL, &request, &response, &closure);
+    if (response.code() != 0 || response.all_table_status_size() == 0) {
+        return 0;
+    }
+    return response.all_table_status(0).offset();
+}
+
 int GetTTL(TabletImpl& tablet, uint32_t tid, uint32_t pid, const std::string& index_name,  // NOLINT
            ::openmldb::common::TTLSt* ttl) {
     ::openmldb::api::GetTableSchemaRequest request;
@@ -1826,6 +1841,60 @@ TEST_P(TabletImplTest, Scan) {
 }
 
 
+TEST_P(TabletImplTest, PutBatch) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    MockClosure closure;
+    ::openmldb::api::PutBatchRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    for (int i = 0; i < 10; i++) {
+        auto row = request.add_rows();
+        std::string key = "key" + std::to_string(i % 2);
+        PackDefaultDimension(key, row);
+        row->set_time(9527 + i);
+        row->set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(i)));
+    }
+    ::openmldb::api::PutBatchResponse response;
+    tablet.PutBatch(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(0, response.failed_idx_size());
+    ASSERT_EQ(10u, GetTableOffset(id, 1, &tablet));
+
+    ::openmldb::api::ScanRequest sr;
+    sr.set_tid(id);
+    sr.set_pid(1);
+    sr.set_pk("key0");
+    sr.set_st(9600);
+    sr.set_et(0);
+    ::openmldb::api::ScanResponse srp;
+    tablet.Scan(NULL, &sr, &srp, &closure);
+    ASSERT_EQ(0, srp.code());
+    ASSERT_EQ(5, (signed)srp.count());
+
+    // invalid dimension fails the whole batch
+    request.mutable_rows(3)->mutable_dimensions(0)->set_idx(10);
+    response.Clear();
+    tablet.PutBatch(NULL, &request, &response, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kInvalidDimensionParameter, response.code());
+    ASSERT_EQ(10u, GetTableOffset(id, 1, &tablet));
+
+    if (storage_mode == ::openmldb::common::kMemory) {
+        // the rows failed to put are not written to binlog
+        request.mutable_rows(3)->mutable_dimensions(0)->set_idx(0);
+        request.mutable_rows(5)->set_value("bad");
+        response.Clear();
+        tablet.PutBatch(NULL, &request, &response, &closure);
+        ASSERT_EQ(::openmldb::base::ReturnCode::kPutFailed, response.code());
+        ASSERT_EQ(1, response.failed_idx_size());
+        ASSERT_EQ(5u, response.failed_idx(0));
+        ASSERT_EQ(19u, GetTableOffset(id, 1, &tablet));
+    }
+}
+
 TEST_P(TabletImplTest, GCWithUpdateLatest) {
     ::openmldb::common::StorageMode storage_mode = GetParam();
     int32_t old_gc_interval = FLAGS_gc_interval;
@@ -2023,6 +2092,68 @@ TEST_P(TabletImplTest, DropTable) {
     ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 1, 0, kAbsoluteTime, storage_mode, &tablet));
 }
 
+TEST_P(TabletImplTest, GetTableAfterDrop) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_FALSE(tablet.GetTable(id, 1));
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 1, 0, kAbsoluteTime, storage_mode, &tablet));
+    auto table = tablet.GetTable(id, 1);
+    ASSERT_TRUE(table);
+    ASSERT_EQ(id, table->GetId());
+    ASSERT_FALSE(tablet.GetTable(id, 2));
+    MockClosure closure;
+    ::openmldb::api::DropTableRequest dr;
+    dr.set_tid(id);
+    dr.set_pid(1);
+    ::openmldb::api::DropTableResponse drs;
+    tablet.DropTable(NULL, &dr, &drs, &closure);
+    ASSERT_EQ(0, drs.code());
+    sleep(1);
+    ASSERT_FALSE(tablet.GetTable(id, 1));
+}
+
+TEST_P(TabletImplTest, GetTableWhileCreateAndDrop) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> mismatch{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto table = tablet.GetTable(id, 1);
+                if (table && (table->GetId() != id || table->GetPid() != 1)) {
+                    mismatch++;
+                }
+            }
+        });
+    }
+    absl::Cleanup join_readers = [&] {
+        stop = true;
+        for (auto& t : readers) {
+            t.join();
+        }
+    };
+    MockClosure closure;
+    ::openmldb::api::DropTableRequest dr;
+    dr.set_tid(id);
+    dr.set_pid(1);
+    for (int round = 0; round < 3; round++) {
+        ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 1, 0, kAbsoluteTime, storage_mode, &tablet));
+        ASSERT_TRUE(tablet.GetTable(id, 1));
+        ::openmldb::api::DropTableResponse drs;
+        tablet.DropTable(NULL, &dr, &drs, &closure);
+        ASSERT_EQ(0, drs.code());
+        sleep(1);
+        ASSERT_FALSE(tablet.GetTable(id, 1));
+    }
+    ASSERT_EQ(0u, mismatch.load());
+}
+
 TEST_F(TabletImplTest, DropTableNoRecycleMem) {
     bool tmp_recycle_bin_enabled = FLAGS_recycle_bin_enabled;
     std::string tmp_db_root_path = FLAGS_db_root_path;
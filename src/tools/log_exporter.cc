@@ -56,8 +56,11 @@ void LogExporter::ReadManifest() {
     }
     std::string snapshot_name = manifest.name();
     snapshot_path_ = table_dir_path_ + "/snapshot/" + snapshot_name;
-    offset_ = manifest.offset();
+    offset_ = ::openmldb::storage::Snapshot::GetManifestOffset(manifest);
     PDLOG(INFO, "Snapshot's offset: %lu, path: %s.", offset_, snapshot_path_.c_str());
+    for (const auto& delta : manifest.deltas()) {
+        delta_paths_.push_back(table_dir_path_ + "/snapshot/" + delta.name());
+    }
 }
 
 void LogExporter::ExportTable() {
@@ -73,7 +76,10 @@ void LogExporter::ExportTable() {
         file_path.emplace_back(log);
     }
     if (snapshot_path_.length()) {
-        ReadSnapshot();
+        ReadSnapshot(snapshot_path_);
+        for (const auto& delta_path : delta_paths_) {
+            ReadSnapshot(delta_path);
+        }
     }
     (void) closedir(dir);
     // Sorts binlog files and performs binary search
@@ -171,17 +177,18 @@ void LogExporter::ReadLog(const std::string &log_path) {
     offset_ += success_cnt;
 }
 
-void LogExporter::ReadSnapshot() {
-    FILE* fd_r = fopen(snapshot_path_.c_str(), "rb");
+void LogExporter::ReadSnapshot(const std::string& snapshot_path) {
+    FILE* fd_r = fopen(snapshot_path.c_str(), "rb");
     if (fd_r == NULL) {
-        PDLOG(ERROR, "fopen failed: %s", snapshot_path_.c_str());
+        PDLOG(ERROR, "fopen failed: %s", snapshot_path.c_str());
         return;
     }
-    SequentialFile* rf = NewSeqFile(snapshot_path_, fd_r);
+    SequentialFile* rf = NewSeqFile(snapshot_path, fd_r);
     std::string scratch;
     bool is_compress = false;
-    if (snapshot_path_.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
-        snapshot_path_.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
+    if (snapshot_path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
+        snapshot_path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos ||
+        snapshot_path.find(openmldb::log::ZSTD_COMPRESS_SUFFIX) != std::string::npos) {
         is_compress = true;
     }
     Reader reader(rf, NULL, true, 0, is_compress);
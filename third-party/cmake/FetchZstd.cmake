@@ -0,0 +1,33 @@
+# Copyright 2021 4Paradigm
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+set(ZSTD_HOME https://github.com/facebook/zstd)
+set(ZSTD_TAG v1.5.2)
+
+message(STATUS "build zstd from ${ZSTD_HOME}@${ZSTD_TAG}")
+
+find_program(MAKE_EXE NAMES gmake nmake make REQUIRED)
+ExternalProject_Add(
+  zstd
+  GIT_REPOSITORY ${ZSTD_HOME}
+  GIT_TAG ${ZSTD_TAG}
+  GIT_SHALLOW TRUE
+  PREFIX ${DEPS_BUILD_DIR}
+  DOWNLOAD_DIR ${DEPS_DOWNLOAD_DIR}/zstd
+  INSTALL_DIR ${DEPS_INSTALL_DIR}
+  BUILD_IN_SOURCE True
+  CONFIGURE_COMMAND ""
+  BUILD_COMMAND bash -c "${CONFIGURE_OPTS} ${MAKE_EXE} ${MAKEOPTS} -C lib CFLAGS='-O3 -fPIC' libzstd.a"
+  INSTALL_COMMAND bash -c "${MAKE_EXE} -C lib PREFIX=<INSTALL_DIR> install-static install-includes")